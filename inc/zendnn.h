@@ -3804,6 +3804,14 @@ zendnn_status_t ZENDNN_API zendnn_reduction_desc_init(zendnn_reduction_desc_t *d
 ///     #zendnn_format_kind_any. The embedding_bag primitive does not
 ///     allocate memory to destination and it should be pre-allocated.
 ///
+/// @note
+///     A #zendnn_u8 input is a row-wise quantized table. Each of its rows
+///     holds the codes of the row followed by an fp32 scale and an fp32
+///     bias, a value being code * scale + bias. Codes are one byte each
+///     (8 bit, input dims[1] = embedding_dim + 8) or one nibble each, low
+///     nibble first (4 bit, input dims[1] = (embedding_dim + 1) / 2 + 8),
+///     where embedding_dim is dst dims[1]. Weights are f32.
+///
 /// @param desc Output descriptor for an embeding_bag primitive
 /// @param prop_kind Propagation kind. currently only forward_inference is
 ///     supported.
@@ -3813,8 +3821,9 @@ zendnn_status_t ZENDNN_API zendnn_reduction_desc_init(zendnn_reduction_desc_t *d
 /// @param num_threads Parallel threads for the primitive (zero for default
 ///              omp threads)
 /// @param input_desc Input (embedding table) memory descriptor.
-/// @param indices_desc Indices memory descriptor.
-/// @param offsets_desc Offsets memory descriptor.
+/// @param indices_desc Indices memory descriptor, #zendnn_s32 or
+///     #zendnn_s64.
+/// @param offsets_desc Offsets memory descriptor, of the indices data type.
 /// @param weights_desc Weights memory descriptor. This can be nullptr if
 ///     no weights vector is present.
 /// @param dst_desc Destination memory descriptor.
@@ -3851,6 +3860,18 @@ zendnn_embedding_bag_desc_init(zendnn_embedding_bag_desc_t *desc,
 ///     #zendnn_format_kind_any. The attention primitive does not
 ///     allocate memory to destination and it should be pre-allocated.
 ///
+/// @note
+///     Supported data types (mask is always f32):
+///      - f32 everywhere.
+///      - bf16 query/key/value and weights, f32 or bf16 bias, f32 or bf16
+///        destination. Projections use the bf16 GEMM, f32 accumulation.
+///      - u8 query/key/value, s8 weights, f32 bias, f32 or bf16
+///        destination. Scales are set with zendnn_primitive_attr_set_scales()
+///        on #ZENDNN_ARG_SRC_0..2 (mask 0) and #ZENDNN_ARG_WEIGHTS_0..2
+///        (mask 0 or 1 << 1 for one scale per output channel), a projection
+///        is s32 * src_scale * weights_scale + bias.
+///     #zendnn_multihead_attention_flash_v1 is f32 only.
+///
 /// @param desc Output descriptor for an attention primitive
 /// @param prop_kind Propagation kind. currently only forward_inference is
 ///     supported.
@@ -3894,6 +3915,70 @@ zendnn_attention_desc_init(zendnn_attention_desc_t *desc,
                            float scale,
                            uint32_t num_heads,
                            uint32_t num_threads);
+
+/// Initializes a descriptor for an attention primitive in incremental decode
+/// mode. Every call attends a single new token per sequence against a paged,
+/// append-only key/value cache: the projected key/value of the new token are
+/// appended to the cache and the query attends over the cached history plus
+/// the new token. History is never re-projected or reordered.
+///
+/// With E the hidden size, H = E / num_heads the head size and Nkv the number
+/// of key/value heads (from the key/value weights, see
+/// #zendnn_attention_desc_t):
+///  - query, key and value are (B, 1, E), dst is (B, 1, E).
+///  - kv_cache is f32 (num_pages, 2, page_size, Nkv * H). Page p holds the
+///    keys of page_size tokens in [p][0] and their values in [p][1].
+///  - kv_cache_index is s32 (B, 1 + max_pages). Column 0 is the number of
+///    tokens of sequence b already in the cache, columns 1.. the cache page
+///    of every logical page of the sequence. The new token is written at
+///    that position; the caller advances the length after the call.
+///  - mask is (B, max_pages * page_size) over token positions.
+///
+/// @param desc Output descriptor for an attention primitive
+/// @param prop_kind Propagation kind. currently only forward_inference is
+///     supported.
+/// @param alg_kind attention algorithm kind, as for
+///     zendnn_attention_desc_init().
+/// @param query_desc Input memory descriptor.
+/// @param key_desc Input memory descriptor.
+/// @param value_desc Input memory descriptor.
+/// @param weights_query_desc Input memory descriptor.
+/// @param weights_key_desc Input memory descriptor.
+/// @param weights_value_desc Input memory descriptor.
+/// @param bias_query_desc Input memory descriptor.
+/// @param bias_key_desc Input memory descriptor.
+/// @param bias_value_desc Input memory descriptor.
+/// @param mask_desc Input memory descriptor.
+/// @param kv_cache_desc Key/value cache memory descriptor.
+/// @param kv_cache_index_desc Key/value cache index memory descriptor.
+/// @param dst_desc Destination memory descriptor.
+/// @param scale Scale factor. sqrt(head_size) or any custom float.
+/// @param num_heads Number of heads.
+/// @param num_threads Parallel threads for the primitive (zero for default
+///              omp threads)
+/// @returns #zendnn_success on success and a status describing the error
+///     otherwise.
+///
+zendnn_status_t ZENDNN_API
+zendnn_attention_decode_desc_init(zendnn_attention_desc_t *desc,
+                                  zendnn_prop_kind_t prop_kind,
+                                  zendnn_alg_kind_t alg_kind,
+                                  const zendnn_memory_desc_t *query_desc,
+                                  const zendnn_memory_desc_t *key_desc,
+                                  const zendnn_memory_desc_t *value_desc,
+                                  const zendnn_memory_desc_t *weights_query_desc,
+                                  const zendnn_memory_desc_t *weights_key_desc,
+                                  const zendnn_memory_desc_t *weights_value_desc,
+                                  const zendnn_memory_desc_t *bias_query_desc,
+                                  const zendnn_memory_desc_t *bias_key_desc,
+                                  const zendnn_memory_desc_t *bias_value_desc,
+                                  const zendnn_memory_desc_t *mask_desc,
+                                  const zendnn_memory_desc_t *kv_cache_desc,
+                                  const zendnn_memory_desc_t *kv_cache_index_desc,
+                                  const zendnn_memory_desc_t *dst_desc,
+                                  float scale,
+                                  uint32_t num_heads,
+                                  uint32_t num_threads);
 /// @} zendnn_api_attention
 
 /// @} zendnn_api_primitives
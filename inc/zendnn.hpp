@@ -774,6 +774,88 @@ class zendnn_custom_op {
                                      std::vector <int32_t> &z_sparse,
                                      std::vector <memory> &z_destination, int thread_qty=1);
 
+//Embedding table row reordering API. Lookups are heavily skewed in practice,
+//so the most frequent rows are moved to a contiguous hot block at the top of
+//the table that stays cache resident.
+//Adds the lookups of every row in z_indices (s32 or s64) to the s64 counts
+//in z_frequencies, one count per table row.
+    static void zendnn_embedding_row_frequencies(const memory &z_indices,
+            memory &z_frequencies);
+
+//Moves the z_hot_rows most frequent rows of z_frequencies (s64) to the top of
+//z_table, in place, most frequent on top. The rows they displace take the
+//places they leave, the other rows stay, so only about twice the hot block
+//is copied. z_hot_rows <= 0 sizes the hot block to half of an L3 domain.
+//z_remap (s32 or s64, one per row) receives the new row of every row.
+//Returns the number of hot rows.
+    static int64_t zendnn_embedding_reorder_rows(memory &z_table,
+            const memory &z_frequencies, memory &z_remap, int64_t z_hot_rows=0);
+
+//Rewrites z_indices in place to rows of the reordered table through the
+//z_remap of zendnn_embedding_reorder_rows. A padding_idx has to be remapped
+//the same way. Throws when an index is outside the table, the valid indices
+//are remapped.
+    static void zendnn_embedding_remap_indices(const memory &z_remap,
+            memory &z_indices);
+
+//Embedding bag backward op API. Gradient of zendnn_embedding_bag with
+//respect to the f32 table, row sparse: z_grad_indices (s32 or s64) receives
+//the distinct rows looked up, ascending, and z_grad_values (f32, of the table
+//width) their gradient rows. Both need room for every distinct row, at most
+//one per index. The max mode reads z_input to find the row selected in each
+//bag and column. Returns the number of distinct rows.
+    static int64_t zendnn_embedding_bag_backward(const memory &z_input,
+            const memory &z_grad_output, const memory &z_indices,
+            const memory &z_offsets, const bool &z_scale_grad_by_freq,
+            const algorithm &z_mode, const memory &z_per_sample_weights_opt,
+            const bool &z_per_sample_weights_defined,
+            const bool &z_include_last_offset, const int32_t &z_padding_idx,
+            memory &z_grad_indices, memory &z_grad_values);
+
+//Optimizers of zendnn_embedding_bag_update, g is the gradient of a row w
+    enum class embedding_optimizer {
+        sgd,                //w -= lr * g
+        rowwise_adagrad     //s += mean(g * g), w -= lr * g / (sqrt(s) + eps)
+    };
+
+//Fused embedding bag backward and optimizer step. The gradient of every row
+//looked up is accumulated and applied to z_input in place, one row at a
+//time, so no dense or sparse gradient is materialized. z_state holds the f32
+//row-wise Adagrad state, one per table row; it is not used by SGD.
+    static void zendnn_embedding_bag_update(memory &z_input, memory &z_state,
+                                            const memory &z_grad_output, const memory &z_indices,
+                                            const memory &z_offsets, const bool &z_scale_grad_by_freq,
+                                            const algorithm &z_mode, const memory &z_per_sample_weights_opt,
+                                            const bool &z_per_sample_weights_defined,
+                                            const bool &z_include_last_offset, const int32_t &z_padding_idx,
+                                            const embedding_optimizer &z_optimizer, const float &z_learning_rate,
+                                            const float &z_eps=1e-10f);
+
+//Embedding table placement API.
+//Maps the bytes of the file z_path at z_file_offset as the data of z_table,
+//a 2D memory created without a buffer (ZENDNN_MEMORY_NONE), without reading
+//them into memory first. Rows are paged in on their first lookup; writes to
+//the table are not carried to the file.
+    static void zendnn_embedding_table_map(const std::string &z_path,
+                                           memory &z_table, int64_t z_file_offset=0);
+
+//Binds the pages of z_table to NUMA node z_numa_node, moving the pages
+//already present, or interleaves them over all the nodes for z_numa_node < 0.
+//zendnn_grp_embedding_bag runs a bound table on the threads of its node.
+//Rows of a mapped table that are only read stay where the page cache holds
+//them.
+    static void zendnn_embedding_table_place(const memory &z_table,
+            int z_numa_node);
+
+//Binds every table of z_tables to a NUMA node, balancing the table bytes
+//over the nodes.
+    static void zendnn_embedding_tables_shard(const std::vector<memory>
+            &z_tables);
+
+//Unmaps a table of zendnn_embedding_table_map and drops the NUMA node of a
+//placed table. z_table must not be used afterwards if it was mapped.
+    static void zendnn_embedding_table_release(const memory &z_table);
+
 //Group MLP op API
     static void zendnn_grp_mlp(const std::vector<memory> &z_input,
                                const std::vector<memory> &z_weight,
@@ -784,6 +866,8 @@ class zendnn_custom_op {
                                const std::vector<int64_t> &z_fuse,
                                const std::vector<memory> &z_result);
 //Group Embedding_Bag and MLP op API
+//With ZENDNN_EB_MLP_OVERLAP=1 the embedding bags and the MLP run at the same
+//time on disjoint sets of threads, unless an MLP input is an embedding output.
     static void zendnn_grp_ebag_mlp(std::vector <memory> &z_eb_input,
                                     std::vector <memory> &z_eb_indices, std::vector <memory> &z_eb_offsets,
                                     std::vector <int32_t> &z_eb_scale_grad_by_freq,
@@ -803,7 +887,7 @@ class zendnn_custom_op {
                                     const std::vector<int64_t> &z_mm_fuse,
                                     const std::vector<memory> &z_mm_result);
 
-//Group Embedding and MLP op API
+//Group Embedding and MLP op API, overlapped as zendnn_grp_ebag_mlp
     static void zendnn_grp_embedding_mlp(std::vector <memory> &z_embed_input,
                                          std::vector <memory> &z_embed_indices,
                                          std::vector <int32_t> &z_embed_scale_grad_by_freq,
@@ -1379,6 +1463,8 @@ struct memory : public handle<zendnn_memory_t> {
         /// 32-bit signed integer.
         s32 = zendnn_s32,
         s16 = zendnn_s16,
+        /// 64-bit signed integer.
+        s64 = zendnn_s64,
         /// 8-bit signed integer.
         s8 = zendnn_s8,
         /// 8-bit unsigned integer.
@@ -13871,6 +13957,70 @@ struct attention : public primitive {
                                                    num_threads),
                     "could not create an attention descriptor:1");
         }
+
+        /// Constructs a descriptor for an attention primitive in incremental
+        /// decode mode: one new token per sequence attends over a paged,
+        /// append-only key/value cache. See
+        /// zendnn_attention_decode_desc_init() for the cache layout.
+        ///
+        /// @param aprop_kind possible value forward_inference
+        /// @param aalgorithm attention algorithm kind.
+        /// @param query_desc Input memory descriptor, (B, 1, E).
+        /// @param key_desc Input memory descriptor, (B, 1, E).
+        /// @param value_desc Input memory descriptor, (B, 1, E).
+        /// @param weights_query_desc Input memory descriptor.
+        /// @param weights_key_desc Input memory descriptor.
+        /// @param weights_value_desc Input memory descriptor.
+        /// @param bias_query_desc Input memory descriptor.
+        /// @param bias_key_desc Input memory descriptor.
+        /// @param bias_value_desc Input memory descriptor.
+        /// @param mask_desc Input memory descriptor.
+        /// @param kv_cache_desc Key/value cache memory descriptor.
+        /// @param kv_cache_index_desc Key/value cache index memory descriptor.
+        /// @param dst_desc Destination memory descriptor, (B, 1, E).
+        /// @param scale Scale factor. sqrt(head_size) or any custom float.
+        /// @param num_heads Number of heads.
+        /// @param num_threads Parallel threads for the primitive (zero for default
+        ///              omp threads)
+        desc(prop_kind aprop_kind, algorithm aalgorithm,
+             const memory::desc &query_desc,
+             const memory::desc &key_desc,
+             const memory::desc &value_desc,
+             const memory::desc &weights_query_desc,
+             const memory::desc &weights_key_desc,
+             const memory::desc &weights_value_desc,
+             const memory::desc &bias_query_desc,
+             const memory::desc &bias_key_desc,
+             const memory::desc &bias_value_desc,
+             const memory::desc &mask_desc,
+             const memory::desc &kv_cache_desc,
+             const memory::desc &kv_cache_index_desc,
+             const memory::desc &dst_desc,
+             float scale,
+             uint32_t           num_heads,
+             uint32_t           num_threads) {
+             error::wrap_c_api(
+                    zendnn_attention_decode_desc_init(&data,
+                                                   convert_to_c(aprop_kind),
+                                                   convert_to_c(aalgorithm),
+                                                   &query_desc.data,
+                                                   &key_desc.data,
+                                                   &value_desc.data,
+                                                   &weights_query_desc.data,
+                                                   &weights_key_desc.data,
+                                                   &weights_value_desc.data,
+                                                   &bias_query_desc.data,
+                                                   &bias_key_desc.data,
+                                                   &bias_value_desc.data,
+                                                   &mask_desc.data,
+                                                   &kv_cache_desc.data,
+                                                   &kv_cache_index_desc.data,
+                                                   &dst_desc.data,
+                                                   scale,
+                                                   num_heads,
+                                                   num_threads),
+                    "could not create an attention decode descriptor");
+        }
     };
 
     /// Primitive descriptor for an attention primitive.
@@ -111,6 +111,7 @@ enum zenEBThreadType {
     TABLE_THREADED = 2,
     HYBRID_THREADED = 3,
     CCD_THREADED = 4,
+    WORK_THREADED = 5,
 };
 
 //class to read environment variables for zendnnn
@@ -122,13 +123,23 @@ class zendnnEnv {
     uint    zenGEMMalgo;
     uint    zenBF16GEMMalgo;
     uint    zenConvAlgo;
+    uint    zenWinogradTile;
+    uint    zenConvPatchKB;
     uint    zenEnableMemPool;
     uint    zenLibMemPoolEnable;
     uint    zenEnableTFOpts;
     uint    zenEBThreadAlgo;
     uint    zenEBAlgo;
+    uint    zenEBMLPOverlap;
+    uint    zenEBMLPThreads;
+    bool    zenEBMLPBind;
+    int     zenEBPrefetchDistance;
+    bool    zenEBNuma;
     bool    zenINT8format;
     bool    zenWeightCache;
+    uint    zenWeightCacheCapacity;
+    uint    zenWeightCacheKey;
+    uint    zenMatMulPlanCacheCapacity;
   private:
     //initializing ZenDNNEnv values.
     zendnnEnv() {
@@ -179,12 +190,15 @@ class zendnnEnv {
         zenEnableTFOpts = zendnn_getenv_int("TF_ENABLE_ZENDNN_OPTS", 1);
         //TODO: Unified FWK and LIB mempool for next release
         zenLibMemPoolEnable = zendnn_getenv_int("ZENDNN_ENABLE_MEMPOOL", 1);
-        //Enabling different threading implementation.
+        //Enabling different threading implementation for group embedding bag.
+        //WORK_THREADED (default, also used for AUTO_ALGO) balances the
+        //estimated per table work across threads, splitting large tables by
+        //bag range. BATCH, TABLE, HYBRID and CCD_THREADED are overrides.
         zenEBThreadAlgo = zendnn_getenv_int("ZENDNN_EB_THREAD_TYPE",
-                                            zenEBThreadType::TABLE_THREADED);
-        if (zenEBThreadAlgo>zenEBThreadType::CCD_THREADED ||
+                                            zenEBThreadType::WORK_THREADED);
+        if (zenEBThreadAlgo>zenEBThreadType::WORK_THREADED ||
                 zenEBThreadAlgo<zenEBThreadType::AUTO_ALGO) {
-            zenEBThreadAlgo = zenEBThreadType::TABLE_THREADED;
+            zenEBThreadAlgo = zenEBThreadType::WORK_THREADED;
         }
         zenEBAlgo = zendnn_getenv_int("ZENDNN_EB_ALGO",
                                       zenEBAlgoType::EB_OP_ZENDNN);
@@ -192,9 +206,52 @@ class zendnnEnv {
                 zenEBAlgo<zenEBAlgoType::EB_OP_FBGEMM) {
             zenEBAlgo = zenEBAlgoType::EB_OP_ZENDNN;
         }
+        //ZENDNN_EB_MLP_OVERLAP runs the embedding and the MLP of the group
+        //embedding(_bag) MLP ops concurrently on disjoint sets of threads
+        // 0. Sequential (default)
+        // 1. Overlapped
+        zenEBMLPOverlap = zendnn_getenv_int("ZENDNN_EB_MLP_OVERLAP", 0);
+        if (zenEBMLPOverlap > 1) {
+            zenEBMLPOverlap = 0;
+        }
+        //ZENDNN_EB_MLP_THREADS is the share of OMP_NUM_THREADS given to the
+        //embedding side when overlapped, the MLP gets the rest. 0 splits the
+        //threads by the estimated cost of both sides.
+        int ebMLPThreads = zendnn_getenv_int("ZENDNN_EB_MLP_THREADS", 0);
+        zenEBMLPThreads = ebMLPThreads < 0 ? 0 : ebMLPThreads;
+        //ZENDNN_EB_MLP_BIND pins the two sides to disjoint, contiguous ranges
+        //of cores (so to separate CCDs) while overlapped
+        zenEBMLPBind = (bool)zendnn_getenv_int("ZENDNN_EB_MLP_BIND", 1);
+        //ZENDNN_EB_PREFETCH_DISTANCE is the number of lookups the embedding
+        //bag kernels prefetch ahead, 0 disables it. By default (-1) it is
+        //picked from the table and row size.
+        zenEBPrefetchDistance = zendnn_getenv_int("ZENDNN_EB_PREFETCH_DISTANCE",
+                                -1);
+        //ZENDNN_EB_NUMA runs the tables bound to a NUMA node
+        //(zendnn_embedding_table_place) on the threads of that node
+        zenEBNuma = (bool)zendnn_getenv_int("ZENDNN_EB_NUMA", 1);
 
         //ZENDNN_WEIGHT_CACHING is to enable/disable weight caching in MatMul
         zenWeightCache = (bool)zendnn_getenv_int("ZENDNN_WEIGHT_CACHING", 0);
+        //ZENDNN_WEIGHT_CACHE_CAPACITY is the budget(in MB) for reordered
+        //weights cached by MatMul. Least recently used entries are evicted
+        //once it is exceeded. 0 keeps the cache unbounded.
+        int cacheCapacity = zendnn_getenv_int("ZENDNN_WEIGHT_CACHE_CAPACITY", 0);
+        zenWeightCacheCapacity = cacheCapacity < 0 ? 0 : cacheCapacity;
+        //ZENDNN_WEIGHT_CACHE_KEY selects how cached weights are identified
+        // 0. Weight address (default)
+        // 1. Fingerprint of the weight contents, taken on first use of a
+        //    buffer. Call zendnnInvalidateWeights after rewriting it.
+        //Framework supplied ids set with zendnnSetWeightId take precedence.
+        zenWeightCacheKey = zendnn_getenv_int("ZENDNN_WEIGHT_CACHE_KEY", 0);
+        if (zenWeightCacheKey > 1) {
+            zenWeightCacheKey = 0;
+        }
+        //ZENDNN_MATMUL_PLAN_CACHE_CAPACITY is the number of per shape MatMul
+        //execution plans each thread keeps. 0 builds the plan on every call.
+        int planCapacity = zendnn_getenv_int("ZENDNN_MATMUL_PLAN_CACHE_CAPACITY",
+                                             1024);
+        zenMatMulPlanCacheCapacity = planCapacity < 0 ? 0 : planCapacity;
         //ZENDNN_INT8_SUPPORT is to enable/disable INT8 support
         zenINT8format = (bool)zendnn_getenv_int("ZENDNN_INT8_SUPPORT", 0);
         zenConvAlgo = zendnn_getenv_int("ZENDNN_CONV_ALGO",0);
@@ -202,6 +259,20 @@ class zendnnEnv {
                 zenConvAlgo > zenConvAlgoType::DIRECT2) {
             zenConvAlgo = zenConvAlgoType::GEMM;
         }
+        //ZENDNN_WINOGRAD_TILE is the output tile of Winograd 3x3 convolution
+        // 0. Picked from the output size (default): F(4x4,3x3) when the
+        //    output is at least 8x8, F(2x2,3x3) otherwise
+        // 2, 4, 6. F(2x2,3x3), F(4x4,3x3), F(6x6,3x3)
+        //Larger tiles need fewer multiplies but lose more precision.
+        zenWinogradTile = zendnn_getenv_int("ZENDNN_WINOGRAD_TILE", 0);
+        if (zenWinogradTile != 2 && zenWinogradTile != 4 && zenWinogradTile != 6) {
+            zenWinogradTile = 0;
+        }
+        //ZENDNN_CONV_PATCH_KB bounds the block of the im2row patch matrix a
+        //thread builds and multiplies at a time in the GEMM convolution
+        //paths, in KB. 0 uses half of the per core L2 (default).
+        int patchKB = zendnn_getenv_int("ZENDNN_CONV_PATCH_KB", 0);
+        zenConvPatchKB = patchKB < 0 ? 0 : patchKB;
     }
 
     static int zenMatMulDefaultAlgo(const std::string &name) {
@@ -274,10 +345,55 @@ class zendnnOpInfo {
     }
 };
 
+//Counters of the reordered weight cache used by MatMul
+struct zendnnWeightCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t entries;
+    uint64_t bytes;     //bytes currently held by the cache
+    uint64_t capacity;  //byte budget, 0 when unbounded
+};
+
+//Associates a framework owned id with a weight buffer. Cache lookups for the
+//buffer are then keyed on the id instead of the address, so a new tensor
+//reusing a freed address never picks up stale reordered weights.
+void zendnnSetWeightId(const void *weights, uint64_t weight_id);
+//Drops all cached reorders of the given weight buffer. Call it after writing
+//new contents into a buffer MatMul has already used.
+void zendnnInvalidateWeights(const void *weights);
+//Drops all cached reorders
+void zendnnClearWeightCache();
+zendnnWeightCacheStats zendnnGetWeightCacheStats();
+
+//Offline auto tuning. Times every algo of the op for one shape with
+//thread_count threads (best of iterations runs), records the fastest algo
+//in the tuning database and returns it. Returns -1 if the shape is invalid
+//or the op is not part of this build.
+int zendnnTuneMatMul(bool transpose_input, bool transpose_weights, int m,
+                     int k, int n, int lda, int ldb, int ldc, unsigned int thread_count,
+                     unsigned int iterations);
+int zendnnTuneMatMulBF16(bool transpose_input, bool transpose_weights, int m,
+                         int k, int n, int lda, int ldb, int ldc, unsigned int thread_count,
+                         unsigned int iterations);
+//Tunes the u8s8 LPGEMM convolution with s8 (output_s32 false) or s32 output
+int zendnnTuneConvLPGEMM(bool output_s32, int no_of_images, int channels,
+                         int height, int width, int no_of_filter, int kernel_h, int kernel_w,
+                         int pad_t, int pad_l, int pad_b, int pad_r, int stride_h, int stride_w,
+                         unsigned int thread_count, unsigned int iterations);
+//Merges the tuned algos into fname, ZENDNN_MATMUL_MAP_FILE when NULL.
+//Returns 0 on success.
+int zendnnSaveTuningDB(const char *fname);
+
 }
 
 
 zendnn::zendnnEnv readEnv();
+//Limits omp_num_threads returned by readEnv() on the calling thread to
+//num_threads, 0 removes the limit. Used to run ops side by side on parts of
+//the thread budget.
+void zendnnSetThreadBudget(unsigned int num_threads);
+unsigned int zendnnGetThreadBudget();
 
 extern "C" {
 
@@ -833,6 +949,20 @@ extern "C" {
         const float leaky_alpha = 0.0f
     );
 
+    //Rows of a GEMM output tile that gets its post-ops right after the
+    //GEMM, while it is in cache: tiles of row_bytes per row stay within
+    //half of the per core L2, and hold at least one M block of the BLIS
+    //kernels. Every tile is its own GEMM that packs the b_bytes of B again;
+    //rows is returned, one GEMM, when that costs more than the round trip
+    //of the tile's C rows of c_row_bytes. b_bytes is 0 when the tiles do
+    //not re-read B. At least one row, at most rows.
+    int zenPostOpsTileRows(
+        unsigned long row_bytes,
+        unsigned long rows,
+        unsigned long b_bytes = 0,
+        unsigned long c_row_bytes = 0
+    );
+
     void zenClipOp(
         zendnn::zendnnEnv zenEnvObj,
         float *out_layer,
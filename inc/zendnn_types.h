@@ -80,6 +80,8 @@ typedef enum {
     /// 8-bit unsigned integer.
     zendnn_u8 = 6,
     zendnn_s16 = 7,
+    /// 64-bit signed integer, used for embedding indices and offsets.
+    zendnn_s64 = 8,
 } zendnn_data_type_t;
 
 /// Memory format kind
@@ -2633,6 +2635,9 @@ typedef struct {
     ///     #zendnn_multihead_attention, #zendnn_multihead_attention_flash_v1, #zendnn_multihead_attention_flash_v2
     ///     #zendnn_multiquery_attention
     ///     #zendnn_groupedquery_attention
+    /// For multi-query and grouped-query attention the number of key/value
+    /// heads Nkv is given by the key/value weights, (hidden size, Nkv * head
+    /// size). Nkv is 1 for multi-query attention and divides num_heads.
     zendnn_alg_kind_t alg_kind;
 
     /// input memory descriptors.
@@ -2656,6 +2661,11 @@ typedef struct {
     /// Destination memory descriptor.
     zendnn_memory_desc_t dst_desc;
 
+    /// KV cache memory descriptors of incremental decode. Zero for attention
+    /// over the full key/value sequence.
+    zendnn_memory_desc_t kv_cache_desc;
+    zendnn_memory_desc_t kv_cache_index_desc;
+
     /// Algorithm specific parameters.
     float scale; //scale value sqrt(head_size) or anyother custom scales
     uint32_t  num_heads; //number of attention heads
@@ -2904,6 +2914,10 @@ typedef const struct zendnn_primitive *const_zendnn_primitive_t;
 #define ZENDNN_ARG_BIAS_1 42
 #define ZENDNN_ARG_BIAS_2 43
 #define ZENDNN_ARG_MASK 44
+/// Paged key/value cache of attention incremental decode, read and appended.
+#define ZENDNN_ARG_KV_CACHE 45
+/// Page table and cached length per sequence of the attention KV cache.
+#define ZENDNN_ARG_KV_CACHE_INDEX 46
 
 /// Mean values tensor argument.
 #define ZENDNN_ARG_MEAN 49
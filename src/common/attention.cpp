@@ -53,7 +53,11 @@ zendnn_attention_desc_init(attention_desc_t *desc,
                              bias_query_desc, bias_key_desc,
                              bias_value_desc, mask_desc, dst_desc)
                    && (prop_kind == forward_inference)
-                   && one_of(alg_kind, multihead_attention);
+                   && one_of(alg_kind, multihead_attention,
+                             multihead_attention_flash_v1,
+                             multihead_attention_flash_v2,
+                             multiquery_attention,
+                             groupedquery_attention);
     if (!args_ok) {
         return invalid_arguments;
     }
@@ -78,6 +82,9 @@ zendnn_attention_desc_init(attention_desc_t *desc,
     attn.weights_query_desc = *weights_query_desc;
     attn.weights_key_desc   = *weights_key_desc;
     attn.weights_value_desc = *weights_value_desc;
+    attn.bias_query_desc    = *bias_query_desc;
+    attn.bias_key_desc      = *bias_key_desc;
+    attn.bias_value_desc    = *bias_value_desc;
     attn.mask_desc          = *mask_desc;
     attn.dst_desc           = *dst_desc;
     attn.scale              =  scale;
@@ -87,3 +94,57 @@ zendnn_attention_desc_init(attention_desc_t *desc,
     *desc = attn;
     return success;
 }
+
+zendnn_status_t
+zendnn_attention_decode_desc_init(attention_desc_t *desc,
+                                  prop_kind_t prop_kind,
+                                  alg_kind_t alg_kind,
+                                  const zendnn_memory_desc_t *query_desc,
+                                  const zendnn_memory_desc_t *key_desc,
+                                  const zendnn_memory_desc_t *value_desc,
+                                  const zendnn_memory_desc_t *weights_query_desc,
+                                  const zendnn_memory_desc_t *weights_key_desc,
+                                  const zendnn_memory_desc_t *weights_value_desc,
+                                  const zendnn_memory_desc_t *bias_query_desc,
+                                  const zendnn_memory_desc_t *bias_key_desc,
+                                  const zendnn_memory_desc_t *bias_value_desc,
+                                  const zendnn_memory_desc_t *mask_desc,
+                                  const zendnn_memory_desc_t *kv_cache_desc,
+                                  const zendnn_memory_desc_t *kv_cache_index_desc,
+                                  const zendnn_memory_desc_t *dst_desc,
+                                  float scale,
+                                  uint32_t num_heads,
+                                  uint32_t num_threads) {
+
+    if (any_null(kv_cache_desc, kv_cache_index_desc)) {
+        return invalid_arguments;
+    }
+    auto attn = attention_desc_t();
+    zendnn_status_t status = zendnn_attention_desc_init(&attn, prop_kind,
+                             alg_kind, query_desc, key_desc, value_desc, weights_query_desc,
+                             weights_key_desc, weights_value_desc, bias_query_desc, bias_key_desc,
+                             bias_value_desc, mask_desc, dst_desc, scale, num_heads, num_threads);
+    if (status != success) {
+        return status;
+    }
+
+    // one new token per sequence, cache (num_pages, 2, page_size, Nkv*H),
+    // index (B, 1 + max_pages)
+    bool args_ok = query_desc->ndims == 3 && query_desc->dims[1] == 1
+                   && key_desc->ndims == 3 && key_desc->dims[1] == 1
+                   && value_desc->ndims == 3 && value_desc->dims[1] == 1
+                   && kv_cache_desc->ndims == 4 && kv_cache_desc->dims[1] == 2
+                   && kv_cache_index_desc->ndims == 2
+                   && kv_cache_index_desc->dims[0] == query_desc->dims[0]
+                   && kv_cache_index_desc->dims[1] > 1
+                   && kv_cache_index_desc->data_type == data_type::s32;
+    if (!args_ok) {
+        return invalid_arguments;
+    }
+
+    attn.kv_cache_desc       = *kv_cache_desc;
+    attn.kv_cache_index_desc = *kv_cache_index_desc;
+
+    *desc = attn;
+    return success;
+}
@@ -45,7 +45,9 @@ struct attention_pd_t : public primitive_desc_t {
         , bias_key_md_(desc_.bias_key_desc)
         , bias_value_md_(desc_.bias_value_desc)
         , mask_md_(desc_.mask_desc)
-        , dst_md_(desc_.dst_desc) {}
+        , dst_md_(desc_.dst_desc)
+        , kv_cache_md_(desc_.kv_cache_desc)
+        , kv_cache_index_md_(desc_.kv_cache_index_desc) {}
 
     const attention_desc_t *desc() const {
         return &desc_;
@@ -100,6 +102,13 @@ struct attention_pd_t : public primitive_desc_t {
         case ZENDNN_ARG_DST:
             return arg_usage_t::output;
             break;
+        case ZENDNN_ARG_KV_CACHE:
+            // new token is appended to the cache
+            return is_decode() ? arg_usage_t::output : arg_usage_t::unused;
+            break;
+        case ZENDNN_ARG_KV_CACHE_INDEX:
+            return is_decode() ? arg_usage_t::input : arg_usage_t::unused;
+            break;
         default:
             return primitive_desc_t::arg_usage(arg);
         }
@@ -140,6 +149,12 @@ struct attention_pd_t : public primitive_desc_t {
         case ZENDNN_ARG_DST:
             return &dst_md_;
             break;
+        case ZENDNN_ARG_KV_CACHE:
+            return &kv_cache_md_;
+            break;
+        case ZENDNN_ARG_KV_CACHE_INDEX:
+            return &kv_cache_index_md_;
+            break;
         default:
             return primitive_desc_t::arg_md(arg);
         }
@@ -157,6 +172,7 @@ struct attention_pd_t : public primitive_desc_t {
         case ZENDNN_ARG_BIAS_1:
         case ZENDNN_ARG_BIAS_2:
         case ZENDNN_ARG_MASK:
+        case ZENDNN_ARG_KV_CACHE_INDEX:
             return arg_md(index);
         }
 
@@ -164,14 +180,18 @@ struct attention_pd_t : public primitive_desc_t {
     }
 
     const memory_desc_t *dst_md(int index = ZENDNN_ARG_DST) const override {
-        return index == ZENDNN_ARG_DST ? arg_md(index) : &glob_zero_md;
+        return utils::one_of(index, ZENDNN_ARG_DST, ZENDNN_ARG_KV_CACHE)
+               ? arg_md(index) : &glob_zero_md;
     }
 
     /* TODO : Derive n_inputs and return accordingly.
      * This is dependent on attention::desc()
      */
-    int n_inputs() const override { return 10; }
-    int n_outputs() const override { return 1; }
+    int n_inputs() const override { return is_decode() ? 11 : 10; }
+    int n_outputs() const override { return is_decode() ? 2 : 1; }
+
+    // incremental decode against a paged KV cache
+    bool is_decode() const { return desc_.kv_cache_desc.ndims != 0; }
 
   protected:
     attention_desc_t desc_;
@@ -187,6 +207,8 @@ struct attention_pd_t : public primitive_desc_t {
     memory_desc_t bias_value_md_;
     memory_desc_t mask_md_;
     memory_desc_t dst_md_;
+    memory_desc_t kv_cache_md_;
+    memory_desc_t kv_cache_index_md_;
 
     status_t set_default_params() {
         return status::success;
@@ -182,6 +182,7 @@ const data_type_t bf16 = zendnn_bf16;
 const data_type_t f32 = zendnn_f32;
 const data_type_t s32 = zendnn_s32;
 const data_type_t s16 = zendnn_s16;
+const data_type_t s64 = zendnn_s64;
 const data_type_t s8 = zendnn_s8;
 const data_type_t u8 = zendnn_u8;
 } // namespace data_type
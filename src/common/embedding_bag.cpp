@@ -18,6 +18,7 @@
 
 #include "zendnn_helper.hpp"
 #include "c_types_map.hpp"
+#include "embedding_bag_pd.hpp"
 #include "utils.hpp"
 
 using namespace zendnn::impl;
@@ -55,13 +56,12 @@ zendnn_embedding_bag_desc_init(embedding_bag_desc_t *desc,
         return invalid_arguments;
     }
 
-    // currently accept only s32 type indices and offsets
-    // TODO: add support for 64bit integers if zendnn supports them
-    if (indices_desc->data_type != data_type::s32) {
+    // indices and offsets are s32 or s64, both of the same type
+    if (!one_of(indices_desc->data_type, data_type::s32, data_type::s64)) {
         return invalid_arguments;
     }
 
-    if (offsets_desc->data_type != data_type::s32) {
+    if (offsets_desc->data_type != indices_desc->data_type) {
         return invalid_arguments;
     }
 
@@ -70,8 +70,18 @@ zendnn_embedding_bag_desc_init(embedding_bag_desc_t *desc,
     // of embedding_bag_desc_t for scatter_offset
     auto bags           = offsets_desc->dims[0];
     auto embedding_dim  = input_desc->dims[1];
-    if ((dst_desc->dims[0] < (bags-1)*scatter_stride) ||
-            (dst_desc->dims[1] != embedding_dim)) {
+    if (dst_desc->dims[0] < (bags-1)*scatter_stride) {
+        return invalid_arguments;
+    }
+    // u8 tables are row-wise quantized, rows hold the codes of dst dims[1]
+    // columns followed by their scale and bias
+    if (input_desc->data_type == data_type::u8) {
+        if (!embedding_bag_quant_bits(embedding_dim, dst_desc->dims[1]) ||
+                dst_desc->data_type != data_type::f32) {
+            return invalid_arguments;
+        }
+    }
+    else if (dst_desc->dims[1] != embedding_dim) {
         return invalid_arguments;
     }
 
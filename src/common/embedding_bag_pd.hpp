@@ -23,6 +23,24 @@
 namespace zendnn {
 namespace impl {
 
+//Bits per code of a row-wise quantized (u8) embedding table of row_bytes
+//bytes per row and width columns, 0 if the row size matches neither layout.
+//A row holds the codes followed by an fp32 scale and an fp32 bias.
+#define EMB_QUANT_ROW_EXTRA (2 * sizeof(float))
+inline int embedding_bag_quant_bits(dim_t row_bytes, dim_t width) {
+    if (row_bytes == width + (dim_t)EMB_QUANT_ROW_EXTRA) {
+        return 8;
+    }
+    if (row_bytes == (width + 1) / 2 + (dim_t)EMB_QUANT_ROW_EXTRA) {
+        return 4;
+    }
+    return 0;
+}
+
+inline dim_t embedding_bag_quant_code_bytes(int bits, dim_t width) {
+    return bits == 8 ? width : (width + 1) / 2;
+}
+
 /* add new primitive */
 struct embedding_bag_pd_t : public primitive_desc_t {
     static constexpr auto base_pkind = primitive_kind::embedding_bag;
@@ -139,6 +139,8 @@ bool primitive_attr_t::has_default_values(zendnn_primitive_attr::skip_mask_t mas
             (bool)(~mask & (mask_name)), (mask_field).has_default_values()))
     CHECK_MASK(smask_t::oscale, output_scales_);
     CHECK_MASK(smask_t::scales, scales_);
+    // Scales of the other arguments are checked by the primitives taking them
+    CHECK_ARG(scales_.has_default_values({ZENDNN_ARG_SRC_0, ZENDNN_ARG_SRC_1}));
     CHECK_MASK(smask_t::zero_points, zero_points_);
     CHECK_MASK(smask_t::post_ops, post_ops_);
     CHECK_MASK(smask_t::rnn_data_qparams, rnn_data_qparams_);
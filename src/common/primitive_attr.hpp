@@ -232,6 +232,20 @@ struct arg_scales_t : public c_compatible {
         return true;
     }
 
+    // Returns true if all the arguments but skip_args have default scales
+    bool has_default_values(std::initializer_list<int> skip_args) const {
+        for (const auto &s : scales_) {
+            bool skip = false;
+            for (int arg : skip_args) {
+                skip = skip || s.first == arg;
+            }
+            if (!skip && !s.second.has_default_values()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     bool defined() const {
         for (const auto &s : scales_) {
             if (!s.second.defined()) {
@@ -276,9 +290,14 @@ struct arg_scales_t : public c_compatible {
     int get_index_val(int arg) const {
         switch (arg) {
         case ZENDNN_ARG_SRC_0:
+        case ZENDNN_ARG_WEIGHTS_0:
             return 0;
         case ZENDNN_ARG_SRC_1:
+        case ZENDNN_ARG_WEIGHTS_1:
             return 1;
+        case ZENDNN_ARG_SRC_2:
+        case ZENDNN_ARG_WEIGHTS_2:
+            return 2;
         default:
             assert(!"unsupported arg");
         }
@@ -288,9 +307,13 @@ struct arg_scales_t : public c_compatible {
     std::map<int, scales_t> scales_;
 
   private:
+    //SRC_2 and WEIGHTS_0..2 carry the quantization scales of the u8s8
+    //attention projections. Only the attention pd accepts them, the scales
+    //skip mask of has_default_values() covers SRC_0 and SRC_1.
     bool check_arg(int arg) const {
         for (const auto &sa : {
-                    ZENDNN_ARG_SRC_0, ZENDNN_ARG_SRC_1
+                    ZENDNN_ARG_SRC_0, ZENDNN_ARG_SRC_1, ZENDNN_ARG_SRC_2,
+                    ZENDNN_ARG_WEIGHTS_0, ZENDNN_ARG_WEIGHTS_1, ZENDNN_ARG_WEIGHTS_2
                 }) {
             if (arg == sa) {
                 return true;
@@ -728,6 +728,8 @@ size_t get_desc_hash(const attention_desc_t &desc) {
     seed = hash_combine(seed, get_md_hash(desc.bias_value_desc));
     seed = hash_combine(seed, get_md_hash(desc.mask_desc));
     seed = hash_combine(seed, get_md_hash(desc.dst_desc));
+    seed = hash_combine(seed, get_md_hash(desc.kv_cache_desc));
+    seed = hash_combine(seed, get_md_hash(desc.kv_cache_index_desc));
 
     seed = hash_combine(seed, static_cast<size_t>(desc.num_heads));
     seed = hash_combine(seed, static_cast<size_t>(desc.num_threads));
@@ -92,6 +92,7 @@ inline size_t data_type_size(data_type_t data_type) {
         case f32: return sizeof(prec_traits<f32>::type);
         case s32: return sizeof(prec_traits<s32>::type);
         case s16: return sizeof(prec_traits<s16>::type);
+        case s64: return sizeof(prec_traits<s64>::type);
         case s8: return sizeof(prec_traits<s8>::type);
         case u8: return sizeof(prec_traits<u8>::type);
         case data_type::undef:
@@ -164,6 +165,7 @@ inline float get_float_value(data_type_t dt, const void *ptr, dim_t idx) {
         CASE(f32);
         CASE(s32);
         CASE(s16);
+        CASE(s64);
         CASE(s8);
         CASE(u8);
         default: assert(!"bad data_type");
@@ -658,6 +660,8 @@ inline bool operator==(const attention_desc_t &lhs, const attention_desc_t &rhs)
             && COMPARE_DESC_MEMBERS(bias_value_desc)
             && COMPARE_DESC_MEMBERS(mask_desc)
             && COMPARE_DESC_MEMBERS(dst_desc)
+            && COMPARE_DESC_MEMBERS(kv_cache_desc)
+            && COMPARE_DESC_MEMBERS(kv_cache_index_desc)
             && COMPARE_DESC_MEMBERS(scale)
             && COMPARE_DESC_MEMBERS(num_heads)
             && COMPARE_DESC_MEMBERS(num_threads);
@@ -906,7 +910,7 @@ inline bool memory_desc_sanity_check(int ndims, const dims_t dims,
     if (ndims == 0) return true;
 
     bool ok = dims != nullptr && 0 < ndims && ndims <= ZENDNN_MAX_NDIMS
-            && utils::one_of(data_type, f16, bf16, f32, s32, s16, s8, u8);
+            && utils::one_of(data_type, f16, bf16, f32, s32, s16, s64, s8, u8);
     if (!ok) return false;
 
     bool has_runtime_dims = false;
@@ -448,7 +448,9 @@ std::ostream &operator<<(std::ostream &ss, const primitive_attr_t *attr) {
             }
 
             int idx = as.get_index_val(map_entry.first);
-            ss << delim << "src" << idx << ":" << val;
+            const bool is_wei = utils::one_of(map_entry.first, ZENDNN_ARG_WEIGHTS_0,
+                                              ZENDNN_ARG_WEIGHTS_1, ZENDNN_ARG_WEIGHTS_2);
+            ss << delim << (is_wei ? "wei" : "src") << idx << ":" << val;
             delim = attr_delim;
         }
         ss << " ";
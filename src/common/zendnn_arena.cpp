@@ -0,0 +1,337 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <new>
+#ifdef __linux__
+    #include <sched.h>
+    #include <sys/mman.h>
+#endif
+#include "zendnn_helper.hpp"
+#include "zendnn_logging.hpp"
+#include "zendnn_cpu_topology.hpp"
+#include "zendnn_arena.hpp"
+
+//Blocks a thread keeps per arena before it hands them to the node lists
+#define ZENDNN_ARENA_THREAD_BLOCKS  8
+#define ZENDNN_ARENA_PAGE           4096
+
+namespace zendnn {
+
+namespace {
+
+struct block_header {
+    uint64_t arena_id;
+    int cls;
+    int node;
+    std::atomic<int> links;
+    bool mapped;
+    void *base;
+    size_t base_bytes;
+};
+static_assert(sizeof(block_header) <= ZENDNN_ARENA_HEADER_BYTES,
+              "arena block header does not fit");
+
+inline block_header *header_of(void *ptr) {
+    return (block_header *)((char *)ptr - ZENDNN_ARENA_HEADER_BYTES);
+}
+
+void free_block(void *ptr) {
+    block_header *hdr = header_of(ptr);
+#ifdef __linux__
+    if (hdr->mapped) {
+        munmap(hdr->base, hdr->base_bytes);
+        return;
+    }
+#endif
+    free(hdr->base);
+}
+
+//Live arenas by id, for thread caches returning their blocks at thread exit
+std::mutex &registry_mutex() {
+    static std::mutex mtx;
+    return mtx;
+}
+
+std::map<uint64_t, zendnnArena *> &registry() {
+    static std::map<uint64_t, zendnnArena *> arenas;
+    return arenas;
+}
+
+std::atomic<uint64_t> next_arena_id(1);
+
+} //namespace
+
+//Blocks released by this thread, per arena, newest last
+struct zendnnArena::thread_cache {
+    struct entry {
+        uint64_t arena_id;
+        std::vector<void *> blocks;
+    };
+    std::vector<entry> arenas;
+
+    entry &find(uint64_t arena_id) {
+        for (auto &e : arenas) {
+            if (e.arena_id == arena_id) {
+                return e;
+            }
+        }
+        arenas.push_back({arena_id, {}});
+        return arenas.back();
+    }
+
+    //Blocks go back to their arena, or to the system when it is gone
+    ~thread_cache() {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        for (auto &e : arenas) {
+            auto it = registry().find(e.arena_id);
+            for (void *ptr : e.blocks) {
+                if (it != registry().end()) {
+                    it->second->push(ptr);
+                }
+                else {
+                    free_block(ptr);
+                }
+            }
+        }
+    }
+};
+
+zendnnArena::thread_cache &zendnnArena::local_cache() {
+    static thread_local thread_cache cache;
+    return cache;
+}
+
+zendnnArena::zendnnArena(int huge_pages, bool first_touch,
+                         size_t thread_cache_bytes)
+    : id(next_arena_id++), huge_pages(huge_pages), first_touch(first_touch),
+      thread_cache_bytes(thread_cache_bytes), num_nodes(1), in_use(0), peak(0),
+      reserved(0), requests(0), reused(0) {
+    //Nodes are renumbered densely, node ids need not be contiguous
+    const zendnnCpuTopology &topology = zendnnCpuTopology::Instance();
+    std::map<int, int> dense;
+    for (const auto &info : topology.cpus) {
+        dense.insert({info.numa, (int)dense.size()});
+        if (info.cpu >= (int)cpu_node.size()) {
+            cpu_node.resize(info.cpu + 1, 0);
+        }
+        cpu_node[info.cpu] = dense[info.numa];
+    }
+    num_nodes = std::max(1, (int)dense.size());
+    bins.reset(new bin[num_nodes * ZENDNN_ARENA_CLASSES]);
+
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    registry()[id] = this;
+}
+
+zendnnArena::~zendnnArena() {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        registry().erase(id);
+    }
+    trim();
+}
+
+int zendnnArena::size_class(size_t bytes) {
+    if (bytes <= ZENDNN_ARENA_MIN_BYTES) {
+        return 0;
+    }
+    //(MIN << exp) < bytes <= (MIN << (exp + 1)), split in four steps
+    size_t q = (bytes - 1) / ZENDNN_ARENA_MIN_BYTES;
+    int exp = 0;
+    while (q >>= 1) {
+        exp++;
+    }
+    size_t base = (size_t)ZENDNN_ARENA_MIN_BYTES << exp;
+    size_t quarter = base / 4;
+    int step = (int)((bytes - base + quarter - 1) / quarter);
+    int cls = exp * 4 + step;
+    return cls < ZENDNN_ARENA_CLASSES ? cls : -1;
+}
+
+size_t zendnnArena::class_bytes(int cls) {
+    size_t base = (size_t)ZENDNN_ARENA_MIN_BYTES << (cls / 4);
+    return base + (cls % 4) * (base / 4);
+}
+
+int zendnnArena::current_node() const {
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && cpu < (int)cpu_node.size()) {
+        return cpu_node[cpu];
+    }
+#endif
+    return 0;
+}
+
+void zendnnArena::add_in_use(size_t bytes) {
+    size_t now = in_use.fetch_add(bytes) + bytes;
+    size_t high = peak.load();
+    while (now > high && !peak.compare_exchange_weak(high, now)) {
+    }
+}
+
+void *zendnnArena::new_block(int cls, int node) {
+    size_t bytes = ZENDNN_ARENA_HEADER_BYTES + class_bytes(cls);
+    void *base = nullptr;
+    bool mapped = false;
+#ifdef __linux__
+    if (huge_pages && bytes >= ZENDNN_ARENA_HUGE_PAGE) {
+        bytes = (bytes + ZENDNN_ARENA_HUGE_PAGE - 1) / ZENDNN_ARENA_HUGE_PAGE *
+                ZENDNN_ARENA_HUGE_PAGE;
+        if (huge_pages == 2) {
+            base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            base = base == MAP_FAILED ? nullptr : base;
+        }
+        if (!base) {
+            //Huge page aligned range out of a larger mapping
+            size_t span = bytes + ZENDNN_ARENA_HUGE_PAGE;
+            char *raw = (char *)mmap(nullptr, span, PROT_READ | PROT_WRITE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw != MAP_FAILED) {
+                char *aligned = (char *)(((uintptr_t)raw + ZENDNN_ARENA_HUGE_PAGE - 1) &
+                                         ~(uintptr_t)(ZENDNN_ARENA_HUGE_PAGE - 1));
+                if (aligned > raw) {
+                    munmap(raw, aligned - raw);
+                }
+                if (raw + span > aligned + bytes) {
+                    munmap(aligned + bytes, raw + span - (aligned + bytes));
+                }
+                madvise(aligned, bytes, MADV_HUGEPAGE);
+                base = aligned;
+            }
+        }
+        mapped = base != nullptr;
+    }
+#endif
+    if (!base) {
+        base = zendnn_aligned_alloc(ZENDNN_ARENA_HEADER_BYTES, bytes);
+        if (!base) {
+            return nullptr;
+        }
+    }
+    //Pages land on the node of the thread writing them first
+    if (first_touch) {
+        for (size_t off = 0; off < bytes; off += ZENDNN_ARENA_PAGE) {
+            ((volatile char *)base)[off] = 0;
+        }
+    }
+    block_header *hdr = new (base) block_header;
+    hdr->arena_id = id;
+    hdr->cls = cls;
+    hdr->node = node;
+    hdr->mapped = mapped;
+    hdr->base = base;
+    hdr->base_bytes = bytes;
+    reserved += bytes;
+    zendnnInfo(ZENDNN_ALGOLOG, "ARENA: new block of ", class_bytes(cls),
+               " bytes on node ", node, mapped ? " (huge pages)" : "");
+    return (char *)base + ZENDNN_ARENA_HEADER_BYTES;
+}
+
+void *zendnnArena::allocate(size_t bytes, int links) {
+    requests++;
+    int cls = size_class(bytes);
+    if (cls < 0) {
+        return nullptr;
+    }
+    void *ptr = nullptr;
+    if (class_bytes(cls) <= thread_cache_bytes) {
+        auto &blocks = local_cache().find(id).blocks;
+        for (size_t i = blocks.size(); i-- > 0;) {
+            if (header_of(blocks[i])->cls == cls) {
+                ptr = blocks[i];
+                blocks.erase(blocks.begin() + i);
+                break;
+            }
+        }
+    }
+    int node = current_node();
+    if (!ptr) {
+        bin &b = bins[node * ZENDNN_ARENA_CLASSES + cls];
+        std::lock_guard<std::mutex> lock(b.mtx);
+        if (!b.blocks.empty()) {
+            ptr = b.blocks.back();
+            b.blocks.pop_back();
+        }
+    }
+    if (ptr) {
+        reused++;
+    }
+    else {
+        ptr = new_block(cls, node);
+        if (!ptr) {
+            return nullptr;
+        }
+    }
+    header_of(ptr)->links = links;
+    add_in_use(class_bytes(cls));
+    return ptr;
+}
+
+void zendnnArena::push(void *ptr) {
+    block_header *hdr = header_of(ptr);
+    bin &b = bins[hdr->node * ZENDNN_ARENA_CLASSES + hdr->cls];
+    std::lock_guard<std::mutex> lock(b.mtx);
+    b.blocks.push_back(ptr);
+}
+
+bool zendnnArena::release(void *ptr) {
+    block_header *hdr = header_of(ptr);
+    if (--hdr->links > 0) {
+        return false;
+    }
+    in_use -= class_bytes(hdr->cls);
+    if (class_bytes(hdr->cls) <= thread_cache_bytes) {
+        auto &blocks = local_cache().find(id).blocks;
+        if (blocks.size() == ZENDNN_ARENA_THREAD_BLOCKS) {
+            push(blocks.front());
+            blocks.erase(blocks.begin());
+        }
+        blocks.push_back(ptr);
+        return true;
+    }
+    push(ptr);
+    return true;
+}
+
+void zendnnArena::trim() {
+    //Caches of other threads are only returned when those threads exit
+    auto &blocks = local_cache().find(id).blocks;
+    for (void *ptr : blocks) {
+        push(ptr);
+    }
+    blocks.clear();
+    for (int i = 0; i < num_nodes * ZENDNN_ARENA_CLASSES; i++) {
+        std::lock_guard<std::mutex> lock(bins[i].mtx);
+        for (void *ptr : bins[i].blocks) {
+            reserved -= header_of(ptr)->base_bytes;
+            free_block(ptr);
+        }
+        bins[i].blocks.clear();
+    }
+}
+
+zendnnArena::stats_t zendnnArena::stats() const {
+    return {in_use.load(), peak.load(), reserved.load(), requests.load(),
+            reused.load()};
+}
+
+} //namespace zendnn
@@ -0,0 +1,111 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef ZENDNN_ARENA_HPP
+#define ZENDNN_ARENA_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//Size classes: four per power of two, from ZENDNN_ARENA_MIN_BYTES up to
+//ZENDNN_ARENA_MIN_BYTES << (ZENDNN_ARENA_CLASSES / 4)
+#define ZENDNN_ARENA_MIN_BYTES      256
+#define ZENDNN_ARENA_CLASSES        160
+//Every block starts with a header of this size, which keeps the data
+//ALIGNED_OFFSET aligned
+#define ZENDNN_ARENA_HEADER_BYTES   64
+#define ZENDNN_ARENA_HUGE_PAGE      (2UL << 20)
+
+namespace zendnn {
+
+//Scratch buffer arena. Blocks are rounded up to a size class and, once
+//released, kept in a free list of their class for the next request of that
+//class: first in a small cache of the releasing thread, which needs no
+//lock, then in a list per NUMA node and class, each with its own lock.
+//A request takes a block of the caller's node. New blocks are first
+//touched by the caller, so their pages are on the caller's node, and
+//blocks of ZENDNN_ARENA_HUGE_PAGE or more can be backed by huge pages.
+class zendnnArena {
+  public:
+    //Bytes are counted by size class, including the free lists
+    struct stats_t {
+        size_t in_use;      //bytes of blocks handed out
+        size_t peak;        //high water mark of in_use
+        size_t reserved;    //bytes held from the system, in use or free
+        size_t requests;    //allocate calls
+        size_t reused;      //requests served from a free list
+    };
+
+    //huge_pages: 0 none, 1 transparent huge pages (madvise), 2 explicit
+    //  huge pages (MAP_HUGETLB) falling back to transparent ones
+    //first_touch: zero one byte per page of a new block in the caller
+    //thread_cache_bytes: largest block kept in a thread cache
+    zendnnArena(int huge_pages, bool first_touch, size_t thread_cache_bytes);
+    //Frees the blocks in the free lists; blocks still in use are not
+    //returned to the system
+    ~zendnnArena();
+
+    //Block of at least bytes, ALIGNED_OFFSET aligned, nullptr when the
+    //system is out of memory. The block goes back to the arena after links
+    //calls of release, the last one returns true.
+    void *allocate(size_t bytes, int links = 1);
+    bool release(void *ptr);
+    //Returns the blocks in the free lists of all nodes and in the cache of
+    //the calling thread to the system
+    void trim();
+    stats_t stats() const;
+
+    static int size_class(size_t bytes);
+    static size_t class_bytes(int cls);
+
+  private:
+    struct bin {
+        std::mutex mtx;
+        std::vector<void *> blocks;
+    };
+    struct thread_cache;
+
+    void *new_block(int cls, int node);
+    void push(void *ptr);
+    void add_in_use(size_t bytes);
+    int current_node() const;
+    static thread_cache &local_cache();
+
+    //Process wide id, thread caches outlive arenas and find them by id
+    uint64_t id;
+    int huge_pages;
+    bool first_touch;
+    size_t thread_cache_bytes;
+    //Node of every CPU id
+    std::vector<int> cpu_node;
+    int num_nodes;
+    //num_nodes * ZENDNN_ARENA_CLASSES bins, node major
+    std::unique_ptr<bin[]> bins;
+
+    std::atomic<size_t> in_use;
+    std::atomic<size_t> peak;
+    std::atomic<size_t> reserved;
+    std::atomic<size_t> requests;
+    std::atomic<size_t> reused;
+};
+
+} //namespace zendnn
+#endif //ZENDNN_ARENA_HPP
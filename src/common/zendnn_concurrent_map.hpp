@@ -0,0 +1,229 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef ZENDNN_CONCURRENT_MAP_HPP
+#define ZENDNN_CONCURRENT_MAP_HPP
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//Number of independent shards in zenConcurrentMap
+#define ZEN_CONCURRENT_MAP_SHARDS   16
+
+//Sharded hash map with wait-free lookups, used for the MatMul auto tuner maps
+//and the reordered weight cache which are read on every MatMul call from any
+//number of inference threads but written only on a miss.
+//
+//Each shard follows the Left-Right scheme: it keeps two copies of its table.
+//Readers announce themselves on a read indicator and look up the copy that
+//is currently published, without taking any lock. A writer (serialized per
+//shard) modifies the unpublished copy, publishes it, waits for readers still
+//on the old copy to drain and then replays the modification on it.
+//
+//As every modification is applied once to each copy, functors passed to
+//update() must produce the same result when replayed on an equal value.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class zenConcurrentMap {
+    typedef std::unordered_map<Key, Value, Hash> table_t;
+
+    struct alignas(64) read_indicator_t {
+        std::atomic<int> count;
+        read_indicator_t() : count(0) {}
+    };
+
+    struct alignas(64) shard_t {
+        table_t table[2];
+        std::atomic<int> left_right;
+        std::atomic<int> version_index;
+        read_indicator_t readers[2];
+        std::mutex writer_mutex;
+        shard_t() : left_right(0), version_index(0) {}
+    };
+
+    //Read section guard, wait-free
+    class reader_t {
+      public:
+        reader_t(const shard_t &shard) : shard_(shard) {
+            vi_ = shard_.version_index.load();
+            const_cast<shard_t &>(shard_).readers[vi_].count.fetch_add(1);
+        }
+        ~reader_t() {
+            const_cast<shard_t &>(shard_).readers[vi_].count.fetch_sub(1);
+        }
+        const table_t &table() const {
+            return shard_.table[shard_.left_right.load()];
+        }
+      private:
+        const shard_t &shard_;
+        int vi_;
+    };
+
+    static void wait_for_readers(const read_indicator_t &indicator) {
+        while (indicator.count.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    //Applies fn to both copies of the shard table. Caller holds writer_mutex.
+    template <typename F>
+    static void write(shard_t &shard, F fn) {
+        int lr = shard.left_right.load();
+        fn(shard.table[1 - lr]);
+        shard.left_right.store(1 - lr);
+        int prev_vi = shard.version_index.load();
+        int next_vi = 1 - prev_vi;
+        wait_for_readers(shard.readers[next_vi]);
+        shard.version_index.store(next_vi);
+        wait_for_readers(shard.readers[prev_vi]);
+        fn(shard.table[lr]);
+    }
+
+    shard_t &get_shard(const Key &key) {
+        return shards_[Hash()(key) % shards_.size()];
+    }
+    const shard_t &get_shard(const Key &key) const {
+        return shards_[Hash()(key) % shards_.size()];
+    }
+
+    std::vector<shard_t> shards_;
+
+  public:
+    zenConcurrentMap(unsigned int num_shards = ZEN_CONCURRENT_MAP_SHARDS)
+        : shards_(num_shards ? num_shards : 1) {}
+
+    zenConcurrentMap(const zenConcurrentMap &) = delete;
+    zenConcurrentMap &operator=(const zenConcurrentMap &) = delete;
+
+    //Copies the value of key into value. Returns false if key is absent.
+    bool find(const Key &key, Value &value) const {
+        reader_t reader(get_shard(key));
+        const table_t &table = reader.table();
+        auto found_obj = table.find(key);
+        if (found_obj == table.end()) {
+            return false;
+        }
+        value = found_obj->second;
+        return true;
+    }
+
+    bool contains(const Key &key) const {
+        reader_t reader(get_shard(key));
+        const table_t &table = reader.table();
+        return table.find(key) != table.end();
+    }
+
+    //Inserts value if key is absent. Returns false and leaves the map
+    //unchanged if the key already exists.
+    bool insert(const Key &key, const Value &value) {
+        shard_t &shard = get_shard(key);
+        std::lock_guard<std::mutex> lock(shard.writer_mutex);
+        if (shard.table[shard.left_right.load()].count(key)) {
+            return false;
+        }
+        write(shard, [&](table_t &table) {
+            table.emplace(key, value);
+        });
+        return true;
+    }
+
+    void insert_or_assign(const Key &key, const Value &value) {
+        shard_t &shard = get_shard(key);
+        std::lock_guard<std::mutex> lock(shard.writer_mutex);
+        write(shard, [&](table_t &table) {
+            table[key] = value;
+        });
+    }
+
+    //Applies fn(Value &) to the entry of key, inserting init first if the key
+    //is absent.
+    template <typename F>
+    void update(const Key &key, const Value &init, F fn) {
+        shard_t &shard = get_shard(key);
+        std::lock_guard<std::mutex> lock(shard.writer_mutex);
+        write(shard, [&](table_t &table) {
+            auto found_obj = table.find(key);
+            if (found_obj == table.end()) {
+                found_obj = table.emplace(key, init).first;
+            }
+            fn(found_obj->second);
+        });
+    }
+
+    bool erase(const Key &key) {
+        shard_t &shard = get_shard(key);
+        std::lock_guard<std::mutex> lock(shard.writer_mutex);
+        if (!shard.table[shard.left_right.load()].count(key)) {
+            return false;
+        }
+        write(shard, [&](table_t &table) {
+            table.erase(key);
+        });
+        return true;
+    }
+
+    //Erases every entry for which pred(key, value) is true
+    template <typename P>
+    void erase_if(P pred) {
+        for (auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.writer_mutex);
+            write(shard, [&](table_t &table) {
+                for (auto it = table.begin(); it != table.end();) {
+                    if (pred(it->first, it->second)) {
+                        it = table.erase(it);
+                    }
+                    else {
+                        ++it;
+                    }
+                }
+            });
+        }
+    }
+
+    void clear() {
+        for (auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.writer_mutex);
+            write(shard, [](table_t &table) {
+                table.clear();
+            });
+        }
+    }
+
+    //Visits every entry, one shard at a time
+    template <typename F>
+    void for_each(F fn) const {
+        for (const auto &shard : shards_) {
+            reader_t reader(shard);
+            for (const auto &entry : reader.table()) {
+                fn(entry.first, entry.second);
+            }
+        }
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const auto &shard : shards_) {
+            reader_t reader(shard);
+            total += reader.table().size();
+        }
+        return total;
+    }
+};
+
+#endif
@@ -23,10 +23,13 @@
     #include "cblas_with_blis_api.hpp"
 #endif // ZENDNN_USE_AOCL_BLIS_API
 #include <time.h>
+#include <algorithm>
 #include "zendnn_convolution_winograd.hpp"
 #include "common/zendnn_private.hpp"
 #include "zendnn_logging.hpp"
 #include "zendnn_private.hpp"
+#include "zendnn_weight_cache.hpp"
+#include "cpu/platform.hpp"
 #include <unordered_map>
 
 using namespace zendnn;
@@ -46,9 +49,56 @@ using namespace zendnn;
 #define DIRECT_CONV_GEMV        0
 #define WINOGRAD_CONV           1
 
-//Simplified Map having Key as struct and value as Blocked Weight matrix address.
-std::unordered_map<Key_conv, const int8_t * > conv_weight_caching_map;
-std::unordered_map<Key_conv, const int16_t * > conv_weight_caching_map_s16;
+//Output rows of the patch matrix built by im2row and multiplied per block.
+//A block of width_col*rows patches, patch_size floats each, is kept within
+//ZENDNN_CONV_PATCH_KB (half of the per core L2 by default) so the patches
+//are still in cache for the GEMM, and the per thread buffer no longer grows
+//with the image. At least one row, at most max_rows.
+static int zenConvPatchBlockRows(const zendnnEnv &zenEnvObj, int width_col,
+                                 int patch_size, int max_rows) {
+    unsigned long budget = (unsigned long)zenEnvObj.zenConvPatchKB * 1024;
+    if (budget == 0) {
+        budget = zendnn::impl::cpu::platform::get_per_core_cache_size(2) / 2;
+    }
+    unsigned long row_bytes = (unsigned long)width_col * patch_size * sizeof(
+                                  float);
+    int rows = row_bytes ? (int)(budget / row_bytes) : max_rows;
+    return std::max(1, std::min(rows, max_rows));
+}
+
+//Reordered B of an LPGEMM convolution. The buffer is kept in the weight
+//cache under ZENDNN_WEIGHT_CACHE_CAPACITY with the MatMul reorders; a miss
+//allocates reorder_size bytes and fills them with reorder. The caller holds
+//the returned reference for its GEMM, so an eviction meanwhile is safe.
+template <typename T, typename F>
+static std::shared_ptr<T> zenConvReorderedWeights(const Key_conv &key_obj,
+        zenWeightCacheKind kind, size_t reorder_size, F reorder) {
+    Key_matmul key;
+    key.transpose_input = false;
+    key.transpose_weights = false;
+    key.m = key_obj.m;
+    key.k = key_obj.k;
+    key.n = key_obj.n;
+    key.lda = key_obj.lda;
+    key.ldb = key_obj.ldb;
+    key.ldc = key_obj.ldc;
+    key.thread_count = 0;
+    key.weights = key_obj.weights;
+
+    //Filter of channels * kernel_h * kernel_w rows by no_of_filter = ldb
+    zendnnWeightCache &weight_cache = zendnnWeightCache::ZenDNNWeightCache();
+    Key_weight_cache cache_key = weight_cache.getKey(key, kind,
+                                 (size_t)key_obj.k * key_obj.n * sizeof(T));
+    std::shared_ptr<T> b_reorder_buf = weight_cache.find_as<T>(cache_key);
+    if (b_reorder_buf) {
+        return b_reorder_buf;
+    }
+    T *b_reorder = (T *) aligned_alloc(64, reorder_size);
+    reorder(b_reorder);
+    //A concurrent caller that inserted first keeps its buffer
+    return weight_cache.insert_as<T>(cache_key, std::shared_ptr<T>(b_reorder,
+                                     free), reorder_size);
+}
 
 // zenConvolution2Dbase_LPGEMM1x1_u8s8s32os32
 // Modification of zenConvolution2Dbase() to support LPGEMM (u8, s8, s32)
@@ -118,24 +168,21 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s32os32(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map.find(key_obj);
-    if (found_obj == conv_weight_caching_map.end()) {
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_u8s8s32os32(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int8_t> b_reorder_ref = zenConvReorderedWeights<int8_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_U8S8S32, aocl_get_reorder_buf_size_u8s8s32os32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int8_t *b_reorder = (int8_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int8_t *b_reorder) {
         aocl_reorder_u8s8s32os32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int8_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // Check if Bias and ReLU postops are required.
@@ -186,7 +233,7 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s32os32(
     aocl_gemm_u8s8s32os32(storage, transa, transb, images * out_height*out_width,
                           no_of_filter,
                           channels*kernel_h*kernel_w, alpha, in_layer,
-                          lda, mem_format_a, /*filter b_reorder*/ conv_weight_caching_map[key_obj], ldb,
+                          lda, mem_format_a, /*filter b_reorder*/ b_reorder_buf, ldb,
                           mem_format_b, beta, out_layer,
                           ldc, post_ops);
 
@@ -276,25 +323,21 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s32os8(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map.find(key_obj);
-    if (found_obj == conv_weight_caching_map.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_u8s8s32os32(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int8_t> b_reorder_ref = zenConvReorderedWeights<int8_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_U8S8S32, aocl_get_reorder_buf_size_u8s8s32os32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int8_t *b_reorder = (int8_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int8_t *b_reorder) {
         aocl_reorder_u8s8s32os32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int8_t *b_reorder_buf = b_reorder_ref.get();
     /*
     siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_u8s8s32os32(
                                       reorder_param0, reorder_param1, reorder_param2);
@@ -372,7 +415,7 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s32os8(
     aocl_gemm_u8s8s32os8(storage, transa, transb, images * out_height*out_width,
                          no_of_filter,
                          channels*kernel_h*kernel_w, alpha, in_layer,
-                         lda, mem_format_a, /*filter*/ /*b_reorder*/ conv_weight_caching_map[key_obj],
+                         lda, mem_format_a, /*filter*/ /*b_reorder*/ b_reorder_buf,
                          ldb, mem_format_b, beta, out_layer,
                          ldc, post_ops);
 
@@ -454,25 +497,21 @@ void zenConvolution2Dbase_LPGEMM1x1_s8s8s32os32(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map.find(key_obj);
-    if (found_obj == conv_weight_caching_map.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_s8s8s32os32(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int8_t> b_reorder_ref = zenConvReorderedWeights<int8_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_S8S8S32, aocl_get_reorder_buf_size_s8s8s32os32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int8_t *b_reorder = (int8_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int8_t *b_reorder) {
         aocl_reorder_s8s8s32os32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int8_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // Check if Bias and ReLU postops are required.
@@ -529,7 +568,7 @@ void zenConvolution2Dbase_LPGEMM1x1_s8s8s32os32(
     aocl_gemm_s8s8s32os32(storage, transa, transb, images * out_height*out_width,
                           no_of_filter,
                           channels*kernel_h*kernel_w, alpha, in_layer,
-                          lda, mem_format_a, conv_weight_caching_map[key_obj], ldb, mem_format_b, beta,
+                          lda, mem_format_a, b_reorder_buf, ldb, mem_format_b, beta,
                           out_layer,
                           ldc, post_ops);
 
@@ -612,25 +651,21 @@ void zenConvolution2Dbase_LPGEMM1x1_s8s8s32os8(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map.find(key_obj);
-    if (found_obj == conv_weight_caching_map.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_s8s8s32os32(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int8_t> b_reorder_ref = zenConvReorderedWeights<int8_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_S8S8S32, aocl_get_reorder_buf_size_s8s8s32os32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int8_t *b_reorder = (int8_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int8_t *b_reorder) {
         aocl_reorder_s8s8s32os32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int8_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // By default, scale postop is always enabled.
@@ -707,7 +742,7 @@ void zenConvolution2Dbase_LPGEMM1x1_s8s8s32os8(
     aocl_gemm_s8s8s32os8(storage, transa, transb, images * out_height*out_width,
                          no_of_filter,
                          channels*kernel_h*kernel_w, alpha, in_layer,
-                         lda, mem_format_a, conv_weight_caching_map[key_obj], ldb, mem_format_b, beta,
+                         lda, mem_format_a, b_reorder_buf, ldb, mem_format_b, beta,
                          out_layer,
                          ldc, post_ops);
 
@@ -788,25 +823,21 @@ void zenConvolution2Dbase_LPGEMM1x1_s8s8s16os16(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map.find(key_obj);
-    if (found_obj == conv_weight_caching_map.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_s8s8s16os16(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int8_t> b_reorder_ref = zenConvReorderedWeights<int8_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_S8S8S16, aocl_get_reorder_buf_size_s8s8s16os16(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int8_t *b_reorder = (int8_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int8_t *b_reorder) {
         aocl_reorder_s8s8s16os16(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int8_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // Check if Bias and ReLU postops are required.
@@ -863,7 +894,7 @@ void zenConvolution2Dbase_LPGEMM1x1_s8s8s16os16(
     aocl_gemm_s8s8s16os16(storage, transa, transb, images * out_height*out_width,
                           no_of_filter,
                           channels*kernel_h*kernel_w, alpha, in_layer,
-                          lda, mem_format_a, conv_weight_caching_map[key_obj], ldb, mem_format_b, beta,
+                          lda, mem_format_a, b_reorder_buf, ldb, mem_format_b, beta,
                           out_layer,
                           ldc, post_ops);
 
@@ -946,25 +977,21 @@ void zenConvolution2Dbase_LPGEMM1x1_s8s8s16os8(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map.find(key_obj);
-    if (found_obj == conv_weight_caching_map.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_s8s8s16os16(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int8_t> b_reorder_ref = zenConvReorderedWeights<int8_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_S8S8S16, aocl_get_reorder_buf_size_s8s8s16os16(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int8_t *b_reorder = (int8_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int8_t *b_reorder) {
         aocl_reorder_s8s8s16os16(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int8_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // By default, scale postop is always enabled.
@@ -1041,7 +1068,7 @@ void zenConvolution2Dbase_LPGEMM1x1_s8s8s16os8(
     aocl_gemm_s8s8s16os8(storage, transa, transb, images * out_height*out_width,
                          no_of_filter,
                          channels*kernel_h*kernel_w, alpha, in_layer,
-                         lda, mem_format_a, conv_weight_caching_map[key_obj], ldb, mem_format_b, beta,
+                         lda, mem_format_a, b_reorder_buf, ldb, mem_format_b, beta,
                          out_layer,
                          ldc, post_ops);
 
@@ -1127,25 +1154,21 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s16(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map.find(key_obj);
-    if (found_obj == conv_weight_caching_map.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_u8s8s16os16(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int8_t> b_reorder_ref = zenConvReorderedWeights<int8_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_U8S8S16, aocl_get_reorder_buf_size_u8s8s16os16(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int8_t *b_reorder = (int8_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int8_t *b_reorder) {
         aocl_reorder_u8s8s16os16(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int8_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // Check if Bias and ReLU postops are required.
@@ -1195,7 +1218,7 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s16(
     aocl_gemm_u8s8s16os16(storage, transa, transb, images * out_height*out_width,
                           no_of_filter,
                           channels*kernel_h*kernel_w, alpha, in_layer,
-                          lda, mem_format_a, /*filter b_reorder*/conv_weight_caching_map[key_obj], ldb,
+                          lda, mem_format_a, /*filter b_reorder*/b_reorder_buf, ldb,
                           mem_format_b, beta, out_layer,
                           ldc, post_ops);
 
@@ -1283,25 +1306,21 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s16os8(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map.find(key_obj);
-    if (found_obj == conv_weight_caching_map.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_u8s8s16os16(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int8_t> b_reorder_ref = zenConvReorderedWeights<int8_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_U8S8S16, aocl_get_reorder_buf_size_u8s8s16os16(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int8_t *b_reorder = (int8_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int8_t *b_reorder) {
         aocl_reorder_u8s8s16os16(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int8_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // By default, scale postop is always enabled.
@@ -1373,7 +1392,7 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s16os8(
     aocl_gemm_u8s8s16os8(storage, transa, transb, images * out_height*out_width,
                          no_of_filter,
                          channels*kernel_h*kernel_w, alpha, in_layer,
-                         lda, mem_format_a, /*filter b_reorder*/ conv_weight_caching_map[key_obj], ldb,
+                         lda, mem_format_a, /*filter b_reorder*/ b_reorder_buf, ldb,
                          mem_format_b, beta, out_layer,
                          ldc, post_ops);
 
@@ -1463,21 +1482,17 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s16ou8(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map.find(key_obj);
-    if (found_obj == conv_weight_caching_map.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_u8s8s16os16(
-                                          order, trans,
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int8_t *b_reorder = (int8_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int8_t> b_reorder_ref = zenConvReorderedWeights<int8_t>(key_obj,
+                                            WEIGHT_CACHE_CONV_U8S8S16, aocl_get_reorder_buf_size_u8s8s16os16(
+                                                    order, trans,
+                                                    reorder_param0, reorder_param1, reorder_param2),
+    [&](int8_t *b_reorder) {
         aocl_reorder_u8s8s16os16(
             order, trans,
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int8_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // By default, scale postop is always enabled.
@@ -1555,7 +1570,7 @@ void zenConvolution2Dbase_LPGEMM1x1_u8s8s16ou8(
     aocl_gemm_u8s8s16ou8(storage, transa, transb, images * out_height*out_width,
                          no_of_filter,
                          channels*kernel_h*kernel_w, alpha, in_layer,
-                         lda, mem_format_a, conv_weight_caching_map[key_obj], ldb,
+                         lda, mem_format_a, b_reorder_buf, ldb,
                          mem_format_b, beta, out_layer,
                          ldc, post_ops);
 
@@ -1642,25 +1657,21 @@ void zenConvolution2Dbase_LPGEMM1x1_bf16bf16f32of32(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map_s16.find(key_obj);
-    if (found_obj == conv_weight_caching_map_s16.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_bf16bf16f32of32(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int16_t> b_reorder_ref = zenConvReorderedWeights<int16_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_BF16, aocl_get_reorder_buf_size_bf16bf16f32of32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int16_t *b_reorder = (int16_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int16_t *b_reorder) {
         aocl_reorder_bf16bf16f32of32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map_s16[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int16_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // Check if Bias and ReLU postops are required.
@@ -1712,7 +1723,7 @@ void zenConvolution2Dbase_LPGEMM1x1_bf16bf16f32of32(
                               images * out_height*out_width,
                               no_of_filter,
                               channels*kernel_h*kernel_w, alpha, in_layer,
-                              lda, mem_format_a, /*filter b_reorder*/ conv_weight_caching_map_s16[key_obj],
+                              lda, mem_format_a, /*filter b_reorder*/ b_reorder_buf,
                               ldb, mem_format_b, beta, out_layer,
                               ldc, post_ops);
 
@@ -1800,25 +1811,21 @@ void zenConvolution2Dbase_LPGEMM1x1_bf16bf16f32obf16(
     const char order = 'r';
     const char trans = 'n';
 
-    // finds object in map
-    auto found_obj = conv_weight_caching_map_s16.find(key_obj);
-    if (found_obj == conv_weight_caching_map_s16.end()) {
-
-        siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_bf16bf16f32of32(
+    // finds object in the weight cache, reorders on a miss
+    std::shared_ptr<int16_t> b_reorder_ref = zenConvReorderedWeights<int16_t>(key_obj,
+                                         WEIGHT_CACHE_CONV_BF16, aocl_get_reorder_buf_size_bf16bf16f32of32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-                                          order, trans,
+                                                 order, trans,
 #endif
-                                          reorder_param0, reorder_param1, reorder_param2);
-        int16_t *b_reorder = (int16_t *) aligned_alloc(64, b_reorder_buf_siz_req);
+                                                 reorder_param0, reorder_param1, reorder_param2),
+    [&](int16_t *b_reorder) {
         aocl_reorder_bf16bf16f32of32(
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             order, trans,
 #endif
-            'B', filter, b_reorder, channels*kernel_h*kernel_w,
-            no_of_filter, ldb);
-        //Create new entry
-        conv_weight_caching_map_s16[key_obj] = b_reorder;
-    }
+            'B', filter, b_reorder, channels*kernel_h*kernel_w, no_of_filter, ldb);
+    });
+    const int16_t *b_reorder_buf = b_reorder_ref.get();
 
     aocl_post_op *post_ops = NULL;
     // By default, scale postop is always enabled.
@@ -1891,7 +1898,7 @@ void zenConvolution2Dbase_LPGEMM1x1_bf16bf16f32obf16(
                                images * out_height*out_width,
                                no_of_filter,
                                channels*kernel_h*kernel_w, alpha, in_layer,
-                               lda, mem_format_a, /*filter b_reorder*/ conv_weight_caching_map_s16[key_obj],
+                               lda, mem_format_a, /*filter b_reorder*/ b_reorder_buf,
                                ldb, mem_format_b, beta, out_layer,
                                ldc, post_ops);
 
@@ -2404,9 +2411,13 @@ void zenConvolution2DsmallGemmVer2(
     omp_set_max_active_levels(1);
 #endif
 
-    //unsigned int no_of_images = images;
+    //Each thread builds the patch matrix of gemmRows output rows at a time
+    //into its own block and multiplies it before building the next one
+    int gemmRows = (BLIS_SMALL_MATRIX/width_col)?(BLIS_SMALL_MATRIX/width_col):1;
+    gemmRows = zenConvPatchBlockRows(zenEnvObj, width_col,
+                                     kernel_h*kernel_w*channels, std::min(gemmRows, height_col));
     unsigned long data_col_size = ((unsigned long)(kernel_h*kernel_w*channels)*
-                                   (out_height*out_width)*sizeof(float)*thread_qty);
+                                   (gemmRows*width_col)*sizeof(float)*thread_qty);
     data_col_size = (data_col_size%ALIGNED_OFFSET == 0) ?  data_col_size :
                     (data_col_size/ALIGNED_OFFSET)*ALIGNED_OFFSET + (ALIGNED_OFFSET);
     float *data_col = NULL;
@@ -2476,7 +2487,7 @@ void zenConvolution2DsmallGemmVer2(
 
             unsigned long inputOffset = ((unsigned long)channels*height*width*threadOffset);
             unsigned long patchInputOffset = ((unsigned long)(kernel_h*kernel_w*channels)*
-                                              (out_height*out_width) * omp_get_thread_num());
+                                              (gemmRows*width_col) * omp_get_thread_num());
 
             if ((kernel_h == 1 && kernel_w == 1 &&  out_height == height &&
                     out_width == width)) {
@@ -2486,15 +2497,20 @@ void zenConvolution2DsmallGemmVer2(
             unsigned long outputOffset = ((unsigned long)ldc*
                                           (out_height*out_width)* threadOffset);
 
-            int gemmRows = (BLIS_SMALL_MATRIX/width_col)?(BLIS_SMALL_MATRIX/width_col):1;
             int gemmRowsLast = (height_col%gemmRows)==0? gemmRows : (height_col%gemmRows);
             int height_colLoop = (height_col%gemmRows)==0? (height_col/gemmRows) :
                                  (height_col/gemmRows)+1;
 
             for (int k=0; k<height_colLoop; k++) {
                 //im2row is more efficient than im2col with NHWC
-                unsigned long patchHeightOffset = (unsigned long)k*gemmRows*width_col*
-                                                  (kernel_h*kernel_w*channels);
+                //The block is reused for every row block, only 1x1 kernels
+                //read the rows from the input itself
+                unsigned long patchHeightOffset = 0;
+                if ((kernel_h == 1 && kernel_w == 1 &&  out_height == height &&
+                        out_width == width)) {
+                    patchHeightOffset = (unsigned long)k*gemmRows*width_col*
+                                        (kernel_h*kernel_w*channels);
+                }
                 if (k==(height_colLoop-1)) {
                     if (!(kernel_h == 1 && kernel_w == 1 &&  out_height == height &&
                             out_width == width))
@@ -2729,29 +2745,46 @@ void zenConvolution2DGemm1x1Direct(
         //bli_rntm_set_ways(1, 1, blis_num_threads, 1, 1, &blis_obj.rntm);
         bli_setsc(gemm_beta, 0.0, &blis_obj.beta);
 
-        bli_obj_create_with_attached_buffer(blis_obj.dt, gemmRows,
-                                            channels*kernel_h*kernel_w,
-                                            (float *)in_layer+inputOffset, channels*kernel_h*kernel_w, 1, &blis_obj.a);
-        bli_obj_create_with_attached_buffer(blis_obj.dt, channels*kernel_h*kernel_w,
-                                            no_of_filter,
-                                            (void *)filter, no_of_filter, 1, &blis_obj.b);
-        bli_obj_create_with_attached_buffer(blis_obj.dt, gemmRows, no_of_filter,
-                                            out_layer+outputOffset+offset, ldc, 1, &blis_obj.c);
+#endif
+        //With post-ops the rows are multiplied in tiles that fit L2, each tile
+        //gets its post-ops while it is still in cache. Large filters are
+        //multiplied in one GEMM as every tile packs them again.
+        unsigned long tileRows = gemmRows;
+        if (bias || relu || scale || elementwise_input) {
+            unsigned long filterRows = (unsigned long)channels*kernel_h*kernel_w;
+            tileRows = zenPostOpsTileRows((filterRows + no_of_filter)*sizeof(float),
+                                          gemmRows, filterRows*no_of_filter*sizeof(float),
+                                          (unsigned long)no_of_filter*sizeof(float));
+        }
+        for (unsigned long row = 0; row < gemmRows; row += tileRows) {
+            unsigned long rows = std::min(tileRows, gemmRows - row);
+            unsigned long tileInputOffset = inputOffset +
+                                            row*channels*kernel_h*kernel_w;
+            unsigned long tileOutputOffset = outputOffset + row*ldc + offset;
+#if BLIS_EXPERT
+            bli_obj_create_with_attached_buffer(blis_obj.dt, rows,
+                                                channels*kernel_h*kernel_w,
+                                                (float *)in_layer+tileInputOffset, channels*kernel_h*kernel_w, 1, &blis_obj.a);
+            bli_obj_create_with_attached_buffer(blis_obj.dt, channels*kernel_h*kernel_w,
+                                                no_of_filter,
+                                                (void *)filter, no_of_filter, 1, &blis_obj.b);
+            bli_obj_create_with_attached_buffer(blis_obj.dt, rows, no_of_filter,
+                                                out_layer+tileOutputOffset, ldc, 1, &blis_obj.c);
 
-        bli_gemm_ex(&blis_obj.alpha, &blis_obj.a, &blis_obj.b, &blis_obj.beta,
-                    &blis_obj.c, NULL, &blis_obj.rntm);
+            bli_gemm_ex(&blis_obj.alpha, &blis_obj.a, &blis_obj.b, &blis_obj.beta,
+                        &blis_obj.c, NULL, &blis_obj.rntm);
 #else
-        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, gemmRows, no_of_filter,
-                    channels*kernel_h*kernel_w, 1.0f,
-                    in_layer+inputOffset, channels*kernel_h*kernel_w, filter, no_of_filter,
-                    gemm_beta,
-                    out_layer+outputOffset+offset, ldc);
+            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, rows, no_of_filter,
+                        channels*kernel_h*kernel_w, 1.0f,
+                        in_layer+tileInputOffset, channels*kernel_h*kernel_w, filter, no_of_filter,
+                        gemm_beta,
+                        out_layer+tileOutputOffset, ldc);
 #endif
-        unsigned long biasOffset = outputOffset+offset;
-        zenPostOps(zenEnvObj, out_layer, elementwise_input,gemmRows, 1, no_of_filter,
-                   ldc, biasOffset,
-                   bias, relu, 0, scale,
-                   blis_num_threads);
+            zenPostOps(zenEnvObj, out_layer, elementwise_input, rows, 1, no_of_filter,
+                       ldc, tileOutputOffset,
+                       bias, relu, 0, scale,
+                       blis_num_threads);
+        }
     }
 
 #if 0
@@ -3180,32 +3213,45 @@ void zenConvolution2DsmallGemm1x1(
         unsigned int offset = filter_offset;
 
         //printf("M=%ld\tN=%ld\tK=%ld\n", gemmRows, no_of_filter, channels*kernel_h*kernel_w);
+        //With post-ops the rows are multiplied in tiles that fit L2, each tile
+        //gets its post-ops while it is still in cache. Large filters are
+        //multiplied in one GEMM as every tile packs them again.
+        unsigned long tileRows = gemmRows;
+        if (bias || relu || scale || elementwise_input) {
+            unsigned long filterRows = (unsigned long)channels*kernel_h*kernel_w;
+            tileRows = zenPostOpsTileRows((filterRows + no_of_filter)*sizeof(float),
+                                          gemmRows, filterRows*no_of_filter*sizeof(float),
+                                          (unsigned long)no_of_filter*sizeof(float));
+        }
+        for (unsigned long row = 0; row < gemmRows; row += tileRows) {
+            unsigned long rows = std::min(tileRows, gemmRows - row);
+            unsigned long tileInputOffset = inputOffset +
+                                            row*channels*kernel_h*kernel_w;
+            unsigned long tileOutputOffset = outputOffset + row*ldc + offset;
 #if BLIS_EXPERT
-        bli_obj_create_with_attached_buffer(blis_obj.dt, gemmRows,
-                                            channels*kernel_h*kernel_w,
-                                            data_col+inputOffset, channels*kernel_h*kernel_w, 1, &blis_obj.a);
-        bli_obj_create_with_attached_buffer(blis_obj.dt, channels*kernel_h*kernel_w,
-                                            no_of_filter,
-                                            (void *)filter, no_of_filter, 1, &blis_obj.b);
-        bli_obj_create_with_attached_buffer(blis_obj.dt, gemmRows, no_of_filter,
-                                            out_layer+outputOffset+offset, ldc, 1, &blis_obj.c);
+            bli_obj_create_with_attached_buffer(blis_obj.dt, rows,
+                                                channels*kernel_h*kernel_w,
+                                                (float *)data_col+tileInputOffset, channels*kernel_h*kernel_w, 1, &blis_obj.a);
+            bli_obj_create_with_attached_buffer(blis_obj.dt, channels*kernel_h*kernel_w,
+                                                no_of_filter,
+                                                (void *)filter, no_of_filter, 1, &blis_obj.b);
+            bli_obj_create_with_attached_buffer(blis_obj.dt, rows, no_of_filter,
+                                                out_layer+tileOutputOffset, ldc, 1, &blis_obj.c);
 
-        bli_gemm_ex(&blis_obj.alpha, &blis_obj.a, &blis_obj.b, &blis_obj.beta,
-                    &blis_obj.c, NULL, &blis_obj.rntm);
+            bli_gemm_ex(&blis_obj.alpha, &blis_obj.a, &blis_obj.b, &blis_obj.beta,
+                        &blis_obj.c, NULL, &blis_obj.rntm);
 #else
-        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, gemmRows, no_of_filter,
-                    channels*kernel_h*kernel_w, 1.0f,
-                    data_col+inputOffset, channels*kernel_h*kernel_w, filter, no_of_filter,
-                    gemm_beta,
-                    out_layer+outputOffset+offset, ldc);
+            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, rows, no_of_filter,
+                        channels*kernel_h*kernel_w, 1.0f,
+                        data_col+tileInputOffset, channels*kernel_h*kernel_w, filter, no_of_filter,
+                        gemm_beta,
+                        out_layer+tileOutputOffset, ldc);
 #endif
-
-        //Below Bias and activation code can be eliminated if not required
-        unsigned long biasOffset = outputOffset+offset;
-        zenPostOps(zenEnvObj, out_layer, elementwise_input,gemmRows, 1, no_of_filter,
-                   ldc, biasOffset,
-                   bias, relu, 0, scale,
-                   blis_num_threads);
+            zenPostOps(zenEnvObj, out_layer, elementwise_input, rows, 1, no_of_filter,
+                       ldc, tileOutputOffset,
+                       bias, relu, 0, scale,
+                       blis_num_threads);
+        }
     }
 #if 0
     gettimeofday(&end, 0);
@@ -3303,6 +3349,9 @@ void zenConvolution2DsmallGemmSplit(
         merge_height1 = (BLIS_SMALL_MATRIX/height_col)?
                         (BLIS_SMALL_MATRIX/height_col):1;
     }
+    //Wide outputs merge fewer rows, the merged block stays within L2
+    merge_height1 = zenConvPatchBlockRows(zenEnvObj, width_col,
+                                          kernel_h*kernel_w*channels, merge_height1);
 
     unsigned long data_col_size = (((unsigned long)kernel_h*kernel_w*channels *
                                     width_col *
@@ -3396,11 +3445,6 @@ void zenConvolution2DsmallGemmSplit(
             unsigned long inputOffset = ((unsigned long)channels*height*width*threadOffset);
             unsigned long patchInputOffset = (((unsigned long)kernel_h*kernel_w*channels*
                                                width_col*merge_height) * omp_get_thread_num());
-
-            if ((kernel_h == 1 && kernel_w == 1 &&  out_height == height &&
-                    out_width == width)) {
-                patchInputOffset = inputOffset;
-            }
             unsigned long outputOffset = ((unsigned long)ldc*
                                           (out_height*out_width)* threadOffset);
 
@@ -4969,18 +5013,22 @@ void zenConvolution2Dgemm(
         //TODO: Need to support winograd version for ZenInceptionOp. Currenlty if we force winograd
         //version for googlenet variants the accuracy validation will fail.
 
+        //F(4x4,3x3) and F(6x6,3x3) crop their edge tiles, only F(2x2,3x3)
+        //needs an even input
+        int winograd_tile = winograd_tile_size(zenEnvObj, out_height, out_width);
         bool kernelCondition = ((stride_h == 1) && (stride_w == 1) && (kernel_h == 3) &&
-                                (kernel_w == 3) && (height % 2 == 0) && (width % 2 == 0));
+                                (kernel_w == 3) && (winograd_tile != 2 ||
+                                        ((height % 2 == 0) && (width % 2 == 0))));
         bool optimalConvInput = ((height*channels >= CONV_INPUT_SIZE) &&
                                  (height<CONV_INPUT_HEIGHT));
         if (kernelCondition && (concat == false) &&
                 ((zenEnvObj.zenConvAlgo==zenConvAlgoType::WINOGRAD) || optimalConvInput)) {
-            winograd_2x2_3x3(zenEnvObj, in_layer, batchsize, channels, height, width,
-                             filter, no_of_filter, kernel_h, kernel_w,
-                             pad_t, pad_l, pad_b, pad_r,
-                             bias,
-                             out_layer, out_height, out_width,
-                             relu, sum_fused, scale);
+            winograd_3x3(zenEnvObj, winograd_tile, in_layer, batchsize, channels,
+                         height, width, filter, no_of_filter,
+                         pad_t, pad_l, pad_b, pad_r,
+                         bias,
+                         out_layer, out_height, out_width,
+                         relu, sum_fused, scale);
         }
         else
 #endif
@@ -1,5 +1,5 @@
 ﻿/*******************************************************************************
-* Copyright (c) 2019-2023 Advanced Micro Devices, Inc. All rights reserved.
+* Copyright (c) 2019-2024 Advanced Micro Devices, Inc. All rights reserved.
 *
 * Licensed under the Apache License, Version 2.0 (the "License");
 * you may not use this file except in compliance with the License.
@@ -27,6 +27,7 @@
 #include <chrono>
 #include "zendnn_convolution_winograd.hpp"
 #include "zendnn_logging.hpp"
+#include "zendnn_weight_cache.hpp"
 #include <omp.h>
 
 using namespace zendnn;
@@ -332,6 +333,14 @@ void batched_gemm_2x2_3x3(zendnnEnv zenEnvObj, float *transformed_image,
                           const int num_tiles,
                           const int num_channels, const int num_images,
                           float *transformed_filter, const int num_filters, float *out) {
+    batched_gemm_winograd(zenEnvObj, transformed_image, num_tiles, num_channels,
+                          transformed_filter, num_filters, out, 16);
+}
+
+void batched_gemm_winograd(zendnnEnv zenEnvObj, const float *transformed_image,
+                           const int num_tiles, const int num_channels,
+                           const float *transformed_filter, const int num_filters,
+                           float *out, const int num_points) {
 
     /*
       The third step in winograd algorithm is an element-wise multiply accumulate
@@ -349,7 +358,8 @@ void batched_gemm_2x2_3x3(zendnnEnv zenEnvObj, float *transformed_image,
       Observe that this can be extended into a gemm product where the first matrix
       is T * C, with each row being Ti(0,0,0) -> Ti(0,0,num_channels). The second
       matrix is C * K with each column being Ki(0,0,0) -> Ki(0,0,num_channels). There
-      will be 16 such matrix multiplications ( Ti(0,0,c) -> Ti(3,3,c) ).
+      will be num_points (alpha * alpha, 16 for F(2x2,3x3)) such matrix
+      multiplications ( Ti(0,0,c) -> Ti(3,3,c) ).
 
       With some careful manipulation of the parameters for sgemm call, we can avoid
       having to do any explicit data transformation from N*4*4*C to those matrices.
@@ -361,9 +371,9 @@ void batched_gemm_2x2_3x3(zendnnEnv zenEnvObj, float *transformed_image,
     const int m = num_tiles;
     const int k = num_channels;
     const int n = num_filters;
-    const int lda = 16 * num_channels;
-    const int ldb = 16 * num_channels;
-    const int ldc = 16 * num_filters;
+    const int lda = num_points * num_channels;
+    const int ldb = num_points * num_channels;
+    const int ldc = num_points * num_filters;
 
     unsigned int thread_qty = zenEnvObj.omp_num_threads;
 #if BLIS_EXPERT
@@ -382,9 +392,9 @@ void batched_gemm_2x2_3x3(zendnnEnv zenEnvObj, float *transformed_image,
     omp_set_max_active_levels(1);
     #pragma omp parallel for
 #endif
-    for (i = 0; i < 16; i++) {
-        float *image = transformed_image + i * num_channels;
-        float *filter = transformed_filter + i * num_channels;
+    for (i = 0; i < num_points; i++) {
+        float *image = (float *)transformed_image + i * num_channels;
+        float *filter = (float *)transformed_filter + i * num_channels;
         float *output = out + i * num_filters;
 #if BLIS_EXPERT
         if ((thread_qty%blis_num_threads)!=0 && omp_get_num_threads()==(thread_qty-1)) {
@@ -560,6 +570,289 @@ void out_transform_2x2_3x3(zendnnEnv zenEnvObj, float *tiled_input,
 
 }
 
+//Transform matrices of F(m x m, 3 x 3), alpha = m + 2 points. The output of
+//a tile is AT [(G g GT) . (BT d B)] A.
+template <int M>
+struct winograd_matrices;
+
+//Points 0, 1, -1, 2, -2 and infinity
+template <>
+struct winograd_matrices<4> {
+    static constexpr int alpha = 6;
+    static constexpr float BT[6][6] = {
+        {4.0f,  0.0f, -5.0f,  0.0f, 1.0f, 0.0f},
+        {0.0f, -4.0f, -4.0f,  1.0f, 1.0f, 0.0f},
+        {0.0f,  4.0f, -4.0f, -1.0f, 1.0f, 0.0f},
+        {0.0f, -2.0f, -1.0f,  2.0f, 1.0f, 0.0f},
+        {0.0f,  2.0f, -1.0f, -2.0f, 1.0f, 0.0f},
+        {0.0f,  4.0f,  0.0f, -5.0f, 0.0f, 1.0f}
+    };
+    static constexpr float G[6][3] = {
+        { 1.0f / 4.0f,  0.0f,         0.0f},
+        {-1.0f / 6.0f, -1.0f / 6.0f, -1.0f / 6.0f},
+        {-1.0f / 6.0f,  1.0f / 6.0f, -1.0f / 6.0f},
+        { 1.0f / 24.0f, 1.0f / 12.0f, 1.0f / 6.0f},
+        { 1.0f / 24.0f, -1.0f / 12.0f, 1.0f / 6.0f},
+        { 0.0f,         0.0f,         1.0f}
+    };
+    static constexpr float AT[4][6] = {
+        {1.0f,  1.0f,  1.0f, 1.0f,  1.0f, 0.0f},
+        {0.0f,  1.0f, -1.0f, 2.0f, -2.0f, 0.0f},
+        {0.0f,  1.0f,  1.0f, 4.0f,  4.0f, 0.0f},
+        {0.0f,  1.0f, -1.0f, 8.0f, -8.0f, 1.0f}
+    };
+};
+
+//Points 0, 1, -1, 1/2, -1/2, 2, -2 and infinity
+template <>
+struct winograd_matrices<6> {
+    static constexpr int alpha = 8;
+    static constexpr float BT[8][8] = {
+        {1.0f,  0.0f, -5.25f,  0.0f,   5.25f,  0.0f,  -1.0f, 0.0f},
+        {0.0f,  1.0f,  1.0f,  -4.25f, -4.25f,  1.0f,   1.0f, 0.0f},
+        {0.0f, -1.0f,  1.0f,   4.25f, -4.25f, -1.0f,   1.0f, 0.0f},
+        {0.0f,  0.5f,  0.25f, -2.5f,  -1.25f,  2.0f,   1.0f, 0.0f},
+        {0.0f, -0.5f,  0.25f,  2.5f,  -1.25f, -2.0f,   1.0f, 0.0f},
+        {0.0f,  2.0f,  4.0f,  -2.5f,  -5.0f,   0.5f,   1.0f, 0.0f},
+        {0.0f, -2.0f,  4.0f,   2.5f,  -5.0f,  -0.5f,   1.0f, 0.0f},
+        {0.0f, -1.0f,  0.0f,   5.25f,  0.0f,  -5.25f,  0.0f, 1.0f}
+    };
+    static constexpr float G[8][3] = {
+        { 1.0f,          0.0f,          0.0f},
+        {-2.0f / 9.0f,  -2.0f / 9.0f,  -2.0f / 9.0f},
+        {-2.0f / 9.0f,   2.0f / 9.0f,  -2.0f / 9.0f},
+        { 1.0f / 90.0f,  1.0f / 45.0f,  2.0f / 45.0f},
+        { 1.0f / 90.0f, -1.0f / 45.0f,  2.0f / 45.0f},
+        {32.0f / 45.0f, 16.0f / 45.0f,  8.0f / 45.0f},
+        {32.0f / 45.0f, -16.0f / 45.0f, 8.0f / 45.0f},
+        { 0.0f,          0.0f,          1.0f}
+    };
+    static constexpr float AT[6][8] = {
+        {1.0f,  1.0f,  1.0f,  1.0f,   1.0f,  1.0f,         1.0f,         0.0f},
+        {0.0f,  1.0f, -1.0f,  2.0f,  -2.0f,  0.5f,        -0.5f,         0.0f},
+        {0.0f,  1.0f,  1.0f,  4.0f,   4.0f,  0.25f,        0.25f,        0.0f},
+        {0.0f,  1.0f, -1.0f,  8.0f,  -8.0f,  0.125f,      -0.125f,       0.0f},
+        {0.0f,  1.0f,  1.0f, 16.0f,  16.0f,  0.0625f,      0.0625f,      0.0f},
+        {0.0f,  1.0f, -1.0f, 32.0f, -32.0f,  0.03125f,    -0.03125f,     1.0f}
+    };
+};
+
+constexpr float winograd_matrices<4>::BT[6][6];
+constexpr float winograd_matrices<4>::G[6][3];
+constexpr float winograd_matrices<4>::AT[4][6];
+constexpr float winograd_matrices<6>::BT[8][8];
+constexpr float winograd_matrices<6>::G[8][3];
+constexpr float winograd_matrices<6>::AT[6][8];
+
+//Channels transformed together, keeps the tile of a block on the stack
+#define WINOGRAD_CHANNEL_BLOCK  64
+
+template <int M>
+void filter_transform_winograd(const float *filter, const int num_channels,
+                               const int num_filters, float *out) {
+    //filter is HWCN, out is N x alpha x alpha x C: G g GT per channel
+    typedef winograd_matrices<M> W;
+    const int A = W::alpha;
+    const int C = num_channels;
+    const int K = num_filters;
+    const int FW = 3;
+
+    #pragma omp parallel for
+    for (int k = 0; k < K; k++) {
+        float *V = out + (unsigned long)k * A * A * C;
+        for (int c = 0; c < C; c++) {
+            float g[3][3], Gg[A][3];
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++) {
+                    g[i][j] = AT_HWCN(filter, FW, C, K, i, j, c, k);
+                }
+            for (int a = 0; a < A; a++)
+                for (int j = 0; j < 3; j++) {
+                    Gg[a][j] = W::G[a][0] * g[0][j] + W::G[a][1] * g[1][j] +
+                               W::G[a][2] * g[2][j];
+                }
+            for (int a = 0; a < A; a++)
+                for (int b = 0; b < A; b++) {
+                    AT(V, C, A, a, b, c) = Gg[a][0] * W::G[b][0] +
+                                           Gg[a][1] * W::G[b][1] + Gg[a][2] * W::G[b][2];
+                }
+        }
+    }
+}
+
+template <int M>
+void input_transform_winograd(const float *input, const int batch_size,
+                              const int height, const int width, const int num_channels,
+                              const int pad_t, const int pad_l, float *out,
+                              const int output_height, const int output_width) {
+    //input is NHWC. Tile (th, tw) reads the alpha x alpha window at
+    //(th * M - pad_t, tw * M - pad_l), zero outside of the image, and
+    //stores BT d B
+    typedef winograd_matrices<M> W;
+    const int A = W::alpha;
+    const int C = num_channels;
+    const int tiles_h = (output_height + M - 1) / M;
+    const int tiles_w = (output_width + M - 1) / M;
+
+    #pragma omp parallel for collapse(3)
+    for (int n = 0; n < batch_size; n++) {
+        for (int th = 0; th < tiles_h; th++) {
+            for (int tw = 0; tw < tiles_w; tw++) {
+                float x[A][A][WINOGRAD_CHANNEL_BLOCK];
+                float BTx[A][A][WINOGRAD_CHANNEL_BLOCK];
+                const int h0 = th * M - pad_t;
+                const int w0 = tw * M - pad_l;
+                unsigned long t = ((unsigned long)n * tiles_h + th) * tiles_w + tw;
+                const float *TI = input + (unsigned long)n * height * width * C;
+                float *U = out + t * A * A * C;
+
+                for (int cb = 0; cb < C; cb += WINOGRAD_CHANNEL_BLOCK) {
+                    const int cn = std::min(WINOGRAD_CHANNEL_BLOCK, C - cb);
+                    for (int i = 0; i < A; i++) {
+                        for (int j = 0; j < A; j++) {
+                            const int hi = h0 + i, wj = w0 + j;
+                            if (hi < 0 || hi >= height || wj < 0 || wj >= width) {
+                                for (int c = 0; c < cn; c++) {
+                                    x[i][j][c] = 0.0f;
+                                }
+                                continue;
+                            }
+                            const float *src = &AT(TI, C, width, hi, wj, cb);
+                            for (int c = 0; c < cn; c++) {
+                                x[i][j][c] = src[c];
+                            }
+                        }
+                    }
+                    //BT d, then (BT d) B, zero coefficients skipped
+                    for (int a = 0; a < A; a++) {
+                        for (int j = 0; j < A; j++) {
+                            for (int c = 0; c < cn; c++) {
+                                BTx[a][j][c] = 0.0f;
+                            }
+                            for (int i = 0; i < A; i++) {
+                                const float coef = W::BT[a][i];
+                                if (coef == 0.0f) {
+                                    continue;
+                                }
+                                for (int c = 0; c < cn; c++) {
+                                    BTx[a][j][c] += coef * x[i][j][c];
+                                }
+                            }
+                        }
+                    }
+                    for (int a = 0; a < A; a++) {
+                        for (int b = 0; b < A; b++) {
+                            float *dst = &AT(U, C, A, a, b, cb);
+                            for (int c = 0; c < cn; c++) {
+                                dst[c] = 0.0f;
+                            }
+                            for (int j = 0; j < A; j++) {
+                                const float coef = W::BT[b][j];
+                                if (coef == 0.0f) {
+                                    continue;
+                                }
+                                for (int c = 0; c < cn; c++) {
+                                    dst[c] += coef * BTx[a][j][c];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <int M>
+void out_transform_winograd(const float *tiled_input, const int num_channels,
+                            float *out, const int batch_size, const int output_height,
+                            const int output_width, const bool sum_fused) {
+    //tiled_input is the gemm output, tiles x alpha x alpha x K. Every tile
+    //is reduced to AT m A and scattered to the NHWC output, cropped at the
+    //right and bottom edges
+    typedef winograd_matrices<M> W;
+    const int A = W::alpha;
+    const int C = num_channels;
+    const int tiles_h = (output_height + M - 1) / M;
+    const int tiles_w = (output_width + M - 1) / M;
+
+    #pragma omp parallel for collapse(3)
+    for (int n = 0; n < batch_size; n++) {
+        for (int th = 0; th < tiles_h; th++) {
+            for (int tw = 0; tw < tiles_w; tw++) {
+                float ATm[M][A][WINOGRAD_CHANNEL_BLOCK];
+                unsigned long t = ((unsigned long)n * tiles_h + th) * tiles_w + tw;
+                const float *I = tiled_input + t * A * A * C;
+                float *O = out + (unsigned long)n * output_height * output_width * C;
+                const int rows = std::min(M, output_height - th * M);
+                const int cols = std::min(M, output_width - tw * M);
+
+                for (int cb = 0; cb < C; cb += WINOGRAD_CHANNEL_BLOCK) {
+                    const int cn = std::min(WINOGRAD_CHANNEL_BLOCK, C - cb);
+                    for (int r = 0; r < M; r++) {
+                        for (int j = 0; j < A; j++) {
+                            for (int c = 0; c < cn; c++) {
+                                ATm[r][j][c] = 0.0f;
+                            }
+                            for (int i = 0; i < A; i++) {
+                                const float coef = W::AT[r][i];
+                                if (coef == 0.0f) {
+                                    continue;
+                                }
+                                const float *src = &AT(I, C, A, i, j, cb);
+                                for (int c = 0; c < cn; c++) {
+                                    ATm[r][j][c] += coef * src[c];
+                                }
+                            }
+                        }
+                    }
+                    for (int r = 0; r < rows; r++) {
+                        for (int s = 0; s < cols; s++) {
+                            float y[WINOGRAD_CHANNEL_BLOCK];
+                            for (int c = 0; c < cn; c++) {
+                                y[c] = 0.0f;
+                            }
+                            for (int j = 0; j < A; j++) {
+                                const float coef = W::AT[s][j];
+                                if (coef == 0.0f) {
+                                    continue;
+                                }
+                                for (int c = 0; c < cn; c++) {
+                                    y[c] += coef * ATm[r][j][c];
+                                }
+                            }
+                            float *dst = &AT(O, C, output_width, (th * M + r), (tw * M + s), cb);
+                            if (sum_fused) {
+                                for (int c = 0; c < cn; c++) {
+                                    dst[c] += y[c];
+                                }
+                            }
+                            else {
+                                for (int c = 0; c < cn; c++) {
+                                    dst[c] = y[c];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template void filter_transform_winograd<4>(const float *, const int,
+        const int, float *);
+template void filter_transform_winograd<6>(const float *, const int,
+        const int, float *);
+template void input_transform_winograd<4>(const float *, const int, const int,
+        const int, const int, const int, const int, float *, const int, const int);
+template void input_transform_winograd<6>(const float *, const int, const int,
+        const int, const int, const int, const int, float *, const int, const int);
+template void out_transform_winograd<4>(const float *, const int, float *,
+                                        const int, const int, const int, const bool);
+template void out_transform_winograd<6>(const float *, const int, float *,
+                                        const int, const int, const int, const bool);
+
 void post_conv_transform(const int batch_size, const int output_height,
                          const int output_width, const int num_channels,
                          float *out,
@@ -609,8 +902,40 @@ void post_conv_transform(const int batch_size, const int output_height,
     }
 }
 
-void winograd_2x2_3x3(
+int winograd_tile_size(const zendnnEnv &zenEnvObj, const int out_height,
+                       const int out_width) {
+    if (zenEnvObj.zenWinogradTile) {
+        return zenEnvObj.zenWinogradTile;
+    }
+    return (out_height >= 8 && out_width >= 8) ? 4 : 2;
+}
+
+//Tile buffer for one call: from the library memory pool when it is enabled
+//and has a free buffer, else allocated. Returns true when allocated.
+static bool winograd_acquire(ZenLibMemoryPool *zenLibPoolBuffer,
+                             float **buffer, unsigned long size) {
+    if (zenLibPoolBuffer &&
+            !zenLibPoolBuffer->acquireZenLibPoolBuf(buffer, size, 1)) {
+        return false;
+    }
+    size = (size + ALIGNED_OFFSET - 1) / ALIGNED_OFFSET * ALIGNED_OFFSET;
+    *buffer = (float *)zendnn_aligned_alloc(ALIGNED_OFFSET, size);
+    return true;
+}
+
+static void winograd_release(ZenLibMemoryPool *zenLibPoolBuffer,
+                             float *buffer, bool allocated) {
+    if (allocated) {
+        free(buffer);
+    }
+    else if (buffer) {
+        zenLibPoolBuffer->zenLibMemPoolFree(buffer);
+    }
+}
+
+void winograd_3x3(
     zendnnEnv zenEnvObj,
+    const int tile,
     const float *in_layer,
     const int num_images,
     const int num_channels,
@@ -618,8 +943,6 @@ void winograd_2x2_3x3(
     const int width,
     const float *filter,
     const int num_filters,
-    const int kernel_h,
-    const int kernel_w,
     const int pad_t,
     const int pad_l,
     const int pad_b,
@@ -632,173 +955,144 @@ void winograd_2x2_3x3(
     const bool sum_fused,
     const float *scale
 ) {
-    assert((kernel_h == 3) && (kernel_w == 3) &&
-           "Winograd kernel called for non 3x3 filter");
+    assert((tile == 2 || tile == 4 || tile == 6) &&
+           "Winograd kernel called for an unsupported tile");
 
+    const int alpha = tile + 2;
+    const int num_points = alpha * alpha;
     // number of tiles
-    const int P = num_images * std::ceil(out_height * 0.5) * std::ceil(
-                      out_width * 0.5);
-
-    static unsigned long MAX_IMAGE_TILES = (unsigned long)(P+1) * 4 * 4 *
-                                           num_channels; // initialization happens only once
-    static unsigned long MAX_FILTER_TILES = (unsigned long)(
-            num_filters+1) * 4 * 4 * num_channels;
-    static unsigned long MAX_OUTPUT_TILES = (unsigned long)(
-            P+1) * 4 * 4 * num_filters;
+    const int P = num_images * ((out_height + tile - 1) / tile) *
+                  ((out_width + tile - 1) / tile);
 
-    unsigned long current_image_tiles = (unsigned long)(P+1) * 4 * 4 * num_channels;
-    unsigned long current_filter_tiles = (unsigned long)(num_filters+1) * 4 * 4 *
-                                         num_channels;
-    unsigned long current_output_tiles = (unsigned long)(P+1) * 4 * 4 * num_filters;
-
-    float *transformed_image = NULL;
-    float *transformed_filter = NULL;
-    float *gemm_output = NULL;
-
-    //Below flags stores the status of buffer allocated through non-mempool allocation(i.e. malloc)
-    bool image_flag = false;
-    bool filter_flag = false;
-    bool output_flag = false;
-
-    int zenLibPoolEnable = zenEnvObj.zenLibMemPoolEnable;
-    ZenLibMemoryPool *zenLibPoolBuffer;
+    unsigned long current_image_tiles = (unsigned long)(P+1) * num_points *
+                                        num_channels;
+    unsigned long current_filter_tiles = (unsigned long)num_filters *
+                                         num_points * num_channels;
+    unsigned long current_output_tiles = (unsigned long)(P+1) * num_points *
+                                         num_filters;
 
     //ZenLibMemPool Optimization reuse tmp buffers from the pool. By default
     //  its enabled, export ZENDNN_ENABLE_MEMPOOL=0 will disable memory
     //  pool optimization
     //  Cases where buffers in pool are not free or requested size is more
-    //  than available buffer size in Pool, control will fall back to
-    //  default way of allocation
-    if (zenLibPoolEnable) {
-        zenLibPoolBuffer = ZenLibMemoryPool::getZenLibMemPool(0);
-        if (zenLibPoolBuffer) {
-
-            int status = zenLibPoolBuffer->acquireZenLibPoolBuf(&transformed_image,
-                         current_image_tiles * sizeof(float),
-                         1);
-            if (status) {
-                transformed_image = (float *)malloc(current_image_tiles * sizeof(
-                                                        float));
-                image_flag = true;
-            }
-            status = zenLibPoolBuffer->acquireZenLibPoolBuf(&transformed_filter,
-                     current_filter_tiles * sizeof(float),
-                     1);
-            if (status) {
-                transformed_filter = (float *)malloc(current_filter_tiles * sizeof(
-                        float));
-                filter_flag = true;
-            }
-            status = zenLibPoolBuffer->acquireZenLibPoolBuf(&gemm_output,
-                     current_output_tiles * sizeof(float),
-                     1);
-            if (status) {
-                gemm_output = (float *)malloc(current_output_tiles * sizeof(
-                                                  float));
-                output_flag = true;
-            }
-            if (!transformed_image || !transformed_filter || !gemm_output) {
-                zendnnError(ZENDNN_ALGOLOG,
-                            "winograd_2x2_3x3 Memory Error while allocating transformed_image or transformed_filter or gemm_output");
+    //  than available buffer size in Pool, buffers are allocated for the call
+    ZenLibMemoryPool *zenLibPoolBuffer = zenEnvObj.zenLibMemPoolEnable ?
+                                         ZenLibMemoryPool::getZenLibMemPool(0) : NULL;
 
-                if (transformed_image) {
-                    free(transformed_image);
-                }
-                if (transformed_filter) {
-                    free(transformed_filter);
-                }
-                if (gemm_output) {
-                    free(gemm_output);
-                }
-                assert(0);
-            }
-        }
-        else {
-            zenLibPoolEnable = false;
-        }
+    float *transformed_image = NULL;
+    float *gemm_output = NULL;
+    bool image_flag = winograd_acquire(zenLibPoolBuffer, &transformed_image,
+                                       current_image_tiles * sizeof(float));
+    bool output_flag = winograd_acquire(zenLibPoolBuffer, &gemm_output,
+                                        current_output_tiles * sizeof(float));
+
+    //Transformed filters depend only on the weights and the tile, a cached
+    //one is reused as long as the weights are
+    Key_matmul key_obj = Key_matmul();
+    key_obj.m = tile;
+    key_obj.k = num_channels;
+    key_obj.n = num_filters;
+    key_obj.weights = filter;
+    zendnnWeightCache &weight_cache = zendnnWeightCache::ZenDNNWeightCache();
+    Key_weight_cache cache_key = weight_cache.getKey(key_obj,
+                                 WEIGHT_CACHE_WINOGRAD_F32,
+                                 (size_t)9 * num_channels * num_filters * sizeof(float));
+    std::shared_ptr<float> filter_buf;
+    if (zenEnvObj.zenWeightCache) {
+        filter_buf = weight_cache.find_as<float>(cache_key);
     }
-    if (!zenLibPoolEnable) {
-
-        static float *tmp_image = (float *)malloc(MAX_IMAGE_TILES * sizeof(
-                                      float));
-        static float *tmp_filter = (float *)malloc(MAX_FILTER_TILES * sizeof(
-                                       float));
-        static float *tmp_gemm_output = (float *)malloc(MAX_OUTPUT_TILES * sizeof(
-                                            float));
-
-        // check if current layer requires more memory
-        // if it does, realloc
-        if (current_image_tiles > MAX_IMAGE_TILES) {
-            MAX_IMAGE_TILES = current_image_tiles;
-            tmp_image = (float *)realloc(tmp_image,
-                                         MAX_IMAGE_TILES * sizeof(float));
-        }
-        if (current_filter_tiles > MAX_FILTER_TILES) {
-            MAX_FILTER_TILES = current_filter_tiles;
-            tmp_filter = (float *)realloc(tmp_filter,
-                                          MAX_FILTER_TILES * sizeof(float));
-        }
-        if (current_output_tiles > MAX_OUTPUT_TILES) {
-            MAX_OUTPUT_TILES = current_output_tiles;
-            tmp_gemm_output = (float *)realloc(tmp_gemm_output,
-                                               MAX_OUTPUT_TILES * sizeof(float));
-        }
 
-        if (!tmp_image || !tmp_filter || !tmp_gemm_output) {
-            zendnnError(ZENDNN_ALGOLOG,
-                        "winograd_2x2_3x3 Memory Error while allocating transformed_image or transformed_filter or gemm_output");
+    if (!transformed_image || !gemm_output) {
+        zendnnError(ZENDNN_ALGOLOG,
+                    "winograd_3x3 Memory Error while allocating transformed_image or gemm_output");
+        winograd_release(zenLibPoolBuffer, transformed_image, image_flag);
+        winograd_release(zenLibPoolBuffer, gemm_output, output_flag);
+        assert(0);
+        return;
+    }
 
-            if (tmp_image) {
-                free(tmp_image);
-            }
-            if (tmp_filter) {
-                free(tmp_filter);
-            }
-            if (tmp_gemm_output) {
-                free(tmp_gemm_output);
-            }
+    int d1 = 0, d2, d3, d4;
+    auto start = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<float> duration;
+    std::chrono::milliseconds duration_ms;
+    if (!filter_buf) {
+        unsigned long filter_bytes = current_filter_tiles * sizeof(float);
+        filter_bytes = (filter_bytes + ALIGNED_OFFSET - 1) / ALIGNED_OFFSET *
+                       ALIGNED_OFFSET;
+        float *transformed_filter = (float *)zendnn_aligned_alloc(ALIGNED_OFFSET,
+                                    filter_bytes);
+        if (!transformed_filter) {
+            zendnnError(ZENDNN_ALGOLOG,
+                        "winograd_3x3 Memory Error while allocating transformed_filter");
+            winograd_release(zenLibPoolBuffer, transformed_image, image_flag);
+            winograd_release(zenLibPoolBuffer, gemm_output, output_flag);
             assert(0);
+            return;
+        }
+        if (tile == 2) {
+            filter_transform_2x2_3x3(zenEnvObj, filter, num_channels, num_filters,
+                                     transformed_filter);
+        }
+        else if (tile == 4) {
+            filter_transform_winograd<4>(filter, num_channels, num_filters,
+                                         transformed_filter);
         }
         else {
-            transformed_image = tmp_image;
-            transformed_filter = tmp_filter;
-            gemm_output = tmp_gemm_output;
+            filter_transform_winograd<6>(filter, num_channels, num_filters,
+                                         transformed_filter);
+        }
+        filter_buf = std::shared_ptr<float>(transformed_filter, free);
+        if (zenEnvObj.zenWeightCache) {
+            filter_buf = weight_cache.insert_as<float>(cache_key, filter_buf,
+                         filter_bytes);
         }
+        auto end = std::chrono::high_resolution_clock::now();
+        duration = end - start;
+        duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+        d1 = duration_ms.count();
     }
 
-
-    int d1,d2,d3,d4;
-    auto start = std::chrono::high_resolution_clock::now();
-    filter_transform_2x2_3x3(zenEnvObj, filter, num_channels, num_filters,
-                             transformed_filter);
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<float> duration = end - start;
-    auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>
-                       (duration);
-    d1 = duration_ms.count();
-
     start = std::chrono::high_resolution_clock::now();
-    input_transform_2x2_3x3(zenEnvObj, in_layer, num_images, height, width,
-                            num_channels,
-                            pad_t, pad_l, pad_b, pad_r,
-                            transformed_image, P, out_height, out_width);
-    end = std::chrono::high_resolution_clock::now();
+    if (tile == 2) {
+        input_transform_2x2_3x3(zenEnvObj, in_layer, num_images, height, width,
+                                num_channels,
+                                pad_t, pad_l, pad_b, pad_r,
+                                transformed_image, P, out_height, out_width);
+    }
+    else if (tile == 4) {
+        input_transform_winograd<4>(in_layer, num_images, height, width,
+                                    num_channels, pad_t, pad_l, transformed_image, out_height, out_width);
+    }
+    else {
+        input_transform_winograd<6>(in_layer, num_images, height, width,
+                                    num_channels, pad_t, pad_l, transformed_image, out_height, out_width);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
     duration = end - start;
     duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
     d2 = duration_ms.count();
 
     start = std::chrono::high_resolution_clock::now();
-    batched_gemm_2x2_3x3(zenEnvObj, transformed_image, P, num_channels, num_images,
-                         transformed_filter, num_filters, gemm_output);
+    batched_gemm_winograd(zenEnvObj, transformed_image, P, num_channels,
+                          filter_buf.get(), num_filters, gemm_output, num_points);
     end = std::chrono::high_resolution_clock::now();
     duration = end - start;
     duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
     d3 = duration_ms.count();
 
     start = std::chrono::high_resolution_clock::now();
-
-    out_transform_2x2_3x3(zenEnvObj, gemm_output, P, num_filters,
-                          out_layer, num_images, out_height, out_width, sum_fused);
+    if (tile == 2) {
+        out_transform_2x2_3x3(zenEnvObj, gemm_output, P, num_filters,
+                              out_layer, num_images, out_height, out_width, sum_fused);
+    }
+    else if (tile == 4) {
+        out_transform_winograd<4>(gemm_output, num_filters, out_layer, num_images,
+                                  out_height, out_width, sum_fused);
+    }
+    else {
+        out_transform_winograd<6>(gemm_output, num_filters, out_layer, num_images,
+                                  out_height, out_width, sum_fused);
+    }
 
     post_conv_transform(num_images, out_height, out_width, num_filters,
                         out_layer,
@@ -808,11 +1102,11 @@ void winograd_2x2_3x3(
     duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
     d4 = duration_ms.count();
 
-    int total = d1+d2+d3+d4;
+    int total = std::max(d1+d2+d3+d4, 1);
 
-    zendnnVerbose(ZENDNN_ALGOLOG, "winograd_2x2_3x3, no_of_images=", num_images,
-               " channels=", num_channels, " height=", height, " width=", width,
-               " no_of_filter=", num_filters, " kernel_h=", kernel_h, " kernel_w=", kernel_w,
+    zendnnVerbose(ZENDNN_ALGOLOG, "winograd_", tile, "x", tile, "_3x3, no_of_images=",
+               num_images, " channels=", num_channels, " height=", height, " width=", width,
+               " no_of_filter=", num_filters,
                " pad_t=", pad_t, " pad_b=", pad_b, " pad_l=", pad_l, " pad_r=", pad_r,
                " Time=", total, "ms",
                " Filter transform time =", 100.0f * d1/total, "%",
@@ -820,32 +1114,37 @@ void winograd_2x2_3x3(
                " Gemm time =", 100.0f*d3/total, "%",
                " Output transform time =", 100.0f*d4/total,"%");
 
+    winograd_release(zenLibPoolBuffer, transformed_image, image_flag);
+    winograd_release(zenLibPoolBuffer, gemm_output, output_flag);
+}
 
-    //If ZenMemPool Optimization is enabled(default), update the state of
-    //  Memory pool based on input_array address
-    if (zenLibPoolEnable) {
-
-        if (image_flag) {
-            free(transformed_image);
-        }
-        else {
-            zenLibPoolBuffer->zenLibMemPoolFree((float *)transformed_image);
-        }
-
-        if (filter_flag) {
-            free(transformed_filter);
-        }
-        else {
-            zenLibPoolBuffer->zenLibMemPoolFree((float *)transformed_filter);
-        }
-
-        if (output_flag) {
-            free(gemm_output);
-        }
-        else {
-            zenLibPoolBuffer->zenLibMemPoolFree((float *)gemm_output);
-        }
-    }
-
+void winograd_2x2_3x3(
+    zendnnEnv zenEnvObj,
+    const float *in_layer,
+    const int num_images,
+    const int num_channels,
+    const int height,
+    const int width,
+    const float *filter,
+    const int num_filters,
+    const int kernel_h,
+    const int kernel_w,
+    const int pad_t,
+    const int pad_l,
+    const int pad_b,
+    const int pad_r,
+    const float *bias,
+    float *out_layer,
+    const int out_height,
+    const int out_width,
+    const bool relu,
+    const bool sum_fused,
+    const float *scale
+) {
+    assert((kernel_h == 3) && (kernel_w == 3) &&
+           "Winograd kernel called for non 3x3 filter");
 
+    winograd_3x3(zenEnvObj, 2, in_layer, num_images, num_channels, height, width,
+                 filter, num_filters, pad_t, pad_l, pad_b, pad_r, bias, out_layer,
+                 out_height, out_width, relu, sum_fused, scale);
 }
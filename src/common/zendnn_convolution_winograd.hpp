@@ -1,5 +1,5 @@
 ﻿/*******************************************************************************
-* Copyright (c) 2019-2023 Advanced Micro Devices, Inc. All rights reserved.
+* Copyright (c) 2019-2024 Advanced Micro Devices, Inc. All rights reserved.
 *
 * Licensed under the Apache License, Version 2.0 (the "License");
 * you may not use this file except in compliance with the License.
@@ -50,6 +50,35 @@ void out_transform_2x2_3x3(zendnnEnv zenEnvObj, float *tiled_input,
                            float *out, const int batch_size, const int output_height,
                            const int output_width);
 
+void batched_gemm_winograd(zendnnEnv zenEnvObj, const float *transformed_image,
+                           const int num_tiles, const int num_channels,
+                           const float *transformed_filter, const int num_filters,
+                           float *out, const int num_points);
+
+//F(m x m, 3 x 3) transforms for m = 4 and 6. Tiles are laid out like the
+//F(2x2,3x3) ones, alpha x alpha x channels each with alpha = m + 2, and the
+//output tiles at the right and bottom edges are cropped, so any output size
+//is supported.
+template <int M>
+void filter_transform_winograd(const float *filter, const int num_channels,
+                               const int num_filters, float *out);
+
+template <int M>
+void input_transform_winograd(const float *input, const int batch_size,
+                              const int height, const int width, const int num_channels,
+                              const int pad_t, const int pad_l, float *out,
+                              const int output_height, const int output_width);
+
+template <int M>
+void out_transform_winograd(const float *tiled_input, const int num_channels,
+                            float *out, const int batch_size, const int output_height,
+                            const int output_width, const bool sum_fused);
+
+//Output tile size used for a Winograd 3x3 convolution: ZENDNN_WINOGRAD_TILE,
+//else picked from the output size
+int winograd_tile_size(const zendnnEnv &zenEnvObj, const int out_height,
+                       const int out_width);
+
 void post_conv_transform(const int batch_size, const int output_height,
                          const int output_width, const int num_channels,
                          float *out,
@@ -78,3 +107,30 @@ void winograd_2x2_3x3(
     const bool sum_fused,
     const float *scale
 );
+
+//Winograd F(tile x tile, 3 x 3) convolution, tile is 2, 4 or 6. F(2x2,3x3)
+//needs an even input height and width. Transformed filters are kept in the
+//weight cache when ZENDNN_WEIGHT_CACHING is set; the tile buffers are taken
+//for the call only, so concurrent calls do not share them.
+void winograd_3x3(
+    zendnnEnv zenEnvObj,
+    const int tile,
+    const float *in_layer,
+    const int num_images,
+    const int num_channels,
+    const int height,
+    const int width,
+    const float *filter,
+    const int num_filters,
+    const int pad_t,
+    const int pad_l,
+    const int pad_b,
+    const int pad_r,
+    const float *bias,
+    float *out_layer,
+    const int out_height,
+    const int out_width,
+    const bool relu,
+    const bool sum_fused,
+    const float *scale
+);
@@ -0,0 +1,378 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <thread>
+#include <utility>
+#ifndef _WIN32
+    #include <dirent.h>
+#endif
+#ifdef __linux__
+    #include <sched.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <cpuid.h>
+    #define ZENDNN_HAS_CPUID 1
+#endif
+#include "zendnn_cpu_topology.hpp"
+#include "zendnn_logging.hpp"
+
+namespace zendnn {
+
+static bool zenReadLine(const std::string &path, std::string &line) {
+    std::ifstream file(path);
+    return file && std::getline(file, line);
+}
+
+//Parses a sysfs CPU list such as "0-7,128-135"
+static std::vector<int> zenParseCpuList(const std::string &list) {
+    std::vector<int> cpus;
+    const char *p = list.c_str();
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long c = first; c <= last; c++) {
+            cpus.push_back(c);
+        }
+        if (*p == ',') {
+            p++;
+        }
+        else {
+            break;
+        }
+    }
+    return cpus;
+}
+
+const zendnnCpuTopology &zendnnCpuTopology::Instance() {
+    static const zendnnCpuTopology topology;
+    return topology;
+}
+
+zendnnCpuTopology::zendnnCpuTopology() {
+    if (read_sysfs()) {
+        source = "sysfs";
+    }
+    else if (read_cpuid()) {
+        source = "cpuid";
+    }
+    else {
+        set_default();
+        source = "default";
+    }
+    finalize();
+    zendnnInfo(ZENDNN_CORELOG, "CPU topology from ", source, ": cpus=",
+               cpus.size(), " cores=", num_cores, " threads_per_core=",
+               threads_per_core, " l3_domains=", l3_domains.size(), " cores_per_l3=",
+               cores_per_l3, " l3_bytes=", l3_bytes, " numa_nodes=", numa_nodes.size());
+}
+
+bool zendnnCpuTopology::read_sysfs() {
+#ifdef _WIN32
+    return false;
+#else
+    const std::string sys_cpu = "/sys/devices/system/cpu/";
+    std::string line;
+    l3_bytes = 0;
+    if (!zenReadLine(sys_cpu + "online", line)) {
+        return false;
+    }
+    std::vector<int> online = zenParseCpuList(line);
+    if (online.empty()) {
+        return false;
+    }
+
+    //NUMA node of each CPU
+    std::map<int, int> numa_of;
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            int node;
+            if (sscanf(entry->d_name, "node%d", &node) != 1) {
+                continue;
+            }
+            std::string path = std::string("/sys/devices/system/node/") +
+                               entry->d_name + "/cpulist";
+            if (zenReadLine(path, line)) {
+                for (int c : zenParseCpuList(line)) {
+                    numa_of[c] = node;
+                }
+            }
+        }
+        closedir(dir);
+    }
+
+    //Cores are keyed by (package, core_id), L3 domains by their first CPU
+    std::map<std::pair<int, int>, int> core_index;
+    std::map<int, int> l3_index;
+    for (int c : online) {
+        std::string topo = sys_cpu + "cpu" + std::to_string(c) + "/topology/";
+        int package = 0, core_id = c;
+        if (zenReadLine(topo + "physical_package_id", line)) {
+            package = atoi(line.c_str());
+        }
+        if (zenReadLine(topo + "core_id", line)) {
+            core_id = atoi(line.c_str());
+        }
+        int smt = 0;
+        if (zenReadLine(topo + "thread_siblings_list", line)) {
+            std::vector<int> siblings = zenParseCpuList(line);
+            smt = std::find(siblings.begin(), siblings.end(), c) - siblings.begin();
+            if (smt == (int)siblings.size()) {
+                smt = 0;
+            }
+        }
+
+        //Without an L3 the package is the sharing domain
+        int l3_key = -1 - package;
+        for (int idx = 0; idx < 16; idx++) {
+            std::string cache = sys_cpu + "cpu" + std::to_string(c) + "/cache/index" +
+                                std::to_string(idx) + "/";
+            if (!zenReadLine(cache + "level", line)) {
+                break;
+            }
+            if (atoi(line.c_str()) != 3) {
+                continue;
+            }
+            if (zenReadLine(cache + "shared_cpu_list", line)) {
+                std::vector<int> shared = zenParseCpuList(line);
+                if (!shared.empty()) {
+                    l3_key = shared[0];
+                }
+            }
+            //"32768K"
+            if (!l3_bytes && zenReadLine(cache + "size", line)) {
+                char *unit;
+                size_t size = strtoul(line.c_str(), &unit, 10);
+                l3_bytes = *unit == 'M' ? size << 20 : *unit == 'K' ? size << 10 : size;
+            }
+            break;
+        }
+
+        std::pair<int, int> core_key(package, core_id);
+        if (!core_index.count(core_key)) {
+            int idx = core_index.size();
+            core_index[core_key] = idx;
+        }
+        if (!l3_index.count(l3_key)) {
+            int idx = l3_index.size();
+            l3_index[l3_key] = idx;
+        }
+        cpu_info info;
+        info.cpu = c;
+        info.core = core_index[core_key];
+        info.l3 = l3_index[l3_key];
+        info.numa = numa_of.count(c) ? numa_of[c] : 0;
+        info.smt = smt;
+        cpus.push_back(info);
+    }
+    return true;
+#endif
+}
+
+bool zendnnCpuTopology::read_cpuid() {
+#ifdef ZENDNN_HAS_CPUID
+    unsigned int num_cpus = std::thread::hardware_concurrency();
+    unsigned int eax, ebx, ecx, edx;
+    if (!num_cpus || !__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    //"AuthenticAMD" reports caches in 0x8000001D, others in leaf 4
+    bool amd = ebx == 0x68747541 && edx == 0x69746e65 && ecx == 0x444d4163;
+    unsigned int cache_leaf = amd ? 0x8000001D : 4;
+    unsigned int tpc = 1, l3_cpus = 0;
+    l3_bytes = 0;
+    if (amd) {
+        if (__get_cpuid(0x8000001E, &eax, &ebx, &ecx, &edx)) {
+            tpc = ((ebx >> 8) & 0xff) + 1;
+        }
+    }
+    else if (__get_cpuid_count(0xB, 0, &eax, &ebx, &ecx, &edx) && (ebx & 0xffff)) {
+        tpc = ebx & 0xffff;
+    }
+    for (unsigned int sub = 0; sub < 16; sub++) {
+        if (!__get_cpuid_count(cache_leaf, sub, &eax, &ebx, &ecx, &edx) ||
+                !(eax & 0x1f)) {
+            break;
+        }
+        if (((eax >> 5) & 0x7) == 3) {
+            l3_cpus = ((eax >> 14) & 0xfff) + 1;
+            //ways * partitions * line size * sets
+            l3_bytes = (size_t)((ebx >> 22) + 1) * (((ebx >> 12) & 0x3ff) + 1) *
+                       ((ebx & 0xfff) + 1) * (ecx + 1);
+            break;
+        }
+    }
+    if (!l3_cpus) {
+        return false;
+    }
+    //The CPU numbering is not known here, SMT siblings are taken as adjacent
+    for (unsigned int c = 0; c < num_cpus; c++) {
+        cpu_info info;
+        info.cpu = c;
+        info.core = c / tpc;
+        info.l3 = c / l3_cpus;
+        info.numa = 0;
+        info.smt = c % tpc;
+        cpus.push_back(info);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void zendnnCpuTopology::set_default() {
+    l3_bytes = 0;
+    unsigned int num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int c = 0; c < num_cpus; c++) {
+        cpu_info info;
+        info.cpu = c;
+        info.core = c;
+        info.l3 = c / ZENDNN_DEFAULT_L3_CORES;
+        info.numa = 0;
+        info.smt = 0;
+        cpus.push_back(info);
+    }
+}
+
+void zendnnCpuTopology::finalize() {
+    std::map<int, int> numa_index;
+    std::set<int> cores;
+    threads_per_core = 1;
+    for (const auto &info : cpus) {
+        if ((int)l3_domains.size() <= info.l3) {
+            l3_domains.resize(info.l3 + 1);
+        }
+        l3_domains[info.l3].push_back(info.cpu);
+        if (!numa_index.count(info.numa)) {
+            int idx = numa_index.size();
+            numa_index[info.numa] = idx;
+            numa_nodes.emplace_back();
+        }
+        numa_nodes[numa_index[info.numa]].push_back(info.cpu);
+        cores.insert(info.core);
+        threads_per_core = std::max(threads_per_core, (unsigned int)info.smt + 1);
+    }
+    num_cores = cores.size();
+
+    cores_per_l3 = 0;
+    for (size_t d = 0; d < l3_domains.size(); d++) {
+        std::set<int> domain_cores;
+        for (const auto &info : cpus) {
+            if (info.l3 == (int)d) {
+                domain_cores.insert(info.core);
+            }
+        }
+        if (!cores_per_l3 || domain_cores.size() < cores_per_l3) {
+            cores_per_l3 = domain_cores.size();
+        }
+    }
+    if (!cores_per_l3) {
+        cores_per_l3 = ZENDNN_DEFAULT_L3_CORES;
+    }
+    if (!l3_bytes) {
+        l3_bytes = ZENDNN_DEFAULT_L3_BYTES;
+    }
+
+    //Threads are bound to the allowed CPUs one per core before the SMT
+    //siblings, siblings may be numbered next to each other or num_cores
+    //apart, so the order comes from the core and SMT rank of every CPU
+    std::vector<cpu_info> order;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool masked = sched_getaffinity(0, sizeof(set), &set) == 0;
+#endif
+    for (const auto &info : cpus) {
+#ifdef __linux__
+        if (masked && info.cpu < CPU_SETSIZE && !CPU_ISSET(info.cpu, &set)) {
+            continue;
+        }
+#endif
+        order.push_back(info);
+    }
+    if (order.empty()) {
+        order = cpus;
+    }
+    std::stable_sort(order.begin(), order.end(),
+    [](const cpu_info &a, const cpu_info &b) {
+        return a.smt < b.smt;
+    });
+    for (const auto &info : order) {
+        thread_l3.push_back(info.l3);
+    }
+}
+
+unsigned int zendnnCpuTopology::l3_threads(unsigned int num_threads) const {
+    std::vector<unsigned int> teams = l3_teams(num_threads);
+    return teams.empty() ? cores_per_l3 : teams[0];
+}
+
+std::vector<unsigned int> zendnnCpuTopology::l3_teams(
+    unsigned int num_threads) const {
+    //Past the allowed CPUs the threads wrap around, teams follow the L3 of
+    //the CPU every thread lands on
+    std::vector<unsigned int> teams;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        if (thread_l3.empty()) {
+            if (t % cores_per_l3 == 0) {
+                teams.push_back(0);
+            }
+        }
+        else if (t == 0 || thread_l3[t % thread_l3.size()] !=
+                 thread_l3[(t - 1) % thread_l3.size()]) {
+            teams.push_back(0);
+        }
+        teams.back()++;
+    }
+    return teams;
+}
+
+unsigned int zendnnCpuTopology::l3_team_size(unsigned int num_threads,
+        unsigned int num_teams) const {
+    unsigned int share = std::max(1u, num_threads / std::max(1u, num_teams));
+    unsigned int domain = l3_threads(num_threads);
+    unsigned int aligned = share;
+    if (share >= domain) {
+        aligned = share / domain * domain;
+    }
+    else {
+        while (domain % aligned) {
+            aligned--;
+        }
+    }
+    return (unsigned long)aligned * num_teams * 8 >= (unsigned long)num_threads * 7
+           ? aligned : share;
+}
+
+} //namespace zendnn
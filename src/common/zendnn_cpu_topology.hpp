@@ -0,0 +1,86 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef ZENDNN_CPU_TOPOLOGY_HPP
+#define ZENDNN_CPU_TOPOLOGY_HPP
+
+#include <string>
+#include <vector>
+
+//Cores per L3 domain and L3 size assumed when the topology can not be read
+#define ZENDNN_DEFAULT_L3_CORES 8
+#define ZENDNN_DEFAULT_L3_BYTES (32 << 20)
+
+namespace zendnn {
+
+//CPU topology of the machine: L3 sharing domains (CCX), NUMA nodes and SMT
+//siblings of the online CPUs. Read once from sysfs, from cpuid when sysfs is
+//not available. Thread counts below assume OpenMP threads are bound to the
+//allowed CPUs one per core before SMT siblings are used, in CPU order
+//otherwise (OMP_PROC_BIND=close).
+class zendnnCpuTopology {
+  public:
+    struct cpu_info {
+        int cpu;        //logical CPU id
+        int core;       //index of the physical core
+        int l3;         //index of the L3 domain
+        int numa;       //NUMA node
+        int smt;        //rank among the SMT siblings of the core
+    };
+
+    static const zendnnCpuTopology &Instance();
+
+    //Online CPUs, ascending
+    std::vector<cpu_info> cpus;
+    //CPUs of each L3 domain and NUMA node, ascending
+    std::vector<std::vector<int>> l3_domains;
+    std::vector<std::vector<int>> numa_nodes;
+    unsigned int num_cores;
+    unsigned int threads_per_core;
+    //Physical cores of the smallest L3 domain
+    unsigned int cores_per_l3;
+    //Size of one L3 domain
+    size_t l3_bytes;
+    //"sysfs", "cpuid" or "default"
+    std::string source;
+    //L3 domain of OpenMP thread t: the CPUs the process may run on, one per
+    //core first (SMT rank, then CPU id), wherever the siblings are numbered
+    std::vector<int> thread_l3;
+
+    //Consecutive threads sharing the L3 of thread 0 in a team of
+    //num_threads threads
+    unsigned int l3_threads(unsigned int num_threads) const;
+    //Splits num_threads into consecutive teams, one per run of threads on
+    //the same L3 domain. The last team holds the remainder.
+    std::vector<unsigned int> l3_teams(unsigned int num_threads) const;
+    //Size of each of num_teams inner teams sharing num_threads threads. The
+    //even share is rounded to whole L3 domains (or to a divisor of one) so
+    //that an inner team does not straddle two domains, unless that leaves
+    //more than 1/8 of the threads idle.
+    unsigned int l3_team_size(unsigned int num_threads,
+                              unsigned int num_teams) const;
+
+  private:
+    zendnnCpuTopology();
+    bool read_sysfs();
+    bool read_cpuid();
+    void set_default();
+    void finalize();
+};
+
+} //namespace zendnn
+#endif //ZENDNN_CPU_TOPOLOGY_HPP
@@ -48,6 +48,7 @@ const char *zendnn_dt2str(zendnn_data_type_t v) {
     if (v == zendnn_f32) return "f32";
     if (v == zendnn_s32) return "s32";
     if (v == zendnn_s16) return "s16";
+    if (v == zendnn_s64) return "s64";
     if (v == zendnn_s8) return "s8";
     if (v == zendnn_u8) return "u8";
     assert(!"unknown dt");
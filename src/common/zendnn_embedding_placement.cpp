@@ -0,0 +1,209 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#include "zendnn.hpp"
+#include <algorithm>
+#include <set>
+#include <vector>
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+#ifdef __linux__
+    #include <sys/syscall.h>
+#endif
+#include "zendnn_logging.hpp"
+#include "zendnn_cpu_topology.hpp"
+#include "zendnn_embedding_placement.hpp"
+
+//Memory policies of mbind(2), <linux/mempolicy.h> is not always installed
+#define ZENDNN_MPOL_BIND        2
+#define ZENDNN_MPOL_INTERLEAVE  3
+#define ZENDNN_MPOL_MF_MOVE     (1 << 1)
+
+namespace zendnn {
+
+zendnnEmbeddingPlacement &zendnnEmbeddingPlacement::Instance() {
+    static zendnnEmbeddingPlacement placement;
+    return placement;
+}
+
+void *zendnnEmbeddingPlacement::map(const std::string &path, size_t bytes,
+                                    size_t offset) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    //Pages past the end of the file raise SIGBUS when touched, a short
+    //file fails here instead
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 0 ||
+            (size_t)st.st_size < offset || (size_t)st.st_size - offset < bytes) {
+        zendnnError(ZENDNN_CORELOG, "Embedding table file ", path,
+                    " does not hold ", bytes, " bytes from offset ", offset);
+        close(fd);
+        return nullptr;
+    }
+    //mmap offsets are page aligned, the table starts inside the first page
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t lead = offset % page;
+    void *base = mmap(nullptr, bytes + lead, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE, fd, offset - lead);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+    //Lookups are random, read ahead would only bring in unused rows
+    madvise(base, bytes + lead, MADV_RANDOM);
+    void *data = (char *)base + lead;
+    std::lock_guard<std::mutex> lock(mtx);
+    tables[data] = {-1, base, bytes + lead};
+    return data;
+#else
+    return nullptr;
+#endif
+}
+
+bool zendnnEmbeddingPlacement::place(void *data, size_t bytes, int node) {
+    const zendnnCpuTopology &topology = zendnnCpuTopology::Instance();
+    std::set<int> nodes;
+    for (const auto &info : topology.cpus) {
+        nodes.insert(info.numa);
+    }
+    if (node >= 0 && !nodes.count(node)) {
+        return false;
+    }
+#ifdef __linux__
+    //Only the pages inside the table are bound, a page shared with other
+    //data keeps its policy
+    if (nodes.size() > 1) {
+        size_t page = sysconf(_SC_PAGESIZE);
+        uintptr_t first = ((uintptr_t)data + page - 1) / page * page;
+        uintptr_t last = ((uintptr_t)data + bytes) / page * page;
+        if (last > first) {
+            int max_node = *nodes.rbegin();
+            std::vector<unsigned long> mask(max_node / (8 * sizeof(unsigned long)) + 1,
+                                            0);
+            for (int n : nodes) {
+                if (node < 0 || n == node) {
+                    mask[n / (8 * sizeof(unsigned long))] |=
+                        1UL << (n % (8 * sizeof(unsigned long)));
+                }
+            }
+            long ret = syscall(SYS_mbind, (void *)first, last - first,
+                               node < 0 ? ZENDNN_MPOL_INTERLEAVE : ZENDNN_MPOL_BIND,
+                               mask.data(), (unsigned long)max_node + 2,
+                               ZENDNN_MPOL_MF_MOVE);
+            if (ret != 0) {
+                return false;
+            }
+        }
+    }
+#endif
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = tables.find(data);
+    if (it == tables.end()) {
+        tables[data] = {node < 0 ? -1 : node, nullptr, 0};
+    }
+    else {
+        it->second.node = node < 0 ? -1 : node;
+    }
+    return true;
+}
+
+void zendnnEmbeddingPlacement::release(void *data) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = tables.find(data);
+    if (it == tables.end()) {
+        return;
+    }
+#ifndef _WIN32
+    if (it->second.map_base) {
+        munmap(it->second.map_base, it->second.map_bytes);
+    }
+#endif
+    tables.erase(it);
+}
+
+int zendnnEmbeddingPlacement::owner(const void *data) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = tables.find(data);
+    return it == tables.end() ? -1 : it->second.node;
+}
+
+void zendnn_custom_op::zendnn_embedding_table_map(const std::string &z_path,
+        memory &z_table, int64_t z_file_offset) {
+    memory::desc table_desc = z_table.get_desc();
+    if (table_desc.dims().size() != 2 || z_file_offset < 0) {
+        throw error(zendnn_invalid_arguments,
+                    "zendnn_embedding_table_map needs a 2D table and a valid file offset");
+    }
+    void *data = zendnnEmbeddingPlacement::Instance().map(z_path,
+                 table_desc.get_size(), z_file_offset);
+    if (!data) {
+        throw error(zendnn_runtime_error,
+                    "zendnn_embedding_table_map failed to map the table file, "
+                    "it is missing or shorter than the table");
+    }
+    z_table.set_data_handle(data);
+    zendnnInfo(ZENDNN_CORELOG, "Embedding table mapped from ", z_path,
+               " bytes=", table_desc.get_size(), " [zendnn_embedding_table_map]");
+}
+
+void zendnn_custom_op::zendnn_embedding_table_place(const memory &z_table,
+        int z_numa_node) {
+    if (!zendnnEmbeddingPlacement::Instance().place(z_table.get_data_handle(),
+            z_table.get_desc().get_size(), z_numa_node)) {
+        throw error(zendnn_runtime_error,
+                    "zendnn_embedding_table_place failed to place the table");
+    }
+}
+
+void zendnn_custom_op::zendnn_embedding_tables_shard(const std::vector<memory>
+        &z_tables) {
+    const zendnnCpuTopology &topology = zendnnCpuTopology::Instance();
+    std::vector<int> nodes;
+    for (const auto &info : topology.cpus) {
+        if (std::find(nodes.begin(), nodes.end(), info.numa) == nodes.end()) {
+            nodes.push_back(info.numa);
+        }
+    }
+    //Largest table first to the node holding the fewest bytes
+    std::vector<size_t> order(z_tables.size());
+    for (size_t t = 0; t < order.size(); t++) {
+        order[t] = t;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return z_tables[a].get_desc().get_size() >
+               z_tables[b].get_desc().get_size();
+    });
+    std::vector<size_t> load(nodes.size(), 0);
+    for (size_t t : order) {
+        size_t n = std::min_element(load.begin(), load.end()) - load.begin();
+        load[n] += z_tables[t].get_desc().get_size();
+        zendnn_embedding_table_place(z_tables[t], nodes[n]);
+    }
+}
+
+void zendnn_custom_op::zendnn_embedding_table_release(const memory &z_table) {
+    zendnnEmbeddingPlacement::Instance().release(z_table.get_data_handle());
+}
+
+} //namespace zendnn
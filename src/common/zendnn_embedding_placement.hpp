@@ -0,0 +1,61 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef ZENDNN_EMBEDDING_PLACEMENT_HPP
+#define ZENDNN_EMBEDDING_PLACEMENT_HPP
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace zendnn {
+
+//Embedding tables memory mapped from files or placed on NUMA nodes, keyed by
+//their data handle. zendnn_grp_embedding_bag looks up the node of a table
+//here to run it on the threads of that node.
+class zendnnEmbeddingPlacement {
+  public:
+    static zendnnEmbeddingPlacement &Instance();
+
+    //Maps bytes of the file at path from offset, private and writable: the
+    //pages are read from the page cache on first use and writes are not
+    //carried to the file. Returns nullptr on failure, or when the file
+    //does not hold bytes from offset.
+    void *map(const std::string &path, size_t bytes, size_t offset);
+    //Binds the pages of [data, data + bytes) to node, or interleaves them
+    //over all the nodes for node < 0, moving the pages already present.
+    bool place(void *data, size_t bytes, int node);
+    //Unmaps a mapped table and forgets the node of a placed one
+    void release(void *data);
+    //Node a table is bound to, -1 when it is not bound to one
+    int owner(const void *data) const;
+
+  private:
+    struct table_entry {
+        int node;
+        void *map_base;
+        size_t map_bytes;
+    };
+
+    zendnnEmbeddingPlacement() = default;
+    mutable std::mutex mtx;
+    std::map<const void *, table_entry> tables;
+};
+
+} //namespace zendnn
+#endif //ZENDNN_EMBEDDING_PLACEMENT_HPP
@@ -18,10 +18,27 @@
 #include <vector>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <omp.h>
+#ifndef _WIN32
+    #include <pthread.h>
+    #include <sched.h>
+#endif
 #include "zendnn_logging.hpp"
+#include "zendnn_helper.hpp"
+#include "zendnn_cpu_topology.hpp"
 #include "verbose.hpp"
 #include <string.h>
 
+//Gather bytes costing as much as one GEMM flop, used by the auto split
+#define EB_MLP_FLOPS_PER_BYTE 20.0
+
 namespace zendnn {
 
 void zen_matmul_impl(
@@ -171,6 +188,325 @@ void zendnn_custom_op::zendnn_grp_mlp(
                   ",ms");
 }
 
+//Runs jobs on a helper thread. The helper owns its own OpenMP thread pool,
+//so the MLP side of an overlapped op runs top level parallel regions next to
+//the embedding side instead of nesting under it.
+//
+//The worker is never destroyed by static destruction, which may run during
+//the OpenMP runtime teardown. An atexit handler registered on creation, so
+//after the runtime started, joins the helper first; its OpenMP pool is
+//released with the thread.
+class zenOverlapWorker {
+  public:
+    static zenOverlapWorker &instance() {
+        static zenOverlapWorker *worker = create();
+        return *worker;
+    }
+
+    void submit(std::function<void()> job) {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending_job = std::move(job);
+        pending = true;
+        error = nullptr;
+        job_cv.notify_one();
+    }
+
+    //True once the helper was joined at exit, jobs then run on the caller
+    bool stopped() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stop;
+    }
+
+    //Waits for the submitted job, rethrows what it threw
+    void wait() {
+        std::unique_lock<std::mutex> lock(mtx);
+        done_cv.wait(lock, [this] {
+            return !pending;
+        });
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    //Held by the op for the whole overlapped run, the worker serves one
+    //caller at a time
+    std::mutex call_mtx;
+    //CPUs the worker pool is pinned to, empty when not pinned
+    std::vector<int> bound_cpus;
+
+  private:
+    zenOverlapWorker() : pending(false), stop(false) {
+        thread = std::thread([this] {
+            run();
+        });
+    }
+
+    static zenOverlapWorker *create() {
+        zenOverlapWorker *worker = new zenOverlapWorker();
+        std::atexit([] {
+            instance().join();
+        });
+        return worker;
+    }
+
+    //Lets the helper finish its job and exit
+    void join() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        job_cv.notify_one();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            job_cv.wait(lock, [this] {
+                return pending || stop;
+            });
+            if (!pending) {
+                return;
+            }
+            std::function<void()> job = std::move(pending_job);
+            lock.unlock();
+            std::exception_ptr job_error = nullptr;
+            try {
+                job();
+            }
+            catch (...) {
+                job_error = std::current_exception();
+            }
+            lock.lock();
+            error = job_error;
+            pending = false;
+            done_cv.notify_all();
+        }
+    }
+
+    std::mutex mtx;
+    std::condition_variable job_cv, done_cv;
+    std::function<void()> pending_job;
+    std::exception_ptr error;
+    bool pending, stop;
+    std::thread thread;
+};
+
+//CPUs the calling thread may run on, in ascending order
+static std::vector<int> zenAllowedCpus() {
+    std::vector<int> cpus;
+#ifndef _WIN32
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set)) {
+                cpus.push_back(c);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+#ifndef _WIN32
+//Pins thread i of a num_threads team of the calling thread to cpus[i], the
+//previous masks are written to saved when given
+static void zenBindTeam(const std::vector<int> &cpus,
+                        std::vector<cpu_set_t> *saved) {
+    int num_threads = cpus.size();
+    if (saved) {
+        saved->resize(num_threads);
+    }
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int ithr = omp_get_thread_num();
+        if (saved) {
+            pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                   &(*saved)[ithr]);
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[ithr], &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+}
+
+static void zenRestoreTeam(const std::vector<cpu_set_t> &saved) {
+    int num_threads = saved.size();
+    #pragma omp parallel num_threads(num_threads)
+    {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                               &saved[omp_get_thread_num()]);
+    }
+}
+#endif
+
+//Bytes of the table rows gathered by the embedding side
+static double zenEmbeddingGatherBytes(const std::vector<memory> &tables,
+                                      const std::vector<memory> &indices) {
+    double bytes = 0;
+    for (size_t i = 0; i < tables.size(); i++) {
+        memory::desc table_md = tables[i].get_desc();
+        memory::dims table_dims = table_md.dims();
+        double row_bytes = table_md.get_size() / (double)table_dims[0];
+        bytes += indices[i].get_desc().get_size() /
+                 (double)memory::data_type_size(indices[i].get_desc().data_type()) *
+                 row_bytes;
+    }
+    return bytes;
+}
+
+//Flops of the group MLP
+static double zenMLPFlops(const std::vector<memory> &weight,
+                          const std::vector<float> &alpha,
+                          const std::vector<memory> &result) {
+    double flops = 0;
+    for (size_t i = 0; i < result.size(); i++) {
+        if (alpha[i] == 0) {
+            continue;
+        }
+        memory::dims w_dims = weight[i].get_desc().dims();
+        memory::dims r_dims = result[i].get_desc().dims();
+        double k = w_dims[w_dims.size() - 2];
+        double mn = 1;
+        for (auto d : r_dims) {
+            mn *= d;
+        }
+        flops += 2 * mn * k;
+    }
+    return flops;
+}
+
+//Threads of the embedding side when num_threads are split between the
+//embedding and the MLP side, 0 when the op should run sequentially
+static unsigned int zenEBMLPSplit(const zendnnEnv &zenEnvObj,
+                                  double gather_bytes, double mlp_flops) {
+    unsigned int num_threads = zenEnvObj.omp_num_threads;
+    if (!zenEnvObj.zenEBMLPOverlap || num_threads < 2 || mlp_flops == 0) {
+        return 0;
+    }
+    unsigned int eb_threads = zenEnvObj.zenEBMLPThreads;
+    if (!eb_threads) {
+        double eb_cost = gather_bytes * EB_MLP_FLOPS_PER_BYTE;
+        eb_threads = (unsigned int)(num_threads * eb_cost / (eb_cost + mlp_flops) +
+                                    0.5);
+        //Whole L3 domains when both sides get at least one
+        unsigned int l3_threads = zendnnCpuTopology::Instance().l3_threads(
+                                      num_threads);
+        if (eb_threads >= l3_threads && num_threads - eb_threads >= l3_threads) {
+            eb_threads = (eb_threads + l3_threads / 2) / l3_threads * l3_threads;
+        }
+    }
+    return std::max(1u, std::min(eb_threads, num_threads - 1));
+}
+
+//Runs eb_job with eb_threads on the calling thread and mlp_job with the rest
+//of the threads on the overlap worker, both at the same time. Returns false
+//without running anything when the worker is busy with another caller or
+//was joined at exit.
+static bool zenRunOverlapped(const zendnnEnv &zenEnvObj,
+                             unsigned int eb_threads,
+                             const std::function<void()> &eb_job,
+                             const std::function<void()> &mlp_job) {
+    zenOverlapWorker &worker = zenOverlapWorker::instance();
+    std::unique_lock<std::mutex> call_lock(worker.call_mtx, std::try_to_lock);
+    if (!call_lock.owns_lock() || worker.stopped()) {
+        return false;
+    }
+    unsigned int num_threads = zenEnvObj.omp_num_threads;
+    unsigned int mlp_threads = num_threads - eb_threads;
+
+    //First eb_threads cpus for the embedding side, the next ones for the MLP
+    std::vector<int> eb_cpus, mlp_cpus;
+    if (zenEnvObj.zenEBMLPBind) {
+        std::vector<int> cpus = zenAllowedCpus();
+        if (cpus.size() >= num_threads) {
+            eb_cpus.assign(cpus.begin(), cpus.begin() + eb_threads);
+            mlp_cpus.assign(cpus.begin() + eb_threads, cpus.begin() + num_threads);
+        }
+    }
+
+    worker.submit([&] {
+        zendnnSetThreadBudget(mlp_threads);
+        omp_set_num_threads(mlp_threads);
+#ifndef _WIN32
+        //The worker pool only serves the MLP side, it stays pinned
+        if (worker.bound_cpus != mlp_cpus && !mlp_cpus.empty()) {
+            zenBindTeam(mlp_cpus, nullptr);
+            worker.bound_cpus = mlp_cpus;
+        }
+#endif
+        mlp_job();
+    });
+
+    unsigned int prev_budget = zendnnGetThreadBudget();
+    int prev_max_threads = omp_get_max_threads();
+    zendnnSetThreadBudget(eb_threads);
+    omp_set_num_threads(eb_threads);
+#ifndef _WIN32
+    std::vector<cpu_set_t> saved;
+    if (!eb_cpus.empty()) {
+        zenBindTeam(eb_cpus, &saved);
+    }
+#endif
+    std::exception_ptr eb_error = nullptr;
+    try {
+        eb_job();
+    }
+    catch (...) {
+        eb_error = std::current_exception();
+    }
+#ifndef _WIN32
+    if (!saved.empty()) {
+        zenRestoreTeam(saved);
+    }
+#endif
+    omp_set_num_threads(prev_max_threads);
+    zendnnSetThreadBudget(prev_budget);
+
+    worker.wait();
+    if (eb_error) {
+        std::rethrow_exception(eb_error);
+    }
+    return true;
+}
+
+//True when the bytes of two memories overlap, views into one buffer at
+//different offsets included
+static bool zenMemoryOverlaps(const memory &a, const memory &b) {
+    const char *a_begin = (const char *)a.get_data_handle();
+    const char *b_begin = (const char *)b.get_data_handle();
+    if (!a_begin || !b_begin) {
+        return false;
+    }
+    const char *a_end = a_begin + a.get_desc().get_size();
+    const char *b_end = b_begin + b.get_desc().get_size();
+    return a_begin < b_end && b_begin < a_end;
+}
+
+//True when an MLP input or result shares bytes with an embedding
+//destination, those ops have to run one after the other
+static bool zenMLPReadsEmbedding(const std::vector<memory> &eb_destination,
+                                 const std::vector<memory> &mm_input,
+                                 const std::vector<memory> &mm_result) {
+    for (const auto &dst : eb_destination) {
+        for (const auto &in : mm_input) {
+            if (zenMemoryOverlaps(in, dst)) {
+                return true;
+            }
+        }
+        for (const auto &res : mm_result) {
+            if (zenMemoryOverlaps(res, dst)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 void zendnn_custom_op::zendnn_grp_ebag_mlp(
     std::vector <memory> &z_eb_input,
     std::vector <memory> &z_eb_indices, std::vector <memory> &z_eb_offsets,
@@ -192,14 +528,43 @@ void zendnn_custom_op::zendnn_grp_ebag_mlp(
     const std::vector<memory> &z_mm_result)
 
 {
+    auto eb_job = [&] {
+        zendnn_custom_op::zendnn_grp_embedding_bag(
+            z_eb_input, z_eb_indices, z_eb_offsets, z_eb_scale_grad_by_freq, z_eb_modes,
+            z_eb_sparse, z_eb_per_sample_weights_opt, z_eb_per_sample_weights_defined,
+            z_eb_include_last_offset, z_eb_padding_idx, z_eb_destination, 1);
+    };
+    auto mlp_job = [&] {
+        zendnn_custom_op::zendnn_grp_mlp(z_mm_input, z_mm_weight, z_mm_bias,
+                                         z_mm_alpha, z_mm_beta, z_mm_bias_defined, z_mm_fuse, z_mm_result);
+    };
 
-    zendnn_custom_op::zendnn_grp_embedding_bag(
-        z_eb_input, z_eb_indices, z_eb_offsets, z_eb_scale_grad_by_freq, z_eb_modes,
-        z_eb_sparse, z_eb_per_sample_weights_opt, z_eb_per_sample_weights_defined,
-        z_eb_include_last_offset, z_eb_padding_idx, z_eb_destination, 1);
+    zendnnEnv zenEnvObj = readEnv();
+    unsigned int eb_threads = 0;
+    if (zenEnvObj.zenEBMLPOverlap &&
+            !zenMLPReadsEmbedding(z_eb_destination, z_mm_input,
+                                  z_mm_result)) {
+        eb_threads = zenEBMLPSplit(zenEnvObj,
+                                   zenEmbeddingGatherBytes(z_eb_input, z_eb_indices),
+                                   zenMLPFlops(z_mm_weight, z_mm_alpha, z_mm_result));
+    }
 
-    zendnn_custom_op::zendnn_grp_mlp(z_mm_input, z_mm_weight, z_mm_bias, z_mm_alpha,
-                                     z_mm_beta, z_mm_bias_defined, z_mm_fuse, z_mm_result);
+    double start_ms = impl::get_msec();
+    bool overlapped = eb_threads && zenRunOverlapped(zenEnvObj, eb_threads,
+                      eb_job, mlp_job);
+    if (!overlapped) {
+        eb_job();
+        mlp_job();
+    }
+    double duration_ms = impl::get_msec() - start_ms;
+
+    zendnnVerbose(ZENDNN_PROFLOG, "zendnn_custom_op_execute,cpu,grp_ebag_mlp,",
+                  "overlap:", overlapped, ",",
+                  "eb_threads:", overlapped ? eb_threads : zenEnvObj.omp_num_threads, ",",
+                  "mlp_threads:", overlapped ? zenEnvObj.omp_num_threads - eb_threads :
+                  zenEnvObj.omp_num_threads, ",",
+                  duration_ms,
+                  ",ms");
 }
 
 void zendnn_custom_op::zendnn_grp_embedding_mlp(
@@ -219,14 +584,42 @@ void zendnn_custom_op::zendnn_grp_embedding_mlp(
     const std::vector<memory> &z_mm_result)
 
 {
+    auto eb_job = [&] {
+        zendnn_custom_op::zendnn_grp_embedding(
+            z_embed_input, z_embed_indices, z_embed_padding_idx, z_embed_scale_grad_by_freq,
+            z_embed_sparse, z_embed_destination, 1);
+    };
+    auto mlp_job = [&] {
+        zendnn_custom_op::zendnn_grp_mlp(z_mm_input, z_mm_weight, z_mm_bias,
+                                         z_mm_alpha, z_mm_beta, z_mm_bias_defined, z_mm_fuse, z_mm_result);
+    };
 
-    zendnn_custom_op::zendnn_grp_embedding(
-        z_embed_input, z_embed_indices, z_embed_padding_idx, z_embed_scale_grad_by_freq,
-        z_embed_sparse, z_embed_destination, 1);
+    zendnnEnv zenEnvObj = readEnv();
+    unsigned int eb_threads = 0;
+    if (zenEnvObj.zenEBMLPOverlap &&
+            !zenMLPReadsEmbedding(z_embed_destination, z_mm_input,
+                                  z_mm_result)) {
+        eb_threads = zenEBMLPSplit(zenEnvObj,
+                                   zenEmbeddingGatherBytes(z_embed_input, z_embed_indices),
+                                   zenMLPFlops(z_mm_weight, z_mm_alpha, z_mm_result));
+    }
 
-    zendnn_custom_op::zendnn_grp_mlp(z_mm_input, z_mm_weight, z_mm_bias, z_mm_alpha,
-                                     z_mm_beta, z_mm_bias_defined, z_mm_fuse, z_mm_result);
-}
+    double start_ms = impl::get_msec();
+    bool overlapped = eb_threads && zenRunOverlapped(zenEnvObj, eb_threads,
+                      eb_job, mlp_job);
+    if (!overlapped) {
+        eb_job();
+        mlp_job();
+    }
+    double duration_ms = impl::get_msec() - start_ms;
 
+    zendnnVerbose(ZENDNN_PROFLOG, "zendnn_custom_op_execute,cpu,grp_embedding_mlp,",
+                  "overlap:", overlapped, ",",
+                  "eb_threads:", overlapped ? eb_threads : zenEnvObj.omp_num_threads, ",",
+                  "mlp_threads:", overlapped ? zenEnvObj.omp_num_threads - eb_threads :
+                  zenEnvObj.omp_num_threads, ",",
+                  duration_ms,
+                  ",ms");
 }
 
+}
@@ -19,6 +19,7 @@
 #include <iostream>
 #include <string>
 #include "zendnn_hw_os_kernel_bios_info.hpp"
+#include "zendnn_cpu_topology.hpp"
 #include "zendnn_helper.hpp"
 #include "zendnn_logging.hpp"
 
@@ -67,6 +68,19 @@ void zendnnHwOsKernelBiosEnv::readHwEnv() {
     hw_l3_cache_ccx_ccd = zendnn_getenv_string("_SYSTEM_HW_L3_CACHE_CCX_CCD");
     hw_cores_ccx = zendnn_getenv_int("_SYSTEM_HW_CORES_CCX");
     hw_equi_l3_cache_core = zendnn_getenv_string("_SYSTEM_HW_EQUI_L3_CACHE_CORE");
+
+    //Not exported by gather_hw_os_kernel_bios_info.sh, take the counts from
+    //the topology read by the library
+    const zendnnCpuTopology &topology = zendnnCpuTopology::Instance();
+    if (!hw_num_threads) {
+        hw_num_threads = topology.cpus.size();
+    }
+    if (!hw_thread_core) {
+        hw_thread_core = topology.threads_per_core;
+    }
+    if (!hw_cores_ccx) {
+        hw_cores_ccx = topology.cores_per_l3;
+    }
 }
 
 void zendnnHwOsKernelBiosEnv::readOsEnv() {
@@ -21,6 +21,8 @@
 #include <utility>
 #include <tuple>
 #include "zendnn_private.hpp"
+#include "zendnn_concurrent_map.hpp"
+#include "zendnn_tuning_db.hpp"
 #include <time.h>
 #include <sstream>
 #include <fstream>
@@ -31,10 +33,6 @@ using namespace zendnn;
 
 //Total num of algo available
 #define NUM_OF_ALGO 5
-//Total num of struct members and algo field in MAP.
-#define NUM_MAP_VALUES 10
-//CPU information size
-#define CPU_INFO_SIZE 12
 
 //Skip Iterations for auto tuner
 //Can be set by environment variable ZENDNN_MATMUL_SKIP_ITER
@@ -52,73 +50,95 @@ using namespace zendnn;
 // from the framework.
 int graph_exe_count = -1;
 
-//enum defines the persistent map controls
-//0: disables
-//1: Write the map on the file
-//2: Read the map from file
-enum persistentMapType {
-    DISABLE = 0,
-    WRITE = 1,
-    READ = 2,
-};
+//Maps are shared by all threads calling MatMul. Lookups are wait-free and
+//return a copy of the value, updates are serialized per shard.
 
 //Simplified Map having Key as struct and value as Algo.
-std::unordered_map<Key_matmul, unsigned int>
+zenConcurrentMap<Key_matmul, unsigned int>
 matmul_kernel_map;
 
 //Map value is tuple of (iteration count, execution time of algo, Algo Path)
 //Used in auto_compute_matmul_v1 and auto_compute_matmul_v3
-std::unordered_map<Key_matmul,std::tuple<unsigned int, float, unsigned int>>
-        matmul_kernel_map1_helper;
+typedef std::tuple<unsigned int, float, unsigned int> matmul_map1_value_t;
+zenConcurrentMap<Key_matmul, matmul_map1_value_t>
+matmul_kernel_map1_helper;
 
 //Map value is tuple of (vector<pair>, execution time of algo, Algo Path)
 //Each element of vector represents pair of
 //iteration count and average time for each algo(iteration count, average time)
-std::unordered_map<Key_matmul,std::tuple<std::vector<std::pair<unsigned int,float>>, float, unsigned int>>
-        matmul_kernel_map2_helper;
+typedef std::tuple<std::vector<std::pair<unsigned int,float>>, float, unsigned int>
+matmul_map2_value_t;
+zenConcurrentMap<Key_matmul, matmul_map2_value_t>
+matmul_kernel_map2_helper;
+
+//Returns the best algo found so far for the layer
+static unsigned int get_best_algo(const Key_matmul &key_obj) {
+    unsigned int algo = zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1;
+    matmul_kernel_map.find(key_obj, algo);
+    return algo;
+}
+
+//Selects the algo to evaluate from the iteration count of the layer
+//and increments the count. Used by auto_compute_matmul_v1 and v3.
+static unsigned int next_eval_algo(const Key_matmul &key_obj,
+                                   const matmul_map1_value_t &map_value) {
+    unsigned int algo = zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1;
+    matmul_kernel_map1_helper.update(key_obj, map_value,
+    [&](matmul_map1_value_t &value) {
+        algo = (std::get<0>(value)%NUM_OF_ALGO) +1;
+        std::get<0>(value) += 1;
+    });
+    return algo;
+}
+
+//Records algo as the best one if cur_algo_time beats the minimum time
+//seen so far. Returns true if the map was updated.
+static bool update_best_algo(const Key_matmul &key_obj,
+                             const matmul_map1_value_t &map_value, float cur_algo_time,
+                             unsigned int algo) {
+    bool updated = false;
+    matmul_kernel_map1_helper.update(key_obj, map_value,
+    [&](matmul_map1_value_t &value) {
+        updated = cur_algo_time < std::get<1>(value);
+        if (updated) {
+            std::get<1>(value) = cur_algo_time; //Minimum time for chosen algo
+            std::get<2>(value) = algo; //Algo with minimum time (1-NUM_OF_ALGO)
+            //Published under the helper shard lock so that the best algo
+            //can not be overwritten by a slower concurrent evaluation
+            matmul_kernel_map.insert_or_assign(key_obj, algo);
+        }
+    });
+    return updated;
+}
 
-//Writing in the file from the map.
+//Records the tuned algos with their best time in the tuning database
+//and merges them into the file.
 int map_write_to_file() {
 
     //Fetch File name given by user.
-    char *fname = getenv("ZENDNN_MATMUL_MAP_FILE");
+    const char *fname = zendnnTuningDB::getFile();
     if (fname == NULL) {
-        fname = (char *)"key_matmul_map.csv";
-    }
-
-    std::ofstream file;
-    Key_matmul sobj;
-    file.open(fname,std::ios::out);
-
-    //File not open
-    if (!file.is_open()) {
-        return 1;
+        fname = "key_matmul_map.csv";
     }
 
-    //Put Main header.
-    file<<"ZENDNN MatMul Primitive Map for selecting best Algo path\n";
-    int cpu_i[CPU_INFO_SIZE];
-
-    //get the cpuid in cpu_i
-    if (getCpuID_brandString(cpu_i)==0) {
-        file<<(char *)cpu_i<<"\n";
-    }
-    else {
-        file<<"Architecture brand string not found\n";
-    }
-    file<<"Transpose Input,Transpose Filter,M,K,N,lda,ldb,ldc,Thread,Algo\n";
-    for (auto itr=matmul_kernel_map.begin(); itr!=matmul_kernel_map.end(); itr++) {
-        sobj = (*itr).first;
-        unsigned int algo_type = (*itr).second;
-
-        file<<sobj.transpose_input<<","<<sobj.transpose_weights<<","<<sobj.m<<","<<sobj.k<<","<<sobj.n<<","<<sobj.lda<<","<<sobj.ldb<<","<<sobj.ldc<<","<<sobj.thread_count<<","<<algo_type<<"\n";
-    }
-
-    file.close();
-
-    zendnnInfo(ZENDNN_ALGOLOG, "MAP FILE LOCATION ", fname);
+    zendnnTuningDB &tuning_db = zendnnTuningDB::ZenDNNTuningDB();
+    matmul_kernel_map.for_each([&](const Key_matmul &sobj,
+    unsigned int algo_type) {
+        //Best time is kept by the helper map of the auto tuner version
+        float time_ms = 0;
+        matmul_map1_value_t map1_value;
+        matmul_map2_value_t map2_value;
+        if (matmul_kernel_map1_helper.find(sobj, map1_value)) {
+            time_ms = std::get<1>(map1_value);
+        }
+        else if (matmul_kernel_map2_helper.find(sobj, map2_value)) {
+            time_ms = std::get<1>(map2_value);
+        }
+        tuning_db.record(zenTuningKey(TUNING_OP_MATMUL_F32, sobj), algo_type,
+                         time_ms);
+    });
 
-    return 0;
+    return tuning_db.save(fname);
 }
 
 
@@ -126,92 +146,32 @@ int map_write_to_file() {
 int map_read_from_file() {
 
     //Fetch File name given by user.
-    char *fname = getenv("ZENDNN_MATMUL_MAP_FILE");
-
-    //File not specified
-    if (fname == NULL) {
-        return 1;
-    }
-
-    Key_matmul obj;
-    std::vector<unsigned int> map_data; //Store each comma separated value
-    std::string temp1,temp2;
-    const char *cpu_str; //To store cpu name as char array.
-    int *temp_cpu_name;
-
-    std::ifstream file;
-    file.open(fname,std::ios::in);
+    const char *fname = zendnnTuningDB::getFile();
 
-    int cpu_i[CPU_INFO_SIZE];
-    if (getCpuID_brandString(cpu_i)!=0) {
-        zendnnError(ZENDNN_ALGOLOG, "Could not fetch CPUID.");
+    zendnnTuningDB &tuning_db = zendnnTuningDB::ZenDNNTuningDB();
+    if (tuning_db.load(fname)) {
         return 1;
     }
 
-    if (file.fail()) {
-        return 1;
-    }
-    else {
-        //read first header
-        getline(file,temp1);
-
-        //Read CPU Name and Check
-        getline(file,temp1);
-
-        cpu_str = temp1.c_str();
-        temp_cpu_name = (int *)cpu_str;
-
-        //Check if CPU name in File is same as current CPU.
-        for (int i=0; i<CPU_INFO_SIZE; i++) {
-            if (temp_cpu_name[i]!=cpu_i[i]) {
-                return 1;
-            }
-        }
-
-        //Read Third line of header
-        getline(file,temp1);
-
-        //Read values from file
-        while (getline(file,temp1)) {
-            std::stringstream line(temp1);
-
-            //Checking for invalid value provided in the file.
-            try {
-                //Retrieve each value from the line(comma separated).
-                while (getline(line, temp2, ',')) {
-                    map_data.push_back(stod(temp2));
-                }
-
-                //Few or more number of values in line
-                if (map_data.size() != NUM_MAP_VALUES) {
-                    return 1;
-                }
-
-            }
-            catch (std::invalid_argument const &e) {
-                return 1;
-            }
-
-            obj.transpose_input = map_data[0];
-            obj.transpose_weights = map_data[1];
-            obj.m = map_data[2];
-            obj.k = map_data[3];
-            obj.n = map_data[4];
-            obj.lda = map_data[5];
-            obj.ldb = map_data[6];
-            obj.ldc = map_data[7];
-            obj.thread_count = map_data[8];
-
-            // weight address is set to NULL for Persistent map feature.
-            obj.weights = NULL;
-
-            //Fill value in the map.
-            matmul_kernel_map[obj] = map_data[9];
-
-            map_data.clear();
-        }
-        file.close();
-    }
+    tuning_db.for_each(TUNING_OP_MATMUL_F32, [&](const Key_tuning &key,
+    const zenTuningRecord &record) {
+        Key_matmul obj;
+        obj.transpose_input = key.dims[0];
+        obj.transpose_weights = key.dims[1];
+        obj.m = key.dims[2];
+        obj.k = key.dims[3];
+        obj.n = key.dims[4];
+        obj.lda = key.dims[5];
+        obj.ldb = key.dims[6];
+        obj.ldc = key.dims[7];
+        obj.thread_count = key.thread_count;
+
+        // weight address is set to NULL for Persistent map feature.
+        obj.weights = NULL;
+
+        //Fill value in the map.
+        matmul_kernel_map.insert_or_assign(obj, record.algo);
+    });
 
     return 0;
 }
@@ -269,18 +229,19 @@ int auto_compute_matmul_v1(
         zendnn::zendnn_getenv_int("ZENDNN_MATMUL_EVALUATE_ITER",
                                   MATMUL_EVALUATE_ITER_V1);
 
-    //finds object in map
-    auto found_obj = matmul_kernel_map1_helper.find(key_obj);
+    //finds object in map, map_value is a snapshot of the entry
+    matmul_map1_value_t map_value;
+    bool found_obj = matmul_kernel_map1_helper.find(key_obj, map_value);
 
     //If iteration count is less than Skip iteration then run default algo
-    if (found_obj == matmul_kernel_map1_helper.end() ||
+    if (!found_obj ||
             graph_exe_count < skip_iteration) {
 
         //Set algo 3 initially
         zenEnvObj.zenGEMMalgo = zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1;
 
         //If Key not found in map then time the algo and add new element to map
-        if (found_obj == matmul_kernel_map1_helper.end()) {
+        if (!found_obj) {
 
             //Time start
 #ifdef _WIN32
@@ -306,9 +267,10 @@ int auto_compute_matmul_v1(
                             (end_n.tv_usec - start_n.tv_usec)/ 1000.0f; //time in milliseconds
 #endif
 
-            //Create new entry
-            matmul_kernel_map[key_obj] = zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1;
-            matmul_kernel_map1_helper[key_obj] = {0, cur_algo_time, zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1}; // {eval_count, time, algo}
+            //Create new entry, first thread to publish wins
+            matmul_kernel_map.insert(key_obj, zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1);
+            matmul_kernel_map1_helper.insert(key_obj, matmul_map1_value_t(0,
+                                             cur_algo_time, zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1)); // {eval_count, time, algo}
         }
         else {
             zenMatMul_gemm(zenEnvObj, true, Layout, transpose_input, transpose_weights, m,
@@ -324,7 +286,7 @@ int auto_compute_matmul_v1(
     else if (graph_exe_count >= evaluate_iteration + skip_iteration) {
 
         //Get best algo for given layer from MAP
-        zenEnvObj.zenGEMMalgo = matmul_kernel_map[key_obj];
+        zenEnvObj.zenGEMMalgo = get_best_algo(key_obj);
         zenMatMul_gemm(zenEnvObj, true, Layout, transpose_input, transpose_weights, m,
                        k,
                        n,
@@ -332,7 +294,7 @@ int auto_compute_matmul_v1(
                        is_weights_const);
 
         //Writing Map in file.
-        if (persistent_map_flag->first == persistentMapType::WRITE &&
+        if (persistent_map_flag->first == zenTuningDBMode::TUNING_DB_WRITE &&
                 persistent_map_flag->second) {
             if (map_write_to_file()) {
                 zendnnError(ZENDNN_ALGOLOG,
@@ -346,9 +308,8 @@ int auto_compute_matmul_v1(
     else {
 
         //Get the number of iteration already ran and select Algo to run for current iteration
-        //get<0>(found_obj->second) = count of iteration
-        zenEnvObj.zenGEMMalgo = (std::get<0>(found_obj->second)%NUM_OF_ALGO) +1;
-        std::get<0>(found_obj->second) += 1;
+        //get<0>(map_value) = count of iteration
+        zenEnvObj.zenGEMMalgo = next_eval_algo(key_obj, map_value);
 
         //timer start
 #ifdef _WIN32
@@ -373,13 +334,7 @@ int auto_compute_matmul_v1(
 #endif
 
         //If current run gives better timing then update
-        if (cur_algo_time < std::get<1>(found_obj->second)) {
-            std::get<1>(found_obj->second) = cur_algo_time; //Minimum time for chosen algo
-            std::get<2>(found_obj->second) =
-                zenEnvObj.zenGEMMalgo; //Algo with minimum time (1-NUM_OF_ALGO)
-
-            matmul_kernel_map[key_obj] = zenEnvObj.zenGEMMalgo;
-        }
+        update_best_algo(key_obj, map_value, cur_algo_time, zenEnvObj.zenGEMMalgo);
 
     }
 
@@ -439,18 +394,19 @@ int auto_compute_matmul_v2(
         zendnn::zendnn_getenv_int("ZENDNN_MATMUL_EVALUATE_ITER",
                                   MATMUL_EVALUATE_ITER_V2);
 
-    //finds object in map
-    auto found_obj = matmul_kernel_map2_helper.find(key_obj);
+    //finds object in map, map_value is a snapshot of the entry
+    matmul_map2_value_t map_value;
+    bool found_obj = matmul_kernel_map2_helper.find(key_obj, map_value);
 
     //If iteration count is less than Skip iteration then run default algo
-    if (found_obj == matmul_kernel_map2_helper.end() ||
+    if (!found_obj ||
             graph_exe_count < skip_iteration) {
 
         //Set algo 3 initially
         zenEnvObj.zenGEMMalgo = zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1;
 
         //If Key not found in map then time the algo and add new element to map
-        if (found_obj == matmul_kernel_map2_helper.end()) {
+        if (!found_obj) {
 
             //Time start
 #ifdef _WIN32
@@ -479,8 +435,9 @@ int auto_compute_matmul_v2(
             //Create new entry
             //initial vector for average time and iteration count for each algorithms.
             std::vector<std::pair<unsigned int,float>> initial_vec(NUM_OF_ALGO, {0,0.0});
-            matmul_kernel_map2_helper[key_obj] = {initial_vec, cur_algo_time, zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1};
-            matmul_kernel_map[key_obj] = zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1;
+            matmul_kernel_map2_helper.insert(key_obj, matmul_map2_value_t(initial_vec,
+                                             cur_algo_time, zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1));
+            matmul_kernel_map.insert(key_obj, zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1);
             //value of map {vector<{iteration,avg time}>, time, algo}
         }
         else {
@@ -494,14 +451,14 @@ int auto_compute_matmul_v2(
     else if (graph_exe_count >= evaluate_iteration + skip_iteration) {
 
         //Get best algo for given layer from MAP (tuple's 2nd index has algo)
-        zenEnvObj.zenGEMMalgo = matmul_kernel_map[key_obj];
+        zenEnvObj.zenGEMMalgo = get_best_algo(key_obj);
 
         zenMatMul_gemm(zenEnvObj, true, Layout, transpose_input, transpose_weights, m,
                        k, n, alpha, input, lda, weights, ldb, bias, relu, gelu, beta, output, ldc,
                        is_weights_const);
 
         //Writing Map in file.
-        if (persistent_map_flag->first == persistentMapType::WRITE &&
+        if (persistent_map_flag->first == zenTuningDBMode::TUNING_DB_WRITE &&
                 persistent_map_flag->second) {
             if (map_write_to_file()) {
                 zendnnError(ZENDNN_ALGOLOG,
@@ -539,25 +496,26 @@ int auto_compute_matmul_v2(
                         (end_n.tv_usec - start_n.tv_usec) / 1000.0f; //time in milliseconds
 #endif
 
-        //Finding the current algorithm's average time and iteration stored in Map
-        float t_algo =  std::get<0>(found_obj->second)[zenEnvObj.zenGEMMalgo -
-                                              1].second;
-        unsigned int i_algo = std::get<0>(found_obj->second)[zenEnvObj.zenGEMMalgo -
-                                                    1].first;
-
-        //updating the average time and iteration for the current algorithm run.
-        cur_algo_time = ((t_algo*i_algo) + cur_algo_time)/(i_algo+1);
-        std::get<0>(found_obj->second)[zenEnvObj.zenGEMMalgo - 1].second =
-            cur_algo_time;
-        std::get<0>(found_obj->second)[zenEnvObj.zenGEMMalgo - 1].first +=1;
-
-        //If current run gives better timing then update
-        if (cur_algo_time < std::get<1>(found_obj->second)) {
-            std::get<1>(found_obj->second) = cur_algo_time; //Minimum time for chosen algo
-            std::get<2>(found_obj->second) =
-                zenEnvObj.zenGEMMalgo; //Algo with minimum time (1-NUM_OF_ALGO)
-            matmul_kernel_map[key_obj] = zenEnvObj.zenGEMMalgo;
-        }
+        unsigned int algo = zenEnvObj.zenGEMMalgo;
+        float run_time = cur_algo_time;
+        matmul_kernel_map2_helper.update(key_obj, map_value,
+        [&](matmul_map2_value_t &value) {
+            //Finding the current algorithm's average time and iteration stored in Map
+            float t_algo = std::get<0>(value)[algo - 1].second;
+            unsigned int i_algo = std::get<0>(value)[algo - 1].first;
+
+            //updating the average time and iteration for the current algorithm run.
+            float avg_time = ((t_algo*i_algo) + run_time)/(i_algo+1);
+            std::get<0>(value)[algo - 1].second = avg_time;
+            std::get<0>(value)[algo - 1].first +=1;
+
+            //If current run gives better timing then update
+            if (avg_time < std::get<1>(value)) {
+                std::get<1>(value) = avg_time; //Minimum time for chosen algo
+                std::get<2>(value) = algo; //Algo with minimum time (1-NUM_OF_ALGO)
+                matmul_kernel_map.insert_or_assign(key_obj, algo);
+            }
+        });
     }
 
     return zenEnvObj.zenGEMMalgo;
@@ -615,19 +573,20 @@ int auto_compute_matmul_v3(
         zendnn::zendnn_getenv_int("ZENDNN_MATMUL_EVALUATE_ITER",
                                   MATMUL_EVALUATE_ITER_V3);
 
-    //finds object in map
-    auto found_obj = matmul_kernel_map1_helper.find(key_obj);
+    //finds object in map, map_value is a snapshot of the entry
+    matmul_map1_value_t map_value;
+    bool found_obj = matmul_kernel_map1_helper.find(key_obj, map_value);
 
     //If current iterations less than Skip iteration then run default algo.
     //Checks using the (0) element of map value that denotes count of iterations in map
-    if (found_obj == matmul_kernel_map1_helper.end() ||
-            std::get<0>(found_obj->second) < skip_iteration) {
+    if (!found_obj ||
+            std::get<0>(map_value) < skip_iteration) {
 
         //Set algo 3 initially
         zenEnvObj.zenGEMMalgo = zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1;
 
         //If Key not found in map then time the algo and add new element to map
-        if (found_obj == matmul_kernel_map1_helper.end()) {
+        if (!found_obj) {
 
             //Time start
 #ifdef _WIN32
@@ -652,12 +611,16 @@ int auto_compute_matmul_v3(
 #endif
 
             //Create new entry
-            matmul_kernel_map1_helper[key_obj] = {1, cur_algo_time, zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1}; // {iter_count, time, algo}
-            matmul_kernel_map[key_obj] = zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1;
+            matmul_kernel_map1_helper.insert(key_obj, matmul_map1_value_t(1,
+                                             cur_algo_time, zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1)); // {iter_count, time, algo}
+            matmul_kernel_map.insert(key_obj, zenMatMulAlgoType::MATMUL_ZENDNN_GEMM1);
         }
         //If key found then increment the iter_count and run algo 3.
         else {
-            std::get<0>(found_obj->second) += 1;
+            matmul_kernel_map1_helper.update(key_obj, map_value,
+            [](matmul_map1_value_t &value) {
+                std::get<0>(value) += 1;
+            });
             zenMatMul_gemm(zenEnvObj, true, Layout, transpose_input, transpose_weights, m,
                            k, n, alpha, input, lda, weights, ldb, bias, relu, gelu, beta, output, ldc,
                            is_weights_const);
@@ -665,16 +628,16 @@ int auto_compute_matmul_v3(
     }
     //Read Value from map.
     //Runs after skip iterations and evaluation iterations are done.
-    else if (std::get<0>(found_obj->second) > evaluate_iteration + skip_iteration) {
+    else if (std::get<0>(map_value) > evaluate_iteration + skip_iteration) {
 
         //Get best algo for given layer from MAP
-        zenEnvObj.zenGEMMalgo = matmul_kernel_map[key_obj];
+        zenEnvObj.zenGEMMalgo = get_best_algo(key_obj);
         zenMatMul_gemm(zenEnvObj, true, Layout, transpose_input, transpose_weights, m,
                        k, n, alpha, input, lda, weights, ldb, bias, relu, gelu, beta, output, ldc,
                        is_weights_const);
 
         //Writing Map in file.
-        if (persistent_map_flag->first == persistentMapType::WRITE &&
+        if (persistent_map_flag->first == zenTuningDBMode::TUNING_DB_WRITE &&
                 persistent_map_flag->second) {
             if (map_write_to_file()) {
                 zendnnError(ZENDNN_ALGOLOG,
@@ -688,9 +651,8 @@ int auto_compute_matmul_v3(
     else {
 
         //Get the number of iteration already ran and select Algo to run for current iteration
-        //get<0>(found_obj->second) = count of iteration
-        zenEnvObj.zenGEMMalgo = (std::get<0>(found_obj->second)%NUM_OF_ALGO) +1;
-        std::get<0>(found_obj->second) += 1;
+        //get<0>(map_value) = count of iteration
+        zenEnvObj.zenGEMMalgo = next_eval_algo(key_obj, map_value);
         //timer start
 #ifdef _WIN32
         auto start_n = std::chrono::high_resolution_clock::now();
@@ -715,12 +677,8 @@ int auto_compute_matmul_v3(
 
 
         //If current run gives better timing then update
-        if (cur_algo_time < std::get<1>(found_obj->second)) {
-            std::get<1>(found_obj->second) = cur_algo_time; //Minimum time for chosen algo
-            std::get<2>(found_obj->second) =
-                zenEnvObj.zenGEMMalgo; //Algo with minimum time (1-NUM_OF_ALGO)
-            matmul_kernel_map[key_obj] = zenEnvObj.zenGEMMalgo;
-
+        if (update_best_algo(key_obj, map_value, cur_algo_time,
+                             zenEnvObj.zenGEMMalgo)) {
             //To update the map file if any update occurs after writing map once.
             persistent_map_flag->second = 1;
         }
@@ -762,13 +720,7 @@ int auto_compute_matmul(
     //Persistent Map
     //{ 0: disable, 1: write, 2:read }
     unsigned int persistent_map =
-        zendnn::zendnn_getenv_int("ZENDNN_MATMUL_PERSISTENT_MAP",
-                                  persistentMapType::DISABLE);
-
-    //If Persistent map value not 0/1/2 then assume it as Disabled.
-    if (persistent_map >2) {
-        persistent_map = persistentMapType::DISABLE;
-    }
+        zendnnTuningDB::getMode("ZENDNN_MATMUL_PERSISTENT_MAP");
 
     //Select auto_tuner version
     //Auto_type 1 and 2 works only with framework.
@@ -794,11 +746,11 @@ int auto_compute_matmul(
     //This condition makes sure that address
     //doesn't gets saved while using persistent map.
     key_obj.weights = mapType == 1 &&
-                      persistent_map == persistentMapType::DISABLE ? weights : NULL;
+                      persistent_map == zenTuningDBMode::TUNING_DB_DISABLE ? weights : NULL;
     key_obj.thread_count = zenEnvObj.omp_num_threads;
 
     //Read operation from File (Persistent Map)
-    if (persistent_map == persistentMapType::READ) {
+    if (persistent_map == zenTuningDBMode::TUNING_DB_READ) {
         //Check if we need to read the map from file.
         if (persistent_map_flag.second) {
             if (map_read_from_file()) {
@@ -809,8 +761,9 @@ int auto_compute_matmul(
             persistent_map_flag.second = 0;
         }
         //Check if given key exist in map or not
-        if (matmul_kernel_map.find(key_obj) != matmul_kernel_map.end()) {
-            zenEnvObj.zenGEMMalgo = matmul_kernel_map[key_obj];
+        unsigned int map_algo;
+        if (matmul_kernel_map.find(key_obj, map_algo)) {
+            zenEnvObj.zenGEMMalgo = map_algo;
 
             zenMatMul_gemm(zenEnvObj, true, Layout, transpose_input, transpose_weights, m,
                            k,
@@ -867,3 +820,47 @@ int auto_compute_matmul(
 
     return algo_type;
 }
+
+namespace zendnn {
+
+int zendnnTuneMatMul(bool transpose_input, bool transpose_weights, int m,
+                     int k, int n, int lda, int ldb, int ldc, unsigned int thread_count,
+                     unsigned int iterations) {
+    if (m <= 0 || k <= 0 || n <= 0 || thread_count == 0 ||
+            lda < (transpose_input ? m : k) || ldb < (transpose_weights ? k : n) ||
+            ldc < n) {
+        return -1;
+    }
+    zendnnEnv zenEnvObj = readEnv();
+    zenEnvObj.omp_num_threads = thread_count;
+
+    std::vector<float> input((size_t)(transpose_input ? k : m) * lda, 0.5f);
+    std::vector<float> weights((size_t)(transpose_weights ? n : k) * ldb, 0.25f);
+    std::vector<float> output((size_t)m * ldc);
+
+    Key_matmul key_obj;
+    key_obj.transpose_input = transpose_input;
+    key_obj.transpose_weights = transpose_weights;
+    key_obj.m = m;
+    key_obj.k = k;
+    key_obj.n = n;
+    key_obj.lda = lda;
+    key_obj.ldb = ldb;
+    key_obj.ldc = ldc;
+    key_obj.weights = NULL;
+    key_obj.thread_count = thread_count;
+
+    //Weights are constant as in inference, so the reorder is only timed
+    //in the warm up run
+    unsigned int algo = zenTuningSweep(zenTuningKey(TUNING_OP_MATMUL_F32, key_obj),
+                                       NUM_OF_ALGO, iterations, [&](unsigned int eval_algo) {
+        zenEnvObj.zenGEMMalgo = eval_algo;
+        zenMatMul_gemm(zenEnvObj, true, true, transpose_input, transpose_weights, m,
+                       k, n, 1.0f, input.data(), lda, weights.data(), ldb, NULL, false, 0,
+                       0.0f, output.data(), ldc, true);
+    });
+    zendnnInvalidateWeights(weights.data());
+    return algo;
+}
+
+}
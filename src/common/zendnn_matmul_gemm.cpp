@@ -23,14 +23,17 @@
     #include "cblas_with_blis_api.hpp"
 #endif // ZENDNN_USE_AOCL_BLIS_API
 #include <time.h>
+#include <algorithm>
 #include <vector>
 #include <mutex>
 #include <cmath>
 #include "zendnn_logging.hpp"
 #include "zendnn_private.hpp"
+#include "zendnn_weight_cache.hpp"
+#include "zendnn_matmul_plan.hpp"
+#include "zendnn_cpu_topology.hpp"
 #include "zendnn.hpp"
 
-std::mutex map_mutex;
 using namespace zendnn;
 using tag = memory::format_tag;
 using dt = memory::data_type;
@@ -41,13 +44,74 @@ using dt = memory::data_type;
 extern float gelu_const;
 extern int graph_exe_count;
 
-//Simplified Map having Key as struct and value as Blocked Weight matrix address.
-std::unordered_map<Key_matmul, float * >
-matmul_weight_caching_map;
+//Engine shared by the MatMul primitive paths, streams are per thread
+static zendnn::engine &zenMatMulEngine() {
+    static zendnn::engine eng(engine::kind::cpu, 0);
+    return eng;
+}
+
+static zendnn::stream &zenMatMulStream() {
+    static thread_local zendnn::stream engine_stream(zenMatMulEngine());
+    return engine_stream;
+}
 
-//Map for weight caching(reordered memory) for JIT Primitive
-std::unordered_map<Key_matmul, zendnn::memory >
-matmul_weight_caching_map_jit_kernel;
+#ifdef ZENDNN_ENABLE_LPGEMM_V4_2
+//AOCL post-op chain of zenMatMul_gemm_blocked, built once per
+//(n, post-ops, alpha) and reused. Order of postops: BIAS -> RELU/GELU
+struct zenAoclPostOpPlan {
+    aocl_post_op post_ops;
+    AOCL_POST_OP_TYPE seq_vector[2];
+    aocl_post_op_eltwise eltwise;
+    //alpha * bias, passed to AOCL when alpha != 1
+    std::vector<float> scaled_bias;
+    const float *scaled_from;
+
+    zenAoclPostOpPlan(bool bias, bool relu, int gelu, int n) : scaled_from(NULL) {
+        memset(&post_ops, 0, sizeof(aocl_post_op));
+        memset(&eltwise, 0, sizeof(aocl_post_op_eltwise));
+        int post_op_i = 0;
+        if (bias) {
+            seq_vector[post_op_i++] = BIAS;
+            scaled_bias.resize(n);
+        }
+        if (relu || gelu) {
+            seq_vector[post_op_i++] = ELTWISE;
+            eltwise.is_power_of_2 = FALSE;
+            eltwise.scale_factor = NULL;
+            eltwise.algo.alpha = NULL;
+            eltwise.algo.beta = NULL;
+            eltwise.algo.algo_type = relu ? RELU : (gelu == 1 ? GELU_TANH : GELU_ERF);
+            post_ops.eltwise = &eltwise;
+        }
+        post_ops.seq_vector = seq_vector;
+        post_ops.seq_length = post_op_i;
+    }
+
+    //Binds the bias of the current call. The scaled bias is recomputed only
+    //if the bias buffer changed or is not constant.
+    aocl_post_op *bind(const float *bias, float alpha, bool is_bias_const,
+                       unsigned int thread_qty) {
+        if (bias != NULL) {
+            if (alpha != 1.0f) {
+                if (!is_bias_const || scaled_from != bias) {
+                    float *bias_ = scaled_bias.data();
+                    int n = scaled_bias.size();
+                    #pragma omp parallel for num_threads(thread_qty)
+                    for (int i=0; i<n; ++i) {
+                        bias_[i] = alpha * bias[i];
+                    }
+                    scaled_from = bias;
+                }
+                post_ops.bias.bias = scaled_bias.data();
+            }
+            else {
+                post_ops.bias.bias = (float *)bias;
+            }
+        }
+        return &post_ops;
+    }
+};
+#endif
 
 void zenMatMul_gemm_blocked(
     zendnnEnv zenEnvObj,
@@ -88,8 +152,15 @@ void zenMatMul_gemm_blocked(
         key_obj.weights = filter;
         key_obj.thread_count = thread_qty;
 
-        //finds object in map
-        auto found_obj = matmul_weight_caching_map.find(key_obj);
+        //finds object in weight cache
+        zendnnWeightCache &weight_cache = zendnnWeightCache::ZenDNNWeightCache();
+        Key_weight_cache cache_key = weight_cache.getKey(key_obj,
+                                     WEIGHT_CACHE_AOCL_F32,
+                                     zenWeightSpan(transpose_filter, k, n, ldb, sizeof(float)));
+        std::shared_ptr<float> reorder_buf;
+        if (is_weights_const) {
+            reorder_buf = weight_cache.find_as<float>(cache_key);
+        }
         // Blocked BLIS API for matmul
         // Set post_ops to NULL and define reorder_param0 as 'B' for B matrix
         // Define dimentions of B matrix as reorder_param1 and reorder_param2
@@ -104,7 +175,7 @@ void zenMatMul_gemm_blocked(
         float_t *reorder_filter = NULL;
 
         //Weight caching based on is_weights_const
-        if (!is_weights_const || found_obj == matmul_weight_caching_map.end()) {
+        if (!reorder_buf) {
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
             zendnnVerbose(ZENDNN_PROFLOG,"BLIS 4.2 enabled");
             siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_f32f32f32of32(
@@ -120,88 +191,37 @@ void zenMatMul_gemm_blocked(
             aocl_reorder_f32f32f32of32('B', filter, reorder_filter, k,
                                        n, ldb);
 #endif
+            reorder_buf = std::shared_ptr<float>(reorder_filter, free);
             //Create new entry
-            map_mutex.lock();
-            matmul_weight_caching_map[key_obj] = reorder_filter;
-            map_mutex.unlock();
-        }
-        else {
-            reorder_filter = matmul_weight_caching_map[key_obj];
+            if (is_weights_const) {
+                reorder_buf = weight_cache.insert_as<float>(cache_key, reorder_buf,
+                              b_reorder_buf_siz_req);
+            }
         }
+        reorder_filter = reorder_buf.get();
 
 
 #ifdef ZENDNN_ENABLE_LPGEMM_V4_2
         // Currently 4.2 blis post ops are used
-        int postop_count = 0;
-        if (bias != NULL) {
-            ++postop_count;
-        }
-        if (relu|| gelu) {
-            ++postop_count;
-        }
-
-        // Create postop for LPGEMM
-        // Order of postops: BIAS -> RELU -> SCALE
-        if (postop_count > 0) {
-            post_ops = (aocl_post_op *) malloc(sizeof(aocl_post_op));
-            dim_t max_post_ops_seq_length = postop_count;
-            post_ops->seq_vector = (AOCL_POST_OP_TYPE *) malloc(max_post_ops_seq_length *
-                                   sizeof(AOCL_POST_OP_TYPE));
-
-            // Iterate through each postop, check and add it if needed.
-            int post_op_i = 0;
-            if (bias != NULL) {
-                // Add bias postop
-                float *bias_ = new float[n]();//const_cast<float*>(bias);
-                if (alpha != 1.0f) {
-                    #pragma omp parallel for num_threads(thread_qty)
-                    for (int i=0; i<n; ++i) {
-                        bias_[i] = alpha * bias[i];
-                    }
-                }
-                post_ops->seq_vector[post_op_i++] = BIAS;
-                post_ops->bias.bias = (alpha!=1.0f) ? bias_ : (float *)bias;
-            }
-            if (relu) {
-                // Add ReLU postop
-                dim_t eltwise_index = 0;
-                post_ops->seq_vector[post_op_i++] = ELTWISE;
-                post_ops->eltwise = (aocl_post_op_eltwise *) malloc(sizeof(
-                                        aocl_post_op_eltwise));
-                (post_ops->eltwise + eltwise_index)->is_power_of_2 = FALSE;
-                (post_ops->eltwise + eltwise_index)->scale_factor = NULL;
-                (post_ops->eltwise + eltwise_index)->algo.alpha = NULL;
-                (post_ops->eltwise + eltwise_index)->algo.beta = NULL;
-                (post_ops->eltwise + eltwise_index)->algo.algo_type = RELU;
+        // Post-op chain depends only on n and the post-op signature, bias
+        // constness follows the weights.
+        if (bias != NULL || relu || gelu) {
+            Key_matmul post_op_key = Key_matmul();
+            post_op_key.n = n;
+            Key_matmul_plan plan_key = zenMatMulPlanKey(MATMUL_PLAN_AOCL_POST_OPS,
+                                       post_op_key, zenMatMulPlanPostOps(bias != NULL, relu, gelu),
+                                       bias != NULL ? alpha : 1.0f, 0.0f);
+            zenMatMulPlanCache<zenAoclPostOpPlan> &plan_cache =
+                zenMatMulPlanCache<zenAoclPostOpPlan>::ZenDNNMatMulPlanCache();
+            zenAoclPostOpPlan *plan = plan_cache.find(plan_key);
+            if (plan == NULL) {
+                plan = plan_cache.insert(plan_key, std::unique_ptr<zenAoclPostOpPlan>
+                                         (new zenAoclPostOpPlan(bias != NULL, relu, gelu, n)));
             }
-
-            else if (gelu == 1) {
-                // Add ReLU postop
-                dim_t eltwise_index = 0;
-                post_ops->seq_vector[post_op_i++] = ELTWISE;
-                post_ops->eltwise = (aocl_post_op_eltwise *) malloc(sizeof(
-                                        aocl_post_op_eltwise));
-                (post_ops->eltwise + eltwise_index)->is_power_of_2 = FALSE;
-                (post_ops->eltwise + eltwise_index)->scale_factor = NULL;
-                (post_ops->eltwise + eltwise_index)->algo.alpha = NULL;
-                (post_ops->eltwise + eltwise_index)->algo.beta = NULL;
-                (post_ops->eltwise + eltwise_index)->algo.algo_type = GELU_TANH;
-            }
-            else if (gelu == 2) {
-                // Add ReLU postop
-                dim_t eltwise_index = 0;
-                post_ops->seq_vector[post_op_i++] = ELTWISE;
-                post_ops->eltwise = (aocl_post_op_eltwise *) malloc(sizeof(
-                                        aocl_post_op_eltwise));
-                (post_ops->eltwise + eltwise_index)->is_power_of_2 = FALSE;
-                (post_ops->eltwise + eltwise_index)->scale_factor = NULL;
-                (post_ops->eltwise + eltwise_index)->algo.alpha = NULL;
-                (post_ops->eltwise + eltwise_index)->algo.beta = NULL;
-                (post_ops->eltwise + eltwise_index)->algo.algo_type = GELU_ERF;
-            }
-            post_ops->seq_length = postop_count;
+            post_ops = plan->bind(bias, alpha, is_weights_const, thread_qty);
         }
 #endif
+
         //Perform MatMul using AMD BLIS
         aocl_gemm_f32f32f32of32(Layout? 'r' : 'c',
                                 transpose_input ? 't' : 'n',
@@ -211,24 +231,7 @@ void zenMatMul_gemm_blocked(
                                 output, ldc,
                                 post_ops);
 
-#ifdef ZENDNN_ENABLE_LPGEMM_V4_2
-        // Currently 4.2 blis post ops are used
-        // Free memory for postops.
-        if (bias != NULL) {
-            //Bias is directly passed
-            post_ops->bias.bias = NULL;
-        }
-        if (relu || gelu) {
-            free(post_ops->eltwise);
-        }
-        if (postop_count > 0) {
-            free(post_ops->seq_vector);
-            free(post_ops);
-        }
-        if (!is_weights_const) {
-            free(reorder_filter);
-        }
-#else
+#ifndef ZENDNN_ENABLE_LPGEMM_V4_2
         // ZenDNN post ops used when 4.1 BLIS is used
         if (bias || relu || gelu) {
             zenPostOps(zenEnvObj, output, NULL, m, 1, n,
@@ -269,38 +272,25 @@ void zenMatMul_gemm_blocked(
     }
 }
 
-void zenMatMulPrimitive(zendnnEnv zenEnvObj, const bool Layout,
-                        const bool TransA, const bool TransB, const int M,
-                        const int N, const int K,
-                        const float *A_Array, const float *B_Array,
-                        float *C_Array, const float alpha,
-                        const float beta, const int lda, const int ldb,
-                        const int ldc, const float *bias, const bool relu,
-                        const int gelu, bool blocked_format, bool is_weights_const = false) {
-    zendnn::engine eng(engine::kind::cpu, 0);
-    zendnn::stream engine_stream(eng);
-
-    Key_matmul key_obj;
-    key_obj.transpose_input = TransA;
-    key_obj.transpose_weights = TransB;
-    key_obj.m = M;
-    key_obj.k = K;
-    key_obj.n = N;
-    key_obj.lda = lda;
-    key_obj.ldb = ldb;
-    key_obj.ldc = ldc;
-    key_obj.weights = B_Array;
-    key_obj.thread_count = zenEnvObj.omp_num_threads;
-
-    //finds object in map
-    auto found_obj = matmul_weight_caching_map_jit_kernel.find(key_obj);
-
-    std::vector<primitive> net;
-    std::vector<std::unordered_map<int, memory>> net_args;
-
-    float *in_arr = const_cast<float *>(A_Array);
-    float *filt_arr = const_cast<float *>(B_Array);
-    float *bias_arr = const_cast<float *>(bias);
+//Ready to run MatMul primitive of one shape and post-op signature.
+//Memory objects are bound to args once, each call only swaps data handles.
+struct zenMatMulPrimitivePlan {
+    zendnn::matmul::primitive_desc matmul_prim_disc;
+    zendnn::matmul matmul_prim;
+    zendnn::memory src_memory, user_weights_memory, bias_memory, dst_memory;
+    //Reorder target for non constant weights, allocated once per plan
+    zendnn::memory reordered_weights_memory;
+    zendnn::reorder weights_reorder;
+    std::unordered_map<int, zendnn::memory> args;
+};
+
+static zenMatMulPrimitivePlan *zenMatMulPrimitiveCreatePlan(
+    const Key_matmul_plan &plan_key, const bool TransA, const bool TransB,
+    const int M, const int N, const int K, const float alpha, const float beta,
+    const int lda, const int ldb, const int ldc, const float *bias,
+    const bool relu, const int gelu, bool blocked_format) {
+    zendnn::engine &eng = zenMatMulEngine();
+    std::unique_ptr<zenMatMulPrimitivePlan> plan(new zenMatMulPrimitivePlan);
 
     //memory dims
     memory::dims src_dims = {M, K};
@@ -361,52 +351,106 @@ void zenMatMulPrimitive(zendnnEnv zenEnvObj, const bool Layout,
                                        matmul_weights_md, bias_md, dst_md): zendnn::matmul::desc(src_md,
                                                matmul_weights_md, dst_md);
 
-    auto matmul_prim_disc =
+    plan->matmul_prim_disc =
         zendnn::matmul::primitive_desc(matmul_disc, matmul_attr, eng);
+    plan->matmul_prim = zendnn::matmul(plan->matmul_prim_disc);
+
+    //Memory creation, data handles are bound per call
+    plan->src_memory = memory(src_md, eng, NULL);
+    plan->user_weights_memory = memory(matmul_weights_md, eng, NULL);
+    plan->dst_memory = memory(dst_md, eng, NULL);
+    plan->args.insert({ZENDNN_ARG_SRC, plan->src_memory});
+    plan->args.insert({ZENDNN_ARG_DST, plan->dst_memory});
+    if (bias) {
+        plan->bias_memory = memory(bias_md, eng, NULL);
+        plan->args.insert({ZENDNN_ARG_BIAS, plan->bias_memory});
+    }
+    if (blocked_format) {
+        plan->reordered_weights_memory = memory(plan->matmul_prim_disc.weights_desc(),
+                                                eng);
+        plan->weights_reorder = reorder(plan->user_weights_memory,
+                                        plan->reordered_weights_memory);
+        plan->args.insert({ZENDNN_ARG_WEIGHTS, plan->reordered_weights_memory});
+    }
+    else {
+        plan->args.insert({ZENDNN_ARG_WEIGHTS, plan->user_weights_memory});
+    }
+
+    return zenMatMulPlanCache<zenMatMulPrimitivePlan>::ZenDNNMatMulPlanCache().insert(
+               plan_key, std::move(plan));
+}
 
-    //Memory creation
-    zendnn::memory user_weights_memory, src_memory, bias_memory, dst_memory;
-    src_memory = memory({{src_dims}, dt::f32, a_strides}, eng, in_arr);
-    user_weights_memory = memory(matmul_weights_md, eng, filt_arr);
+void zenMatMulPrimitive(zendnnEnv zenEnvObj, const bool Layout,
+                        const bool TransA, const bool TransB, const int M,
+                        const int N, const int K,
+                        const float *A_Array, const float *B_Array,
+                        float *C_Array, const float alpha,
+                        const float beta, const int lda, const int ldb,
+                        const int ldc, const float *bias, const bool relu,
+                        const int gelu, bool blocked_format, bool is_weights_const = false) {
+    zendnn::stream &engine_stream = zenMatMulStream();
 
+    Key_matmul key_obj;
+    key_obj.transpose_input = TransA;
+    key_obj.transpose_weights = TransB;
+    key_obj.m = M;
+    key_obj.k = K;
+    key_obj.n = N;
+    key_obj.lda = lda;
+    key_obj.ldb = ldb;
+    key_obj.ldc = ldc;
+    key_obj.weights = B_Array;
+    key_obj.thread_count = zenEnvObj.omp_num_threads;
+
+    //Primitive, memory objects and args are built once per shape and
+    //post-op signature
+    Key_matmul_plan plan_key = zenMatMulPlanKey(blocked_format ?
+                               MATMUL_PLAN_BLOCKED_PRIMITIVE : MATMUL_PLAN_PRIMITIVE, key_obj,
+                               zenMatMulPlanPostOps(bias != NULL, relu, gelu), alpha, beta);
+    zenMatMulPrimitivePlan *plan =
+        zenMatMulPlanCache<zenMatMulPrimitivePlan>::ZenDNNMatMulPlanCache().find(
+            plan_key);
+    if (plan == NULL) {
+        plan = zenMatMulPrimitiveCreatePlan(plan_key, TransA, TransB, M, N, K,
+                                            alpha, beta, lda, ldb, ldc, bias, relu, gelu, blocked_format);
+    }
+
+    plan->src_memory.set_data_handle(const_cast<float *>(A_Array));
+    plan->user_weights_memory.set_data_handle(const_cast<float *>(B_Array));
+    plan->dst_memory.set_data_handle(C_Array);
     if (bias) {
-        bias_memory = memory(bias_md, eng, bias_arr);
+        plan->bias_memory.set_data_handle(const_cast<float *>(bias));
     }
-    dst_memory = memory({{dst_dims}, dt::f32, memory::dims {ldc, 1}}, eng, C_Array);
 
     //Weight reordering
-    zendnn::memory reordered_weights_memory;
     if (blocked_format) {
-        if (!is_weights_const ||
-                found_obj == matmul_weight_caching_map_jit_kernel.end()) {
-            reordered_weights_memory = memory(matmul_prim_disc.weights_desc(), eng);
-            reorder(user_weights_memory, reordered_weights_memory).execute(engine_stream,
-                    user_weights_memory, reordered_weights_memory);
-
-            map_mutex.lock();
-            matmul_weight_caching_map_jit_kernel[key_obj] = reordered_weights_memory;
-            map_mutex.unlock();
+        zendnnWeightCache &weight_cache = zendnnWeightCache::ZenDNNWeightCache();
+        Key_weight_cache cache_key = weight_cache.getKey(key_obj,
+                                     WEIGHT_CACHE_JIT_F32,
+                                     zenWeightSpan(TransB, K, N, ldb, sizeof(float)));
+        std::shared_ptr<zendnn::memory> cached_weights;
+        if (is_weights_const) {
+            cached_weights = weight_cache.find_as<zendnn::memory>(cache_key);
         }
-        else {
-            reordered_weights_memory = matmul_weight_caching_map_jit_kernel[key_obj];
+        if (!cached_weights) {
+            if (is_weights_const) {
+                //Cached reorder must outlive the plan, give it its own buffer
+                cached_weights = std::make_shared<zendnn::memory>
+                                 (plan->matmul_prim_disc.weights_desc(), zenMatMulEngine());
+                plan->weights_reorder.execute(engine_stream, plan->user_weights_memory,
+                                              *cached_weights);
+                cached_weights = weight_cache.insert_as<zendnn::memory>(cache_key,
+                                 cached_weights, plan->matmul_prim_disc.weights_desc().get_size());
+            }
+            else {
+                plan->weights_reorder.execute(engine_stream, plan->user_weights_memory,
+                                              plan->reordered_weights_memory);
+            }
         }
+        plan->args[ZENDNN_ARG_WEIGHTS] = cached_weights ? *cached_weights :
+                                         plan->reordered_weights_memory;
     }
-    net.push_back(zendnn::matmul(matmul_prim_disc));
-    if (bias) {
-        net_args.push_back({{ZENDNN_ARG_SRC, src_memory},
-            {ZENDNN_ARG_WEIGHTS, blocked_format ? reordered_weights_memory : user_weights_memory},
-            {ZENDNN_ARG_BIAS, bias_memory},
-            {ZENDNN_ARG_DST, dst_memory}});
-    }
-    else {
-        net_args.push_back({{ZENDNN_ARG_SRC, src_memory},
-            {ZENDNN_ARG_WEIGHTS, blocked_format ? reordered_weights_memory : user_weights_memory},
-            {ZENDNN_ARG_DST, dst_memory}});
-    }
-    assert(net.size() == net_args.size() && "something is missing");
-    for (size_t i = 0; i < net.size(); ++i) {
-        net.at(i).execute(engine_stream, net_args.at(i));
-    }
+    plan->matmul_prim.execute(engine_stream, plan->args);
 }
 
 
@@ -897,6 +941,8 @@ void zenBatchMatMulSplitV2(zendnnEnv zenEnvObj, bool Layout,
 
     unsigned int thread_qty = zenEnvObj.omp_num_threads;
     unsigned int grp_start = 0;
+    std::vector<unsigned int> l3_teams =
+        zendnnCpuTopology::Instance().l3_teams(thread_qty);
 
     for (int i=0; i<group_count; i++) {
         bool transpose_input = (TransA_Array[i] == CblasNoTrans)?0:1;
@@ -906,19 +952,23 @@ void zenBatchMatMulSplitV2(zendnnEnv zenEnvObj, bool Layout,
         unsigned long n = N_Array[i];
         unsigned long k = K_Array[i];
 
-        unsigned int loopCount = (group_size[i]%thread_qty)==0 ?
-                                 group_size[i]/thread_qty:
-                                 (group_size[i]/thread_qty)+1;
-
         omp_set_max_active_levels(1);
         #pragma omp parallel num_threads(thread_qty)
         {
-            for (int j=0; j<loopCount; j++) {
-
-                int threadOffset = omp_get_thread_num()+ (j*thread_qty);
-                if (threadOffset >= group_size[i]) {
-                    break;
-                }
+            //Each L3 team takes a contiguous range of the group, so the
+            //GEMMs of one batch entry share a domain, and its threads
+            //stride through the range
+            unsigned int ithr = omp_get_thread_num();
+            unsigned int team_first = 0, team_size = l3_teams[0];
+            for (size_t t = 1; ithr >= team_first + team_size; t++) {
+                team_first += team_size;
+                team_size = l3_teams[t];
+            }
+            int range_begin = (long)group_size[i] * team_first / thread_qty;
+            int range_end = (long)group_size[i] * (team_first + team_size) /
+                            thread_qty;
+            for (int threadOffset = range_begin + (ithr - team_first);
+                    threadOffset < range_end; threadOffset += team_size) {
 
                 //if ZENDNN_GEMM_ALGO is set to 3, then zendnn_sgemm
                 // jit based kernel will be called.
@@ -1007,24 +1057,17 @@ void zenBatchMatMulSplitV3(zendnnEnv zenEnvObj, bool Layout,
                                  group_size[i]/outer_threads:
                                  (group_size[i]/outer_threads)+1;
 
+        //With more threads than GEMMs every GEMM gets an inner team sized
+        //to whole L3 domains (or an even part of one)
+        int inner_threads = outer_threads < thread_qty ?
+                            zendnnCpuTopology::Instance().l3_team_size(thread_qty, outer_threads) : 1;
+
         omp_set_max_active_levels(2);
         #pragma omp parallel num_threads(outer_threads)
         {
 
             //TODO: Need to test this path with dfferent matrix sizes,
             //give more control over threads with nested parallelism
-            int inner_threads = 1;
-            //If inner_threads*outer_threads < OMP_NUM_THREADS, inner_threads will be incremented for few parent threads
-            //This make sure that all the threads are utilized
-            unsigned int temp = thread_qty - (inner_threads*outer_threads);
-            int thread_loop = (temp%outer_threads)?(temp/outer_threads):((
-                                  temp/outer_threads)+1);
-            for (int j=0; j<thread_loop; j++) {
-                if (omp_get_thread_num() < temp) {
-                    inner_threads++;
-                }
-                temp = temp - outer_threads;
-            }
 
             for (int j=0; j<loopCount; j++) {
 
@@ -1088,150 +1131,141 @@ void zenBatchMatMulSplitV3(zendnnEnv zenEnvObj, bool Layout,
 
 // ZenBatchMatMulPrimitives helps to execute using MatMul primitives.
 // TODO: Add support for Primitive caching
-void zenBatchMatMulPrimitive(zendnnEnv zenEnvObj, bool Layout,
-                             bool TransA, bool TransB, int *M_Array,
-                             int *N_Array, int *K_Array,
-                             const float **A_Array, const float **B_Array,
-                             float **C_Array, int *group_size,
-                             const float **Add_Array, int *add_shape,
-                             float mul_node, int batch_size) {
-    zendnn::engine eng(engine::kind::cpu, 0);
-    zendnn::stream engine_stream(eng);
-
-    std::vector<primitive> net;
-    std::vector<std::unordered_map<int, memory>> net_args;
-
-    float *in_arr = const_cast<float *>(A_Array[0]);
-    float *filt_arr = const_cast<float *>(B_Array[0]);
-    float *output_array = const_cast<float *>(C_Array[0]);
-
-    long M = M_Array[0];
-    long N = N_Array[0];
-    long K = K_Array[0];
-
-    memory::dims src_dims = (group_size[0] == 1) ? (memory::dims) {
+//Ready to run BatchMatMul primitive with its Mul/Add post-ops
+struct zenBatchMatMulPrimitivePlan {
+    zendnn::matmul matmul_prim;
+    zendnn::memory src_memory, user_weights_memory, dst_memory;
+    zendnn::memory postop_memory1, postop_memory2;
+    std::unordered_map<int, zendnn::memory> args;
+};
+
+static zenBatchMatMulPrimitivePlan *zenBatchMatMulPrimitiveCreatePlan(
+    const Key_matmul_plan &plan_key, bool TransB, long M, long N, long K,
+    int group_size, bool has_mul, bool has_add, int *add_shape,
+    int batch_size) {
+    zendnn::engine &eng = zenMatMulEngine();
+    std::unique_ptr<zenBatchMatMulPrimitivePlan> plan(new
+            zenBatchMatMulPrimitivePlan);
+
+    memory::dims src_dims = (group_size == 1) ? (memory::dims) {
         M, K
 } :
     (memory::dims) {
-        batch_size, group_size[0]/batch_size, M, K
+        batch_size, group_size/batch_size, M, K
     };
-    memory::dims weight_dims = (group_size[0] == 1) ? (memory::dims) {
+    memory::dims weight_dims = (group_size == 1) ? (memory::dims) {
         K, N
 } :
     (memory::dims) {
-        batch_size, group_size[0]/batch_size, K, N
+        batch_size, group_size/batch_size, K, N
     };
-    memory::dims dst_dims = (group_size[0] == 1) ? (memory::dims) {
+    memory::dims dst_dims = (group_size == 1) ? (memory::dims) {
         M, N
 } :
     (memory::dims) {
-        batch_size, group_size[0]/batch_size, M, N
-    };
-    memory::dims bias_dims = (group_size[0] == 1) ? (memory::dims) {
-        1, N
-} :
-    (memory::dims) {
-        1, 1, 1, N
+        batch_size, group_size/batch_size, M, N
     };
 
     memory::desc src_md = memory::desc({src_dims}, dt::f32,
-                                       (group_size[0] == 1) ? tag::ab : tag::abcd);
+                                       (group_size == 1) ? tag::ab : tag::abcd);
     memory::desc dst_md = memory::desc({dst_dims}, dt::f32,
-                                       (group_size[0] == 1) ? tag::ab : tag::abcd);
+                                       (group_size == 1) ? tag::ab : tag::abcd);
     memory::desc matmul_weights_md =
         memory::desc({weight_dims}, dt::f32,
-                     (group_size[0] == 1) ? tag::ab : (TransB ? tag::abdc : tag::abcd));
+                     (group_size == 1) ? tag::ab : (TransB ? tag::abdc : tag::abcd));
     memory::desc bias_md = memory::desc();
 
-    zendnn::memory user_weights_memory, src_memory, dst_memory;
-    src_memory = memory({{src_dims}, dt::f32,(group_size[0] == 1) ? tag::ab : tag::abcd},
-    eng, in_arr);
-    dst_memory = memory({{dst_dims}, dt::f32,(group_size[0] == 1) ? tag::ab : tag::abcd},
-    eng, output_array);
-    user_weights_memory =
-    memory({{weight_dims}, dt::f32,(group_size[0] == 1) ? tag::ab : (TransB ? tag::abdc : tag::abcd)},
-    eng,
-    filt_arr);
+    plan->src_memory = memory(src_md, eng, NULL);
+    plan->dst_memory = memory(dst_md, eng, NULL);
+    plan->user_weights_memory = memory(matmul_weights_md, eng, NULL);
 
     primitive_attr matmul_attr;
-    if (*Add_Array != nullptr || mul_node != 1) {
-
-        float *add_arr = const_cast<float *>(Add_Array[0]);
-
-        const float *mul = &mul_node;
-        float *mul_arr = const_cast<float *>(mul);
-
-        memory::dims mul_dims = {1, 1, 1, 1};
-        memory::dims add_dims;
-
+    memory::dims mul_dims = {1, 1, 1, 1};
+    memory::dims add_dims;
+    if (has_mul) {
         zendnn::post_ops post_ops;
         post_ops.append_binary(algorithm::binary_mul,
                                memory::desc({mul_dims}, dt::f32, tag::abcd));
-        if (*Add_Array != nullptr) {
+        if (has_add) {
             add_dims = {batch_size, 1, add_shape[1], add_shape[2]};
             post_ops.append_binary(algorithm::binary_add,
                                    memory::desc({add_dims}, dt::f32, tag::abcd));
         }
-
-
         matmul_attr.set_post_ops(post_ops);
-        matmul::desc matmul_pd1 =
-            matmul::desc(src_md, matmul_weights_md, bias_md, dst_md);
-        matmul::primitive_desc matmul_pd =
-            matmul::primitive_desc(matmul_pd1, matmul_attr, eng);
-
-        net.push_back(matmul(matmul_pd));
-
-        zendnn::memory postop_memory1;
-        postop_memory1 =
-        memory({{mul_dims}, dt::f32, tag::abcd}, eng, mul_arr);
-        if (*Add_Array != nullptr) {
+    }
+    matmul::desc matmul_pd1 =
+        matmul::desc(src_md, matmul_weights_md, bias_md, dst_md);
+    matmul::primitive_desc matmul_pd =
+        matmul::primitive_desc(matmul_pd1, matmul_attr, eng);
+    plan->matmul_prim = matmul(matmul_pd);
+
+    plan->args.insert({ZENDNN_ARG_SRC, plan->src_memory});
+    plan->args.insert({ZENDNN_ARG_WEIGHTS, plan->user_weights_memory});
+    plan->args.insert({ZENDNN_ARG_DST, plan->dst_memory});
+    if (has_mul) {
+        // BatchMatMul + Mul
+        plan->postop_memory1 = memory({{mul_dims}, dt::f32, tag::abcd}, eng, NULL);
+        plan->args.insert({ZENDNN_ARG_ATTR_MULTIPLE_POST_OP(0) | ZENDNN_ARG_SRC_1,
+                           plan->postop_memory1});
+        if (has_add) {
             // BatchMatMul + Mul + Add
-            zendnn::memory postop_memory2;
-            postop_memory2 =
-            memory({{add_dims}, dt::f32, tag::abcd}, eng, add_arr);
-
-            net_args.push_back({
-                {ZENDNN_ARG_SRC, src_memory},
-                {ZENDNN_ARG_WEIGHTS, user_weights_memory},
-                {ZENDNN_ARG_DST, dst_memory},
-                {
-                    ZENDNN_ARG_ATTR_MULTIPLE_POST_OP(0) | ZENDNN_ARG_SRC_1,
-                    postop_memory1
-                },
-                {
-                    ZENDNN_ARG_ATTR_MULTIPLE_POST_OP(1) | ZENDNN_ARG_SRC_1,
-                    postop_memory2
-                }});
-        }
-        else {
-            // BatchMatMul + Mul
-            net_args.push_back({
-                {ZENDNN_ARG_SRC, src_memory},
-                {ZENDNN_ARG_WEIGHTS, user_weights_memory},
-                {ZENDNN_ARG_DST, dst_memory},
-                {
-                    ZENDNN_ARG_ATTR_MULTIPLE_POST_OP(0) | ZENDNN_ARG_SRC_1,
-                    postop_memory1
-                }});
+            plan->postop_memory2 = memory({{add_dims}, dt::f32, tag::abcd}, eng, NULL);
+            plan->args.insert({ZENDNN_ARG_ATTR_MULTIPLE_POST_OP(1) | ZENDNN_ARG_SRC_1,
+                               plan->postop_memory2});
         }
     }
-    else {
-        // BatchMatMul
-        matmul::desc matmul_pd1 =
-            matmul::desc(src_md, matmul_weights_md, bias_md, dst_md);
-        matmul::primitive_desc matmul_pd =
-            matmul::primitive_desc(matmul_pd1, matmul_attr, eng);
-
-        net.push_back(matmul(matmul_pd));
-        net_args.push_back({{ZENDNN_ARG_SRC, src_memory},
-            {ZENDNN_ARG_WEIGHTS, user_weights_memory},
-            {ZENDNN_ARG_DST, dst_memory}});
+
+    return zenMatMulPlanCache<zenBatchMatMulPrimitivePlan>::ZenDNNMatMulPlanCache().insert(
+               plan_key, std::move(plan));
+}
+
+void zenBatchMatMulPrimitive(zendnnEnv zenEnvObj, bool Layout,
+                             bool TransA, bool TransB, int *M_Array,
+                             int *N_Array, int *K_Array,
+                             const float **A_Array, const float **B_Array,
+                             float **C_Array, int *group_size,
+                             const float **Add_Array, int *add_shape,
+                             float mul_node, int batch_size) {
+    zendnn::stream &engine_stream = zenMatMulStream();
+
+    long M = M_Array[0];
+    long N = N_Array[0];
+    long K = K_Array[0];
+    bool has_add = *Add_Array != nullptr;
+    bool has_mul = has_add || mul_node != 1;
+
+    Key_matmul key_obj = Key_matmul();
+    key_obj.transpose_weights = TransB;
+    key_obj.m = M;
+    key_obj.k = K;
+    key_obj.n = N;
+    key_obj.thread_count = zenEnvObj.omp_num_threads;
+    Key_matmul_plan plan_key = zenMatMulPlanKey(MATMUL_PLAN_BATCH_PRIMITIVE,
+                               key_obj, (has_mul ? MATMUL_PLAN_MUL : 0) | (has_add ? MATMUL_PLAN_ADD : 0),
+                               1.0f, 0.0f);
+    plan_key.batch[0] = batch_size;
+    plan_key.batch[1] = group_size[0];
+    plan_key.batch[2] = has_add ? add_shape[1] : 0;
+    plan_key.batch[3] = has_add ? add_shape[2] : 0;
+
+    zenBatchMatMulPrimitivePlan *plan =
+        zenMatMulPlanCache<zenBatchMatMulPrimitivePlan>::ZenDNNMatMulPlanCache().find(
+            plan_key);
+    if (plan == NULL) {
+        plan = zenBatchMatMulPrimitiveCreatePlan(plan_key, TransB, M, N, K,
+                group_size[0], has_mul, has_add, add_shape, batch_size);
     }
-    assert(net.size() == net_args.size() && "something is missing");
-    for (size_t i = 0; i < net.size(); ++i) {
-        net.at(i).execute(engine_stream, net_args.at(i));
+
+    plan->src_memory.set_data_handle(const_cast<float *>(A_Array[0]));
+    plan->user_weights_memory.set_data_handle(const_cast<float *>(B_Array[0]));
+    plan->dst_memory.set_data_handle(C_Array[0]);
+    if (has_mul) {
+        plan->postop_memory1.set_data_handle(&mul_node);
+        if (has_add) {
+            plan->postop_memory2.set_data_handle(const_cast<float *>(Add_Array[0]));
+        }
     }
+    plan->matmul_prim.execute(engine_stream, plan->args);
 }
 
 
@@ -1429,65 +1463,72 @@ void zenMatmulSplit(
 
         unsigned long gemmRows = m_per_thread;
 
-        if (zenEnvObj.zenGEMMalgo == zenMatMulAlgoType::MATMUL_BLIS_GEMM2) {
-
+        if (zenEnvObj.zenGEMMalgo == zenMatMulAlgoType::MATMUL_BLIS_GEMM2 ||
+                zenEnvObj.zenGEMMalgo == zenMatMulAlgoType::MATMUL_ZENDNN_GEMM2) {
+            //With post-ops the rows are multiplied in tiles that fit L2, each
+            //tile gets its post-ops while it is still in cache. Large weights
+            //are multiplied in one GEMM as every tile packs them again.
+            unsigned long tileRows = gemmRows;
+            if (Layout && (bias || relu || gelu)) {
+                tileRows = zenPostOpsTileRows((unsigned long)(k + n)*sizeof(float),
+                                              gemmRows, (unsigned long)k*n*sizeof(float),
+                                              (unsigned long)n*sizeof(float));
+            }
+            for (unsigned long row = 0; row < gemmRows; row += tileRows) {
+                unsigned long rows = std::min(tileRows, gemmRows - row);
+                unsigned long tileInputOffset = inputOffset +
+                                                (transpose_input ? row : row*lda);
+                unsigned long tileOutputOffset = outputOffset + row*ldc;
+                if (zenEnvObj.zenGEMMalgo == zenMatMulAlgoType::MATMUL_BLIS_GEMM2) {
 #if BLIS_EXPERT
-            if (transpose_input)
-                bli_obj_create_with_attached_buffer(blis_obj.dt, gemmRows,
-                                                    k,
-                                                    data_col+inputOffset,
-                                                    1, lda, &blis_obj.a);
-            else
-                bli_obj_create_with_attached_buffer(blis_obj.dt, gemmRows,
-                                                    k,
-                                                    data_col+inputOffset,
-                                                    lda, 1, &blis_obj.a);
-
-            if (transpose_filter)
-                bli_obj_create_with_attached_buffer(blis_obj.dt, k,
-                                                    n,
-                                                    (void *)filter,
-                                                    1, ldb, &blis_obj.b);
-
-            else
-                bli_obj_create_with_attached_buffer(blis_obj.dt, k,
-                                                    n,
-                                                    (void *)filter,
-                                                    ldb, 1, &blis_obj.b);
-            bli_obj_create_with_attached_buffer(blis_obj.dt, gemmRows, n,
-                                                output+outputOffset, ldc, 1, &blis_obj.c);
-            bli_gemm_ex(&blis_obj.alpha, &blis_obj.a, &blis_obj.b, &blis_obj.beta,
-                        &blis_obj.c, NULL, &blis_obj.rntm);
+                    if (transpose_input)
+                        bli_obj_create_with_attached_buffer(blis_obj.dt, rows,
+                                                            k,
+                                                            data_col+tileInputOffset,
+                                                            1, lda, &blis_obj.a);
+                    else
+                        bli_obj_create_with_attached_buffer(blis_obj.dt, rows,
+                                                            k,
+                                                            data_col+tileInputOffset,
+                                                            lda, 1, &blis_obj.a);
+
+                    if (transpose_filter)
+                        bli_obj_create_with_attached_buffer(blis_obj.dt, k,
+                                                            n,
+                                                            (void *)filter,
+                                                            1, ldb, &blis_obj.b);
+
+                    else
+                        bli_obj_create_with_attached_buffer(blis_obj.dt, k,
+                                                            n,
+                                                            (void *)filter,
+                                                            ldb, 1, &blis_obj.b);
+                    bli_obj_create_with_attached_buffer(blis_obj.dt, rows, n,
+                                                        output+tileOutputOffset, ldc, 1, &blis_obj.c);
+                    bli_gemm_ex(&blis_obj.alpha, &blis_obj.a, &blis_obj.b, &blis_obj.beta,
+                                &blis_obj.c, NULL, &blis_obj.rntm);
 
 #else
-            cblas_sgemm(Layout ? CblasRowMajor : CblasColMajor,
-                        transpose_input ? CblasTrans : CblasNoTrans,
-                        transpose_filter ? CblasTrans : CblasNoTrans, gemmRows, n, k,
-                        alpha, input + inputOffset, lda, filter, ldb, beta,
-                        output + outputOffset, ldc);
+                    cblas_sgemm(Layout ? CblasRowMajor : CblasColMajor,
+                                transpose_input ? CblasTrans : CblasNoTrans,
+                                transpose_filter ? CblasTrans : CblasNoTrans, rows, n, k,
+                                alpha, input + tileInputOffset, lda, filter, ldb, beta,
+                                output + tileOutputOffset, ldc);
 #endif
+                }
+                else {
+                    zendnn_sgemm(transpose_input ? 'T' : 'N', transpose_filter ? 'T' : 'N',
+                                 rows, n, k, alpha, data_col+tileInputOffset, lda, filter,
+                                 ldb, beta, output+tileOutputOffset, ldc);
+                }
 
-            //Below Bias and activation code can be eliminated if not required
-            unsigned long biasOffset = outputOffset;
-            if (bias || relu || gelu) {
-                zenPostOps(zenEnvObj, output, NULL, gemmRows, 1, n,
-                           ldc, biasOffset,
-                           bias, relu, gelu, NULL,
-                           l2_num_threads, alpha);
-            }
-        }
-        else if (zenEnvObj.zenGEMMalgo == zenMatMulAlgoType::MATMUL_ZENDNN_GEMM2) {
-            zendnn_sgemm(transpose_input ? 'T' : 'N', transpose_filter ? 'T' : 'N',
-                         gemmRows, n, k, alpha, data_col+inputOffset, lda, filter,
-                         ldb, beta, output+outputOffset, ldc);
-
-            //Below Bias and activation code can be eliminated if not required
-            unsigned long biasOffset = outputOffset;
-            if (bias || relu || gelu) {
-                zenPostOps(zenEnvObj, output, NULL, gemmRows, 1, n,
-                           ldc, biasOffset,
-                           bias, relu, gelu, NULL,
-                           l2_num_threads, alpha);
+                //Below Bias and activation code can be eliminated if not required
+                if (bias || relu || gelu) {
+                    zenPostOps(zenEnvObj, output, NULL, rows, 1, n,
+                               ldc, tileOutputOffset,
+                               bias, relu, gelu, NULL,
+                               l2_num_threads, alpha);
+                }
             }
         }
         else {
@@ -0,0 +1,160 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef ZENDNN_MATMUL_PLAN_HPP
+#define ZENDNN_MATMUL_PLAN_HPP
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "zendnn_private.hpp"
+
+//Execution path a plan was built for
+enum zenMatMulPlanKind {
+    MATMUL_PLAN_PRIMITIVE = 0,
+    MATMUL_PLAN_BLOCKED_PRIMITIVE = 1,
+    MATMUL_PLAN_AOCL_POST_OPS = 2,
+    MATMUL_PLAN_BATCH_PRIMITIVE = 3,
+};
+
+//Post-op signature bits of a plan
+enum zenMatMulPlanPostOp {
+    MATMUL_PLAN_BIAS = 1 << 0,
+    MATMUL_PLAN_RELU = 1 << 1,
+    MATMUL_PLAN_GELU_TANH = 1 << 2,
+    MATMUL_PLAN_GELU_ERF = 1 << 3,
+    MATMUL_PLAN_MUL = 1 << 4,
+    MATMUL_PLAN_ADD = 1 << 5,
+};
+
+inline unsigned int zenMatMulPlanPostOps(bool bias, bool relu, int gelu) {
+    return (bias ? MATMUL_PLAN_BIAS : 0) | (relu ? MATMUL_PLAN_RELU : 0) |
+           (gelu == 1 ? MATMUL_PLAN_GELU_TANH : 0) |
+           (gelu == 2 ? MATMUL_PLAN_GELU_ERF : 0);
+}
+
+//Key of a per shape execution plan: GEMM shape, post-op signature and the
+//scalars baked into the plan. Weight address is never part of the key.
+//batch holds extra dims of batched plans (batch size, group size, add shape).
+struct Key_matmul_plan {
+    Key_matmul key;
+    unsigned int kind;
+    unsigned int post_ops;
+    float alpha;
+    float beta;
+    int batch[4];
+
+    bool operator==(const Key_matmul_plan &other) const {
+        return (kind == other.kind
+                && post_ops == other.post_ops
+                && alpha == other.alpha
+                && beta == other.beta
+                && batch[0] == other.batch[0]
+                && batch[1] == other.batch[1]
+                && batch[2] == other.batch[2]
+                && batch[3] == other.batch[3]
+                && key == other.key
+               );
+    }
+};
+
+namespace std {
+template <>
+struct hash<Key_matmul_plan> {
+    std::size_t operator()(const Key_matmul_plan &k) const {
+        std::size_t seed = std::hash<Key_matmul>()(k.key);
+        seed = zendnn::impl::hash_combine(seed, (k.kind));
+        seed = zendnn::impl::hash_combine(seed, (k.post_ops));
+        seed = zendnn::impl::hash_combine(seed, (k.alpha));
+        seed = zendnn::impl::hash_combine(seed, (k.beta));
+        for (int i = 0; i < 4; i++) {
+            seed = zendnn::impl::hash_combine(seed, (k.batch[i]));
+        }
+        return seed;
+    }
+};
+}
+
+inline Key_matmul_plan zenMatMulPlanKey(zenMatMulPlanKind kind,
+                                        const Key_matmul &key_obj, unsigned int post_ops, float alpha,
+                                        float beta) {
+    Key_matmul_plan plan_key;
+    plan_key.key = key_obj;
+    plan_key.key.weights = NULL;
+    plan_key.kind = kind;
+    plan_key.post_ops = post_ops;
+    plan_key.alpha = alpha;
+    plan_key.beta = beta;
+    for (int i = 0; i < 4; i++) {
+        plan_key.batch[i] = 0;
+    }
+    return plan_key;
+}
+
+//Per thread LRU cache of MatMul execution plans.
+//Plans own memory objects whose data handles are rebound on every call, so
+//a plan is only ever used by the thread that built it and needs no locking.
+//Holds up to ZENDNN_MATMUL_PLAN_CACHE_CAPACITY plans per thread.
+template <typename Plan>
+class zenMatMulPlanCache {
+  public:
+    static zenMatMulPlanCache &ZenDNNMatMulPlanCache() {
+        static thread_local zenMatMulPlanCache obj;
+        return obj;
+    }
+
+    //Returns the plan for key or NULL
+    Plan *find(const Key_matmul_plan &key) {
+        auto found_obj = map_.find(key);
+        if (found_obj == map_.end()) {
+            return NULL;
+        }
+        lru_.splice(lru_.begin(), lru_, found_obj->second);
+        return found_obj->second->second.get();
+    }
+
+    //Takes ownership of plan. With capacity 0 the plan is only kept until
+    //the next insert.
+    Plan *insert(const Key_matmul_plan &key, std::unique_ptr<Plan> plan) {
+        if (capacity_ == 0) {
+            uncached_ = std::move(plan);
+            return uncached_.get();
+        }
+        while (lru_.size() >= capacity_) {
+            map_.erase(lru_.back().first);
+            lru_.pop_back();
+        }
+        lru_.emplace_front(key, std::move(plan));
+        map_[key] = lru_.begin();
+        return lru_.front().second.get();
+    }
+
+  private:
+    typedef std::list<std::pair<Key_matmul_plan, std::unique_ptr<Plan>>>
+            lru_list_t;
+
+    zenMatMulPlanCache() {
+        capacity_ = readEnv().zenMatMulPlanCacheCapacity;
+    }
+
+    size_t capacity_;
+    lru_list_t lru_;
+    std::unordered_map<Key_matmul_plan, typename lru_list_t::iterator> map_;
+    std::unique_ptr<Plan> uncached_;
+};
+
+#endif
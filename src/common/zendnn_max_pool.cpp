@@ -18,6 +18,7 @@
 #include "common/zendnn_private.hpp"
 #include <time.h>
 #include "zendnn_helper.hpp"
+#include "zendnn_cpu_topology.hpp"
 #include "zendnn_logging.hpp"
 #include <omp.h>
 
@@ -104,7 +105,9 @@ void max_pooling_v1(
             //utilize all the cores. Outer work with BS and inner with height col
             //(inner_thread_qty*thread_qty) should be <= total_no_threads
             if (thread_qty > number_of_images) {
-                inner_thread_qty = thread_qty/number_of_images;
+                //Inner teams do not straddle L3 domains where possible
+                inner_thread_qty = zendnnCpuTopology::Instance().l3_team_size(
+                                       thread_qty, number_of_images);
                 thread_qty = number_of_images;
                 omp_set_max_active_levels(2);
             }
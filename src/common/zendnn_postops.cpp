@@ -26,6 +26,8 @@
 #include <time.h>
 #include "zendnn_helper.hpp"
 #include "zendnn_logging.hpp"
+#include "cpu/platform.hpp"
+#include <algorithm>
 #include <blis.h>
 
 
@@ -33,6 +35,10 @@ float gelu_const = sqrtf(2/M_PI);
 
 #define GELU_VECTOR_ENABLE      1
 
+//M block of the BLIS sgemm kernels on Zen, a post-op tile of fewer rows
+//would split one packed panel of A over several GEMM calls
+#define ZENDNN_POSTOPS_MIN_TILE_ROWS    144
+
 #if GELU_VECTOR_ENABLE
     #define COMPUTE_GELU    COMPUTE_GELU_VEC16
     #define COMPUTE_GELU_TANH   COMPUTE_GELU_TANH_VEC16
@@ -160,6 +166,22 @@ float gelu_const = sqrtf(2/M_PI);
     }
 
 using namespace zendnn;
+
+int zenPostOpsTileRows(unsigned long row_bytes, unsigned long rows,
+                       unsigned long b_bytes, unsigned long c_row_bytes) {
+    static const unsigned long budget =
+        zendnn::impl::cpu::platform::get_per_core_cache_size(2) / 2;
+    unsigned long tile_rows = row_bytes ? budget / row_bytes : rows;
+    //No fewer rows than one M block of the GEMM
+    tile_rows = std::max(tile_rows, (unsigned long)ZENDNN_POSTOPS_MIN_TILE_ROWS);
+    //Every tile packs B again to save one write and one read of its C rows,
+    //when B is the larger of the two one GEMM over all rows is cheaper
+    if (b_bytes > 2 * tile_rows * c_row_bytes) {
+        return (int)std::max(1UL, rows);
+    }
+    return (int)std::max(1UL, std::min(tile_rows, rows));
+}
+
 //ZenClip clips the output values based on upperbound
 void zenClipOp(zendnnEnv zenEnvObj,float *out_layer,float upper_bound,
                unsigned long size) {
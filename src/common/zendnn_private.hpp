@@ -101,35 +101,16 @@ struct hash<Key_matmul> {
 }
 
 //Updates the cpu information(BRAND String) in the given array.
-//Makes use of inline assembly
+//Makes use of inline assembly, registers are bound through constraints so
+//that the compiler can not reuse them between the cpuid leaves.
 inline int getCpuID_brandString(int *a) {
 
-    __asm__ __volatile__("xor %eax , %eax\n\t");
-    __asm__ __volatile__("xor %ebx , %ebx\n\t");
-    __asm__ __volatile__("xor %ecx , %ecx\n\t");
-    __asm__ __volatile__("xor %edx , %edx\n\t");
-
-    __asm__ __volatile__("mov $0x80000002 , %eax\n\t");
-
-    __asm__ __volatile__("cpuid\n\t");
-    __asm__ __volatile__("mov %%eax, %0\n\t":"=r"(a[0]));
-    __asm__ __volatile__("mov %%ebx, %0\n\t":"=r"(a[1]));
-    __asm__ __volatile__("mov %%ecx, %0\n\t":"=r"(a[2]));
-    __asm__ __volatile__("mov %%edx, %0\n\t":"=r"(a[3]));
-
-    __asm__ __volatile__("mov $0x80000003 , %eax\n\t");
-    __asm__ __volatile__("cpuid\n\t");
-    __asm__ __volatile__("mov %%eax, %0\n\t":"=r"(a[4]));
-    __asm__ __volatile__("mov %%ebx, %0\n\t":"=r"(a[5]));
-    __asm__ __volatile__("mov %%ecx, %0\n\t":"=r"(a[6]));
-    __asm__ __volatile__("mov %%edx, %0\n\t":"=r"(a[7]));
-
-    __asm__ __volatile__("mov $0x80000004 , %eax\n\t");
-    __asm__ __volatile__("cpuid\n\t");
-    __asm__ __volatile__("mov %%eax, %0\n\t":"=r"(a[8]));
-    __asm__ __volatile__("mov %%ebx, %0\n\t":"=r"(a[9]));
-    __asm__ __volatile__("mov %%ecx, %0\n\t":"=r"(a[10]));
-    __asm__ __volatile__("mov %%edx, %0\n\t":"=r"(a[11]));
+    for (unsigned int i = 0; i < 3; i++) {
+        __asm__ __volatile__("cpuid\n\t"
+                             :"=a"(a[4 * i]), "=b"(a[4 * i + 1]), "=c"(a[4 * i + 2]),
+                             "=d"(a[4 * i + 3])
+                             :"a"(0x80000002 + i), "c"(0));
+    }
     return 0;
 }
 
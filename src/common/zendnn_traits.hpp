@@ -67,6 +67,10 @@ struct prec_traits<data_type::s16> {
     typedef int16_t type;
 };
 template <>
+struct prec_traits<data_type::s64> {
+    typedef int64_t type;
+};
+template <>
 struct prec_traits<data_type::s8> {
     typedef int8_t type;
 };
@@ -96,6 +100,10 @@ struct data_traits<int16_t> {
     static constexpr data_type_t data_type = data_type::s16;
 };
 template <>
+struct data_traits<int64_t> {
+    static constexpr data_type_t data_type = data_type::s64;
+};
+template <>
 struct data_traits<int8_t> {
     static constexpr data_type_t data_type = data_type::s8;
 };
@@ -0,0 +1,458 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #include <process.h>
+#endif
+#include <fstream>
+#include <sstream>
+#include "zendnn.h"
+#include "zendnn_tuning_db.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+
+//Header of the files written before the tuning database (MatMul only)
+#define TUNING_DB_LEGACY_HEADER "ZENDNN MatMul Primitive Map"
+//Values in a row of the legacy file
+#define TUNING_DB_LEGACY_VALUES 10
+//Leading fields of a record row: op, threads, algo, time_ms, runs
+#define TUNING_DB_RECORD_FIELDS 5
+//CPU information size
+#define CPU_INFO_SIZE 12
+
+//Names of zenTuningOp in the file
+static const char *tuning_op_names[TUNING_OP_COUNT] = {
+    "matmul_f32",
+    "matmul_bf16",
+    "conv_lpgemm_os8",
+    "conv_lpgemm_os32",
+};
+
+static std::string trim(const std::string &str) {
+    size_t begin = str.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(begin, end - begin + 1);
+}
+
+static std::vector<std::string> split(const std::string &line) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (getline(stream, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+//Major version part of a library version string
+static std::string major_version(const std::string &library) {
+    return library.substr(0, library.find('.'));
+}
+
+zendnnTuningDB &zendnnTuningDB::ZenDNNTuningDB() {
+    static zendnnTuningDB obj;
+    return obj;
+}
+
+zendnnTuningDB::zendnnTuningDB() {
+    const zendnn_version_t *version = zendnn_version();
+    platform_.library = std::to_string(version->major) + "." +
+                        std::to_string(version->minor) + "." +
+                        std::to_string(version->patch);
+
+    std::stringstream isa;
+    isa<<"0x"<<std::hex<<(unsigned int)zendnn_get_effective_cpu_isa();
+    platform_.isa = isa.str();
+
+    //Brand string is a field of the file, commas and control characters
+    //are replaced
+    int cpu_i[CPU_INFO_SIZE + 1] = {0};
+    if (getCpuID_brandString(cpu_i) == 0) {
+        std::string cpu = (char *)cpu_i;
+        for (auto &c : cpu) {
+            c = (c == ',' || c < ' ' || c > '~') ? ' ' : c;
+        }
+        platform_.cpu = trim(cpu);
+    }
+    else {
+        platform_.cpu = "unknown";
+    }
+}
+
+unsigned int zendnnTuningDB::getMode(const char *env_name) {
+    unsigned int mode = zendnn::zendnn_getenv_int(env_name,
+                        zenTuningDBMode::TUNING_DB_DISABLE);
+
+    //If value is not 0/1/2 then assume it as disabled.
+    if (mode > zenTuningDBMode::TUNING_DB_READ) {
+        mode = zenTuningDBMode::TUNING_DB_DISABLE;
+    }
+    return mode;
+}
+
+const char *zendnnTuningDB::getFile() {
+    return getenv("ZENDNN_MATMUL_MAP_FILE");
+}
+
+//Keeps the faster algo. Records without a measured time (legacy files)
+//lose against any measured one.
+void zendnnTuningDB::merge(zenTuningRecord &dst, const zenTuningRecord &src) {
+    if (dst.time_ms <= 0 || (src.time_ms > 0 && src.time_ms < dst.time_ms)) {
+        dst.algo = src.algo;
+        dst.time_ms = src.time_ms;
+    }
+    dst.runs += src.runs;
+}
+
+zendnnTuningDB::section_t &zendnnTuningDB::get_section(
+    std::vector<section_t> &sections, const platform_t &platform) {
+    for (auto &section : sections) {
+        if (section.platform.library == platform.library &&
+                section.platform.isa == platform.isa &&
+                section.platform.cpu == platform.cpu) {
+            return section;
+        }
+    }
+    sections.push_back({platform, table_t()});
+    return sections.back();
+}
+
+//Merges the file into sections.
+//Returns 0 on success, 1 if the file can not be opened and 2 if it is not
+//a tuning database or was written by a newer format version.
+int zendnnTuningDB::read_file(const char *fname,
+                              std::vector<section_t> &sections) const {
+    std::ifstream file(fname, std::ios::in);
+    if (!file.is_open()) {
+        return 1;
+    }
+
+    std::string line;
+    if (!getline(file, line)) {
+        return 2;
+    }
+
+    //MatMul map of older releases: brand string, column header and rows of
+    //transpose input, transpose weights, M, K, N, lda, ldb, ldc, threads, algo
+    if (line.compare(0, strlen(TUNING_DB_LEGACY_HEADER),
+                     TUNING_DB_LEGACY_HEADER) == 0) {
+        platform_t platform = platform_;
+        getline(file, line);
+        platform.cpu = trim(line);
+        getline(file, line);
+        section_t &section = get_section(sections, platform);
+        while (getline(file, line)) {
+            std::vector<std::string> fields = split(line);
+            if (fields.size() != TUNING_DB_LEGACY_VALUES) {
+                return 2;
+            }
+            Key_tuning key;
+            zenTuningRecord record;
+            try {
+                key.op = TUNING_OP_MATMUL_F32;
+                for (int i = 0; i < 8; i++) {
+                    key.dims.push_back(std::stoi(fields[i]));
+                }
+                key.thread_count = std::stoi(fields[8]);
+                record = {(unsigned int)std::stoi(fields[9]), 0, 1};
+            }
+            catch (std::exception const &e) {
+                return 2;
+            }
+            section.records[key] = record;
+        }
+        return 0;
+    }
+
+    std::vector<std::string> header = split(line);
+    if (header.size() != 2 || header[0] != "ZENDNN_TUNING_DB") {
+        return 2;
+    }
+    int version = atoi(header[1].c_str());
+    if (version < 1 || version > ZENDNN_TUNING_DB_VERSION) {
+        zendnnError(ZENDNN_ALGOLOG, "Tuning database ", fname,
+                    " has unsupported format version ", version);
+        return 2;
+    }
+
+    section_t *section = NULL;
+    unsigned int skipped = 0;
+    while (getline(file, line)) {
+        std::vector<std::string> fields = split(line);
+        if (fields.empty()) {
+            continue;
+        }
+        if (fields[0] == "platform") {
+            if (fields.size() < 4) {
+                return 2;
+            }
+            //Brand string is the rest of the line
+            size_t cpu_pos = line.find(',', line.find(',',
+                                       line.find(',') + 1) + 1);
+            section = &get_section(sections, {fields[1], fields[2],
+                                              trim(line.substr(cpu_pos + 1))
+                                             });
+            continue;
+        }
+
+        //Rows of ops unknown to this library are skipped
+        unsigned int op = 0;
+        while (op < TUNING_OP_COUNT && fields[0] != tuning_op_names[op]) {
+            op++;
+        }
+        if (section == NULL || op == TUNING_OP_COUNT ||
+                fields.size() <= TUNING_DB_RECORD_FIELDS) {
+            skipped++;
+            continue;
+        }
+
+        Key_tuning key;
+        zenTuningRecord record;
+        try {
+            key.op = op;
+            key.thread_count = std::stoi(fields[1]);
+            record.algo = std::stoi(fields[2]);
+            record.time_ms = std::stof(fields[3]);
+            record.runs = std::stoi(fields[4]);
+            for (size_t i = TUNING_DB_RECORD_FIELDS; i < fields.size(); i++) {
+                key.dims.push_back(std::stoi(fields[i]));
+            }
+        }
+        catch (std::exception const &e) {
+            skipped++;
+            continue;
+        }
+
+        auto found_obj = section->records.find(key);
+        if (found_obj == section->records.end()) {
+            section->records[key] = record;
+        }
+        else {
+            merge(found_obj->second, record);
+        }
+    }
+    if (skipped) {
+        zendnnInfo(ZENDNN_ALGOLOG, "Tuning database ", fname, " skipped ",
+                   skipped, " rows");
+    }
+    return 0;
+}
+
+//Records of the exact platform first, then records of compatible platforms
+//(same ISA and library major version) for the keys still missing.
+void zendnnTuningDB::build_usable() {
+    usable_.clear();
+    for (const auto &section : sections_) {
+        if (section.platform.library == platform_.library &&
+                section.platform.isa == platform_.isa &&
+                section.platform.cpu == platform_.cpu) {
+            usable_ = section.records;
+        }
+    }
+    size_t exact = usable_.size(), reused = 0;
+    for (const auto &section : sections_) {
+        if (section.platform.isa != platform_.isa ||
+                major_version(section.platform.library) !=
+                major_version(platform_.library)) {
+            continue;
+        }
+        for (const auto &entry : section.records) {
+            if (usable_.find(entry.first) == usable_.end()) {
+                usable_[entry.first] = entry.second;
+                reused++;
+            }
+        }
+    }
+    zendnnInfo(ZENDNN_ALGOLOG, "Tuning database: ", exact,
+               " records for this platform, ", reused,
+               " reused from compatible platforms");
+}
+
+int zendnnTuningDB::load(const char *fname) {
+    if (fname == NULL) {
+        return 1;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &loaded : loaded_files_) {
+        if (loaded == fname) {
+            return 0;
+        }
+    }
+    if (read_file(fname, sections_)) {
+        return 1;
+    }
+    loaded_files_.push_back(fname);
+    build_usable();
+    return 0;
+}
+
+#ifndef _WIN32
+//Exclusive flock on the side file <database>.lock, held while the object
+//lives. Serializes the re-read, merge and rename of processes saving to one
+//database, the database itself is replaced by rename and can not be locked.
+struct zenTuningDBFileLock {
+    int fd;
+    zenTuningDBFileLock(const std::string &name) {
+        fd = open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd >= 0 && flock(fd, LOCK_EX) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    ~zenTuningDBFileLock() {
+        if (fd >= 0) {
+            flock(fd, LOCK_UN);
+            close(fd);
+        }
+    }
+};
+#endif
+
+int zendnnTuningDB::save(const char *fname) {
+    if (fname == NULL) {
+        return 1;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+#ifndef _WIN32
+    zenTuningDBFileLock file_lock(std::string(fname) + ".lock");
+    if (file_lock.fd < 0) {
+        zendnnError(ZENDNN_ALGOLOG, "Tuning database ", fname,
+                    ".lock can not be locked, not saving");
+        return 1;
+    }
+#endif
+
+    //Re-read the file so that results saved by other processes are kept
+    std::vector<section_t> sections;
+    if (read_file(fname, sections) == 2) {
+        zendnnError(ZENDNN_ALGOLOG, "Tuning database ", fname,
+                    " can not be updated, not overwriting it");
+        return 1;
+    }
+    section_t &section = get_section(sections, platform_);
+    for (const auto &entry : session_) {
+        zenTuningRecord record = entry.second;
+        //A key saved before only updates the algo and time
+        if (saved_.find(entry.first) != saved_.end()) {
+            record.runs = 0;
+        }
+        auto found_obj = section.records.find(entry.first);
+        if (found_obj == section.records.end()) {
+            section.records[entry.first] = record;
+        }
+        else {
+            merge(found_obj->second, record);
+        }
+        saved_[entry.first] = entry.second;
+    }
+
+    //Written to a temporary file and renamed, readers never see a
+    //partially written database. The name is unique so that processes
+    //saving at the same time do not write into one file.
+#ifndef _WIN32
+    std::string tmp_name = std::string(fname) + ".XXXXXX";
+    int fd = mkstemp(&tmp_name[0]);
+    if (fd < 0) {
+        return 1;
+    }
+    //mkstemp creates the file private, keep the mode of the database
+    struct stat st;
+    fchmod(fd, stat(fname, &st) == 0 ? st.st_mode & 0777 : 0644);
+    close(fd);
+#else
+    std::string tmp_name = std::string(fname) + "." +
+                           std::to_string(_getpid()) + ".tmp";
+#endif
+    std::ofstream file(tmp_name, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        remove(tmp_name.c_str());
+        return 1;
+    }
+    file<<"ZENDNN_TUNING_DB,"<<ZENDNN_TUNING_DB_VERSION<<"\n";
+    for (const auto &sec : sections) {
+        file<<"platform,"<<sec.platform.library<<","<<sec.platform.isa<<","
+            <<sec.platform.cpu<<"\n";
+        for (const auto &entry : sec.records) {
+            file<<tuning_op_names[entry.first.op]<<","<<entry.first.thread_count
+                <<","<<entry.second.algo<<","<<entry.second.time_ms<<","
+                <<entry.second.runs;
+            for (int dim : entry.first.dims) {
+                file<<","<<dim;
+            }
+            file<<"\n";
+        }
+    }
+    file.close();
+    if (file.fail() || rename(tmp_name.c_str(), fname) != 0) {
+        remove(tmp_name.c_str());
+        return 1;
+    }
+
+    zendnnInfo(ZENDNN_ALGOLOG, "MAP FILE LOCATION ", fname);
+    return 0;
+}
+
+bool zendnnTuningDB::find(const Key_tuning &key, zenTuningRecord &record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found_obj = usable_.find(key);
+    if (found_obj == usable_.end()) {
+        return false;
+    }
+    record = found_obj->second;
+    return true;
+}
+
+void zendnnTuningDB::record(const Key_tuning &key, unsigned int algo,
+                            float time_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    zenTuningRecord record = {algo, time_ms, 1};
+    auto found_obj = session_.find(key);
+    if (found_obj == session_.end()) {
+        session_[key] = record;
+    }
+    else if (time_ms > 0 && (found_obj->second.time_ms <= 0 ||
+                             time_ms < found_obj->second.time_ms)) {
+        found_obj->second.algo = algo;
+        found_obj->second.time_ms = time_ms;
+    }
+}
+
+namespace zendnn {
+
+int zendnnSaveTuningDB(const char *fname) {
+    if (fname == NULL) {
+        fname = zendnnTuningDB::getFile();
+    }
+    if (fname == NULL) {
+        fname = "key_matmul_map.csv";
+    }
+    return zendnnTuningDB::ZenDNNTuningDB().save(fname);
+}
+
+}
@@ -0,0 +1,214 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef ZENDNN_TUNING_DB_HPP
+#define ZENDNN_TUNING_DB_HPP
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "zendnn_private.hpp"
+#include "zendnn_logging.hpp"
+
+//Version of the tuning database file format
+#define ZENDNN_TUNING_DB_VERSION    1
+
+//Persistent tuning database controls
+//ZENDNN_MATMUL_PERSISTENT_MAP (MatMul) and ZENDNN_LPGEMM_PERSISTENT_MAP (conv)
+//0: disable, 1: write tuned algos to the file, 2: read algos from the file
+enum zenTuningDBMode {
+    TUNING_DB_DISABLE = 0,
+    TUNING_DB_WRITE = 1,
+    TUNING_DB_READ = 2,
+};
+
+//Operation a tuning record belongs to
+enum zenTuningOp {
+    TUNING_OP_MATMUL_F32 = 0,
+    TUNING_OP_MATMUL_BF16 = 1,
+    TUNING_OP_CONV_LPGEMM_OS8 = 2,
+    TUNING_OP_CONV_LPGEMM_OS32 = 3,
+    TUNING_OP_COUNT
+};
+
+//Key of a tuning record. dims holds the op specific shape:
+// MatMul : transpose_input, transpose_weights, m, k, n, lda, ldb, ldc
+// Conv   : images, channels, height, width, filters, kernel_h, kernel_w,
+//          pad_t, pad_l, pad_b, pad_r, stride_h, stride_w
+struct Key_tuning {
+    unsigned int op;
+    unsigned int thread_count;
+    std::vector<int> dims;
+
+    bool operator==(const Key_tuning &other) const {
+        return (op == other.op
+                && thread_count == other.thread_count
+                && dims == other.dims
+               );
+    }
+};
+
+namespace std {
+template <>
+struct hash<Key_tuning> {
+    std::size_t operator()(const Key_tuning &k) const {
+        std::size_t seed = 0;
+        seed = zendnn::impl::hash_combine(seed, (k.op));
+        seed = zendnn::impl::hash_combine(seed, (k.thread_count));
+        for (int dim : k.dims) {
+            seed = zendnn::impl::hash_combine(seed, dim);
+        }
+        return seed;
+    }
+};
+}
+
+//Tuning decision for a key
+struct zenTuningRecord {
+    unsigned int algo;
+    float time_ms;      //Best measured time of algo, 0 if not measured
+    unsigned int runs;  //Number of tuning runs merged into the record
+};
+
+inline Key_tuning zenTuningKey(zenTuningOp op, const Key_matmul &key_obj) {
+    Key_tuning key;
+    key.op = op;
+    key.thread_count = key_obj.thread_count;
+    key.dims = {key_obj.transpose_input, key_obj.transpose_weights,
+                (int)key_obj.m, (int)key_obj.k, (int)key_obj.n,
+                (int)key_obj.lda, (int)key_obj.ldb, (int)key_obj.ldc
+               };
+    return key;
+}
+
+//Persistent auto tuner database shared by MatMul and LPGEMM convolution.
+//
+//The file holds one section per platform, a platform being the library
+//version, effective ISA and CPU brand string the records were tuned on:
+//
+//  ZENDNN_TUNING_DB,<format version>
+//  platform,<library version>,<isa>,<cpu brand string>
+//  <op>,<threads>,<algo>,<time_ms>,<runs>,<dims...>
+//  ...
+//
+//Records of the exact platform are preferred. Records tuned on another CPU
+//with the same ISA and library major version are reused for keys the exact
+//platform has no record for. Saving merges with the file on disk, keeping
+//the faster algo per key, so results of several runs and processes add up.
+//Processes saving at the same time take turns on an flock of <file>.lock
+//(not on Windows, where concurrent saves may drop each other's records).
+//Files written by older releases (MatMul only CSV) are still read.
+class zendnnTuningDB {
+  public:
+    static zendnnTuningDB &ZenDNNTuningDB();
+
+    //Mode of an auto tuner, read from env_name
+    static unsigned int getMode(const char *env_name);
+
+    //File from ZENDNN_MATMUL_MAP_FILE, NULL if not set
+    static const char *getFile();
+
+    //Merges the records of fname, once per file. Returns 0 on success.
+    int load(const char *fname);
+
+    //Merges this process's records into fname. Returns 0 on success.
+    int save(const char *fname);
+
+    //Looks up key in the records loaded from file
+    bool find(const Key_tuning &key, zenTuningRecord &record);
+
+    //Records algo measured at time_ms in this process, keeping the faster
+    //algo if the key was recorded before
+    void record(const Key_tuning &key, unsigned int algo, float time_ms);
+
+    //Visits the usable loaded records of op as fn(key, record)
+    template <typename F>
+    void for_each(zenTuningOp op, F fn) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &entry : usable_) {
+            if (entry.first.op == (unsigned int)op) {
+                fn(entry.first, entry.second);
+            }
+        }
+    }
+
+  private:
+    zendnnTuningDB();
+    zendnnTuningDB(const zendnnTuningDB &) = delete;
+    zendnnTuningDB &operator=(const zendnnTuningDB &) = delete;
+
+    typedef std::unordered_map<Key_tuning, zenTuningRecord> table_t;
+
+    struct platform_t {
+        std::string library;
+        std::string isa;
+        std::string cpu;
+    };
+
+    struct section_t {
+        platform_t platform;
+        table_t records;
+    };
+
+    static void merge(zenTuningRecord &dst, const zenTuningRecord &src);
+    int read_file(const char *fname, std::vector<section_t> &sections) const;
+    static section_t &get_section(std::vector<section_t> &sections,
+                                  const platform_t &platform);
+    void build_usable();
+
+    platform_t platform_;
+    std::vector<std::string> loaded_files_;
+    std::vector<section_t> sections_;   //Loaded from file
+    table_t usable_;                    //Loaded records usable on platform_
+    table_t session_;                   //Tuned by this process
+    table_t saved_;                     //Part of session_ already saved
+    std::mutex mutex_;
+};
+
+//Offline tuning of one key: runs every algo (1..num_algo) once to warm up
+//and then iterations times, records the algo with the best time in the
+//tuning database and returns it. run_algo(algo) executes the op once.
+template <typename F>
+unsigned int zenTuningSweep(const Key_tuning &key, unsigned int num_algo,
+                            unsigned int iterations, F run_algo) {
+    unsigned int best_algo = 1;
+    float best_time = 0;
+    for (unsigned int algo = 1; algo <= num_algo; algo++) {
+        run_algo(algo);
+        float algo_time = 0;
+        for (unsigned int i = 0; i < (iterations ? iterations : 1); i++) {
+            auto start = std::chrono::steady_clock::now();
+            run_algo(algo);
+            auto end = std::chrono::steady_clock::now();
+            float cur_time = std::chrono::duration<float, std::milli>
+                             (end - start).count();
+            algo_time = (i == 0 || cur_time < algo_time) ? cur_time : algo_time;
+        }
+        zendnnVerbose(ZENDNN_PROFLOG, "Offline tuner op:", key.op, " algo:", algo,
+                      " time:", algo_time);
+        if (algo == 1 || algo_time < best_time) {
+            best_algo = algo;
+            best_time = algo_time;
+        }
+    }
+    zendnnTuningDB::ZenDNNTuningDB().record(key, best_algo, best_time);
+    return best_algo;
+}
+
+#endif
@@ -27,16 +27,31 @@
 using namespace zendnn;
 // initialize memory pool static array for use by the kernels
 // declared in zendnn_utils.hpp
-ZenLibMemoryPool *ZenLibMemoryPool::zenLibMemPoolArr[ZEN_LIB_MEM_POOL_LIMIT] = {NULL};
+std::atomic<ZenLibMemoryPool *>
+ZenLibMemoryPool::zenLibMemPoolArr[ZEN_LIB_MEM_POOL_LIMIT] = {};
 int ZenLibMemoryPool::zenLibMemPoolCount = 0;
 
 
+//Thread budget of the calling thread, 0 when not limited
+static thread_local unsigned int zenThreadBudget = 0;
+
 //ZenDNN Env Instance
 zendnnEnv readEnv() {
-    const zendnnEnv &obj = zendnnEnv::ZenDNNEnv();
+    zendnnEnv obj = zendnnEnv::ZenDNNEnv();
+    if (zenThreadBudget) {
+        obj.omp_num_threads = zenThreadBudget;
+    }
     return (obj);
 }
 
+void zendnnSetThreadBudget(unsigned int num_threads) {
+    zenThreadBudget = num_threads;
+}
+
+unsigned int zendnnGetThreadBudget() {
+    return zenThreadBudget;
+}
+
 void compute_padding(const int image_h, const int image_w,
                      const int filter_h, const int filter_w,
                      const int stride_h, const int stride_w,
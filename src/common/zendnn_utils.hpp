@@ -19,9 +19,12 @@
 #include <stdlib.h>
 #include <float.h>
 #include <math.h>
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include "zendnn_logging.hpp"
 #include "zendnn_helper.hpp"
+#include "zendnn_arena.hpp"
 
 #define DATA_FORMAT_NCHW 1
 #define DATA_FORMAT_NHWC 0
@@ -83,26 +86,10 @@ class blis_expert {
 //      ZEN_LIB_MEM_POOL_LIMIT accordingly
 #define     ZEN_LIB_MEM_POOL_LIMIT          64
 
-//ZEN_LIB_BUF_POOL_LIMIT define the limit for active buffers inside pool for
-//  given Memory pool
-//TODO: Test with increased limit and tune it accordingly
-#define     ZEN_LIB_BUF_POOL_LIMIT       16
-
-
-//zenLibBufPool structure holds zenLibBufPtr with its state 0, -1 and > 0
-//  Possible states -1(not allocated),
-//                  0(allocated and free)
-//                  >0(occupied, no. of links with other node)
-//  zenLibBufSize is size of pointed memory(no. of elements inside tensor)
-typedef struct zenLibBufState {
-    float               *zenLibBufPtr;
-    int                 zenLibBufPtrStatus;
-    unsigned long       zenLibBufSize;
-} zenLibBufPool;
-
-
-//class ZenLibMemoryPool holds description about memory pool with all buffer pointer
-//  created inside pool.
+//class ZenLibMemoryPool is the scratch memory pool of one stream. Buffers
+//  come from a zendnnArena: size classes with free lists per thread and per
+//  NUMA node, so concurrent streams and threads do not serialize on the
+//  pool and released buffers are reused without new page faults.
 class ZenLibMemoryPool {
 
     //zenLibMemPoolArr hold no. of memory pool exist, In case of multiple streams,
@@ -113,251 +100,129 @@ class ZenLibMemoryPool {
     //  object.
     //zenLibMemPoolCount hold the no of active memory pool
   private:
-    static ZenLibMemoryPool *zenLibMemPoolArr[ZEN_LIB_MEM_POOL_LIMIT];
+    static std::atomic<ZenLibMemoryPool *> zenLibMemPoolArr[ZEN_LIB_MEM_POOL_LIMIT];
     static int zenLibMemPoolCount;
-    //Initialize pool object with default values
-    ZenLibMemoryPool() {
-        zenLibBufPoolSize = 0;
-        zenLibBufPoolLimit = ZEN_LIB_BUF_POOL_LIMIT;
-        max_size = 1;
-        max_size_enable = 0;
-        //To enable/disable Reduced memory pool(default) OR Fixed memory
-        //  pool buffer from env variable.
-        //  Reduced memory pool buffer works with different size buffers in pool,
-        //  Some models are exception to this. For those, in case of Reduced memory
-        //  pool, some of the layers will use default memory allocation once we
-        //  hit the pool limit with ZEN_LIB_BUF_POOL_LIMIT
-        //  Otherwise works with Fixed memory pool buffers, this will works with
-        //  finding max from increasing size as we go deeper into model.
-        //  In future as a part of cost function max size will be calculated and
-        //  used accordingly.
+    //Arena settings are read from env variables
+    //  ZENDNN_ARENA_HUGEPAGES: 0 none, 1 transparent huge pages (default),
+    //      2 explicit huge pages, for buffers of 2MB and more
+    //  ZENDNN_ARENA_FIRST_TOUCH: touch new buffers in the requesting thread
+    //      so they are placed on its NUMA node (default 1)
+    //  ZENDNN_ARENA_THREAD_CACHE_KB: largest buffer kept in the cache of the
+    //      releasing thread (default 1024)
+    //  ZENDNN_LIB_BUF_POOL_LIMIT: most buffers of the pool in use at once,
+    //      further requests use the default allocation (default 0, no limit)
+    //  ZENDNN_LIB_BUF_MAXSIZE_ENABLE: every buffer takes the running max of
+    //      the requested sizes, so any free buffer fits the next request
+    //      (default 0)
+    ZenLibMemoryPool()
+        : zenLibArena(zendnn_getenv_int("ZENDNN_ARENA_HUGEPAGES", 1),
+                      zendnn_getenv_int("ZENDNN_ARENA_FIRST_TOUCH", 1) != 0,
+                      (size_t)std::max(0, zendnn_getenv_int("ZENDNN_ARENA_THREAD_CACHE_KB",
+                                       1024)) * 1024),
+          zenLibBufActive(0), max_size(0) {
+        zenLibBufPoolLimit = std::max(0, zendnn_getenv_int("ZENDNN_LIB_BUF_POOL_LIMIT",
+                                      0));
         max_size_enable = zendnn_getenv_int("ZENDNN_LIB_BUF_MAXSIZE_ENABLE", 0);
-        //Getting max pool limit from env variable
-        zenLibBufPoolLimit = zendnn_getenv_int("ZENDNN_LIB_BUF_POOL_LIMIT",
-                                               ZEN_LIB_BUF_POOL_LIMIT);
-        zenLibBufPoolLimit = (zenLibBufPoolLimit <=0)?1:zenLibBufPoolLimit;
-
-        zenLibBufPoolArr = (zenLibBufPool *) malloc(zenLibBufPoolLimit * sizeof(
-                               zenLibBufPool));
-
-        for (int i=0; i<zenLibBufPoolLimit; i++) {
-            zenLibBufPoolArr[i].zenLibBufPtr = NULL;
-            zenLibBufPoolArr[i].zenLibBufPtrStatus = -1;
-            zenLibBufPoolArr[i].zenLibBufSize = 0;
-        }
     }
 
     //destroy Memory pool once done with usage
-    ~ZenLibMemoryPool() {
-        for (int i=0; i<zenLibBufPoolSize; i++) {
-            free(zenLibBufPoolArr[i].zenLibBufPtr);
-        }
-        free(zenLibBufPoolArr);
-    }
-
-  public:
-    //zenLibBufPoolArr will hold all ptr and state of buffers created
-    //  in the pool
-    //zenLibBufPtrStatus will hold the state of those buffers
-    //  Possible states -1(not allocated),
-    //                0(allocated and free)
-    //                >0(buffer links with other node)
-    zenLibBufPool     *zenLibBufPoolArr;
+    ~ZenLibMemoryPool() {}
 
-    //No. of allocated buffers inside pool
-    unsigned int    zenLibBufPoolSize;
+    zendnnArena zenLibArena;
 
-    //Max limit for active buffers inside pool
-    unsigned int    zenLibBufPoolLimit;
+    //Buffers handed out and not released yet, counted with a limit only
+    std::atomic<int> zenLibBufActive;
+    int zenLibBufPoolLimit;
 
-    //max_size_enable will allocate all buffers in pool of size equal to size
-    //  of the o/p first layer or running max with pool array
-    //TODO: calulate max_size as part of cost function during graph analysis
-    //  phase and then use it accordingly.
-    int            max_size_enable;
-
-    //max size of allocated buffers in the pool
-    unsigned long     max_size;
+    //Running max of the requested sizes, with max_size_enable
+    int max_size_enable;
+    std::atomic<unsigned long> max_size;
 
+  public:
     //Get Memory pool pointer from Global array of memory pool based on index
     //Create ZenMemPool object, if not created corresponding to that index
     static ZenLibMemoryPool *getZenLibMemPool(int index) {
-
-        bool flag = false;
-        #pragma omp critical
-        {
-            //ZEN_LIB_MEM_POOL_LIMIT is the hard limit on the total no. of ZenLibMemoryPool
-            //TODO: Need to tune ZEN_LIB_MEM_POOL_LIMIT based on the available memory or
-            //make it grow dynamically
-            if (index >= ZEN_LIB_MEM_POOL_LIMIT) {
-                flag = true;
-            }
-            else if (!zenLibMemPoolArr[index]) {
-                zenLibMemPoolArr[index] = new ZenLibMemoryPool();
-                zenLibMemPoolCount++;
-            }
-        }
-        if (flag) {
+        //ZEN_LIB_MEM_POOL_LIMIT is the hard limit on the total no. of ZenLibMemoryPool
+        //TODO: Need to tune ZEN_LIB_MEM_POOL_LIMIT based on the available memory or
+        //make it grow dynamically
+        if (index < 0 || index >= ZEN_LIB_MEM_POOL_LIMIT) {
             return NULL;
         }
-        else {
-            return zenLibMemPoolArr[index];
+        //Pools are only created under the lock, lookups do not take it
+        ZenLibMemoryPool *pool = zenLibMemPoolArr[index].load(
+                                     std::memory_order_acquire);
+        if (!pool) {
+            #pragma omp critical
+            {
+                pool = zenLibMemPoolArr[index].load(std::memory_order_relaxed);
+                if (!pool) {
+                    pool = new ZenLibMemoryPool();
+                    zenLibMemPoolArr[index].store(pool, std::memory_order_release);
+                    zenLibMemPoolCount++;
+                }
+            }
         }
+        return pool;
     }
 
-    //Free zenLibMemPoolArr based on index passed
+    //Free zenLibMemPoolArr based on index passed, no buffer of the pool
+    //  may be in use
     static void freeZenLibMemPool(int index) {
 
         #pragma omp critical
         {
-            if (index < ZEN_LIB_MEM_POOL_LIMIT && zenLibMemPoolArr[index]) {
-                delete zenLibMemPoolArr[index];
+            if (index >= 0 && index < ZEN_LIB_MEM_POOL_LIMIT && zenLibMemPoolArr[index]) {
+                delete zenLibMemPoolArr[index].exchange(NULL);
                 zenLibMemPoolCount--;
             }
         }
     }
 
-    //Reset status of all buffers as free at
-    //the start of graph execution.
-    void resetLibPoolStatus() {
-        for (int i=0; i<zenLibBufPoolSize; i++) {
-            zenLibBufPoolArr[i].zenLibBufPtrStatus = 0;
-        }
-    }
-    //Acquire buffer from the given pool object. If pool is not
-    //  initialized or buffer is not free, create buffer and
-    //  add to the pool.
+    //Acquire buffer of out_size bytes from the given pool object, returns
+    //  non zero when it can not be allocated. The buffer is released after
+    //  outlinks calls of zenLibMemPoolFree.
     int acquireZenLibPoolBuf(float **output, unsigned long out_size, int outlinks) {
-
-        int return_flag = 0;
-        #pragma omp critical
-        {
-            /*
-                    if (reset && zenLibBufPoolSize) {
-                        resetLibPoolStatus();
-                    }
-            */
-            int acquire_flag = 0;
-            int free_flag = 0;
-
-            // Search for free buffer in pool for buffer_size >= out_size
-            for (int i=0; i<zenLibBufPoolSize; i++) {
-                if (zenLibBufPoolArr[i].zenLibBufPtrStatus == 0) {
-
-                    free_flag = 1;
-
-                    //Go to next free buffer when out_size is more
-                    //  than buffer_size of pool at given offset.
-                    unsigned long buffer_size = zenLibBufPoolArr[i].zenLibBufSize;
-                    if (out_size > buffer_size) {
-                        zenLibBufPoolArr[i].zenLibBufPtr = (float *) realloc(
-                                                               zenLibBufPoolArr[i].zenLibBufPtr, out_size);
-                        if (zenLibBufPoolArr[i].zenLibBufPtr == NULL) {
-                            continue;
-                        }
-                        zenLibBufPoolArr[i].zenLibBufSize = out_size;
-                    }
-                    *output = zenLibBufPoolArr[i].zenLibBufPtr;
-                    zenLibBufPoolArr[i].zenLibBufPtrStatus = outlinks;
-                    acquire_flag = 1;
-                    zendnnInfo(ZENDNN_ALGOLOG,
-                               "LIB-MEM-POOL: Acquired libBufPool Ptr[", i,
-                               "] pointed to size(no. of elements)",
-                               buffer_size);
-
-                    break;
-                }
-            }
-            //If requested buffer not found in pool, go ahead and create
-            //  new buffer inside pool.
-            if (!acquire_flag) {
-
-                if (zenLibBufPoolSize == zenLibBufPoolLimit) {
-                    if (free_flag) {
-                        zendnnInfo(ZENDNN_ALGOLOG,
-                                   "LIB-MEM-POOL: Requested buffer from ZenLibMemPool, But Falling back to default allocation as out_size > available buffer_size inside Pool");
-                    }
-                    else {
-                        zendnnInfo(ZENDNN_ALGOLOG,
-                                   "LIB-MEM-POOL: Requested buffer from ZenLibMemPool, But Falling back to default allocation as zenLibBufPoolSize == ZEN_LIB_BUF_POOL_LIMIT");
-                    }
-                    return_flag = 1;
-                }
-                else {
-                    unsigned int poolOffset = zenLibBufPoolSize;
-                    unsigned long size;
-
-                    //Set max_size based on current layer output dimension
-                    //  and ZEN_LIB_BUF_SIZE_FACTOR, Most of the cases Output
-                    //  dimension goes down after first layer. However few
-                    //  models are exception to this.
-                    //max_size required can be computed during first run
-                    //  for graph execution and same can be used for Buffer
-                    //  allocation. But this will not give optimal performance
-                    //  for first graph execution.
-                    //TODO: Compute max_size as part of cost function during
-                    //  graph analysis phase
-                    if (out_size > max_size) {
-                        max_size = out_size;
-                    }
-
-                    //max_size_enable will create all the buffers with increasing
-                    //  size inside the pool
-                    if (max_size_enable) {
-                        size = max_size;
-                    }
-                    else {
-                        size = out_size;
-                    }
-                    zenLibBufPoolArr[poolOffset].zenLibBufPtr = (float *) zendnn_aligned_alloc(
-                                ALIGNED_OFFSET, sizeof(
-                                    float) * size);
-
-                    if (zenLibBufPoolArr[poolOffset].zenLibBufPtr == NULL) {
-                        return_flag = 1;
-                    }
-                    else {
-                        zenLibBufPoolArr[poolOffset].zenLibBufSize = size;
-                        *output = zenLibBufPoolArr[poolOffset].zenLibBufPtr;
-                        zenLibBufPoolArr[poolOffset].zenLibBufPtrStatus = outlinks;
-                        acquire_flag = 1;
-                        zenLibBufPoolSize++;
-                        zendnnInfo(ZENDNN_ALGOLOG,
-                                   "LIB-MEM-POOL: Allocation done for Buffer in Pool of size = ",
-                                   size, " elements", " zenLibBufPoolCount = ",
-                                   zenLibBufPoolSize-1);
-                        zendnnInfo(ZENDNN_ALGOLOG,
-                                   "LIB-MEM-POOL: Acquired LibBufPool Ptr[", poolOffset,
-                                   "] pointed to size(no. of elements)",
-                                   size);
-                    }
-                }
+        if (max_size_enable) {
+            unsigned long cur_max = max_size.load();
+            while (out_size > cur_max &&
+                    !max_size.compare_exchange_weak(cur_max, out_size)) {
             }
+            out_size = std::max(out_size, cur_max);
         }
-        if (return_flag) {
-            return 1;
+        if (zenLibBufPoolLimit && zenLibBufActive.fetch_add(1) >= zenLibBufPoolLimit) {
+            zenLibBufActive--;
+            *output = NULL;
         }
         else {
-            return 0;
+            *output = (float *)zenLibArena.allocate(out_size, outlinks);
+            if (*output == NULL && zenLibBufPoolLimit) {
+                zenLibBufActive--;
+            }
         }
-
-
+        if (*output == NULL) {
+            zendnnInfo(ZENDNN_ALGOLOG,
+                       "LIB-MEM-POOL: Requested buffer of ", out_size,
+                       " bytes from ZenLibMemPool, falling back to default allocation");
+            return 1;
+        }
+        return 0;
     }
-    //This will update the state of Memory pool by decrementing
-    //zenLibBufPtrStatus based on the input buffer comparison.
-    void zenLibMemPoolFree(float *buffer) {
-        #pragma omp critical
-        {
-            for (int i=0; i<zenLibBufPoolSize; i++) {
-                float *buffer_array = zenLibBufPoolArr[i].zenLibBufPtr;
-                if (buffer == buffer_array) {
-                    zenLibBufPoolArr[i].zenLibBufPtrStatus--;
-                    break;
-                }
 
-            }
+    //Release one link of a buffer acquired from this pool
+    void zenLibMemPoolFree(float *buffer) {
+        if (zenLibArena.release(buffer) && zenLibBufPoolLimit) {
+            zenLibBufActive--;
         }
+    }
+
+    //Occupancy and high water mark of the pool
+    zendnnArena::stats_t zenLibMemPoolStats() const {
+        return zenLibArena.stats();
+    }
 
+    //Return the free buffers of the pool to the system
+    void zenLibMemPoolTrim() {
+        zenLibArena.trim();
     }
 };
 #endif
@@ -0,0 +1,253 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#include <string.h>
+#include <vector>
+#include "zendnn_weight_cache.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+
+//Content fingerprint: hashes the buffer size and every byte of the buffer,
+//8 bytes at a time. Taken once per buffer span, lookups reuse the stored
+//value. Never returns 0 as 0 means "no id" in Key_weight_cache.
+static uint64_t zenWeightFingerprint(const void *weights, size_t size) {
+    const char *buf = (const char *)weights;
+    size_t seed = zendnn::impl::hash_combine((size_t)0, size);
+    size_t words = size / sizeof(uint64_t);
+    for (size_t i = 0; i < words; i++) {
+        uint64_t word;
+        memcpy(&word, buf + i * sizeof(uint64_t), sizeof(uint64_t));
+        seed = zendnn::impl::hash_combine(seed, word);
+    }
+    for (size_t i = words * sizeof(uint64_t); i < size; i++) {
+        seed = zendnn::impl::hash_combine(seed, buf[i]);
+    }
+    return seed == 0 ? 1 : seed;
+}
+
+zendnnWeightCache &zendnnWeightCache::ZenDNNWeightCache() {
+    static zendnnWeightCache obj;
+    return obj;
+}
+
+zendnnWeightCache::zendnnWeightCache() : bytes_(0), tick_(1), evictions_(0) {
+    zendnnEnv zenEnvObj = readEnv();
+    capacity_ = (size_t)zenEnvObj.zenWeightCacheCapacity * 1024 * 1024;
+    key_type_ = zenEnvObj.zenWeightCacheKey;
+}
+
+//Each thread keeps updating the same counter stripe
+zendnnWeightCache::counter_t &zendnnWeightCache::counter() {
+    static std::atomic<unsigned int> next_stripe(0);
+    static thread_local unsigned int stripe = next_stripe.fetch_add(1) %
+            WEIGHT_CACHE_COUNTER_STRIPES;
+    return counters_[stripe];
+}
+
+Key_weight_cache zendnnWeightCache::getKey(const Key_matmul &key_obj,
+        zenWeightCacheKind kind, size_t weights_size) {
+    Key_weight_cache cache_key;
+    cache_key.key = key_obj;
+    cache_key.kind = kind;
+    cache_key.weight_id = 0;
+
+    //AOCL reordered buffers are built from B, its transpose, k, n and ldb
+    //only, drop the fields of A and C so that all batch sizes share one
+    //reorder. Thread count stays in the key as the reorder runs threaded.
+    if (kind == WEIGHT_CACHE_AOCL_F32 || kind == WEIGHT_CACHE_AOCL_BF16 ||
+            kind == WEIGHT_CACHE_AOCL_U8S8 || kind == WEIGHT_CACHE_AOCL_S8S8 ||
+            kind == WEIGHT_CACHE_S8_COLSUM || kind >= WEIGHT_CACHE_CONV_U8S8S32) {
+        cache_key.key.m = 0;
+        cache_key.key.lda = 0;
+        cache_key.key.ldc = 0;
+    }
+
+    //A framework id names the tensor wherever it lives. A fingerprint only
+    //tells apart contents at one address, the address stays in the key so
+    //two live tensors never share an entry.
+    weight_ids_.find(key_obj.weights, cache_key.weight_id);
+    if (cache_key.weight_id != 0) {
+        cache_key.key.weights = NULL;
+    }
+    else if (key_type_ == WEIGHT_CACHE_KEY_FINGERPRINT &&
+             key_obj.weights != NULL) {
+        //Hashed on first use only, invalidate() marks the contents changed
+        zenWeightSpanKey span(key_obj.weights, weights_size);
+        if (!fingerprints_.find(span, cache_key.weight_id)) {
+            cache_key.weight_id = zenWeightFingerprint(key_obj.weights, weights_size);
+            fingerprints_.insert(span, cache_key.weight_id);
+        }
+    }
+    return cache_key;
+}
+
+std::shared_ptr<void> zendnnWeightCache::find(const Key_weight_cache &key) {
+    std::shared_ptr<entry_t> entry;
+    if (!map_.find(key, entry)) {
+        counter().misses.fetch_add(1, std::memory_order_relaxed);
+        return std::shared_ptr<void>();
+    }
+    counter().hits.fetch_add(1, std::memory_order_relaxed);
+    //Mark as used in the current epoch, skip the store if already marked
+    //to keep the entry cache line shared between readers
+    uint64_t tick = tick_.load(std::memory_order_relaxed);
+    if (entry->last_use.load(std::memory_order_relaxed) != tick) {
+        entry->last_use.store(tick, std::memory_order_relaxed);
+    }
+    return entry->value;
+}
+
+std::shared_ptr<void> zendnnWeightCache::insert(const Key_weight_cache &key,
+        const std::shared_ptr<void> &value, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<entry_t> entry;
+    if (map_.find(key, entry)) {
+        entry->last_use.store(tick_.load());
+        return entry->value;
+    }
+    if (capacity_ && size > capacity_) {
+        zendnnVerbose(ZENDNN_ALGOLOG, "WEIGHT-CACHE: reorder of ", size,
+                      " bytes exceeds capacity ", capacity_, " bytes, not cached");
+        return value;
+    }
+    evict(size);
+    //Start a new epoch so that hits from now on rank above older entries
+    uint64_t tick = tick_.fetch_add(1) + 1;
+    entry = std::make_shared<entry_t>(value, size, tick);
+    entry->lru_pos = lru_.insert(lru_.end(), key);
+    map_.insert(key, entry);
+    bytes_ += size;
+    return value;
+}
+
+void zendnnWeightCache::evict(size_t size) {
+    if (!capacity_) {
+        return;
+    }
+    while (bytes_ + size > capacity_ && !lru_.empty()) {
+        Key_weight_cache lru_key = lru_.front();
+        std::shared_ptr<entry_t> entry;
+        if (!map_.find(lru_key, entry)) {
+            lru_.pop_front();
+            continue;
+        }
+        //Hit since it was queued: requeue in the current epoch. A hit in
+        //that epoch does not change last_use again, so every entry is
+        //requeued at most once per insert.
+        uint64_t tick = tick_.load();
+        if (entry->last_use.load(std::memory_order_relaxed) > entry->queued &&
+                entry->queued != tick) {
+            entry->queued = tick;
+            lru_.splice(lru_.end(), lru_, entry->lru_pos);
+            continue;
+        }
+        zendnnVerbose(ZENDNN_ALGOLOG, "WEIGHT-CACHE: evicting ", entry->size,
+                      " bytes, in use ", bytes_.load(), " bytes");
+        erase(lru_key);
+        evictions_++;
+    }
+}
+
+void zendnnWeightCache::erase(const Key_weight_cache &key) {
+    std::shared_ptr<entry_t> entry;
+    if (map_.find(key, entry)) {
+        bytes_ -= entry->size;
+        lru_.erase(entry->lru_pos);
+        map_.erase(key);
+    }
+}
+
+void zendnnWeightCache::setWeightId(const void *weights, uint64_t weight_id) {
+    uint64_t cur_id = 0;
+    if (weight_ids_.find(weights, cur_id) && cur_id == weight_id) {
+        return;
+    }
+    //Buffer now holds a different tensor, drop reorders of the old one
+    invalidate(weights);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (weight_id == 0) {
+        weight_ids_.erase(weights);
+    }
+    else {
+        weight_ids_.insert_or_assign(weights, weight_id);
+    }
+}
+
+void zendnnWeightCache::invalidate(const void *weights) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t weight_id = 0;
+    weight_ids_.find(weights, weight_id);
+    std::vector<Key_weight_cache> keys;
+    map_.for_each([&](const Key_weight_cache &key,
+    const std::shared_ptr<entry_t> &entry) {
+        if (key.key.weights == weights ||
+                (weight_id != 0 && key.weight_id == weight_id)) {
+            keys.push_back(key);
+        }
+    });
+    for (auto &key : keys) {
+        erase(key);
+    }
+    fingerprints_.erase_if([&](const zenWeightSpanKey &span, uint64_t) {
+        return span.first == weights;
+    });
+}
+
+void zendnnWeightCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    map_.clear();
+    lru_.clear();
+    fingerprints_.clear();
+    bytes_ = 0;
+}
+
+zendnnWeightCacheStats zendnnWeightCache::getStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    zendnnWeightCacheStats stats;
+    stats.hits = 0;
+    stats.misses = 0;
+    for (auto &stripe : counters_) {
+        stats.hits += stripe.hits.load(std::memory_order_relaxed);
+        stats.misses += stripe.misses.load(std::memory_order_relaxed);
+    }
+    stats.evictions = evictions_;
+    stats.entries = map_.size();
+    stats.bytes = bytes_;
+    stats.capacity = capacity_;
+    return stats;
+}
+
+namespace zendnn {
+
+void zendnnSetWeightId(const void *weights, uint64_t weight_id) {
+    zendnnWeightCache::ZenDNNWeightCache().setWeightId(weights, weight_id);
+}
+
+void zendnnInvalidateWeights(const void *weights) {
+    zendnnWeightCache::ZenDNNWeightCache().invalidate(weights);
+}
+
+void zendnnClearWeightCache() {
+    zendnnWeightCache::ZenDNNWeightCache().clear();
+}
+
+zendnnWeightCacheStats zendnnGetWeightCacheStats() {
+    return zendnnWeightCache::ZenDNNWeightCache().getStats();
+}
+
+}
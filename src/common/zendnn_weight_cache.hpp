@@ -0,0 +1,201 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef ZENDNN_WEIGHT_CACHE_HPP
+#define ZENDNN_WEIGHT_CACHE_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "zendnn_private.hpp"
+#include "zendnn_concurrent_map.hpp"
+
+//Number of hit/miss counter stripes, spreads the counter updates of
+//concurrent callers over different cache lines
+#define WEIGHT_CACHE_COUNTER_STRIPES    16
+
+//Reorder format held by a cache entry. Same weights can be reordered for
+//more than one GEMM backend, hence kind is part of the key.
+enum zenWeightCacheKind {
+    WEIGHT_CACHE_AOCL_F32 = 0,
+    WEIGHT_CACHE_AOCL_BF16 = 1,
+    WEIGHT_CACHE_JIT_F32 = 2,
+    WEIGHT_CACHE_JIT_BF16 = 3,
+    WEIGHT_CACHE_WINOGRAD_F32 = 4,
+    WEIGHT_CACHE_AOCL_U8S8 = 5,
+    WEIGHT_CACHE_AOCL_S8S8 = 6,
+    //Column sums of s8 weights, for source zero point compensation
+    WEIGHT_CACHE_S8_COLSUM = 7,
+    //LPGEMM convolution filters
+    WEIGHT_CACHE_CONV_U8S8S32 = 8,
+    WEIGHT_CACHE_CONV_S8S8S32 = 9,
+    WEIGHT_CACHE_CONV_U8S8S16 = 10,
+    WEIGHT_CACHE_CONV_S8S8S16 = 11,
+    WEIGHT_CACHE_CONV_BF16 = 12,
+};
+
+//How weights are identified when no framework weight id is registered
+// ADDRESS     : raw weight pointer (default, old behaviour)
+// FINGERPRINT : raw weight pointer and a hash of the weight contents, taken
+//               on first use of the buffer and again after invalidate()
+enum zenWeightCacheKeyType {
+    WEIGHT_CACHE_KEY_ADDRESS = 0,
+    WEIGHT_CACHE_KEY_FINGERPRINT = 1,
+};
+
+//Key for reordered weights. weight_id is either the framework supplied id or
+//the content fingerprint. A framework id clears the raw pointer inside key,
+//so that a freed and reallocated address can never alias an entry; a
+//fingerprint keeps it, so that only contents at one address are compared.
+struct Key_weight_cache {
+    Key_matmul key;
+    unsigned int kind;
+    uint64_t weight_id;
+
+    bool operator==(const Key_weight_cache &other) const {
+        return (kind == other.kind
+                && weight_id == other.weight_id
+                && key == other.key
+               );
+    }
+};
+
+namespace std {
+template <>
+struct hash<Key_weight_cache> {
+    std::size_t operator()(const Key_weight_cache &k) const {
+        std::size_t seed = std::hash<Key_matmul>()(k.key);
+        seed = zendnn::impl::hash_combine(seed, (k.kind));
+        seed = zendnn::impl::hash_combine(seed, (k.weight_id));
+        return seed;
+    }
+};
+}
+
+//Weight buffer address and span in bytes, key of the stored fingerprints
+typedef std::pair<const void *, size_t> zenWeightSpanKey;
+
+struct zenWeightSpanHash {
+    std::size_t operator()(const zenWeightSpanKey &k) const {
+        std::size_t seed = std::hash<const void *>()(k.first);
+        return zendnn::impl::hash_combine(seed, k.second);
+    }
+};
+
+//Size in bytes spanned by a (k x n) weight matrix with leading dimension ldb
+inline size_t zenWeightSpan(bool transpose, int k, int n, int ldb,
+                            size_t type_size) {
+    size_t elems = transpose ? (size_t)(n - 1) * ldb + k :
+                   (size_t)(k - 1) * ldb + n;
+    return elems * type_size;
+}
+
+//Unified cache for reordered MatMul weights.
+//Least recently used entries are evicted once the byte budget set by
+//ZENDNN_WEIGHT_CACHE_CAPACITY (in MB, 0 = unbounded) is exceeded. Values
+//are reference counted, so an entry evicted while a GEMM is still reading
+//it is only released once that GEMM drops its reference.
+//
+//Lookups are wait-free: a hit only reads the concurrent map and stamps the
+//entry with the current insert epoch. Insertion, eviction and invalidation
+//are serialized by mutex_, which also guards lru_, the entries in the order
+//they were inserted or last requeued. Eviction takes the front of lru_; an
+//entry hit in a later epoch than it was queued in is requeued at the back
+//instead (second chance), so each eviction costs O(1) amortized.
+class zendnnWeightCache {
+  public:
+    static zendnnWeightCache &ZenDNNWeightCache();
+
+    //Builds the cache key for weights of the given reorder kind.
+    //weights_size is the span of the user weights in bytes and is only
+    //used when fingerprinting is enabled. The fingerprint of a span is
+    //computed once and kept until invalidate() is called on its address.
+    Key_weight_cache getKey(const Key_matmul &key_obj, zenWeightCacheKind kind,
+                            size_t weights_size);
+
+    //Returns the cached value or an empty pointer on miss
+    std::shared_ptr<void> find(const Key_weight_cache &key);
+
+    //Inserts value of size bytes and returns the value held by the cache.
+    //If another thread inserted the same key first, that value is returned.
+    //Values larger than the whole budget are not cached.
+    std::shared_ptr<void> insert(const Key_weight_cache &key,
+                                 const std::shared_ptr<void> &value, size_t size);
+
+    //Typed helpers
+    template <typename T>
+    std::shared_ptr<T> find_as(const Key_weight_cache &key) {
+        return std::static_pointer_cast<T>(find(key));
+    }
+    template <typename T>
+    std::shared_ptr<T> insert_as(const Key_weight_cache &key,
+                                 const std::shared_ptr<T> &value, size_t size) {
+        return std::static_pointer_cast<T>(insert(key,
+                                           std::static_pointer_cast<void>(value), size));
+    }
+
+    void setWeightId(const void *weights, uint64_t weight_id);
+    void invalidate(const void *weights);
+    void clear();
+    zendnn::zendnnWeightCacheStats getStats();
+
+  private:
+    zendnnWeightCache();
+    zendnnWeightCache(const zendnnWeightCache &) = delete;
+    zendnnWeightCache &operator=(const zendnnWeightCache &) = delete;
+
+    struct entry_t {
+        std::shared_ptr<void> value;
+        size_t size;
+        std::atomic<uint64_t> last_use;
+        //Position in lru_ and the epoch it was queued in, under mutex_
+        std::list<Key_weight_cache>::iterator lru_pos;
+        uint64_t queued;
+        entry_t(const std::shared_ptr<void> &v, size_t s, uint64_t tick)
+            : value(v), size(s), last_use(tick), queued(tick) {}
+    };
+
+    struct alignas(64) counter_t {
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> misses;
+        counter_t() : hits(0), misses(0) {}
+    };
+
+    //Drops least recently used entries until size more bytes fit the budget.
+    //Caller must hold mutex_.
+    void evict(size_t size);
+    void erase(const Key_weight_cache &key);
+    counter_t &counter();
+
+    std::mutex mutex_;
+    zenConcurrentMap<Key_weight_cache, std::shared_ptr<entry_t>> map_;
+    zenConcurrentMap<const void *, uint64_t> weight_ids_;
+    zenConcurrentMap<zenWeightSpanKey, uint64_t, zenWeightSpanHash> fingerprints_;
+    std::list<Key_weight_cache> lru_;
+    counter_t counters_[WEIGHT_CACHE_COUNTER_STRIPES];
+
+    size_t capacity_;
+    std::atomic<size_t> bytes_;
+    std::atomic<uint64_t> tick_;
+    unsigned int key_type_;
+    std::atomic<uint64_t> evictions_;
+};
+
+#endif
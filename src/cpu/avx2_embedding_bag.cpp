@@ -26,6 +26,7 @@
 #include "zendnn_logging.hpp"
 #include "cpu/avx2_embedding_bag.hpp"
 
+#include <algorithm>
 #include <vector>
 
 namespace zendnn {
@@ -34,9 +35,9 @@ namespace cpu {
 
 using namespace data_type;
 
-template<data_type_t data_type>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx2_embedding_bag_t<data_type>::execute(const exec_ctx_t &ctx) const {
+avx2_embedding_bag_t<data_type, idx_type>::execute(const exec_ctx_t &ctx) const {
 
 #if ZENDNN_CPU_THREADING_RUNTIME != ZENDNN_RUNTIME_OMP
     assert(!"threading env need to be omp for embedding_bag");
@@ -70,9 +71,9 @@ avx2_embedding_bag_t<data_type>::execute(const exec_ctx_t &ctx) const {
 /*
  * extract embedding bag parameters
  */
-template<data_type_t data_type>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx2_embedding_bag_t<data_type>::pre_process(const exec_ctx_t &ctx,
+avx2_embedding_bag_t<data_type, idx_type>::pre_process(const exec_ctx_t &ctx,
         emb_params_t &params) const {
 
     status_t status = status::success;
@@ -106,7 +107,13 @@ avx2_embedding_bag_t<data_type>::pre_process(const exec_ctx_t &ctx,
     memory_desc_wrapper dst_mdw(pd()->dst_md(ZENDNN_ARG_DST));
 
     const auto &input_dims   = input_mdw.dims();
-    params.width             = input_dims[1];
+    params.width             = dst_mdw.dims()[1];
+    params.row_bytes         = input_dims[1];
+    params.qbits             = data_type == u8 ? embedding_bag_quant_bits(
+                                   input_dims[1], params.width) : 0;
+    params.prefetch_dist     = embedding_bag_prefetch_distance(
+                                   input_mdw.size(), params.qbits ? params.row_bytes :
+                                   params.width * sizeof(input_type));
 
     params.offset_size       = offsets_mdw.nelems();
     params.indices_size      = indices_mdw.nelems();
@@ -127,9 +134,9 @@ avx2_embedding_bag_t<data_type>::pre_process(const exec_ctx_t &ctx,
 /*
  * sum without weights
  */
-template<>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx2_embedding_bag_t<f32>::avx2_sum(const emb_params_t &params) const {
+avx2_embedding_bag_t<data_type, idx_type>::avx2_sum(const emb_params_t &params) const {
 
     float        const *input    = static_cast<float *>(params.input);
     indices_type       *indices  = static_cast<indices_type *>(params.indices);
@@ -138,6 +145,7 @@ avx2_embedding_bag_t<f32>::avx2_sum(const emb_params_t &params) const {
 
     const int64_t      &width          = static_cast<int64_t>(params.width);
     const int32_t      &indsz          = params.indices_size;
+    const int32_t      &pfd            = params.prefetch_dist;
     int32_t            offsz           = params.offset_size;
     const int32_t      &dstsz          = params.dst_size;
     const indices_type &padidx         = params.padidx;
@@ -169,6 +177,7 @@ avx2_embedding_bag_t<f32>::avx2_sum(const emb_params_t &params) const {
 
                 zenmm_ext_ps128 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_add_ps(input + (indices[i] * width));
                     }
@@ -190,6 +199,7 @@ avx2_embedding_bag_t<f32>::avx2_sum(const emb_params_t &params) const {
 
                 zenmm_ext_ps128 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -214,6 +224,7 @@ avx2_embedding_bag_t<f32>::avx2_sum(const emb_params_t &params) const {
 
                 zenmm_ext_ps64 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_add_ps(input + (indices[i] * width));
                     }
@@ -235,6 +246,7 @@ avx2_embedding_bag_t<f32>::avx2_sum(const emb_params_t &params) const {
 
                 zenmm_ext_ps64 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -259,6 +271,7 @@ avx2_embedding_bag_t<f32>::avx2_sum(const emb_params_t &params) const {
 
             std::vector<dst_type> sum(width,0.0);
             for (auto i = ofirst; i < olast; ++i) {
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                 if (indices[i] != padidx) {
                     for (auto j = 0; j < width; ++j) {
                         sum[j] += input[j + (indices[i] * width)];
@@ -300,9 +313,9 @@ avx2_embedding_bag_t<f32>::avx2_sum(const emb_params_t &params) const {
  * sum with weights
  */
 
-template<>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx2_embedding_bag_t<f32>::avx2_sum_wt(const emb_params_t &params) const {
+avx2_embedding_bag_t<data_type, idx_type>::avx2_sum_wt(const emb_params_t &params) const {
 
     float        const *input    = static_cast<float *>(params.input);
     float        const *wts      = static_cast<float *>(params.weights);
@@ -312,6 +325,7 @@ avx2_embedding_bag_t<f32>::avx2_sum_wt(const emb_params_t &params) const {
 
     const int64_t      &width    = static_cast<int64_t>(params.width);
     const int32_t      &indsz    = params.indices_size;
+    const int32_t      &pfd      = params.prefetch_dist;
     int32_t            offsz     = params.offset_size;
     const int32_t      &dstsz    = params.dst_size;
     const indices_type &padidx   = params.padidx;
@@ -342,6 +356,7 @@ avx2_embedding_bag_t<f32>::avx2_sum_wt(const emb_params_t &params) const {
 
                 zenmm_ext_ps128 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                     }
@@ -363,6 +378,7 @@ avx2_embedding_bag_t<f32>::avx2_sum_wt(const emb_params_t &params) const {
 
                 zenmm_ext_ps128 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                 }
                 sum.store_ps(dst + oi*stride);
@@ -387,6 +403,7 @@ avx2_embedding_bag_t<f32>::avx2_sum_wt(const emb_params_t &params) const {
 
                 zenmm_ext_ps64 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                     }
@@ -408,6 +425,7 @@ avx2_embedding_bag_t<f32>::avx2_sum_wt(const emb_params_t &params) const {
 
                 zenmm_ext_ps64 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                 }
                 sum.store_ps(dst + oi*stride);
@@ -431,6 +449,7 @@ avx2_embedding_bag_t<f32>::avx2_sum_wt(const emb_params_t &params) const {
 
             std::vector<dst_type> sum(width,0.0);
             for (auto i = ofirst; i < olast; ++i) {
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                 if (indices[i] != padidx) {
                     for (auto j = 0; j < width; ++j) {
                         sum[j] += wts[i]*input[j + (indices[i] * width)];
@@ -471,9 +490,9 @@ avx2_embedding_bag_t<f32>::avx2_sum_wt(const emb_params_t &params) const {
 /*
  * mean without weights
  */
-template<>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx2_embedding_bag_t<f32>::avx2_mean(const emb_params_t &params) const {
+avx2_embedding_bag_t<data_type, idx_type>::avx2_mean(const emb_params_t &params) const {
 
     float        const *input    = static_cast<float *>(params.input);
     indices_type       *indices  = static_cast<indices_type *>(params.indices);
@@ -482,6 +501,7 @@ avx2_embedding_bag_t<f32>::avx2_mean(const emb_params_t &params) const {
 
     const int64_t      &width    = static_cast<int64_t>(params.width);
     const int32_t      &indsz    = params.indices_size;
+    const int32_t      &pfd      = params.prefetch_dist;
     int32_t            offsz     = params.offset_size;
     const int32_t      &dstsz    = params.dst_size;
     const indices_type &padidx   = params.padidx;
@@ -513,6 +533,7 @@ avx2_embedding_bag_t<f32>::avx2_mean(const emb_params_t &params) const {
                 zenmm_ext_ps128 sum;
                 int32_t         count = 0;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         count++;
                         sum.fetch_add_ps(input + (indices[i] * width));
@@ -535,6 +556,7 @@ avx2_embedding_bag_t<f32>::avx2_mean(const emb_params_t &params) const {
 
                 zenmm_ext_ps128 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 float dn = (ofirst!=indsz) ? (1.0/float(olast - ofirst)) : 1.0;
@@ -561,6 +583,7 @@ avx2_embedding_bag_t<f32>::avx2_mean(const emb_params_t &params) const {
                 zenmm_ext_ps64  sum;
                 int32_t         count = 0;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         count++;
                         sum.fetch_add_ps(input + (indices[i] * width));
@@ -583,6 +606,7 @@ avx2_embedding_bag_t<f32>::avx2_mean(const emb_params_t &params) const {
 
                 zenmm_ext_ps64 sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 float dn = (ofirst!=indsz) ? (1.0/float(olast - ofirst)) : 1.0;
@@ -609,6 +633,7 @@ avx2_embedding_bag_t<f32>::avx2_mean(const emb_params_t &params) const {
             std::vector<dst_type> sum(width,0.0);
             int32_t               count = 0;
             for (auto i = ofirst; i < olast; ++i) {
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                 if (indices[i] != padidx) {
                     count++;
                     for (auto j = 0; j < width; ++j) {
@@ -653,9 +678,9 @@ avx2_embedding_bag_t<f32>::avx2_mean(const emb_params_t &params) const {
 /*
  * max without weights
  */
-template<>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx2_embedding_bag_t<f32>::avx2_max(const emb_params_t &params) const {
+avx2_embedding_bag_t<data_type, idx_type>::avx2_max(const emb_params_t &params) const {
 
     float        const *input    = static_cast<float *>(params.input);
     indices_type       *indices  = static_cast<indices_type *>(params.indices);
@@ -664,6 +689,7 @@ avx2_embedding_bag_t<f32>::avx2_max(const emb_params_t &params) const {
 
     const int64_t      &width    = static_cast<int64_t>(params.width);
     const int32_t      &indsz    = params.indices_size;
+    const int32_t      &pfd      = params.prefetch_dist;
     int32_t            offsz     = params.offset_size;
     const int32_t      &dstsz    = params.dst_size;
     const indices_type &padidx   = params.padidx;
@@ -703,6 +729,7 @@ avx2_embedding_bag_t<f32>::avx2_max(const emb_params_t &params) const {
                 }
 
                 for (auto i = nfirst +1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_max_ps(input + (indices[i] * width));
                     }
@@ -727,6 +754,7 @@ avx2_embedding_bag_t<f32>::avx2_max(const emb_params_t &params) const {
                     sum.load_ps(input + (indices[ofirst] * width));
                 }
                 for (auto i = ofirst+1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_max_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -760,6 +788,7 @@ avx2_embedding_bag_t<f32>::avx2_max(const emb_params_t &params) const {
                 }
 
                 for (auto i = nfirst +1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_max_ps(input + (indices[i] * width));
                     }
@@ -784,6 +813,7 @@ avx2_embedding_bag_t<f32>::avx2_max(const emb_params_t &params) const {
                     sum.load_ps(input + (indices[ofirst] * width));
                 }
                 for (auto i = ofirst+1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_max_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -819,6 +849,7 @@ avx2_embedding_bag_t<f32>::avx2_max(const emb_params_t &params) const {
             }
 
             for (auto i = nfirst+1; i < olast; ++i) {
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                 if (indices[i] != padidx) {
                     for (auto j = 0; j < width; ++j) {
                         if (sum[j]  < input[j + (indices[i] * width)]) {
@@ -867,7 +898,232 @@ avx2_embedding_bag_t<f32>::avx2_max(const emb_params_t &params) const {
 }
 
 
-template struct avx2_embedding_bag_t<f32>;
+/*
+ * row-wise quantized (u8) tables, codes are dequantized in registers
+ */
+template<uint32_t BITS, uint32_t DIM, typename idx_t>
+static status_t avx2_qbag_kernel(const emb_params_t &params, alg_kind_t alg) {
+    uint8_t      const *input    = static_cast<uint8_t *>(params.input);
+    idx_t              *indices  = static_cast<idx_t *>(params.indices);
+    idx_t              *offsets  = static_cast<idx_t *>(params.offsets);
+    float              *dst      = static_cast<float *>(params.dst);
+    float        const *weights  = alg == alg_kind::embedding_bag_sum ?
+                                   static_cast<float *>(params.weights) : nullptr;
+
+    const int64_t      width       = params.width;
+    const int64_t      row_bytes   = params.row_bytes;
+    const int64_t      code_bytes  = embedding_bag_quant_code_bytes(BITS, width);
+    const int32_t      &indsz      = params.indices_size;
+    const int32_t      &pfd        = params.prefetch_dist;
+    int32_t            offsz       = params.offset_size;
+    const int32_t      &padidx     = params.padidx;
+    const uint32_t     &nthr       = params.nthr;
+    const bool         &include_last_offset = params.include_last_offset;
+
+    // add scatter_offset
+    uint32_t stride  = params.scatter_stride*width;
+    dst             += params.scatter_offset*width;
+    if (include_last_offset==1) {
+        offsz -= 1;
+    }
+
+    #pragma omp parallel for num_threads(nthr) //proc_bind(master)
+    for (auto oi = 0; oi < offsz; ++oi) {
+        auto ofirst = offsets[oi];
+        auto olast  = 0;
+        if (include_last_offset==0) {
+            olast  = oi < (offsz -1) ? offsets[oi+1] : indsz;
+        }
+        else {
+            olast  = offsets[oi+1];
+        }
+        zenmm_ext_pq<BITS, DIM> sum;
+        int32_t count = 0;
+        for (auto i = ofirst; i < olast; ++i) {
+            emb_prefetch_row(input, indices, i, indsz, row_bytes, pfd);
+            if (indices[i] == padidx) {
+                continue;
+            }
+            uint8_t const *row = input + indices[i] * row_bytes;
+            float scale, bias;
+            emb_quant_scale_bias(row, code_bytes, scale, bias);
+            if (alg == alg_kind::embedding_bag_max) {
+                if (count) {
+                    sum.fetch_max_ps(row, scale, bias);
+                }
+                else {
+                    sum.load_ps(row, scale, bias);
+                }
+            }
+            else if (weights) {
+                sum.fetch_fmadd_ps(row, scale, bias, weights[i]);
+            }
+            else {
+                sum.fetch_add_ps(row, scale, bias);
+            }
+            count++;
+        }
+        if (alg == alg_kind::embedding_bag_mean && count) {
+            sum.scale_store_ps(dst + oi*stride, 1.0f/count);
+        }
+        else {
+            sum.store_ps(dst + oi*stride);
+        }
+    }
+    return status::success;
+}
+
+template<uint32_t BITS, typename idx_t>
+status_t emb_qbag_ref(const emb_params_t &params, alg_kind_t alg) {
+    uint8_t      const *input    = static_cast<uint8_t *>(params.input);
+    idx_t              *indices  = static_cast<idx_t *>(params.indices);
+    idx_t              *offsets  = static_cast<idx_t *>(params.offsets);
+    float              *dst      = static_cast<float *>(params.dst);
+    float        const *weights  = alg == alg_kind::embedding_bag_sum ?
+                                   static_cast<float *>(params.weights) : nullptr;
+
+    const int64_t      width       = params.width;
+    const int64_t      row_bytes   = params.row_bytes;
+    const int64_t      code_bytes  = embedding_bag_quant_code_bytes(BITS, width);
+    const int32_t      &indsz      = params.indices_size;
+    const int32_t      &pfd        = params.prefetch_dist;
+    int32_t            offsz       = params.offset_size;
+    const int32_t      &padidx     = params.padidx;
+    const uint32_t     &nthr       = params.nthr;
+    const bool         &include_last_offset = params.include_last_offset;
+
+    // add scatter_offset
+    uint32_t stride  = params.scatter_stride*width;
+    dst             += params.scatter_offset*width;
+    if (include_last_offset==1) {
+        offsz -= 1;
+    }
+
+    #pragma omp parallel for num_threads(nthr) //proc_bind(master)
+    for (auto oi = 0; oi < offsz; ++oi) {
+        auto ofirst = offsets[oi];
+        auto olast  = 0;
+        if (include_last_offset==0) {
+            olast  = oi < (offsz -1) ? offsets[oi+1] : indsz;
+        }
+        else {
+            olast  = offsets[oi+1];
+        }
+        float  *out   = dst + oi*stride;
+        int32_t count = 0;
+        std::fill(out, out + width, 0.0f);
+        for (auto i = ofirst; i < olast; ++i) {
+            emb_prefetch_row(input, indices, i, indsz, row_bytes, pfd);
+            if (indices[i] == padidx) {
+                continue;
+            }
+            uint8_t const *row = input + indices[i] * row_bytes;
+            float scale, bias;
+            emb_quant_scale_bias(row, code_bytes, scale, bias);
+            float wt = weights ? weights[i] : 1.0f;
+            for (auto j = 0; j < width; ++j) {
+                uint32_t code = BITS == 8 ? row[j] : (row[j/2] >> ((j & 1) * 4)) & 0x0f;
+                float    val  = code * scale + bias;
+                if (alg == alg_kind::embedding_bag_max) {
+                    out[j] = count ? std::max(out[j], val) : val;
+                }
+                else {
+                    out[j] += wt * val;
+                }
+            }
+            count++;
+        }
+        if (alg == alg_kind::embedding_bag_mean && count) {
+            for (auto j = 0; j < width; ++j) {
+                out[j] /= count;
+            }
+        }
+    }
+    return status::success;
+}
+template status_t emb_qbag_ref<8, int32_t>(const emb_params_t &params,
+        alg_kind_t alg);
+template status_t emb_qbag_ref<4, int32_t>(const emb_params_t &params,
+        alg_kind_t alg);
+template status_t emb_qbag_ref<8, int64_t>(const emb_params_t &params,
+        alg_kind_t alg);
+template status_t emb_qbag_ref<4, int64_t>(const emb_params_t &params,
+        alg_kind_t alg);
+
+// fast path for widths 128, 64, 32 and 16
+template<uint32_t BITS, typename idx_t>
+static status_t avx2_qbag(const emb_params_t &params, alg_kind_t alg) {
+    switch (params.width) {
+    case 128:
+        return avx2_qbag_kernel<BITS, 16, idx_t>(params, alg);
+    case 64:
+        return avx2_qbag_kernel<BITS, 8, idx_t>(params, alg);
+    case 32:
+        return avx2_qbag_kernel<BITS, 4, idx_t>(params, alg);
+    case 16:
+        return avx2_qbag_kernel<BITS, 2, idx_t>(params, alg);
+    }
+    return emb_qbag_ref<BITS, idx_t>(params, alg);
+}
+
+template<typename idx_t>
+static status_t avx2_qbag(const emb_params_t &params, alg_kind_t alg) {
+    return params.qbits == 8 ? avx2_qbag<8, idx_t>(params, alg)
+           : avx2_qbag<4, idx_t>(params, alg);
+}
+
+template<>
+status_t
+avx2_embedding_bag_t<u8, s32>::avx2_sum(const emb_params_t &params) const {
+    return avx2_qbag<offsets_type>(params, alg_kind::embedding_bag_sum);
+}
+
+template<>
+status_t
+avx2_embedding_bag_t<u8, s32>::avx2_sum_wt(const emb_params_t &params) const {
+    return avx2_qbag<offsets_type>(params, alg_kind::embedding_bag_sum);
+}
+
+template<>
+status_t
+avx2_embedding_bag_t<u8, s32>::avx2_mean(const emb_params_t &params) const {
+    return avx2_qbag<offsets_type>(params, alg_kind::embedding_bag_mean);
+}
+
+template<>
+status_t
+avx2_embedding_bag_t<u8, s32>::avx2_max(const emb_params_t &params) const {
+    return avx2_qbag<offsets_type>(params, alg_kind::embedding_bag_max);
+}
+
+template<>
+status_t
+avx2_embedding_bag_t<u8, s64>::avx2_sum(const emb_params_t &params) const {
+    return avx2_qbag<offsets_type>(params, alg_kind::embedding_bag_sum);
+}
+
+template<>
+status_t
+avx2_embedding_bag_t<u8, s64>::avx2_sum_wt(const emb_params_t &params) const {
+    return avx2_qbag<offsets_type>(params, alg_kind::embedding_bag_sum);
+}
+
+template<>
+status_t
+avx2_embedding_bag_t<u8, s64>::avx2_mean(const emb_params_t &params) const {
+    return avx2_qbag<offsets_type>(params, alg_kind::embedding_bag_mean);
+}
+
+template<>
+status_t
+avx2_embedding_bag_t<u8, s64>::avx2_max(const emb_params_t &params) const {
+    return avx2_qbag<offsets_type>(params, alg_kind::embedding_bag_max);
+}
+
+template struct avx2_embedding_bag_t<f32, s32>;
+template struct avx2_embedding_bag_t<f32, s64>;
+template struct avx2_embedding_bag_t<u8, s32>;
+template struct avx2_embedding_bag_t<u8, s64>;
 
 } //namespace cpu
 }
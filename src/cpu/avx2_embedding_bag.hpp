@@ -19,8 +19,11 @@
 #define CPU_AVX2_EMBEDDING_BAG_HPP
 
 #include <iostream>
+#include <algorithm>
 #include <assert.h>
 #include <cstdint>
+#include <cstring>
+#include <immintrin.h>
 
 #include "common/c_types_map.hpp"
 #include "common/primitive.hpp"
@@ -32,6 +35,14 @@
 
 #include "cpu/cpu_embedding_bag_pd.hpp"
 
+#include "zendnn_helper.hpp"
+#include "zendnn_cpu_topology.hpp"
+
+//Bytes of rows the embedding bag prefetch keeps in flight, and the furthest
+//it looks ahead
+#define EMB_PREFETCH_BYTES      2048
+#define EMB_PREFETCH_MAX_ROWS   16
+
 namespace zendnn {
 namespace impl {
 namespace cpu {
@@ -39,6 +50,9 @@ namespace cpu {
 /* adding for embedding_bag */
 struct emb_params_t {
     int32_t         width;
+    int32_t         row_bytes;  // table row size of quantized tables
+    int32_t         qbits;      // 8 or 4 for quantized tables, else 0
+    int32_t         prefetch_dist; // lookups prefetched ahead, 0 disables
     int32_t         indices_size;
     int32_t         offset_size;
     int32_t         dst_size;
@@ -54,13 +68,15 @@ struct emb_params_t {
     void            *weights;
 };
 
-template <impl::data_type_t data_type>
+// idx_type is the data type of the indices and the offsets, s32 or s64
+template <impl::data_type_t data_type,
+          impl::data_type_t idx_type = impl::data_type::s32>
 struct avx2_embedding_bag_t : public primitive_t {
     struct pd_t : public cpu_embedding_bag_pd_t {
         using cpu_embedding_bag_pd_t::cpu_embedding_bag_pd_t;
         using input_type   = typename prec_traits<data_type>::type;
-        using indices_type = int32_t;
-        using offsets_type = int32_t;
+        using indices_type = typename prec_traits<idx_type>::type;
+        using offsets_type = typename prec_traits<idx_type>::type;
 
         DECLARE_COMMON_PD_T("avx2:any", avx2_embedding_bag_t);
 
@@ -81,8 +97,8 @@ struct avx2_embedding_bag_t : public primitive_t {
     }
 
     using input_type   = typename prec_traits<data_type>::type;
-    using indices_type = int32_t;
-    using offsets_type = int32_t;
+    using indices_type = typename prec_traits<idx_type>::type;
+    using offsets_type = typename prec_traits<idx_type>::type;
     using dst_type     = input_type;
 
     // exec() override from primitive_t
@@ -103,6 +119,49 @@ struct avx2_embedding_bag_t : public primitive_t {
 
 };
 
+//Scale and bias stored after the code_bytes codes of a quantized row
+inline void emb_quant_scale_bias(uint8_t const *row, int64_t code_bytes,
+                                 float &scale, float &bias) {
+    std::memcpy(&scale, row + code_bytes, sizeof(float));
+    std::memcpy(&bias, row + code_bytes + sizeof(float), sizeof(float));
+}
+
+//Lookups prefetched ahead of the one being reduced. Tables that fit in half
+//of an L3 domain are left to the caches, otherwise about EMB_PREFETCH_BYTES
+//of rows are kept in flight, so narrow rows look further ahead than wide
+//ones. ZENDNN_EB_PREFETCH_DISTANCE overrides it.
+inline int32_t embedding_bag_prefetch_distance(int64_t table_bytes,
+        int64_t row_bytes) {
+    int env_dist = readEnv().zenEBPrefetchDistance;
+    if (env_dist >= 0) {
+        return env_dist;
+    }
+    if (row_bytes <= 0 || table_bytes <= (int64_t)
+            zendnnCpuTopology::Instance().l3_bytes / 2) {
+        return 0;
+    }
+    return std::max<int64_t>(1, std::min<int64_t>(EMB_PREFETCH_MAX_ROWS,
+                             EMB_PREFETCH_BYTES / row_bytes));
+}
+
+//Prefetches all cache lines of the row of lookup i + dist
+template<typename idx_t>
+inline void emb_prefetch_row(const void *input, const idx_t *indices,
+                             int64_t i, int64_t indsz, int64_t row_bytes, int32_t dist) {
+    if (dist && i + dist < indsz) {
+        const char *row = static_cast<const char *>(input) +
+                          indices[i + dist] * row_bytes;
+        for (int64_t b = 0; b < row_bytes; b += 64) {
+            _mm_prefetch(row + b, _MM_HINT_T0);
+        }
+    }
+}
+
+//Row-wise quantized (u8) tables, scalar path for widths without a vector
+//kernel. alg is sum, mean or max, weights only apply to sum.
+template<uint32_t BITS, typename idx_t>
+status_t emb_qbag_ref(const emb_params_t &params, alg_kind_t alg);
+
 } // namespace cpu
 } // namespace impl
 } // namespace zendnn
@@ -28,35 +28,13 @@
 #include "cpu/avx512_embedding_bag_utils.hpp"
 #include "cpu/avx512_embedding_bag.hpp"
 
-#define PREFETCH_EN         0
-#define PREFETCH_DISTANCE   0
-
 namespace zendnn {
 namespace impl {
 namespace cpu {
 using namespace data_type;
-template<>
-inline void avx512_embedding_bag_t<f32>::ebvec_prefetch(float const *input,
-        indices_type *indices,
-        const int64_t width, offsets_type *offsets, const int32_t index,
-        const int32_t offsz, const int32_t indsz) const {
-
-    auto prefetch_distance = PREFETCH_DISTANCE;
-    //if((index+PREFETCH_DISTANCE)>=offsz)
-    //  prefetch_distance = 0;
-
-    auto ofirst = offsets[index+prefetch_distance];
-    auto olast  = index < (offsz -1) ? offsets[index+prefetch_distance+1] : indsz;
-
-    for (auto i = ofirst; i < olast; ++i) {
-        float const *prefetch_addr = input + (indices[i] * width);
-        _mm_prefetch(prefetch_addr, _MM_HINT_T0);
-    }
-}
-
-template<data_type_t data_type>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx512_embedding_bag_t<data_type>::execute(const exec_ctx_t &ctx) const {
+avx512_embedding_bag_t<data_type, idx_type>::execute(const exec_ctx_t &ctx) const {
 #if ZENDNN_CPU_THREADING_RUNTIME != ZENDNN_RUNTIME_OMP
     assert(!"threading env need to be omp for embedding_bag");
 #endif
@@ -67,6 +45,9 @@ avx512_embedding_bag_t<data_type>::execute(const exec_ctx_t &ctx) const {
     if (status != status::success) {
         return status;
     }
+    if (kernel_) {
+        return avx512_jit(params);
+    }
     auto  algo                = pd()->desc()->alg_kind;
     bool  is_weights          = pd()->desc()->is_weights;
     switch (algo) {
@@ -79,12 +60,38 @@ avx512_embedding_bag_t<data_type>::execute(const exec_ctx_t &ctx) const {
     }
     return status::unimplemented;
 }
+/*
+ * generate a kernel for the exact width when there is no hand unrolled
+ * fast path for it
+ */
+template<data_type_t data_type, data_type_t idx_type>
+status_t
+avx512_embedding_bag_t<data_type, idx_type>::init(engine_t *engine) {
+    const int64_t width = pd()->dst_md()->dims[1];
+    if (!x64::jit_avx512_embedding_bag_kernel_t::is_applicable(data_type) ||
+            utils::one_of(width, 512, 256, 128, 64, 32, 16)) {
+        return status::success;
+    }
+    x64::jit_emb_bag_conf_t conf;
+    conf.width         = width;
+    conf.src_dt        = data_type;
+    conf.idx_dt        = idx_type;
+    conf.alg           = pd()->desc()->alg_kind;
+    conf.is_weights    = pd()->desc()->is_weights;
+    conf.padidx        = pd()->desc()->padding_idx;
+    conf.prefetch_dist = embedding_bag_prefetch_distance(
+                             memory_desc_wrapper(pd()->src_md(ZENDNN_ARG_SRC_0)).size(),
+                             width * sizeof(input_type));
+    CHECK(safe_ptr_assign(kernel_,
+                          new x64::jit_avx512_embedding_bag_kernel_t(conf)));
+    return kernel_->create_kernel();
+}
 /*
  * extract embedding bag parameters
  */
-template<data_type_t data_type>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx512_embedding_bag_t<data_type>::pre_process(const exec_ctx_t &ctx,
+avx512_embedding_bag_t<data_type, idx_type>::pre_process(const exec_ctx_t &ctx,
         emb_params_t &params) const {
     status_t status = status::success;
     // get algorithm params
@@ -112,7 +119,13 @@ avx512_embedding_bag_t<data_type>::pre_process(const exec_ctx_t &ctx,
     memory_desc_wrapper offsets_mdw(pd()->src_md(ZENDNN_ARG_SRC_2));
     memory_desc_wrapper dst_mdw(pd()->dst_md(ZENDNN_ARG_DST));
     const auto &input_dims   = input_mdw.dims();
-    params.width             = input_dims[1];
+    params.width             = dst_mdw.dims()[1];
+    params.row_bytes         = input_dims[1];
+    params.qbits             = data_type == u8 ? embedding_bag_quant_bits(
+                                   input_dims[1], params.width) : 0;
+    params.prefetch_dist     = embedding_bag_prefetch_distance(
+                                   input_mdw.size(), params.qbits ? params.row_bytes :
+                                   params.width * sizeof(input_type));
     params.offset_size       = offsets_mdw.nelems();
     params.indices_size      = indices_mdw.nelems();
     params.include_last_offset=0;
@@ -128,18 +141,67 @@ avx512_embedding_bag_t<data_type>::pre_process(const exec_ctx_t &ctx,
 
     return status;
 }
+/*
+ * all reductions with the generated kernel, one call per bag
+ */
+template<data_type_t data_type, data_type_t idx_type>
+status_t
+avx512_embedding_bag_t<data_type, idx_type>::avx512_jit(const emb_params_t &params) const {
+    input_type   const *input    = static_cast<input_type *>(params.input);
+    float        const *wts      = static_cast<float *>(params.weights);
+    indices_type       *indices  = static_cast<indices_type *>(params.indices);
+    offsets_type       *offsets  = static_cast<offsets_type *>(params.offsets);
+    dst_type           *dst      = static_cast<dst_type *>(params.dst);
+
+    const int64_t      &width    = static_cast<int64_t>(params.width);
+    const int32_t      &indsz    = params.indices_size;
+    int32_t            offsz     = params.offset_size;
+    const uint32_t     &nthr     = params.nthr;
+    const uint32_t     &scatter_offset = params.scatter_offset;
+    const uint32_t     &scatter_stride = params.scatter_stride;
+    const bool         &include_last_offset = params.include_last_offset;
+
+    // add scatter_offset
+    uint32_t stride  = scatter_stride*width;
+    dst             += scatter_offset*width;
+    if (include_last_offset==1) {
+        offsz -= 1;
+    }
+
+    #pragma omp parallel for num_threads(nthr) //proc_bind(master)
+    for (auto oi = 0; oi < offsz; ++oi) {
+        auto ofirst = offsets[oi];
+        auto olast  = 0;
+        if (include_last_offset==0) {
+            olast  = oi < (offsz -1) ? offsets[oi+1] : indsz;
+        }
+        else {
+            olast  = offsets[oi+1];
+        }
+        x64::jit_emb_bag_call_s args;
+        args.input          = input;
+        args.indices        = indices + ofirst;
+        args.weights        = wts ? wts + ofirst : nullptr;
+        args.dst            = dst + oi*stride;
+        args.count          = olast - ofirst;
+        args.prefetch_count = indsz - ofirst;
+        (*kernel_)(&args);
+    }
+    return status::success;
+}
 /*
  * sum without weights
  */
-template<data_type_t data_type>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const {
+avx512_embedding_bag_t<data_type, idx_type>::avx512_sum(const emb_params_t &params) const {
     input_type   const *input    = static_cast<input_type *>(params.input);
     indices_type       *indices  = static_cast<indices_type *>(params.indices);
     offsets_type       *offsets  = static_cast<offsets_type *>(params.offsets);
     dst_type           *dst      = static_cast<dst_type *>(params.dst);
     const int64_t      &width               = static_cast<int64_t>(params.width);
     const int32_t      &indsz               = params.indices_size;
+    const int32_t      &pfd                 = params.prefetch_dist;
     int32_t            offsz                = params.offset_size;
     const int32_t      &dstsz               = params.dst_size;
     const indices_type &padidx              = params.padidx;
@@ -169,11 +231,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 32> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_add_ps(input + (indices[i] * width));
                     }
@@ -192,11 +252,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 32> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -216,11 +274,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 16> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_add_ps(input + (indices[i] * width));
                     }
@@ -239,11 +295,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 16> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -263,11 +317,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 8> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_add_ps(input + (indices[i] * width));
                     }
@@ -286,11 +338,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 8> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -310,11 +360,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 4> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_add_ps(input + (indices[i] * width));
                     }
@@ -333,11 +381,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 4> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -357,11 +403,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 2> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_add_ps(input + (indices[i] * width));
                     }
@@ -380,11 +424,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 2> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -404,11 +446,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 1> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_add_ps(input + (indices[i] * width));
                     }
@@ -427,11 +467,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 1> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -451,13 +489,11 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
             else {
                 olast  = offsets[oi+1];
             }
-#if PREFETCH_EN
-            ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
             std::vector<dst_type> sum(width,0.0);
             for (auto i = ofirst; i < olast; ++i) {
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                 if (indices[i] != padidx) {
-                    uint32_t input_offset = indices[i]*width;
+                    int64_t input_offset = indices[i]*width;
                     emb_sum<input_type>(sum.data(), input, width, input_offset, 1.0);
                 }
             }
@@ -477,12 +513,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
             else {
                 olast  = offsets[oi+1];
             }
-#if PREFETCH_EN
-            ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
             std::vector<dst_type> sum(width,0.0);
             for (auto i = ofirst; i < olast; ++i){
-                uint32_t input_offset = indices[i]*width;
+                int64_t input_offset = indices[i]*width;
                 emb_sum<input_type>(sum.data(), input, width, input_offset, 1.0);
             }
 
@@ -496,9 +529,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum(const emb_params_t &params) const
 /*
  * sum with weights
  */
-template<data_type_t data_type>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) const {
+avx512_embedding_bag_t<data_type, idx_type>::avx512_sum_wt(const emb_params_t &params) const {
     input_type   const *input    = static_cast<input_type *>(params.input);
     float        const *wts      = static_cast<float *>(params.weights);
     indices_type       *indices  = static_cast<indices_type *>(params.indices);
@@ -507,6 +540,7 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
 
     const int64_t      &width    = static_cast<int64_t>(params.width);
     const int32_t      &indsz    = params.indices_size;
+    const int32_t      &pfd      = params.prefetch_dist;
     int32_t            offsz    = params.offset_size;
     const int32_t      &dstsz    = params.dst_size;
     const indices_type &padidx   = params.padidx;
@@ -535,11 +569,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 32> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                     }
@@ -558,11 +590,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 32> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                 }
                 sum.store_ps(dst + oi*stride);
@@ -582,11 +612,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 16> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                     }
@@ -605,11 +633,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 16> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                 }
                 sum.store_ps(dst + oi*stride);
@@ -629,11 +655,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 8> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                     }
@@ -652,11 +676,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 8> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                 }
                 sum.store_ps(dst + oi*stride);
@@ -676,11 +698,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 4> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                     }
@@ -699,11 +719,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 4> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                 }
                 sum.store_ps(dst + oi*stride);
@@ -723,11 +741,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 2> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                     }
@@ -746,11 +762,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 2> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                 }
                 sum.store_ps(dst + oi*stride);
@@ -770,11 +784,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 1> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                     }
@@ -793,11 +805,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 1> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_fmadd_ps(input + (indices[i] * width), wts[i]);
                 }
                 sum.store_ps(dst + oi*stride);
@@ -817,13 +827,11 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
             else {
                 olast  = offsets[oi+1];
             }
-#if PREFETCH_EN
-            ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
             std::vector<dst_type> sum(width,0.0);
             for (auto i = ofirst; i < olast; ++i) {
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                 if (indices[i] != padidx) {
-                    uint32_t input_offset = indices[i]*width;
+                    int64_t input_offset = indices[i]*width;
                     emb_sum<input_type>(sum.data(), input, width, input_offset,wts[i]);
                 }
             }
@@ -843,12 +851,10 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
             else {
                 olast  = offsets[oi+1];
             }
-#if PREFETCH_EN
-            ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
             std::vector<dst_type> sum(width,0.0);
             for (auto i = ofirst; i < olast; ++i) {
-                uint32_t input_offset = indices[i]*width;
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
+                int64_t input_offset = indices[i]*width;
                 emb_sum<input_type>(sum.data(), input, width, input_offset, wts[i]);
             }
 
@@ -862,9 +868,9 @@ avx512_embedding_bag_t<data_type>::avx512_sum_wt(const emb_params_t &params) con
 /*
  * mean without weights
  */
-template<data_type_t data_type>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const {
+avx512_embedding_bag_t<data_type, idx_type>::avx512_mean(const emb_params_t &params) const {
     input_type   const *input    = static_cast<input_type *>(params.input);
     indices_type       *indices  = static_cast<indices_type *>(params.indices);
     offsets_type       *offsets  = static_cast<offsets_type *>(params.offsets);
@@ -872,6 +878,7 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
 
     const int64_t      &width    = static_cast<int64_t>(params.width);
     const int32_t      &indsz    = params.indices_size;
+    const int32_t      &pfd      = params.prefetch_dist;
     int32_t            offsz    = params.offset_size;
     const int32_t      &dstsz    = params.dst_size;
     const indices_type &padidx   = params.padidx;
@@ -901,12 +908,10 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 32> sum;
                 int32_t         count = 0;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         count++;
                         sum.fetch_add_ps(input + (indices[i] * width));
@@ -926,11 +931,9 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 32> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 float dn = (ofirst!=indsz) ? (1.0/float(olast - ofirst)) : 1.0;
@@ -951,12 +954,10 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 16> sum;
                 int32_t         count = 0;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         count++;
                         sum.fetch_add_ps(input + (indices[i] * width));
@@ -976,11 +977,9 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 16> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 float dn = (ofirst!=indsz) ? (1.0/float(olast - ofirst)) : 1.0;
@@ -1001,12 +1000,10 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 8> sum;
                 int32_t         count = 0;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         count++;
                         sum.fetch_add_ps(input + (indices[i] * width));
@@ -1026,11 +1023,9 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 8> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 float dn = (ofirst!=indsz) ? (1.0/float(olast - ofirst)) : 1.0;
@@ -1051,12 +1046,10 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 4> sum;
                 int32_t         count = 0;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         count++;
                         sum.fetch_add_ps(input + (indices[i] * width));
@@ -1076,11 +1069,9 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 4> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 float dn = (ofirst!=indsz) ? (1.0/float(olast - ofirst)) : 1.0;
@@ -1101,12 +1092,10 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 2> sum;
                 int32_t         count = 0;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         count++;
                         sum.fetch_add_ps(input + (indices[i] * width));
@@ -1126,11 +1115,9 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 2> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 float dn = (ofirst!=indsz) ? (1.0/float(olast - ofirst)) : 1.0;
@@ -1151,12 +1138,10 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 1>  sum;
                 int32_t         count = 0;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         count++;
                         sum.fetch_add_ps(input + (indices[i] * width));
@@ -1176,11 +1161,9 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 1> sum;
                 for (auto i = ofirst; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_add_ps(input + (indices[i] * width));
                 }
                 float dn = (ofirst!=indsz) ? (1.0/float(olast - ofirst)) : 1.0;
@@ -1201,15 +1184,13 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
             else {
                 olast  = offsets[oi+1];
             }
-#if PREFETCH_EN
-            ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
             std::vector<dst_type> sum(width,0.0);
             int32_t               count = 0;
             for (auto i = ofirst; i < olast; ++i) {
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                 if (indices[i] != padidx) {
                     count++;
-                    uint32_t input_offset = indices[i]*width;
+                    int64_t input_offset = indices[i]*width;
                     emb_sum<input_type>(sum.data(), input, width, input_offset, 1.0);
                 }
             }
@@ -1230,12 +1211,10 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
             else {
                 olast  = offsets[oi+1];
             }
-#if PREFETCH_EN
-            ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
             std::vector<dst_type> sum(width,0.0);
             for (auto i = ofirst; i < olast; ++i) {
-                uint32_t input_offset = indices[i]*width;
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
+                int64_t input_offset = indices[i]*width;
                 emb_sum<input_type>(sum.data(), input, width, input_offset, 1.0);
             }
 
@@ -1250,9 +1229,9 @@ avx512_embedding_bag_t<data_type>::avx512_mean(const emb_params_t &params) const
 /*
  * max without weights
  */
-template<data_type_t data_type>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const {
+avx512_embedding_bag_t<data_type, idx_type>::avx512_max(const emb_params_t &params) const {
     input_type   const *input    = static_cast<input_type *>(params.input);
     indices_type       *indices  = static_cast<indices_type *>(params.indices);
     offsets_type       *offsets  = static_cast<offsets_type *>(params.offsets);
@@ -1260,6 +1239,7 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
 
     const int64_t      &width    = static_cast<int64_t>(params.width);
     const int32_t      &indsz    = params.indices_size;
+    const int32_t      &pfd      = params.prefetch_dist;
     int32_t            offsz     = params.offset_size;
     const int32_t      &dstsz    = params.dst_size;
     const indices_type &padidx   = params.padidx;
@@ -1288,9 +1268,6 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 32> sum;
                 int32_t         nfirst = ofirst;
                 while (nfirst < olast) {
@@ -1301,6 +1278,7 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                     nfirst++;
                 }
                 for (auto i = nfirst +1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_max_ps(input + (indices[i] * width));
                     }
@@ -1319,14 +1297,12 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 32> sum;
                 if (ofirst!=indsz) {
                     sum.load_ps(input + (indices[ofirst] * width));
                 }
                 for (auto i = ofirst+1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_max_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -1346,9 +1322,6 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 16> sum;
                 int32_t         nfirst = ofirst;
                 while (nfirst < olast) {
@@ -1359,6 +1332,7 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                     nfirst++;
                 }
                 for (auto i = nfirst +1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_max_ps(input + (indices[i] * width));
                     }
@@ -1377,14 +1351,12 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 16> sum;
                 if (ofirst!=indsz) {
                     sum.load_ps(input + (indices[ofirst] * width));
                 }
                 for (auto i = ofirst+1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_max_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -1404,9 +1376,6 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 8> sum;
                 int32_t         nfirst = ofirst;
                 while (nfirst < olast) {
@@ -1417,6 +1386,7 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                     nfirst++;
                 }
                 for (auto i = nfirst +1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_max_ps(input + (indices[i] * width));
                     }
@@ -1435,14 +1405,12 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 8> sum;
                 if (ofirst!=indsz) {
                     sum.load_ps(input + (indices[ofirst] * width));
                 }
                 for (auto i = ofirst+1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_max_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -1462,9 +1430,6 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 4> sum;
                 int32_t         nfirst = ofirst;
                 while (nfirst < olast) {
@@ -1475,6 +1440,7 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                     nfirst++;
                 }
                 for (auto i = nfirst +1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_max_ps(input + (indices[nfirst] * width));
                     }
@@ -1493,14 +1459,12 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 4> sum;
                 if (ofirst!=indsz) {
                     sum.load_ps(input + (indices[ofirst] * width));
                 }
                 for (auto i = ofirst+1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_max_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -1520,9 +1484,6 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 2> sum;
                 int32_t         nfirst = ofirst;
                 while (nfirst < olast) {
@@ -1533,6 +1494,7 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                     nfirst++;
                 }
                 for (auto i = nfirst +1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_max_ps(input + (indices[i] * width));
                     }
@@ -1551,14 +1513,12 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 2> sum;
                 if (ofirst!=indsz) {
                     sum.load_ps(input + (indices[ofirst] * width));
                 }
                 for (auto i = ofirst+1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_max_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -1578,9 +1538,6 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 1> sum;
                 int32_t        nfirst = ofirst;
                 while (nfirst < olast) {
@@ -1591,6 +1548,7 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                     nfirst++;
                 }
                 for (auto i = nfirst +1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     if (indices[i] != padidx) {
                         sum.fetch_max_ps(input + (indices[i] * width));
                     }
@@ -1609,14 +1567,12 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 else {
                     olast  = offsets[oi+1];
                 }
-#if PREFETCH_EN
-                ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
                 zenmmAVX512_ext_ps<input_type, 1> sum;
                 if (ofirst!=indsz) {
                     sum.load_ps(input + (indices[ofirst] * width));
                 }
                 for (auto i = ofirst+1; i < olast; ++i) {
+                    emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                     sum.fetch_max_ps(input + (indices[i] * width));
                 }
                 sum.store_ps(dst + oi*stride);
@@ -1636,9 +1592,6 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
             else {
                 olast  = offsets[oi+1];
             }
-#if PREFETCH_EN
-            ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
             std::vector<dst_type> sum(width,0.0);
             int32_t               nfirst = ofirst;
             while (nfirst < olast) {
@@ -1651,6 +1604,7 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
                 nfirst++;
             }
             for (auto i = nfirst+1; i < olast; ++i) {
+                emb_prefetch_row(input, indices, i, indsz, width * sizeof(input_type), pfd);
                 if (indices[i] != padidx) {
                     for (auto j = 0; j < width; ++j) {
                         if (sum[j]  < input[j + (indices[i] * width)]) {
@@ -1675,9 +1629,6 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
             else {
                 olast  = offsets[oi+1];
             }
-#if PREFETCH_EN
-            ebvec_prefetch(input, indices, width, offsets, oi, offsz, indsz);
-#endif
             std::vector<dst_type> sum(width,0.0);
             for (auto j = 0; j < width; ++j) {
                 if (ofirst!=indsz) {
@@ -1697,8 +1648,163 @@ avx512_embedding_bag_t<data_type>::avx512_max(const emb_params_t &params) const
     }
     return status::success;
 }
-template struct avx512_embedding_bag_t<f32>;
-template struct avx512_embedding_bag_t<s16>;
+
+/*
+ * row-wise quantized (u8) tables, codes are dequantized in registers
+ */
+template<uint32_t BITS, uint32_t DIM, typename idx_t>
+static status_t avx512_qbag_kernel(const emb_params_t &params,
+                                   alg_kind_t alg) {
+    uint8_t      const *input    = static_cast<uint8_t *>(params.input);
+    idx_t              *indices  = static_cast<idx_t *>(params.indices);
+    idx_t              *offsets  = static_cast<idx_t *>(params.offsets);
+    float              *dst      = static_cast<float *>(params.dst);
+    float        const *weights  = alg == alg_kind::embedding_bag_sum ?
+                                   static_cast<float *>(params.weights) : nullptr;
+
+    const int64_t      width       = params.width;
+    const int64_t      row_bytes   = params.row_bytes;
+    const int64_t      code_bytes  = embedding_bag_quant_code_bytes(BITS, width);
+    const int32_t      &indsz      = params.indices_size;
+    const int32_t      &pfd        = params.prefetch_dist;
+    int32_t            offsz       = params.offset_size;
+    const int32_t      &padidx     = params.padidx;
+    const uint32_t     &nthr       = params.nthr;
+    const bool         &include_last_offset = params.include_last_offset;
+
+    // add scatter_offset
+    uint32_t stride  = params.scatter_stride*width;
+    dst             += params.scatter_offset*width;
+    if (include_last_offset==1) {
+        offsz -= 1;
+    }
+
+    #pragma omp parallel for num_threads(nthr) //proc_bind(master)
+    for (auto oi = 0; oi < offsz; ++oi) {
+        auto ofirst = offsets[oi];
+        auto olast  = 0;
+        if (include_last_offset==0) {
+            olast  = oi < (offsz -1) ? offsets[oi+1] : indsz;
+        }
+        else {
+            olast  = offsets[oi+1];
+        }
+        zenmmAVX512_ext_pq<BITS, DIM> sum;
+        int32_t count = 0;
+        for (auto i = ofirst; i < olast; ++i) {
+            emb_prefetch_row(input, indices, i, indsz, row_bytes, pfd);
+            if (indices[i] == padidx) {
+                continue;
+            }
+            uint8_t const *row = input + indices[i] * row_bytes;
+            float scale, bias;
+            emb_quant_scale_bias(row, code_bytes, scale, bias);
+            if (alg == alg_kind::embedding_bag_max) {
+                if (count) {
+                    sum.fetch_max_ps(row, scale, bias);
+                }
+                else {
+                    sum.load_ps(row, scale, bias);
+                }
+            }
+            else if (weights) {
+                sum.fetch_fmadd_ps(row, scale, bias, weights[i]);
+            }
+            else {
+                sum.fetch_add_ps(row, scale, bias);
+            }
+            count++;
+        }
+        if (alg == alg_kind::embedding_bag_mean && count) {
+            sum.scale_store_ps(dst + oi*stride, 1.0f/count);
+        }
+        else {
+            sum.store_ps(dst + oi*stride);
+        }
+    }
+    return status::success;
+}
+
+// fast path for widths 512, 256, 128, 64, 32 and 16
+template<uint32_t BITS, typename idx_t>
+static status_t avx512_qbag(const emb_params_t &params, alg_kind_t alg) {
+    switch (params.width) {
+    case 512:
+        return avx512_qbag_kernel<BITS, 32, idx_t>(params, alg);
+    case 256:
+        return avx512_qbag_kernel<BITS, 16, idx_t>(params, alg);
+    case 128:
+        return avx512_qbag_kernel<BITS, 8, idx_t>(params, alg);
+    case 64:
+        return avx512_qbag_kernel<BITS, 4, idx_t>(params, alg);
+    case 32:
+        return avx512_qbag_kernel<BITS, 2, idx_t>(params, alg);
+    case 16:
+        return avx512_qbag_kernel<BITS, 1, idx_t>(params, alg);
+    }
+    return emb_qbag_ref<BITS, idx_t>(params, alg);
+}
+
+template<typename idx_t>
+static status_t avx512_qbag(const emb_params_t &params, alg_kind_t alg) {
+    return params.qbits == 8 ? avx512_qbag<8, idx_t>(params, alg)
+           : avx512_qbag<4, idx_t>(params, alg);
+}
+
+template<>
+status_t
+avx512_embedding_bag_t<u8, s32>::avx512_sum(const emb_params_t &params) const {
+    return avx512_qbag<offsets_type>(params, alg_kind::embedding_bag_sum);
+}
+
+template<>
+status_t
+avx512_embedding_bag_t<u8, s32>::avx512_sum_wt(const emb_params_t &params) const {
+    return avx512_qbag<offsets_type>(params, alg_kind::embedding_bag_sum);
+}
+
+template<>
+status_t
+avx512_embedding_bag_t<u8, s32>::avx512_mean(const emb_params_t &params) const {
+    return avx512_qbag<offsets_type>(params, alg_kind::embedding_bag_mean);
+}
+
+template<>
+status_t
+avx512_embedding_bag_t<u8, s32>::avx512_max(const emb_params_t &params) const {
+    return avx512_qbag<offsets_type>(params, alg_kind::embedding_bag_max);
+}
+
+template<>
+status_t
+avx512_embedding_bag_t<u8, s64>::avx512_sum(const emb_params_t &params) const {
+    return avx512_qbag<offsets_type>(params, alg_kind::embedding_bag_sum);
+}
+
+template<>
+status_t
+avx512_embedding_bag_t<u8, s64>::avx512_sum_wt(const emb_params_t &params) const {
+    return avx512_qbag<offsets_type>(params, alg_kind::embedding_bag_sum);
+}
+
+template<>
+status_t
+avx512_embedding_bag_t<u8, s64>::avx512_mean(const emb_params_t &params) const {
+    return avx512_qbag<offsets_type>(params, alg_kind::embedding_bag_mean);
+}
+
+template<>
+status_t
+avx512_embedding_bag_t<u8, s64>::avx512_max(const emb_params_t &params) const {
+    return avx512_qbag<offsets_type>(params, alg_kind::embedding_bag_max);
+}
+
+template struct avx512_embedding_bag_t<f32, s32>;
+template struct avx512_embedding_bag_t<f32, s64>;
+template struct avx512_embedding_bag_t<s16, s32>;
+template struct avx512_embedding_bag_t<s16, s64>;
+template struct avx512_embedding_bag_t<u8, s32>;
+template struct avx512_embedding_bag_t<u8, s64>;
 } //namespace cpu
 }
 }
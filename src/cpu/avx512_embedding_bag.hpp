@@ -23,6 +23,7 @@
 #include <iostream>
 #include <assert.h>
 #include <cstdint>
+#include <memory>
 
 #include "common/c_types_map.hpp"
 #include "common/primitive.hpp"
@@ -33,6 +34,7 @@
 #include "cpu/platform.hpp"
 #include "cpu/primitive_attr_postops.hpp"
 #include "cpu/x64/cpu_isa_traits.hpp"
+#include "cpu/x64/jit_avx512_embedding_bag_kernel.hpp"
 
 #include "cpu/cpu_embedding_bag_pd.hpp"
 #include "cpu/avx2_embedding_bag.hpp"
@@ -41,13 +43,15 @@ namespace zendnn {
 namespace impl {
 namespace cpu {
 
-template <impl::data_type_t data_type>
+// idx_type is the data type of the indices and the offsets, s32 or s64
+template <impl::data_type_t data_type,
+          impl::data_type_t idx_type = impl::data_type::s32>
 struct avx512_embedding_bag_t : public primitive_t {
     struct pd_t : public cpu_embedding_bag_pd_t {
         using cpu_embedding_bag_pd_t::cpu_embedding_bag_pd_t;
         using input_type   = typename prec_traits<data_type>::type;
-        using indices_type = int32_t;
-        using offsets_type = int32_t;
+        using indices_type = typename prec_traits<idx_type>::type;
+        using offsets_type = typename prec_traits<idx_type>::type;
 
         impl::data_type_t src_type = src_md(0)->data_type;
         impl::data_type_t dst_type = dst_md()->data_type;
@@ -71,13 +75,11 @@ struct avx512_embedding_bag_t : public primitive_t {
     avx512_embedding_bag_t(const pd_t *apd) : primitive_t(apd) {}
 
     // init() override from primitive_t
-    status_t init(engine_t *engine) override {
-        return status::success;
-    }
+    status_t init(engine_t *engine) override;
 
     using input_type   = typename prec_traits<data_type>::type;
-    using indices_type = int32_t;
-    using offsets_type = int32_t;
+    using indices_type = typename prec_traits<idx_type>::type;
+    using offsets_type = typename prec_traits<idx_type>::type;
     using dst_type     = float; //input_type;
 
     // exec() override from primitive_t
@@ -95,10 +97,10 @@ struct avx512_embedding_bag_t : public primitive_t {
 
     status_t avx512_mean(const emb_params_t &params) const;
     status_t avx512_max(const emb_params_t &params) const;
-    void ebvec_prefetch(float const *input, indices_type *indices,
-                        const int64_t width, offsets_type *offsets, const int32_t index,
-                        const int32_t offsz, const int32_t indsz) const;
+    status_t avx512_jit(const emb_params_t &params) const;
 
+    // generated for widths without a hand unrolled path
+    std::unique_ptr<x64::jit_avx512_embedding_bag_kernel_t> kernel_;
 
 };
 
@@ -172,19 +172,104 @@ struct zenmmAVX512_ext_ps<int16_t, DIM> {
     const uint32_t     unroll_factor = DIM;
 };
 
+//row-wise quantized embedding bag, rows of DIM*16 codes of BITS (8 or 4,
+//low nibble first) dequantized in registers as code * scale + bias
+template<uint32_t BITS, uint32_t DIM>
+struct zenmmAVX512_ext_pq {
+    static_assert(BITS == 8 || BITS == 4, "zenmmAVX512_ext_pq: BITS needs to be 8 or 4");
+
+    zenmmAVX512_ext_pq() {
+        setzero_ps();
+    }
+
+    inline void setzero_ps() {
+        for (uint32_t i = 0; i< unroll_factor; ++i) {
+            v[i] = _mm512_setzero_ps();
+        }
+    };
+
+    inline void load_ps(uint8_t const *row, const float scale, const float bias) {
+        __m512 ms = _mm512_set1_ps(scale), mb = _mm512_set1_ps(bias);
+        for (uint32_t i = 0; i< unroll_factor; ++i) {
+            v[i] = dequant_ps(row, i, ms, mb);
+        }
+    };
+
+    inline void fetch_add_ps(uint8_t const *row, const float scale,
+                             const float bias) {
+        __m512 ms = _mm512_set1_ps(scale), mb = _mm512_set1_ps(bias);
+        for (uint32_t i = 0; i< unroll_factor; ++i) {
+            v[i] = _mm512_add_ps(dequant_ps(row, i, ms, mb), v[i]);
+        }
+    };
+
+    inline void fetch_fmadd_ps(uint8_t const *row, const float scale,
+                               const float bias, const float mfactor) {
+        __m512 ms = _mm512_set1_ps(scale * mfactor);
+        __m512 mb = _mm512_set1_ps(bias * mfactor);
+        for (uint32_t i = 0; i< unroll_factor; ++i) {
+            v[i] = _mm512_add_ps(dequant_ps(row, i, ms, mb), v[i]);
+        }
+    };
+
+    inline void fetch_max_ps(uint8_t const *row, const float scale,
+                             const float bias) {
+        __m512 ms = _mm512_set1_ps(scale), mb = _mm512_set1_ps(bias);
+        for (uint32_t i = 0; i< unroll_factor; ++i) {
+            v[i] = _mm512_max_ps(dequant_ps(row, i, ms, mb), v[i]);
+        }
+    };
+
+    inline void store_ps(float *mem) {
+        for (uint32_t i = 0; i< unroll_factor; ++i) {
+            _mm512_storeu_ps(mem, v[i]);
+            mem += ZEN_MM_STRIDE_FP32_512;
+        }
+    };
+
+    inline void scale_store_ps(float *mem, const float mfactor) {
+        __m512 mm = _mm512_set1_ps(mfactor);
+        for (uint32_t i = 0; i< unroll_factor; ++i) {
+            _mm512_storeu_ps(mem, _mm512_mul_ps(v[i], mm));
+            mem += ZEN_MM_STRIDE_FP32_512;
+        }
+    };
+
+  private:
+    // codes i*16 .. i*16+15 of the row
+    inline __m512 dequant_ps(uint8_t const *row, uint32_t i, __m512 ms,
+                             __m512 mb) {
+        __m128i q;
+        if (BITS == 8) {
+            q = _mm_loadu_si128((__m128i const *)(row + i * ZEN_MM_STRIDE_FP32_512));
+        }
+        else {
+            __m128i p  = _mm_loadl_epi64((__m128i const *)(row + i *
+                                         (ZEN_MM_STRIDE_FP32_512 / 2)));
+            __m128i lo = _mm_and_si128(p, _mm_set1_epi8(0x0f));
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(p, 4), _mm_set1_epi8(0x0f));
+            q = _mm_unpacklo_epi8(lo, hi);
+        }
+        __m512 codes = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(q));
+        return _mm512_fmadd_ps(codes, ms, mb);
+    }
+
+    __m512           v[DIM];
+    const uint32_t   unroll_factor = DIM;
+};
 
 template<typename input_type>
-void emb_sum(float* sum, const input_type* input, uint32_t width, uint32_t input_offset, float wt);
+void emb_sum(float* sum, const input_type* input, uint32_t width, int64_t input_offset, float wt);
 
 template<>
-void emb_sum<float>(float* sum, const float* input, uint32_t width, uint32_t input_offset, float wt){
+void emb_sum<float>(float* sum, const float* input, uint32_t width, int64_t input_offset, float wt){
     for (auto j = 0; j < width; ++j) {
         sum[j] += wt*input[j + input_offset];
     }
 }
 
 template<>
-void emb_sum<int16_t>(float* sum, const int16_t* input, uint32_t width, uint32_t input_offset, float wt) {
+void emb_sum<int16_t>(float* sum, const int16_t* input, uint32_t width, int64_t input_offset, float wt) {
     for (auto j = 0; j < width; ++j) {
         float   input_fp32;
         int16_t input_bf16     = input[j + input_offset];
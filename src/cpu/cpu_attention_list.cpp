@@ -17,6 +17,8 @@
 
 #include "cpu/cpu_engine.hpp"
 #include "cpu/ref_attention.hpp"
+#include "cpu/flash_attention.hpp"
+#include "cpu/decode_attention.hpp"
 //#include "cpu/avx2_attention.hpp"
 //#include "cpu/avx512_attention.hpp"
 
@@ -33,8 +35,14 @@ using namespace zendnn::impl::prop_kind;
 const std::map<pk_impl_key_t, std::vector<impl_list_item_t>> &impl_list_map() {
     static const std::map<pk_impl_key_t, std::vector<impl_list_item_t>> the_map = REG_ATTENTION_P({
         {{forward}, {
-            //CPU_INSTANCE(flash_attention_v2<f32>)
-            //CPU_INSTANCE(flash_attention_v1<f32>)
+            CPU_INSTANCE(decode_attention_t<f32>)
+            CPU_INSTANCE(grouped_attention_t<bf16>)
+            CPU_INSTANCE(flash_attention_v2<bf16>)
+            CPU_INSTANCE(grouped_attention_t<u8>)
+            CPU_INSTANCE(flash_attention_v2<u8>)
+            CPU_INSTANCE(grouped_attention_t<f32>)
+            CPU_INSTANCE(flash_attention_v2<f32>)
+            CPU_INSTANCE(flash_attention_v1<f32>)
             CPU_INSTANCE(ref_attention_t<f32>)
             /* eol */
             nullptr,
@@ -34,22 +34,58 @@ const std::map<pk_dt_impl_key_t, std::vector<impl_list_item_t>> &impl_list_map()
     REG_EMBEDDING_BAG_P({
             { {forward, f32, s32, f32}, {
 #if AVX512_EB_EN
-                    CPU_INSTANCE(avx512_embedding_bag_t<f32>)
+                    CPU_INSTANCE(avx512_embedding_bag_t<f32, s32>)
 #endif
-                    CPU_INSTANCE(avx2_embedding_bag_t<f32>)
-                    CPU_INSTANCE(ref_embedding_bag_t<f32>)
+                    CPU_INSTANCE(avx2_embedding_bag_t<f32, s32>)
+                    CPU_INSTANCE(ref_embedding_bag_t<f32, s32>)
                     /* eol */
                     nullptr,
                 }
             },
             { {forward, s16, s32, f32}, {
 #if AVX512_EB_EN
-                    CPU_INSTANCE(avx512_embedding_bag_t<s16>)
+                    CPU_INSTANCE(avx512_embedding_bag_t<s16, s32>)
 #endif
                     /* eol */
                     nullptr,
                 }
             },
+            { {forward, u8, s32, f32}, {
+#if AVX512_EB_EN
+                    CPU_INSTANCE(avx512_embedding_bag_t<u8, s32>)
+#endif
+                    CPU_INSTANCE(avx2_embedding_bag_t<u8, s32>)
+                    /* eol */
+                    nullptr,
+                }
+            },
+            { {forward, f32, s64, f32}, {
+#if AVX512_EB_EN
+                    CPU_INSTANCE(avx512_embedding_bag_t<f32, s64>)
+#endif
+                    CPU_INSTANCE(avx2_embedding_bag_t<f32, s64>)
+                    CPU_INSTANCE(ref_embedding_bag_t<f32, s64>)
+                    /* eol */
+                    nullptr,
+                }
+            },
+            { {forward, s16, s64, f32}, {
+#if AVX512_EB_EN
+                    CPU_INSTANCE(avx512_embedding_bag_t<s16, s64>)
+#endif
+                    /* eol */
+                    nullptr,
+                }
+            },
+            { {forward, u8, s64, f32}, {
+#if AVX512_EB_EN
+                    CPU_INSTANCE(avx512_embedding_bag_t<u8, s64>)
+#endif
+                    CPU_INSTANCE(avx2_embedding_bag_t<u8, s64>)
+                    /* eol */
+                    nullptr,
+                }
+            },
         });
     return the_map;
 }
@@ -66,8 +102,9 @@ const impl_list_item_t *get_embedding_bag_impl_list(
 
     const memory_desc_t* src_md = &desc->input_desc;
     const memory_desc_t* dst_md = &desc->dst_desc;
+    const memory_desc_t* indices_md = &desc->indices_desc;
 
-    pk_dt_impl_key_t key {prop_kind, src_md->data_type, s32, f32};
+    pk_dt_impl_key_t key {prop_kind, src_md->data_type, indices_md->data_type, f32};
 
     const auto impl_list_it = impl_list_map().find(key);
     return impl_list_it != impl_list_map().cend() ? impl_list_it->second.data()
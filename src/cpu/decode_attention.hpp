@@ -0,0 +1,420 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef CPU_DECODE_ATTENTION_HPP
+#define CPU_DECODE_ATTENTION_HPP
+
+#include <cstring>
+
+#include "cpu/flash_attention.hpp"
+
+namespace zendnn {
+namespace impl {
+namespace cpu {
+namespace attention {
+
+//Shape of an incremental decode step. q and dst are (B, N*H), the new K/V
+//rows (B, Nkv*H). The cache is (num_pages, 2, page_size, Nkv*H) and the
+//index (B, 1 + max_pages): cached length followed by the page table.
+struct decode_attention_dims_t {
+    dim_t B;            //batch
+    dim_t N;            //number of query heads
+    dim_t Nkv;          //number of key/value heads
+    dim_t H;            //head size
+    dim_t ld;           //query/dst row stride, N*H
+    dim_t ld_kv;        //key/value row stride, Nkv*H
+    dim_t num_pages;    //pages in the cache
+    dim_t page_size;    //tokens per page
+    dim_t max_pages;    //pages per sequence
+    dim_t splits;       //parallel splits of the token range of a sequence
+};
+
+inline dim_t zenDecodeAttention_PartialSize(const decode_attention_dims_t
+        &d) {
+    //Per (batch, K/V head, split): output, running max and sum of the group
+    return d.B * d.Nkv * d.splits * (d.N / d.Nkv) * (d.H + 2);
+}
+
+//Returns false if a cached length or a page id of index is out of range
+inline bool zenDecodeAttention_CheckIndex(const int32_t *index,
+        const decode_attention_dims_t &d) {
+    for (dim_t b = 0; b < d.B; b++) {
+        const int32_t *index_b = index + b * (1 + d.max_pages);
+        const dim_t len = index_b[0];
+        if (len < 0 || len + 1 > d.max_pages * d.page_size) {
+            return false;
+        }
+        for (dim_t p = 0; p <= len / d.page_size; p++) {
+            if (index_b[1 + p] < 0 || index_b[1 + p] >= d.num_pages) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//Appends the K/V rows of the new token at the cached length of its sequence
+inline void zenDecodeAttention_Append(const float *k, const float *v,
+                                      const int32_t *index, const decode_attention_dims_t &d, float *cache) {
+    for (dim_t b = 0; b < d.B; b++) {
+        const int32_t *index_b = index + b * (1 + d.max_pages);
+        const dim_t pos = index_b[0];
+        const dim_t page = index_b[1 + pos / d.page_size];
+        const dim_t slot = pos % d.page_size;
+        std::memcpy(cache + ((page * 2) * d.page_size + slot) * d.ld_kv,
+                    k + b * d.ld_kv, d.ld_kv * sizeof(float));
+        std::memcpy(cache + ((page * 2 + 1) * d.page_size + slot) * d.ld_kv,
+                    v + b * d.ld_kv, d.ld_kv * sizeof(float));
+    }
+}
+
+//Attends the new token against the cached history plus itself. Parallel
+//over (batch, K/V head, split of the token range): each split runs the
+//online softmax of zenFlashAttention_* over the pages of its range, reading
+//K/V straight from the cache, and the partial results of the splits are
+//merged at the end. Every K/V row of the cache is read once per step.
+inline void zenDecodeAttention(const float *q, const float *cache,
+                               const int32_t *index, const float *mask, const decode_attention_dims_t &d,
+                               float scale, int nthr, float *partial, float *thread_scratch, float *dst) {
+    const dim_t group = d.N / d.Nkv;
+    const dim_t partial_size = group * (d.H + 2);
+    const dim_t mask_ld = d.max_pages * d.page_size;
+    //Query heads of a group are consecutive rows of stride H for the tiles
+    flash_attention_dims_t tile_d;
+    tile_d.H = d.H;
+    tile_d.ld = d.H;
+    tile_d.ld_kv = d.ld_kv;
+
+    parallel_nd_ext(nthr, d.B, d.Nkv, d.splits, [&](int ithr, int, dim_t b,
+    dim_t kv_head, dim_t split) {
+        float *score = thread_scratch + ithr * FLASH_ATTN_BLOCK_Q *
+                       FLASH_ATTN_BLOCK_KV;
+        float *out = partial + ((b * d.Nkv + kv_head) * d.splits + split) *
+                     partial_size;
+        float *row_max = out + group * d.H;
+        float *row_sum = row_max + group;
+        const int32_t *index_b = index + b * (1 + d.max_pages);
+        const float *q_group = q + b * d.ld + kv_head * group * d.H;
+        const float *mask_b = mask + b * mask_ld;
+
+        std::fill(out, out + group * d.H, 0.0f);
+        for (dim_t g = 0; g < group; g++) {
+            row_max[g] = -std::numeric_limits<float>::infinity();
+            row_sum[g] = 0.0f;
+        }
+        const dim_t tokens = index_b[0] + 1;
+        const dim_t chunk = utils::div_up(tokens, d.splits);
+        const dim_t t_end = std::min(tokens, (split + 1) * chunk);
+        for (dim_t t = split * chunk; t < t_end;) {
+            const dim_t page = index_b[1 + t / d.page_size];
+            const dim_t slot = t % d.page_size;
+            const dim_t cols = std::min(std::min((dim_t)FLASH_ATTN_BLOCK_KV,
+                                                 d.page_size - slot), t_end - t);
+            const float *k_tile = cache + ((page * 2) * d.page_size + slot) *
+                                  d.ld_kv + kv_head * d.H;
+            const float *v_tile = cache + ((page * 2 + 1) * d.page_size + slot) *
+                                  d.ld_kv + kv_head * d.H;
+            for (dim_t g0 = 0; g0 < group; g0 += FLASH_ATTN_BLOCK_Q) {
+                const dim_t rows = std::min((dim_t)FLASH_ATTN_BLOCK_Q, group - g0);
+                zenFlashAttention_Scores(q_group + g0 * d.H, k_tile, mask_b + t,
+                                         tile_d, scale, rows, cols, score);
+                for (dim_t i = 0; i < rows; i++) {
+                    float *score_row = score + i * FLASH_ATTN_BLOCK_KV;
+                    float correction = zenFlashAttention_Rescale(score_row, cols,
+                                       row_max[g0 + i], row_sum[g0 + i]);
+                    zenFlashAttention_AccumulateV(score_row, v_tile, cols, d.H,
+                                                  d.ld_kv, correction, out + (g0 + i) * d.H);
+                }
+            }
+            t += cols;
+        }
+    });
+
+    //Merge the splits: rescale every split to the global max
+    parallel_nd(d.B, d.N, [&](dim_t b, dim_t n) {
+        const dim_t kv_head = n / group, g = n % group;
+        const float *part = partial + (b * d.Nkv + kv_head) * d.splits *
+                            partial_size;
+        float *dst_row = dst + b * d.ld + n * d.H;
+        //Splits past the end of a short sequence have an empty sum
+        float max_all = -std::numeric_limits<float>::infinity();
+        for (dim_t s = 0; s < d.splits; s++) {
+            const float *row_max = part + s * partial_size + group * d.H;
+            const float *row_sum = row_max + group;
+            if (row_sum[g] > 0.0f) {
+                max_all = std::max(max_all, row_max[g]);
+            }
+        }
+        float sum_all = 0.0f;
+        std::fill(dst_row, dst_row + d.H, 0.0f);
+        for (dim_t s = 0; s < d.splits; s++) {
+            const float *out = part + s * partial_size;
+            const float *row_max = out + group * d.H;
+            const float *row_sum = row_max + group;
+            if (row_sum[g] <= 0.0f) {
+                continue;
+            }
+            const float weight = expf(row_max[g] - max_all);
+            sum_all += row_sum[g] * weight;
+            const float *out_row = out + g * d.H;
+            ZENDNN_PRAGMA_OMP_SIMD()
+            for (dim_t h = 0; h < d.H; h++) {
+                dst_row[h] += weight * out_row[h];
+            }
+        }
+        const float inv_sum = 1.0f / sum_all;
+        ZENDNN_PRAGMA_OMP_SIMD()
+        for (dim_t h = 0; h < d.H; h++) {
+            dst_row[h] *= inv_sum;
+        }
+    });
+}
+
+} // namespace attention
+
+/* add new primitive */
+//Incremental decode of all attention algorithms against a paged KV cache
+template <impl::data_type_t data_type>
+struct decode_attention_t : public primitive_t {
+    struct pd_t : public cpu_attention_pd_t {
+        using cpu_attention_pd_t::cpu_attention_pd_t;
+
+        DECLARE_COMMON_PD_T("decode:any", decode_attention_t);
+
+        status_t init(engine_t *engine) {
+            using namespace format_tag;
+            if (!this->is_decode()
+                    || data_type != zendnn::impl::data_type::f32
+                    || !platform::has_data_type_support(data_type)) {
+                return status::unimplemented;
+            }
+            memory_desc_wrapper mask_mdw(this->src_md(ZENDNN_ARG_MASK));
+            memory_desc_wrapper dst_mdw(this->dst_md(ZENDNN_ARG_DST));
+            memory_desc_wrapper cache_mdw(this->dst_md(ZENDNN_ARG_KV_CACHE));
+            memory_desc_wrapper index_mdw(this->src_md(ZENDNN_ARG_KV_CACHE_INDEX));
+            const dim_t N = this->desc()->num_heads;
+            bool ok = N > 0 && dst_mdw.ndims() == 3 && dst_mdw.dims()[1] == 1
+                      && dst_mdw.dims()[2] >= N && dst_mdw.dims()[2] % N == 0
+                      && dst_mdw.matches_tag(abc) && mask_mdw.matches_tag(ab)
+                      && cache_mdw.data_type() == zendnn::impl::data_type::f32
+                      && cache_mdw.matches_tag(abcd) && index_mdw.matches_tag(ab)
+                      && cache_mdw.dims()[2] > 0 && index_mdw.dims()[1] > 1
+                      && data_types_ok() && this->attr()->has_default_values();
+            if (!ok) {
+                return status::unimplemented;
+            }
+            nthr_ = zendnn_get_max_threads();
+            auto d = dims();
+            ok = d.Nkv > 0 && d.N % d.Nkv == 0
+                 && this->src_md(ZENDNN_ARG_WEIGHTS_0)->dims[1] == d.ld
+                 && this->src_md(ZENDNN_ARG_WEIGHTS_1)->dims[1] == d.ld_kv
+                 && this->src_md(ZENDNN_ARG_WEIGHTS_2)->dims[1] == d.ld_kv
+                 && cache_mdw.dims()[3] == d.ld_kv
+                 && mask_mdw.dims()[0] == d.B
+                 && mask_mdw.dims()[1] == d.max_pages * d.page_size
+                 && IMPLICATION(this->desc()->alg_kind == alg_kind::multiquery_attention,
+                                d.Nkv == 1);
+            if (!ok) {
+                return status::unimplemented;
+            }
+
+            init_scratchpad();
+            return status::success;
+        }
+
+        attention::decode_attention_dims_t dims() const {
+            memory_desc_wrapper dMD(this->dst_md(ZENDNN_ARG_DST));
+            memory_desc_wrapper cMD(this->dst_md(ZENDNN_ARG_KV_CACHE));
+            memory_desc_wrapper iMD(this->src_md(ZENDNN_ARG_KV_CACHE_INDEX));
+            attention::decode_attention_dims_t d;
+            d.B = dMD.dims()[0];
+            d.N = this->desc()->num_heads;
+            d.H = dMD.dims()[2] / d.N;
+            //init() refuses a head size of 0, keep dims() safe on such descs
+            d.Nkv = d.H ? this->src_md(ZENDNN_ARG_WEIGHTS_1)->dims[1] / d.H : 0;
+            d.ld = dMD.dims()[2];
+            d.ld_kv = d.Nkv * d.H;
+            d.num_pages = cMD.dims()[0];
+            d.page_size = cMD.dims()[2];
+            d.max_pages = iMD.dims()[1] - 1;
+            //Split the token range when (batch, K/V head) can not feed all
+            //threads, at most one split per page
+            d.splits = std::max((dim_t)1, std::min(d.max_pages,
+                                                   (dim_t)utils::div_up(nthr_, d.B * d.Nkv)));
+            return d;
+        }
+
+        int nthr_;
+
+        private:
+            //Every input, weight, bias and the dst are read and written as f32
+            bool data_types_ok() const {
+                using namespace zendnn::impl::data_type;
+                for (int arg : {
+                            ZENDNN_ARG_SRC_0, ZENDNN_ARG_SRC_1, ZENDNN_ARG_SRC_2,
+                            ZENDNN_ARG_MASK
+                        }) {
+                    if (this->src_md(arg)->data_type != f32) {
+                        return false;
+                    }
+                }
+                for (int arg : {
+                            ZENDNN_ARG_WEIGHTS_0, ZENDNN_ARG_WEIGHTS_1, ZENDNN_ARG_WEIGHTS_2
+                        }) {
+                    memory_desc_wrapper weights_mdw(this->src_md(arg));
+                    if (weights_mdw.data_type() != f32
+                            || !weights_mdw.matches_tag(format_tag::ab)) {
+                        return false;
+                    }
+                }
+                for (int arg : {
+                            ZENDNN_ARG_BIAS_0, ZENDNN_ARG_BIAS_1, ZENDNN_ARG_BIAS_2
+                        }) {
+                    if (!utils::one_of(this->src_md(arg)->data_type, f32, undef)) {
+                        return false;
+                    }
+                }
+                return this->dst_md(ZENDNN_ARG_DST)->data_type == f32;
+            }
+
+            void init_scratchpad() {
+                auto scratchpad = scratchpad_registry().registrar();
+                auto d = dims();
+
+                //Projected query and new K/V row, split partials and one
+                //score tile per thread. Nothing depends on the cached length.
+                auto scratchpad_size = d.B * d.ld + 2 * d.B * d.ld_kv
+                                       + attention::zenDecodeAttention_PartialSize(d)
+                                       + nthr_ * FLASH_ATTN_BLOCK_Q * FLASH_ATTN_BLOCK_KV;
+
+                zendnnInfo(ZENDNN_CORELOG, "init_scratchpad() decode scratchpad_size : ",
+                           scratchpad_size);
+
+                scratchpad.book(memory_tracking::names::key_attention,
+                    scratchpad_size, types::data_type_size(zendnn_f32));
+            }
+    };
+    // constructor using pd_t
+    decode_attention_t(const pd_t *apd) : primitive_t(apd) {}
+
+    // init() override from primitive_t
+    status_t init(engine_t *engine) override {
+        return status::success;
+    }
+
+    // exec() override from primitive_t
+    status_t execute(const exec_ctx_t &ctx) const override {
+        return execute_decode(ctx);
+    }
+
+  private:
+    const pd_t *pd() const {
+        return (const pd_t *)primitive_t::pd().get();
+    }
+
+    status_t execute_decode(const exec_ctx_t &ctx) const;
+};
+
+template<data_type_t data_type>
+status_t
+decode_attention_t<data_type>::execute_decode(const exec_ctx_t &ctx) const {
+    auto scale = pd()->desc()->scale;
+
+    // get the tensors
+    auto query   = CTX_IN_MEM(const float *, ZENDNN_ARG_SRC_0);
+    auto key   = CTX_IN_MEM(const float *, ZENDNN_ARG_SRC_1);
+    auto value   = CTX_IN_MEM(const float *, ZENDNN_ARG_SRC_2);
+    auto weights_query   = CTX_IN_MEM(const float *, ZENDNN_ARG_WEIGHTS_0);
+    auto weights_key   = CTX_IN_MEM(const float *, ZENDNN_ARG_WEIGHTS_1);
+    auto weights_value   = CTX_IN_MEM(const float *, ZENDNN_ARG_WEIGHTS_2);
+    auto bias_query   = CTX_IN_MEM(const float *, ZENDNN_ARG_BIAS_0);
+    auto bias_key   = CTX_IN_MEM(const float *, ZENDNN_ARG_BIAS_1);
+    auto bias_value   = CTX_IN_MEM(const float *, ZENDNN_ARG_BIAS_2);
+    auto mask  = CTX_IN_MEM(const float *, ZENDNN_ARG_MASK);
+    auto kv_cache_index  = CTX_IN_MEM(const int32_t *,
+                                      ZENDNN_ARG_KV_CACHE_INDEX);
+    auto kv_cache  = CTX_OUT_MEM(float *, ZENDNN_ARG_KV_CACHE);
+    auto dst     = CTX_OUT_MEM(float *, ZENDNN_ARG_DST);
+
+    auto d = pd()->dims();
+    if (!zendnn::impl::cpu::attention::zenDecodeAttention_CheckIndex(
+                kv_cache_index, d)) {
+        zendnnError(ZENDNN_CORELOG,
+                    "attention decode: KV cache index out of range");
+        return status::invalid_arguments;
+    }
+
+    const auto scratchpad = ctx.get_scratchpad_grantor();
+    auto scratchpad_buf_base = scratchpad.template get<float>(
+                               memory_tracking::names::key_attention);
+
+    memory_desc_wrapper query_mdw(pd()->src_md(ZENDNN_ARG_SRC_0));
+    memory_desc_wrapper key_mdw(pd()->src_md(ZENDNN_ARG_SRC_1));
+    memory_desc_wrapper value_mdw(pd()->src_md(ZENDNN_ARG_SRC_2));
+    memory_desc_wrapper weights_query_mdw(pd()->src_md(ZENDNN_ARG_WEIGHTS_0));
+    memory_desc_wrapper weights_key_mdw(pd()->src_md(ZENDNN_ARG_WEIGHTS_1));
+    memory_desc_wrapper weights_value_mdw(pd()->src_md(ZENDNN_ARG_WEIGHTS_2));
+    memory_desc_wrapper bias_query_mdw(pd()->src_md(ZENDNN_ARG_BIAS_0));
+    memory_desc_wrapper bias_key_mdw(pd()->src_md(ZENDNN_ARG_BIAS_1));
+    memory_desc_wrapper bias_value_mdw(pd()->src_md(ZENDNN_ARG_BIAS_2));
+
+    //Only the new token is projected, (B, 1, N*H) and (B, 1, Nkv*H)
+    memory_desc_t qBuff_md, kvBuff_md;
+    std::vector<dim_t> qDims = {d.B, 1, d.ld};
+    std::vector<dim_t> kvDims = {d.B, 1, d.ld_kv};
+    zendnn::impl::dims_t qStrides{d.ld, d.ld, 1};
+    zendnn::impl::dims_t kvStrides{d.ld_kv, d.ld_kv, 1};
+    zendnn_memory_desc_init_by_strides(&qBuff_md, qDims.size(), qDims.data(),
+                                       zendnn::impl::data_type::f32, qStrides);
+    zendnn_memory_desc_init_by_strides(&kvBuff_md, kvDims.size(), kvDims.data(),
+                                       zendnn::impl::data_type::f32, kvStrides);
+    memory_desc_wrapper qBuff_mdw(qBuff_md);
+    memory_desc_wrapper kvBuff_mdw(kvBuff_md);
+
+    auto scp_qBuff = scratchpad_buf_base;
+    auto scp_kBuff = scp_qBuff + d.B * d.ld;
+    auto scp_vBuff = scp_kBuff + d.B * d.ld_kv;
+    auto scp_partial = scp_vBuff + d.B * d.ld_kv;
+    auto scp_thread = scp_partial +
+                      zendnn::impl::cpu::attention::zenDecodeAttention_PartialSize(d);
+
+    zendnn::impl::cpu::attention::zenAttention_Matmul(query, query_mdw,
+            weights_query, weights_query_mdw, 1.0f, bias_query, bias_query_mdw,
+            scp_qBuff, qBuff_mdw);
+    zendnn::impl::cpu::attention::zenAttention_Matmul(key, key_mdw,
+            weights_key, weights_key_mdw, 1.0f, bias_key, bias_key_mdw,
+            scp_kBuff, kvBuff_mdw);
+    zendnn::impl::cpu::attention::zenAttention_Matmul(value, value_mdw,
+            weights_value, weights_value_mdw, 1.0f, bias_value, bias_value_mdw,
+            scp_vBuff, kvBuff_mdw);
+
+    zendnn::impl::cpu::attention::zenDecodeAttention_Append(scp_kBuff,
+            scp_vBuff, kv_cache_index, d, kv_cache);
+    zendnn::impl::cpu::attention::zenDecodeAttention(scp_qBuff, kv_cache,
+            kv_cache_index, mask, d, scale, pd()->nthr_, scp_partial, scp_thread,
+            dst);
+    zendnnVerbose(ZENDNN_CORELOG, "[Custom] decode attention B:", d.B, " N:",
+                  d.N, " Nkv:", d.Nkv, " H:", d.H, " page_size:", d.page_size,
+                  " splits:", d.splits);
+    return status::success;
+}
+
+} // namespace cpu
+} // namespace impl
+} // namespace zendnn
+
+#endif
@@ -0,0 +1,769 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef CPU_FLASH_ATTENTION_HPP
+#define CPU_FLASH_ATTENTION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "common/bfloat16.hpp"
+#include "cpu/gemm/gemm.hpp"
+#include "cpu/matmul/zendnn_bf16_matmul.hpp"
+#include "cpu/ref_attention.hpp"
+
+//Flash attention: QK', scale, mask, softmax and xV fused per tile with an
+//online softmax. The SxS score matrix is never materialized, a thread only
+//holds a FLASH_ATTN_BLOCK_Q x FLASH_ATTN_BLOCK_KV score tile. With H <= 128
+//the Q, K, V, score and output tiles of a thread stay within L2.
+#define FLASH_ATTN_BLOCK_Q      64
+#define FLASH_ATTN_BLOCK_KV     64
+//Query rows x key rows of the score block kept in registers, 8 accumulators
+//and the 6 Q/K vectors they read fit the 16 AVX2 registers
+#define FLASH_ATTN_REG_Q        4
+#define FLASH_ATTN_REG_KV       2
+//Mask is transformed as in zenAttention_TransformAddMask: 10000*mask - 10000
+#define FLASH_ATTN_MASK_SCALE   10000.0f
+
+namespace zendnn {
+namespace impl {
+namespace cpu {
+namespace attention {
+
+//Shape of a flash attention problem. Q and dst are (B, S, N*H) and K, V
+//are (B, S, Nkv*H) row major, head n of row s starting at s*ld + n*H.
+//Query head n attends with K/V head n / (N / Nkv).
+//Projected Q, K and V are f32 or bf16, scores and outputs are always
+//accumulated in f32.
+struct flash_attention_dims_t {
+    dim_t B;    //batch
+    dim_t Sq;   //query sequence length
+    dim_t Skv;  //key/value sequence length
+    dim_t N;    //number of query heads
+    dim_t Nkv;  //number of key/value heads, N for multihead attention
+    dim_t H;    //head size
+    dim_t ld;   //query/dst row stride, N*H
+    dim_t ld_kv;//key/value row stride, Nkv*H
+};
+
+//Loop order of a flash attention kernel
+enum flash_attention_kernel_t {
+    flash_kernel_v1 = 0,
+    flash_kernel_v2 = 1,
+    flash_kernel_grouped = 2,
+};
+
+inline dim_t zenFlashAttention_ThreadScratchSize(const flash_attention_dims_t
+        &d, flash_attention_kernel_t kernel) {
+    //v1: score tile + running max/sum of every query row of a head
+    //v2: score tile + output tile + running max/sum of the query tile
+    //grouped: v2 tile set for every query head of a K/V head
+    const dim_t heads = kernel == flash_kernel_grouped ? d.N / d.Nkv : 1;
+    return kernel == flash_kernel_v1
+           ? FLASH_ATTN_BLOCK_Q * FLASH_ATTN_BLOCK_KV + 2 * d.Sq
+           : FLASH_ATTN_BLOCK_Q * FLASH_ATTN_BLOCK_KV
+           + heads * (FLASH_ATTN_BLOCK_Q * d.H + 2 * FLASH_ATTN_BLOCK_Q);
+}
+
+//Widens a projected Q/K/V element to f32. Inline so that the bf16 loads
+//vectorize together with the dot products.
+inline float zenFlashAttention_Load(float x) {
+    return x;
+}
+inline float zenFlashAttention_Load(bfloat16_t x) {
+    return utils::bit_cast<float>((uint32_t)x.raw_bits_ << 16);
+}
+
+inline float zenFlashAttention_Score(float dot, float scale, float mask) {
+    return scale * dot + (FLASH_ATTN_MASK_SCALE * mask - FLASH_ATTN_MASK_SCALE);
+}
+
+//score[i][j] = scale * q_i.k_j + mask_j for a rows x cols tile. Blocks of
+//FLASH_ATTN_REG_Q query rows by FLASH_ATTN_REG_KV key rows keep their dot
+//products in registers, every Q and K vector loaded is used for 2 or 4 of
+//them instead of 1. Rows and columns past the blocks take the plain loop.
+template <typename src_t>
+inline void zenFlashAttention_Scores(const src_t *q, const src_t *k,
+                                     const float *mask, const flash_attention_dims_t &d, float scale,
+                                     dim_t rows, dim_t cols, float *score) {
+    const dim_t H = d.H;
+    dim_t i = 0;
+    for (; i + FLASH_ATTN_REG_Q <= rows; i += FLASH_ATTN_REG_Q) {
+        const src_t *q0 = q + i * d.ld;
+        const src_t *q1 = q0 + d.ld;
+        const src_t *q2 = q1 + d.ld;
+        const src_t *q3 = q2 + d.ld;
+        float *score0 = score + i * FLASH_ATTN_BLOCK_KV;
+        float *score1 = score0 + FLASH_ATTN_BLOCK_KV;
+        float *score2 = score1 + FLASH_ATTN_BLOCK_KV;
+        float *score3 = score2 + FLASH_ATTN_BLOCK_KV;
+        dim_t j = 0;
+        for (; j + FLASH_ATTN_REG_KV <= cols; j += FLASH_ATTN_REG_KV) {
+            const src_t *k0 = k + j * d.ld_kv;
+            const src_t *k1 = k0 + d.ld_kv;
+            float s00 = 0.0f, s01 = 0.0f, s10 = 0.0f, s11 = 0.0f;
+            float s20 = 0.0f, s21 = 0.0f, s30 = 0.0f, s31 = 0.0f;
+            ZENDNN_PRAGMA_OMP_SIMD(reduction(+:s00, s01, s10, s11, s20, s21, s30, s31))
+            for (dim_t h = 0; h < H; h++) {
+                const float kh0 = zenFlashAttention_Load(k0[h]);
+                const float kh1 = zenFlashAttention_Load(k1[h]);
+                const float qh0 = zenFlashAttention_Load(q0[h]);
+                const float qh1 = zenFlashAttention_Load(q1[h]);
+                const float qh2 = zenFlashAttention_Load(q2[h]);
+                const float qh3 = zenFlashAttention_Load(q3[h]);
+                s00 += qh0 * kh0;
+                s01 += qh0 * kh1;
+                s10 += qh1 * kh0;
+                s11 += qh1 * kh1;
+                s20 += qh2 * kh0;
+                s21 += qh2 * kh1;
+                s30 += qh3 * kh0;
+                s31 += qh3 * kh1;
+            }
+            score0[j] = zenFlashAttention_Score(s00, scale, mask[j]);
+            score0[j + 1] = zenFlashAttention_Score(s01, scale, mask[j + 1]);
+            score1[j] = zenFlashAttention_Score(s10, scale, mask[j]);
+            score1[j + 1] = zenFlashAttention_Score(s11, scale, mask[j + 1]);
+            score2[j] = zenFlashAttention_Score(s20, scale, mask[j]);
+            score2[j + 1] = zenFlashAttention_Score(s21, scale, mask[j + 1]);
+            score3[j] = zenFlashAttention_Score(s30, scale, mask[j]);
+            score3[j + 1] = zenFlashAttention_Score(s31, scale, mask[j + 1]);
+        }
+        for (; j < cols; j++) {
+            const src_t *k0 = k + j * d.ld_kv;
+            float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+            ZENDNN_PRAGMA_OMP_SIMD(reduction(+:s0, s1, s2, s3))
+            for (dim_t h = 0; h < H; h++) {
+                const float kh = zenFlashAttention_Load(k0[h]);
+                s0 += zenFlashAttention_Load(q0[h]) * kh;
+                s1 += zenFlashAttention_Load(q1[h]) * kh;
+                s2 += zenFlashAttention_Load(q2[h]) * kh;
+                s3 += zenFlashAttention_Load(q3[h]) * kh;
+            }
+            score0[j] = zenFlashAttention_Score(s0, scale, mask[j]);
+            score1[j] = zenFlashAttention_Score(s1, scale, mask[j]);
+            score2[j] = zenFlashAttention_Score(s2, scale, mask[j]);
+            score3[j] = zenFlashAttention_Score(s3, scale, mask[j]);
+        }
+    }
+    for (; i < rows; i++) {
+        const src_t *q_row = q + i * d.ld;
+        float *score_row = score + i * FLASH_ATTN_BLOCK_KV;
+        for (dim_t j = 0; j < cols; j++) {
+            const src_t *k_row = k + j * d.ld_kv;
+            float dot = 0.0f;
+            ZENDNN_PRAGMA_OMP_SIMD(reduction(+:dot))
+            for (dim_t h = 0; h < H; h++) {
+                dot += zenFlashAttention_Load(q_row[h])
+                       * zenFlashAttention_Load(k_row[h]);
+            }
+            score_row[j] = zenFlashAttention_Score(dot, scale, mask[j]);
+        }
+    }
+}
+
+//Online softmax step of one row: turns score_row into exp(score - new max),
+//rescales the running sum and returns the correction factor of the output
+//accumulated so far.
+inline float zenFlashAttention_Rescale(float *score_row, dim_t cols,
+                                       float &row_max, float &row_sum) {
+    float tile_max = row_max;
+    for (dim_t j = 0; j < cols; j++) {
+        tile_max = std::max(tile_max, score_row[j]);
+    }
+    float tile_sum = 0.0f;
+    for (dim_t j = 0; j < cols; j++) {
+        score_row[j] = expf(score_row[j] - tile_max);
+        tile_sum += score_row[j];
+    }
+    float correction = expf(row_max - tile_max);
+    row_sum = row_sum * correction + tile_sum;
+    row_max = tile_max;
+    return correction;
+}
+
+//out = out * correction + p x V for one row
+template <typename src_t>
+inline void zenFlashAttention_AccumulateV(const float *p, const src_t *v,
+        dim_t cols, dim_t H, dim_t ld, float correction, float *out) {
+    ZENDNN_PRAGMA_OMP_SIMD()
+    for (dim_t h = 0; h < H; h++) {
+        out[h] *= correction;
+    }
+    for (dim_t j = 0; j < cols; j++) {
+        const src_t *v_row = v + j * ld;
+        const float p_j = p[j];
+        ZENDNN_PRAGMA_OMP_SIMD()
+        for (dim_t h = 0; h < H; h++) {
+            out[h] += p_j * zenFlashAttention_Load(v_row[h]);
+        }
+    }
+}
+
+//Flash attention v1 loop order: parallel over (batch, head), K/V tiles in
+//the outer loop, so each K/V tile is read once while the query tiles stream
+//over it. The output rows live in dst and are rescaled in place, running
+//max/sum of all query rows of the head are kept in the thread scratchpad.
+inline void zenFlashAttention_v1(const float *q, const float *k,
+                                 const float *v, const float *mask, const flash_attention_dims_t &d,
+                                 float scale, int nthr, float *thread_scratch, float *dst) {
+    const dim_t scratch_size = zenFlashAttention_ThreadScratchSize(d,
+                                 flash_kernel_v1);
+    parallel_nd_ext(nthr, d.B, d.N, [&](int ithr, int, dim_t b, dim_t n) {
+        float *score = thread_scratch + ithr * scratch_size;
+        float *row_max = score + FLASH_ATTN_BLOCK_Q * FLASH_ATTN_BLOCK_KV;
+        float *row_sum = row_max + d.Sq;
+        const float *q_head = q + b * d.Sq * d.ld + n * d.H;
+        const dim_t kv_off = b * d.Skv * d.ld_kv + (n / (d.N / d.Nkv)) * d.H;
+        const float *k_head = k + kv_off;
+        const float *v_head = v + kv_off;
+        const float *mask_b = mask + b * d.Skv;
+        float *dst_head = dst + b * d.Sq * d.ld + n * d.H;
+
+        for (dim_t i = 0; i < d.Sq; i++) {
+            row_max[i] = -std::numeric_limits<float>::infinity();
+            row_sum[i] = 0.0f;
+            std::fill(dst_head + i * d.ld, dst_head + i * d.ld + d.H, 0.0f);
+        }
+        for (dim_t kv = 0; kv < d.Skv; kv += FLASH_ATTN_BLOCK_KV) {
+            const dim_t cols = std::min((dim_t)FLASH_ATTN_BLOCK_KV, d.Skv - kv);
+            for (dim_t qs = 0; qs < d.Sq; qs += FLASH_ATTN_BLOCK_Q) {
+                const dim_t rows = std::min((dim_t)FLASH_ATTN_BLOCK_Q, d.Sq - qs);
+                zenFlashAttention_Scores(q_head + qs * d.ld, k_head + kv * d.ld_kv,
+                                         mask_b + kv, d, scale, rows, cols, score);
+                for (dim_t i = 0; i < rows; i++) {
+                    float *score_row = score + i * FLASH_ATTN_BLOCK_KV;
+                    float correction = zenFlashAttention_Rescale(score_row, cols,
+                                       row_max[qs + i], row_sum[qs + i]);
+                    zenFlashAttention_AccumulateV(score_row, v_head + kv * d.ld_kv,
+                                                  cols, d.H, d.ld_kv, correction,
+                                                  dst_head + (qs + i) * d.ld);
+                }
+            }
+        }
+        for (dim_t i = 0; i < d.Sq; i++) {
+            const float inv_sum = 1.0f / row_sum[i];
+            float *dst_row = dst_head + i * d.ld;
+            ZENDNN_PRAGMA_OMP_SIMD()
+            for (dim_t h = 0; h < d.H; h++) {
+                dst_row[h] *= inv_sum;
+            }
+        }
+    });
+}
+
+//Flash attention v2 loop order: parallel over (batch, head, query tile),
+//K/V tiles in the inner loop. The output tile is accumulated in the thread
+//scratchpad and normalized once when it is written to dst.
+template <typename src_t, typename dst_t>
+inline void zenFlashAttention_v2(const src_t *q, const src_t *k,
+                                 const src_t *v, const float *mask, const flash_attention_dims_t &d,
+                                 float scale, int nthr, float *thread_scratch, dst_t *dst) {
+    const dim_t scratch_size = zenFlashAttention_ThreadScratchSize(d,
+                                 flash_kernel_v2);
+    const dim_t q_tiles = utils::div_up(d.Sq, (dim_t)FLASH_ATTN_BLOCK_Q);
+    parallel_nd_ext(nthr, d.B, d.N, q_tiles, [&](int ithr, int, dim_t b,
+    dim_t n, dim_t q_tile) {
+        float *score = thread_scratch + ithr * scratch_size;
+        float *out = score + FLASH_ATTN_BLOCK_Q * FLASH_ATTN_BLOCK_KV;
+        float *row_max = out + FLASH_ATTN_BLOCK_Q * d.H;
+        float *row_sum = row_max + FLASH_ATTN_BLOCK_Q;
+        const dim_t qs = q_tile * FLASH_ATTN_BLOCK_Q;
+        const dim_t rows = std::min((dim_t)FLASH_ATTN_BLOCK_Q, d.Sq - qs);
+        const src_t *q_tile_ptr = q + (b * d.Sq + qs) * d.ld + n * d.H;
+        const dim_t kv_off = b * d.Skv * d.ld_kv + (n / (d.N / d.Nkv)) * d.H;
+        const src_t *k_head = k + kv_off;
+        const src_t *v_head = v + kv_off;
+        const float *mask_b = mask + b * d.Skv;
+        dst_t *dst_tile = dst + (b * d.Sq + qs) * d.ld + n * d.H;
+
+        std::fill(out, out + rows * d.H, 0.0f);
+        for (dim_t i = 0; i < rows; i++) {
+            row_max[i] = -std::numeric_limits<float>::infinity();
+            row_sum[i] = 0.0f;
+        }
+        for (dim_t kv = 0; kv < d.Skv; kv += FLASH_ATTN_BLOCK_KV) {
+            const dim_t cols = std::min((dim_t)FLASH_ATTN_BLOCK_KV, d.Skv - kv);
+            zenFlashAttention_Scores(q_tile_ptr, k_head + kv * d.ld_kv, mask_b + kv, d,
+                                     scale, rows, cols, score);
+            for (dim_t i = 0; i < rows; i++) {
+                float *score_row = score + i * FLASH_ATTN_BLOCK_KV;
+                float correction = zenFlashAttention_Rescale(score_row, cols,
+                                   row_max[i], row_sum[i]);
+                zenFlashAttention_AccumulateV(score_row, v_head + kv * d.ld_kv, cols,
+                                              d.H, d.ld_kv, correction, out + i * d.H);
+            }
+        }
+        for (dim_t i = 0; i < rows; i++) {
+            const float inv_sum = 1.0f / row_sum[i];
+            const float *out_row = out + i * d.H;
+            dst_t *dst_row = dst_tile + i * d.ld;
+            ZENDNN_PRAGMA_OMP_SIMD()
+            for (dim_t h = 0; h < d.H; h++) {
+                dst_row[h] = out_row[h] * inv_sum;
+            }
+        }
+    });
+}
+
+//Grouped-query and multi-query attention: parallel over (batch, K/V head,
+//query tile). Every K/V tile is read once and reused by all N / Nkv query
+//heads of its group while it is in cache, there are no per query head K/V
+//copies. Output tiles of the group are accumulated in the thread scratchpad.
+template <typename src_t, typename dst_t>
+inline void zenFlashAttention_Grouped(const src_t *q, const src_t *k,
+                                      const src_t *v, const float *mask, const flash_attention_dims_t &d,
+                                      float scale, int nthr, float *thread_scratch, dst_t *dst) {
+    const dim_t scratch_size = zenFlashAttention_ThreadScratchSize(d,
+                               flash_kernel_grouped);
+    const dim_t group = d.N / d.Nkv;
+    const dim_t q_tiles = utils::div_up(d.Sq, (dim_t)FLASH_ATTN_BLOCK_Q);
+    parallel_nd_ext(nthr, d.B, d.Nkv, q_tiles, [&](int ithr, int, dim_t b,
+    dim_t kv_head, dim_t q_tile) {
+        float *score = thread_scratch + ithr * scratch_size;
+        float *out = score + FLASH_ATTN_BLOCK_Q * FLASH_ATTN_BLOCK_KV;
+        float *row_max = out + group * FLASH_ATTN_BLOCK_Q * d.H;
+        float *row_sum = row_max + group * FLASH_ATTN_BLOCK_Q;
+        const dim_t qs = q_tile * FLASH_ATTN_BLOCK_Q;
+        const dim_t rows = std::min((dim_t)FLASH_ATTN_BLOCK_Q, d.Sq - qs);
+        const src_t *q_group = q + (b * d.Sq + qs) * d.ld + kv_head * group * d.H;
+        const src_t *k_head = k + b * d.Skv * d.ld_kv + kv_head * d.H;
+        const src_t *v_head = v + b * d.Skv * d.ld_kv + kv_head * d.H;
+        const float *mask_b = mask + b * d.Skv;
+        dst_t *dst_group = dst + (b * d.Sq + qs) * d.ld + kv_head * group * d.H;
+
+        std::fill(out, out + group * FLASH_ATTN_BLOCK_Q * d.H, 0.0f);
+        for (dim_t i = 0; i < group * FLASH_ATTN_BLOCK_Q; i++) {
+            row_max[i] = -std::numeric_limits<float>::infinity();
+            row_sum[i] = 0.0f;
+        }
+        for (dim_t kv = 0; kv < d.Skv; kv += FLASH_ATTN_BLOCK_KV) {
+            const dim_t cols = std::min((dim_t)FLASH_ATTN_BLOCK_KV, d.Skv - kv);
+            for (dim_t g = 0; g < group; g++) {
+                float *out_g = out + g * FLASH_ATTN_BLOCK_Q * d.H;
+                zenFlashAttention_Scores(q_group + g * d.H, k_head + kv * d.ld_kv,
+                                         mask_b + kv, d, scale, rows, cols, score);
+                for (dim_t i = 0; i < rows; i++) {
+                    float *score_row = score + i * FLASH_ATTN_BLOCK_KV;
+                    const dim_t r = g * FLASH_ATTN_BLOCK_Q + i;
+                    float correction = zenFlashAttention_Rescale(score_row, cols,
+                                       row_max[r], row_sum[r]);
+                    zenFlashAttention_AccumulateV(score_row, v_head + kv * d.ld_kv,
+                                                  cols, d.H, d.ld_kv, correction, out_g + i * d.H);
+                }
+            }
+        }
+        for (dim_t g = 0; g < group; g++) {
+            for (dim_t i = 0; i < rows; i++) {
+                const float inv_sum = 1.0f / row_sum[g * FLASH_ATTN_BLOCK_Q + i];
+                const float *out_row = out + (g * FLASH_ATTN_BLOCK_Q + i) * d.H;
+                dst_t *dst_row = dst_group + i * d.ld + g * d.H;
+                ZENDNN_PRAGMA_OMP_SIMD()
+                for (dim_t h = 0; h < d.H; h++) {
+                    dst_row[h] = out_row[h] * inv_sum;
+                }
+            }
+        }
+    });
+}
+
+//Q/K/V projection o = a x b + bias, a (M, K) and b (K, N) row major with
+//contiguous rows. There is one overload per attention data type, u8s8 is
+//the only one using the quantization scales.
+//f32: zenMatMulWithBias
+inline status_t zenAttention_Project(const float *a, const float *b,
+                                     const void *bias, data_type_t bias_dt, float src_scale,
+                                     const scales_t &wei_scales, dim_t M, dim_t K, dim_t N, float *o) {
+    const int offset = 0;
+    zenMatMulWithBias(true, false, false, 1, &offset, &offset, &offset, M, K, N,
+                      1.0f, a, K, b, N, (const float *)bias, 0.0f, o, N);
+    return status::success;
+}
+
+//bf16: AOCL bf16 GEMM (BRGEMM when built without LPGEMM) through the bf16
+//MatMul dispatch, f32 accumulation with a bf16 result. bias is f32 or bf16.
+inline status_t zenAttention_Project(const bfloat16_t *a, const bfloat16_t *b,
+                                     const void *bias, data_type_t bias_dt, float src_scale,
+                                     const scales_t &wei_scales, dim_t M, dim_t K, dim_t N, bfloat16_t *o) {
+    zendnnEnv zenEnvObj = readEnv();
+    const float out_scale = 1.0f;
+    matmul::matmul_bf16_wrapper(zenEnvObj, data_type::bf16, bias_dt, true, false,
+                                false, M, K, N, 1.0f, a, K, b, N, (const char *)bias, false, 0, 0.0f,
+                                o, N, &out_scale, 1, zenEnvObj.zenWeightCache);
+    return status::success;
+}
+
+//u8s8: int8 GEMM with s32 accumulation, dequantized in place to
+//o = s32 * src_scale * wei_scale[n] + bias with f32 bias.
+//Row major (M, N) = (M, K) x (K, N) is column major (N, M) = (N, K) x (K, M).
+inline status_t zenAttention_Project(const uint8_t *a, const int8_t *b,
+                                     const void *bias, data_type_t bias_dt, float src_scale,
+                                     const scales_t &wei_scales, dim_t M, dim_t K, dim_t N, float *o) {
+    int32_t *acc = reinterpret_cast<int32_t *>(o);
+    const float alpha = 1.0f, beta = 0.0f;
+    const int8_t off_b = 0;
+    const uint8_t off_a = 0;
+    const int32_t off_c = 0;
+    status_t st = gemm_s8x8s32("N", "N", "F", &N, &M, &K, &alpha, b, &N, &off_b,
+                               a, &K, &off_a, &beta, acc, &N, &off_c);
+    if (st != status::success) {
+        return st;
+    }
+    const float *bias_f32 = (const float *)bias;
+    const bool per_oc = wei_scales.mask_ != 0;
+    parallel_nd(M, [&](dim_t m) {
+        const int32_t *acc_row = acc + m * N;
+        float *o_row = o + m * N;
+        for (dim_t n = 0; n < N; n++) {
+            o_row[n] = (float)acc_row[n] * src_scale
+                       * wei_scales.scales_[per_oc ? n : 0]
+                       + (bias_f32 ? bias_f32[n] : 0.0f);
+        }
+    });
+    return status::success;
+}
+
+} // namespace attention
+
+/* add new primitive */
+//data_type selects the input precision:
+// f32  : f32 everything
+// bf16 : bf16 query/key/value and weights, f32 or bf16 bias, bf16 Q/K/V
+//        projections, f32 or bf16 dst
+// u8   : u8 query/key/value, s8 weights, f32 bias, f32 projections, f32 or
+//        bf16 dst. Quantization scales are given as attr scales of the
+//        inputs (common) and the weights (common or per output channel).
+//Mask is f32 and the attention itself is accumulated in f32 for all of them.
+template <impl::data_type_t data_type, attention::flash_attention_kernel_t kernel>
+struct flash_attention_t : public primitive_t {
+    typedef typename prec_traits<data_type>::type src_data_t;
+    typedef typename prec_traits<data_type == zendnn::impl::data_type::u8
+    ? zendnn::impl::data_type::s8 : data_type>::type weights_data_t;
+    typedef typename std::conditional<data_type == zendnn::impl::data_type::bf16,
+            bfloat16_t, float>::type proj_data_t;
+
+    struct pd_t : public cpu_attention_pd_t {
+        using cpu_attention_pd_t::cpu_attention_pd_t;
+
+        DECLARE_COMMON_PD_T(kernel == attention::flash_kernel_v1 ? "flash_v1:any"
+                            : kernel == attention::flash_kernel_v2 ? "flash_v2:any"
+                            : "flash_grouped:any", flash_attention_t);
+
+        status_t init(engine_t *engine) {
+            using namespace format_tag;
+            using namespace alg_kind;
+            using namespace zendnn::impl::data_type;
+            memory_desc_wrapper query_mdw(this->src_md(ZENDNN_ARG_SRC_0));
+            memory_desc_wrapper key_mdw(this->src_md(ZENDNN_ARG_SRC_1));
+            memory_desc_wrapper value_mdw(this->src_md(ZENDNN_ARG_SRC_2));
+            memory_desc_wrapper mask_mdw(this->src_md(ZENDNN_ARG_MASK));
+            memory_desc_wrapper dst_mdw(this->dst_md(ZENDNN_ARG_DST));
+            const alg_kind_t alg = this->desc()->alg_kind;
+            const bool is_lowp = data_type != f32;
+            //There is no reference for bf16 and u8s8, v2 also serves plain
+            //multihead_attention for them. v1 accumulates in dst, f32 only.
+            bool alg_ok = kernel == attention::flash_kernel_v1
+                          ? alg == multihead_attention_flash_v1 && !is_lowp
+                          : kernel == attention::flash_kernel_v2
+                          ? alg == multihead_attention_flash_v2
+                          || (is_lowp && alg == multihead_attention)
+                          : utils::one_of(alg, multiquery_attention, groupedquery_attention);
+            bool ok = alg_ok && !this->is_decode()
+                      && platform::has_data_type_support(data_type)
+                      && this->desc()->num_heads > 0
+                      && dst_mdw.ndims() == 3 && mask_mdw.ndims() == 2
+                      && key_mdw.dims()[1] == value_mdw.dims()[1]
+                      && mask_mdw.dims()[1] == key_mdw.dims()[1]
+                      && query_mdw.dims()[1] == dst_mdw.dims()[1]
+                      && dst_mdw.dims()[2] >= this->desc()->num_heads
+                      && dst_mdw.dims()[2] % this->desc()->num_heads == 0
+                      && query_mdw.matches_tag(abc) && key_mdw.matches_tag(abc)
+                      && value_mdw.matches_tag(abc)
+                      && dst_mdw.matches_tag(abc) && mask_mdw.matches_tag(ab)
+                      && data_types_ok() && attr_ok();
+            if (!ok) {
+                return status::unimplemented;
+            }
+            //K and V weights give the number of K/V heads: N for multihead,
+            //1 for multi-query and a divisor of N for grouped-query attention
+            auto d = dims();
+            const dim_t kv_width = d.Nkv * d.H;
+            ok = this->src_md(ZENDNN_ARG_WEIGHTS_0)->dims[1] == d.ld
+                 && this->src_md(ZENDNN_ARG_WEIGHTS_1)->dims[1] == kv_width
+                 && this->src_md(ZENDNN_ARG_WEIGHTS_2)->dims[1] == kv_width
+                 && this->src_md(ZENDNN_ARG_WEIGHTS_0)->dims[0] == query_mdw.dims()[2]
+                 && this->src_md(ZENDNN_ARG_WEIGHTS_1)->dims[0] == key_mdw.dims()[2]
+                 && this->src_md(ZENDNN_ARG_WEIGHTS_2)->dims[0] == value_mdw.dims()[2]
+                 && d.Nkv > 0 && d.N % d.Nkv == 0
+                 && IMPLICATION(alg == multiquery_attention, d.Nkv == 1)
+                 && IMPLICATION(kernel != attention::flash_kernel_grouped,
+                                d.Nkv == d.N)
+                 && weights_scales_ok(ZENDNN_ARG_WEIGHTS_0, d.ld)
+                 && weights_scales_ok(ZENDNN_ARG_WEIGHTS_1, kv_width)
+                 && weights_scales_ok(ZENDNN_ARG_WEIGHTS_2, kv_width);
+            if (!ok) {
+                return status::unimplemented;
+            }
+
+            nthr_ = zendnn_get_max_threads();
+            init_scratchpad();
+            return status::success;
+        }
+
+        attention::flash_attention_dims_t dims() const {
+            memory_desc_wrapper dMD(this->dst_md(ZENDNN_ARG_DST));
+            memory_desc_wrapper kMD(this->src_md(ZENDNN_ARG_SRC_1));
+            attention::flash_attention_dims_t d;
+            d.B = dMD.dims()[0];
+            d.Sq = dMD.dims()[1];
+            d.Skv = kMD.dims()[1];
+            d.N = this->desc()->num_heads;
+            d.H = dMD.dims()[2] / d.N;
+            //init() refuses a head size of 0, keep dims() safe on such descs
+            d.Nkv = d.H ? this->src_md(ZENDNN_ARG_WEIGHTS_1)->dims[1] / d.H : 0;
+            d.ld = dMD.dims()[2];
+            d.ld_kv = d.Nkv * d.H;
+            return d;
+        }
+
+        //Bytes of the projected Q, K and V, the per thread tiles follow
+        size_t proj_bytes() const {
+            auto d = dims();
+            return utils::rnd_up((d.B * d.Sq * d.ld + 2 * d.B * d.Skv * d.ld_kv)
+                                 * sizeof(proj_data_t), 64);
+        }
+
+        int nthr_;
+
+        private:
+            bool data_types_ok() const {
+                using namespace zendnn::impl::data_type;
+                const data_type_t weights_dt = data_type == u8 ? s8 : data_type;
+                for (int arg : {
+                            ZENDNN_ARG_SRC_0, ZENDNN_ARG_SRC_1, ZENDNN_ARG_SRC_2
+                        }) {
+                    if (this->src_md(arg)->data_type != data_type) {
+                        return false;
+                    }
+                }
+                for (int arg : {
+                            ZENDNN_ARG_WEIGHTS_0, ZENDNN_ARG_WEIGHTS_1, ZENDNN_ARG_WEIGHTS_2
+                        }) {
+                    memory_desc_wrapper weights_mdw(this->src_md(arg));
+                    if (weights_mdw.data_type() != weights_dt
+                            || !weights_mdw.matches_tag(format_tag::ab)) {
+                        return false;
+                    }
+                }
+                for (int arg : {
+                            ZENDNN_ARG_BIAS_0, ZENDNN_ARG_BIAS_1, ZENDNN_ARG_BIAS_2
+                        }) {
+                    const data_type_t bias_dt = this->src_md(arg)->data_type;
+                    if (!utils::one_of(bias_dt, f32, undef)
+                            && !(data_type == bf16 && bias_dt == bf16)) {
+                        return false;
+                    }
+                }
+                const data_type_t dst_dt = this->dst_md(ZENDNN_ARG_DST)->data_type;
+                return this->src_md(ZENDNN_ARG_MASK)->data_type == f32
+                       && (dst_dt == f32 || (data_type != f32 && dst_dt == bf16));
+            }
+
+            bool attr_ok() const {
+                using namespace zendnn::impl::data_type;
+                if (data_type != u8) {
+                    return this->attr()->has_default_values();
+                }
+                //Scales of the projection inputs and weights only, the scales
+                //skip mask of has_default_values() covers SRC_0 and SRC_1
+                const auto *attr = this->attr();
+                if (!attr->output_scales_.has_default_values()
+                        || !attr->zero_points_.has_default_values()
+                        || !attr->post_ops_.has_default_values()
+                        || !attr->rnn_data_qparams_.has_default_values()
+                        || !attr->rnn_weights_qparams_.has_default_values()
+                        || !attr->rnn_weights_projection_qparams_.has_default_values()
+                        || !attr->scales_.has_default_values({ZENDNN_ARG_SRC_0,
+                                ZENDNN_ARG_SRC_1, ZENDNN_ARG_SRC_2, ZENDNN_ARG_WEIGHTS_0,
+                                ZENDNN_ARG_WEIGHTS_1, ZENDNN_ARG_WEIGHTS_2})) {
+                    return false;
+                }
+                for (int arg : {
+                            ZENDNN_ARG_SRC_0, ZENDNN_ARG_SRC_1, ZENDNN_ARG_SRC_2
+                        }) {
+                    const auto &s = this->attr()->scales_.get(arg);
+                    if (!s.defined() || s.mask_ != 0) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            //Weights scales are common or per output channel (dimension 1)
+            bool weights_scales_ok(int arg, dim_t width) const {
+                const auto &s = this->attr()->scales_.get(arg);
+                return s.defined()
+                       && (s.mask_ == 0 || (s.mask_ == (1 << 1) && s.count_ == width));
+            }
+
+            void init_scratchpad() {
+                auto scratchpad = scratchpad_registry().registrar();
+                auto d = dims();
+
+                //Projected Q, K and V plus one f32 tile set per thread, O(S*H)
+                auto scratchpad_size = proj_bytes() + nthr_ * sizeof(float)
+                                       * attention::zenFlashAttention_ThreadScratchSize(d, kernel);
+
+                zendnnInfo(ZENDNN_CORELOG, "init_scratchpad() ", this->name(),
+                           " scratchpad_size : ", scratchpad_size);
+
+                scratchpad.book(memory_tracking::names::key_attention,
+                    scratchpad_size, 1);
+            }
+    };
+    // constructor using pd_t
+    flash_attention_t(const pd_t *apd) : primitive_t(apd) {}
+
+    // init() override from primitive_t
+    status_t init(engine_t *engine) override {
+        return status::success;
+    }
+
+    // exec() override from primitive_t
+    status_t execute(const exec_ctx_t &ctx) const override {
+        return execute_flash(ctx);
+    }
+
+  private:
+    const pd_t *pd() const {
+        return (const pd_t *)primitive_t::pd().get();
+    }
+
+    status_t execute_flash(const exec_ctx_t &ctx) const;
+
+    template <typename dst_t>
+    void execute_kernel(const proj_data_t *q, const proj_data_t *k,
+                        const proj_data_t *v, const float *mask, float *thread_scratch,
+                        dst_t *dst) const;
+};
+
+template <impl::data_type_t data_type>
+using flash_attention_v1 = flash_attention_t<data_type,
+      attention::flash_kernel_v1>;
+template <impl::data_type_t data_type>
+using flash_attention_v2 = flash_attention_t<data_type,
+      attention::flash_kernel_v2>;
+//multiquery_attention and groupedquery_attention
+template <impl::data_type_t data_type>
+using grouped_attention_t = flash_attention_t<data_type,
+      attention::flash_kernel_grouped>;
+
+template<data_type_t data_type, attention::flash_attention_kernel_t kernel>
+template <typename dst_t>
+void flash_attention_t<data_type, kernel>::execute_kernel(
+    const proj_data_t *q, const proj_data_t *k, const proj_data_t *v,
+    const float *mask, float *thread_scratch, dst_t *dst) const {
+    auto d = pd()->dims();
+    auto scale = pd()->desc()->scale;
+    if (kernel == attention::flash_kernel_v1) {
+        //f32 only, checked by pd_t::init()
+        zendnn::impl::cpu::attention::zenFlashAttention_v1(
+            reinterpret_cast<const float *>(q), reinterpret_cast<const float *>(k),
+            reinterpret_cast<const float *>(v), mask, d, scale, pd()->nthr_,
+            thread_scratch, reinterpret_cast<float *>(dst));
+    }
+    else if (kernel == attention::flash_kernel_v2) {
+        zendnn::impl::cpu::attention::zenFlashAttention_v2(q, k, v, mask, d,
+                scale, pd()->nthr_, thread_scratch, dst);
+    }
+    else {
+        zendnn::impl::cpu::attention::zenFlashAttention_Grouped(q, k, v, mask, d,
+                scale, pd()->nthr_, thread_scratch, dst);
+    }
+}
+
+template<data_type_t data_type, attention::flash_attention_kernel_t kernel>
+status_t
+flash_attention_t<data_type, kernel>::execute_flash(const exec_ctx_t &ctx)
+const {
+    // get the tensors
+    auto query   = CTX_IN_MEM(const src_data_t *, ZENDNN_ARG_SRC_0);
+    auto key   = CTX_IN_MEM(const src_data_t *, ZENDNN_ARG_SRC_1);
+    auto value   = CTX_IN_MEM(const src_data_t *, ZENDNN_ARG_SRC_2);
+    auto weights_query   = CTX_IN_MEM(const weights_data_t *, ZENDNN_ARG_WEIGHTS_0);
+    auto weights_key   = CTX_IN_MEM(const weights_data_t *, ZENDNN_ARG_WEIGHTS_1);
+    auto weights_value   = CTX_IN_MEM(const weights_data_t *, ZENDNN_ARG_WEIGHTS_2);
+    auto bias_query   = CTX_IN_MEM(const void *, ZENDNN_ARG_BIAS_0);
+    auto bias_key   = CTX_IN_MEM(const void *, ZENDNN_ARG_BIAS_1);
+    auto bias_value   = CTX_IN_MEM(const void *, ZENDNN_ARG_BIAS_2);
+    auto mask  = CTX_IN_MEM(const float *, ZENDNN_ARG_MASK);
+    auto dst     = CTX_OUT_MEM(void *, ZENDNN_ARG_DST);
+
+    const auto scratchpad = ctx.get_scratchpad_grantor();
+    auto scratchpad_buf_base = scratchpad.template get<char>(
+                               memory_tracking::names::key_attention);
+
+    auto d = pd()->dims();
+    const auto &scales = pd()->attr()->scales_;
+    //Hidden sizes of the inputs, the K of the projections
+    const dim_t Eq = pd()->src_md(ZENDNN_ARG_SRC_0)->dims[2];
+    const dim_t Ek = pd()->src_md(ZENDNN_ARG_SRC_1)->dims[2];
+    const dim_t Ev = pd()->src_md(ZENDNN_ARG_SRC_2)->dims[2];
+
+    //Q projection is (B, S, N*H), K and V projections are (B, S, Nkv*H).
+    //Heads are read in place with the row stride, so no transposes are needed
+    auto scp_qBuff = reinterpret_cast<proj_data_t *>(scratchpad_buf_base);
+    auto scp_kBuff = scp_qBuff + d.B * d.Sq * d.ld;
+    auto scp_vBuff = scp_kBuff + d.B * d.Skv * d.ld_kv;
+    auto scp_thread = reinterpret_cast<float *>(scratchpad_buf_base
+                      + pd()->proj_bytes());
+
+    CHECK(zendnn::impl::cpu::attention::zenAttention_Project(query,
+            weights_query, bias_query, pd()->src_md(ZENDNN_ARG_BIAS_0)->data_type,
+            scales.get(ZENDNN_ARG_SRC_0).scales_[0],
+            scales.get(ZENDNN_ARG_WEIGHTS_0), d.B * d.Sq, Eq, d.ld, scp_qBuff));
+    CHECK(zendnn::impl::cpu::attention::zenAttention_Project(key,
+            weights_key, bias_key, pd()->src_md(ZENDNN_ARG_BIAS_1)->data_type,
+            scales.get(ZENDNN_ARG_SRC_1).scales_[0],
+            scales.get(ZENDNN_ARG_WEIGHTS_1), d.B * d.Skv, Ek, d.ld_kv,
+            scp_kBuff));
+    CHECK(zendnn::impl::cpu::attention::zenAttention_Project(value,
+            weights_value, bias_value, pd()->src_md(ZENDNN_ARG_BIAS_2)->data_type,
+            scales.get(ZENDNN_ARG_SRC_2).scales_[0],
+            scales.get(ZENDNN_ARG_WEIGHTS_2), d.B * d.Skv, Ev, d.ld_kv,
+            scp_vBuff));
+
+    if (pd()->dst_md(ZENDNN_ARG_DST)->data_type == zendnn::impl::data_type::bf16) {
+        execute_kernel(scp_qBuff, scp_kBuff, scp_vBuff, mask, scp_thread,
+                       static_cast<bfloat16_t *>(dst));
+    }
+    else {
+        execute_kernel(scp_qBuff, scp_kBuff, scp_vBuff, mask, scp_thread,
+                       static_cast<float *>(dst));
+    }
+    zendnnVerbose(ZENDNN_CORELOG, "[Custom] ", pd()->name(), " B:", d.B,
+                  " S:", d.Sq, " N:", d.N, " Nkv:", d.Nkv, " H:", d.H);
+    return status::success;
+}
+
+} // namespace cpu
+} // namespace impl
+} // namespace zendnn
+
+#endif
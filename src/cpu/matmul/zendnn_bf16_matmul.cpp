@@ -50,6 +50,9 @@
 
 #include "zendnn_logging.hpp"
 #include "common/zendnn_private.hpp"
+#include "common/zendnn_weight_cache.hpp"
+#include "common/zendnn_concurrent_map.hpp"
+#include "common/zendnn_tuning_db.hpp"
 #include "zendnn.hpp"
 
 #define NUM_BF16_ALGO 3
@@ -60,22 +63,40 @@ using namespace zendnn;
 using tag = memory::format_tag;
 using dt = memory::data_type;
 extern int graph_exe_count;
-extern std::mutex map_mutex;
-//Map for weight caching of jit Primitive(reordered memory)
-std::unordered_map<Key_matmul, zendnn::memory >
-matmul_weight_caching_map_jit;
-
-//AOCL weight caching map
-std::unordered_map<Key_matmul, int16_t * >
-matmul_weight_caching_map_aocl;
 
 //AutoTuner Simplified Map having Key as struct and value as Algo.
-std::unordered_map<Key_matmul, unsigned int>
+zenConcurrentMap<Key_matmul, unsigned int>
 matmul_kernel_map_bf16;
 
 //AutoTuner Helper map
-std::unordered_map<Key_matmul,std::tuple<unsigned int, float, unsigned int>>
-        matmul_kernel_map_bf16_helper;
+//Map value is tuple of (iteration count, execution time of algo, Algo Path)
+typedef std::tuple<unsigned int, float, unsigned int> matmul_map_bf16_value_t;
+zenConcurrentMap<Key_matmul, matmul_map_bf16_value_t>
+matmul_kernel_map_bf16_helper;
+
+//Set when a new layer is tuned, the tuning database is written once the
+//layer finishes evaluation (ZENDNN_MATMUL_PERSISTENT_MAP=1)
+static std::atomic<bool> bf16_persistent_map_dirty(false);
+
+//Records the tuned BF16 algos with their best time in the tuning database
+//and merges them into the file.
+static int bf16_map_write_to_file() {
+    const char *fname = zendnnTuningDB::getFile();
+    if (fname == NULL) {
+        fname = "key_matmul_map.csv";
+    }
+
+    zendnnTuningDB &tuning_db = zendnnTuningDB::ZenDNNTuningDB();
+    matmul_kernel_map_bf16.for_each([&](const Key_matmul &sobj,
+    unsigned int algo_type) {
+        matmul_map_bf16_value_t map_value;
+        float time_ms = matmul_kernel_map_bf16_helper.find(sobj, map_value) ?
+                        std::get<1>(map_value) : 0;
+        tuning_db.record(zenTuningKey(TUNING_OP_MATMUL_BF16, sobj), algo_type,
+                         time_ms);
+    });
+    return tuning_db.save(fname);
+}
 
 void zenMatMul_gemm_bf16bf16f32of32(
     const bool Layout,
@@ -112,8 +133,15 @@ void zenMatMul_gemm_bf16bf16f32of32(
     key_obj.weights = filter;
     key_obj.thread_count = thread_qty;
 
-    //finds object in map
-    auto found_obj = matmul_weight_caching_map_aocl.find(key_obj);
+    //finds object in weight cache
+    zendnnWeightCache &weight_cache = zendnnWeightCache::ZenDNNWeightCache();
+    Key_weight_cache cache_key = weight_cache.getKey(key_obj,
+                                 WEIGHT_CACHE_AOCL_BF16,
+                                 zenWeightSpan(transpose_filter, k, n, ldb, sizeof(int16_t)));
+    std::shared_ptr<int16_t> reorder_buf;
+    if (is_weights_const) {
+        reorder_buf = weight_cache.find_as<int16_t>(cache_key);
+    }
     // Blocked BLIS API for matmul
     // Set post_ops to NULL and define reorder_param0 as 'B' for B matrix
     // Define dimentions of B matrix as reorder_param1 and reorder_param2
@@ -132,22 +160,21 @@ void zenMatMul_gemm_bf16bf16f32of32(
     int16_t *reorder_filter = NULL;
 
     //Weight caching
-    if (!is_weights_const ||
-            found_obj == matmul_weight_caching_map_aocl.end()) {
+    if (!reorder_buf) {
         siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_bf16bf16f32of32(
                                           order, trans, reorder_param0, reorder_param1, reorder_param2);
         reorder_filter = (int16_t *) aligned_alloc(64,
                          b_reorder_buf_siz_req);
         aocl_reorder_bf16bf16f32of32(order, trans, 'B', filter, reorder_filter, k,
                                      n, ldb);
+        reorder_buf = std::shared_ptr<int16_t>(reorder_filter, free);
         //Create new entry
-        map_mutex.lock();
-        matmul_weight_caching_map_aocl[key_obj] = reorder_filter;
-        map_mutex.unlock();
-    }
-    else {
-        reorder_filter = matmul_weight_caching_map_aocl[key_obj];
+        if (is_weights_const) {
+            reorder_buf = weight_cache.insert_as<int16_t>(cache_key, reorder_buf,
+                          b_reorder_buf_siz_req);
+        }
     }
+    reorder_filter = reorder_buf.get();
     aocl_post_op *post_ops = NULL;
 
     int postop_count = 0;
@@ -237,9 +264,6 @@ void zenMatMul_gemm_bf16bf16f32of32(
         free(post_ops->seq_vector);
         free(post_ops);
     }
-    if (!is_weights_const) {
-        free(reorder_filter);
-    }
 #endif
 }
 
@@ -280,8 +304,15 @@ void zenMatMul_gemm_bf16bf16f32obf16(
     key_obj.weights = filter;
     key_obj.thread_count = thread_qty;
 
-    //finds object in map
-    auto found_obj = matmul_weight_caching_map_aocl.find(key_obj);
+    //finds object in weight cache
+    zendnnWeightCache &weight_cache = zendnnWeightCache::ZenDNNWeightCache();
+    Key_weight_cache cache_key = weight_cache.getKey(key_obj,
+                                 WEIGHT_CACHE_AOCL_BF16,
+                                 zenWeightSpan(transpose_filter, k, n, ldb, sizeof(int16_t)));
+    std::shared_ptr<int16_t> reorder_buf;
+    if (is_weights_const) {
+        reorder_buf = weight_cache.find_as<int16_t>(cache_key);
+    }
     // Blocked BLIS API for matmul
     // Set post_ops to NULL and define reorder_param0 as 'B' for B matrix
     // Define dimentions of B matrix as reorder_param1 and reorder_param2
@@ -299,22 +330,21 @@ void zenMatMul_gemm_bf16bf16f32obf16(
 
     int16_t *reorder_filter = NULL;
     //Weight caching
-    if (!is_weights_const ||
-            found_obj == matmul_weight_caching_map_aocl.end()) {
+    if (!reorder_buf) {
         siz_t b_reorder_buf_siz_req = aocl_get_reorder_buf_size_bf16bf16f32of32(
                                           order, trans, reorder_param0, reorder_param1, reorder_param2);
         reorder_filter = (int16_t *) aligned_alloc(64,
                          b_reorder_buf_siz_req);
         aocl_reorder_bf16bf16f32of32(order, trans, 'B',filter, reorder_filter, k,
                                      n, ldb);
+        reorder_buf = std::shared_ptr<int16_t>(reorder_filter, free);
         //Create new entry
-        map_mutex.lock();
-        matmul_weight_caching_map_aocl[key_obj] = reorder_filter;
-        map_mutex.unlock();
-    }
-    else {
-        reorder_filter = matmul_weight_caching_map_aocl[key_obj];
+        if (is_weights_const) {
+            reorder_buf = weight_cache.insert_as<int16_t>(cache_key, reorder_buf,
+                          b_reorder_buf_siz_req);
+        }
     }
+    reorder_filter = reorder_buf.get();
     //Post ops addition
     aocl_post_op *post_ops = NULL;
 
@@ -469,9 +499,6 @@ void zenMatMul_gemm_bf16bf16f32obf16(
 
         free(post_ops);
     }
-    if (!is_weights_const) {
-        free(reorder_filter);
-    }
 #endif
 }
 
@@ -506,9 +533,6 @@ void zenMatMulPrimitiveBF16(zendnnEnv zenEnvObj, int dst_type, int bias_type,
     key_obj_reorder.weights = B_Array;
     key_obj_reorder.thread_count = zenEnvObj.omp_num_threads;
 
-    //finds object in map
-    auto found_obj_reorder = matmul_weight_caching_map_jit.find(key_obj_reorder);
-
     std::vector<primitive> net;
     std::vector<std::unordered_map<int, memory>> net_args;
 
@@ -597,18 +621,27 @@ void zenMatMulPrimitiveBF16(zendnnEnv zenEnvObj, int dst_type, int bias_type,
     //Weight reordering
     zendnn::memory reordered_weights_memory;
     if (blocked_format) {
-        if (!is_weights_const ||
-                found_obj_reorder == matmul_weight_caching_map_jit.end()) {
+        zendnnWeightCache &weight_cache = zendnnWeightCache::ZenDNNWeightCache();
+        Key_weight_cache cache_key = weight_cache.getKey(key_obj_reorder,
+                                     WEIGHT_CACHE_JIT_BF16,
+                                     zenWeightSpan(TransB, K, N, ldb, sizeof(int16_t)));
+        std::shared_ptr<zendnn::memory> cached_weights;
+        if (is_weights_const) {
+            cached_weights = weight_cache.find_as<zendnn::memory>(cache_key);
+        }
+        if (!cached_weights) {
             reordered_weights_memory = memory(matmul_prim_disc.weights_desc(), eng);
             reorder(user_weights_memory, reordered_weights_memory).execute(engine_stream,
                     user_weights_memory, reordered_weights_memory);
-            //Save in map
-            map_mutex.lock();
-            matmul_weight_caching_map_jit[key_obj_reorder] = reordered_weights_memory;
-            map_mutex.unlock();
+            //Save in weight cache
+            if (is_weights_const) {
+                weight_cache.insert_as<zendnn::memory>(cache_key,
+                                                       std::make_shared<zendnn::memory>(reordered_weights_memory),
+                                                       matmul_prim_disc.weights_desc().get_size());
+            }
         }
         else {
-            reordered_weights_memory = matmul_weight_caching_map_jit[key_obj_reorder];
+            reordered_weights_memory = *cached_weights;
         }
     }
 
@@ -782,14 +815,48 @@ int auto_compute_matmul_bf16(
     key_obj_auto.ldb = ldb;
     key_obj_auto.ldc = ldc;
 
+    //Persistent Map
+    //{ 0: disable, 1: write, 2:read }
+    unsigned int persistent_map =
+        zendnnTuningDB::getMode("ZENDNN_MATMUL_PERSISTENT_MAP");
+
     //This condition makes sure that address
     //doesn't gets saved while using persistent map.
     unsigned int map_type =
         zendnn::zendnn_getenv_int("ZENDNN_GEMM_MAP_TYPE",0);
-    key_obj_auto.weights =
-        map_type == 1 ? weights : NULL;
+    key_obj_auto.weights = map_type == 1 &&
+                           persistent_map == zenTuningDBMode::TUNING_DB_DISABLE ? weights : NULL;
     key_obj_auto.thread_count = zenEnvObj.omp_num_threads;
 
+    //Read operation from File (Persistent Map)
+    if (persistent_map == zenTuningDBMode::TUNING_DB_READ) {
+        zendnnTuningDB &tuning_db = zendnnTuningDB::ZenDNNTuningDB();
+        static std::once_flag map_read;
+        std::call_once(map_read, [&] {
+            if (tuning_db.load(zendnnTuningDB::getFile())) {
+                zendnnError(ZENDNN_ALGOLOG,
+                            "Persistent Map File Not Found or invalid value in file. Persistent feature won't work. Set ZENDNN_MATMUL_MAP_FILE environment variable. Executing with default algo.");
+            }
+        });
+        //Layers missing from the file run the default algo. The choice is
+        //cached so that the database is only searched once per layer.
+        unsigned int map_algo = zenBF16MatMulAlgoType::MATMUL_AOCL_GEMM;
+        if (!matmul_kernel_map_bf16.find(key_obj_auto, map_algo)) {
+            zenTuningRecord record;
+            if (tuning_db.find(zenTuningKey(TUNING_OP_MATMUL_BF16, key_obj_auto),
+                               record)) {
+                map_algo = record.algo;
+            }
+            matmul_kernel_map_bf16.insert(key_obj_auto, map_algo);
+        }
+        zenEnvObj.zenBF16GEMMalgo = map_algo;
+        matmul_bf16_wrapper(zenEnvObj, dst_type, bias_type, Layout, transpose_input,
+                            transpose_filter,
+                            M, K, N, alpha, src, lda, weights, ldb, bias, has_eltwise_relu,
+                            geluType, beta, dst, ldc, output_scales, scale_size, is_weights_const);
+        return zenEnvObj.zenBF16GEMMalgo;
+    }
+
     float cur_algo_time; //current algorithm's execution time
     struct timeval start_n, end_n;
 
@@ -803,20 +870,21 @@ int auto_compute_matmul_bf16(
         zendnn::zendnn_getenv_int("ZENDNN_MATMUL_EVALUATE_ITER_BF16",
                                   MATMUL_EVALUATE_ITER_BF16);
 
-    //finds object in map
-    auto found_obj = matmul_kernel_map_bf16_helper.find(key_obj_auto);
+    //finds object in map, map_value is a snapshot of the entry
+    matmul_map_bf16_value_t map_value;
+    bool found_obj = matmul_kernel_map_bf16_helper.find(key_obj_auto, map_value);
 
     //If current iterations less than Skip iteration then run default algo.
     //Checks using the (0) element of map value that denotes count of iterations in map
-    if (found_obj == matmul_kernel_map_bf16_helper.end() ||
-            std::get<0>(found_obj->second) < skip_iteration) {
+    if (!found_obj ||
+            std::get<0>(map_value) < skip_iteration) {
 
         zendnnVerbose(ZENDNN_PROFLOG,"AutoTuner BF16 SKIP Iteration");
         //Set aocl gemm initially
         zenEnvObj.zenBF16GEMMalgo = zenBF16MatMulAlgoType::MATMUL_AOCL_GEMM;
 
         //If Key not found in map then time the algo and add new element to map
-        if (found_obj == matmul_kernel_map_bf16_helper.end()) {
+        if (!found_obj) {
 
             //Time start
 #ifdef _WIN32
@@ -842,12 +910,18 @@ int auto_compute_matmul_bf16(
 #endif
 
             //Create new entry
-            matmul_kernel_map_bf16_helper[key_obj_auto] = {1, cur_algo_time, zenBF16MatMulAlgoType::MATMUL_AOCL_GEMM}; // {iter_count, time, algo}
-            matmul_kernel_map_bf16[key_obj_auto] = zenBF16MatMulAlgoType::MATMUL_AOCL_GEMM;
+            matmul_kernel_map_bf16_helper.insert(key_obj_auto, matmul_map_bf16_value_t(1,
+                                                 cur_algo_time, zenBF16MatMulAlgoType::MATMUL_AOCL_GEMM)); // {iter_count, time, algo}
+            matmul_kernel_map_bf16.insert(key_obj_auto,
+                                          zenBF16MatMulAlgoType::MATMUL_AOCL_GEMM);
+            bf16_persistent_map_dirty = true;
         }
         //If key found then increment the iter_count and run aocl algo.
         else {
-            std::get<0>(found_obj->second) += 1;
+            matmul_kernel_map_bf16_helper.update(key_obj_auto, map_value,
+            [](matmul_map_bf16_value_t &value) {
+                std::get<0>(value) += 1;
+            });
             matmul_bf16_wrapper(zenEnvObj, dst_type, bias_type, Layout, transpose_input,
                                 transpose_filter,
                                 M, K, N, alpha, src, lda, weights, ldb, bias, has_eltwise_relu,
@@ -857,9 +931,20 @@ int auto_compute_matmul_bf16(
     }
     //Read Value from map.
     //Runs after skip iterations and evaluation iterations are done.
-    else if (std::get<0>(found_obj->second) > evaluate_iteration + skip_iteration) {
+    else if (std::get<0>(map_value) > evaluate_iteration + skip_iteration) {
         //Get best algo for given layer from MAP
-        zenEnvObj.zenBF16GEMMalgo = matmul_kernel_map_bf16[key_obj_auto];
+        unsigned int map_algo = zenBF16MatMulAlgoType::MATMUL_AOCL_GEMM;
+        matmul_kernel_map_bf16.find(key_obj_auto, map_algo);
+        zenEnvObj.zenBF16GEMMalgo = map_algo;
+
+        //Write the map once the new layers are tuned
+        if (persistent_map == zenTuningDBMode::TUNING_DB_WRITE &&
+                bf16_persistent_map_dirty.exchange(false)) {
+            if (bf16_map_write_to_file()) {
+                zendnnError(ZENDNN_ALGOLOG,
+                            "Error occured while writing Persistent Map File. Check the file");
+            }
+        }
 
         matmul_bf16_wrapper(zenEnvObj, dst_type, bias_type, Layout, transpose_input,
                             transpose_filter,
@@ -870,9 +955,14 @@ int auto_compute_matmul_bf16(
     else {
 
         //Get the number of iteration already ran and select Algo to run for current iteration
-        //get<0>(found_obj->second) = count of iteration
-        zenEnvObj.zenBF16GEMMalgo = (std::get<0>(found_obj->second)%NUM_BF16_ALGO) +1;
-        std::get<0>(found_obj->second) += 1;
+        //get<0>(map_value) = count of iteration
+        unsigned int eval_algo = zenBF16MatMulAlgoType::MATMUL_AOCL_GEMM;
+        matmul_kernel_map_bf16_helper.update(key_obj_auto, map_value,
+        [&](matmul_map_bf16_value_t &value) {
+            eval_algo = (std::get<0>(value)%NUM_BF16_ALGO) +1;
+            std::get<0>(value) += 1;
+        });
+        zenEnvObj.zenBF16GEMMalgo = eval_algo;
         //timer start
 #ifdef _WIN32
         auto start_n = std::chrono::high_resolution_clock::now();
@@ -898,12 +988,16 @@ int auto_compute_matmul_bf16(
         zendnnVerbose(ZENDNN_PROFLOG,"AutoTuner BF16 Evaluate Iteration algo:",
                       zenEnvObj.zenBF16GEMMalgo, " time:",cur_algo_time);
         //If current run gives better timing then update
-        if (cur_algo_time < std::get<1>(found_obj->second)) {
-            std::get<1>(found_obj->second) = cur_algo_time; //Minimum time for chosen algo
-            std::get<2>(found_obj->second) =
-                zenEnvObj.zenBF16GEMMalgo; //Algo with minimum time (1-NUM_OF_ALGO)
-            matmul_kernel_map_bf16[key_obj_auto] = zenEnvObj.zenBF16GEMMalgo;
-        }
+        //Best algo is published under the helper shard lock so that a slower
+        //concurrent evaluation can not overwrite it
+        matmul_kernel_map_bf16_helper.update(key_obj_auto, map_value,
+        [&](matmul_map_bf16_value_t &value) {
+            if (cur_algo_time < std::get<1>(value)) {
+                std::get<1>(value) = cur_algo_time; //Minimum time for chosen algo
+                std::get<2>(value) = eval_algo; //Algo with minimum time (1-NUM_OF_ALGO)
+                matmul_kernel_map_bf16.insert_or_assign(key_obj_auto, eval_algo);
+            }
+        });
 
     }
     return zenEnvObj.zenBF16GEMMalgo;
@@ -1134,3 +1228,50 @@ template struct zendnn_bf16_matmul_t<data_type::bf16>;
 } // namespace cpu
 } // namespace impl
 } // namespace zendnn
+
+namespace zendnn {
+
+int zendnnTuneMatMulBF16(bool transpose_input, bool transpose_weights, int m,
+                         int k, int n, int lda, int ldb, int ldc, unsigned int thread_count,
+                         unsigned int iterations) {
+    using namespace zendnn::impl;
+    if (m <= 0 || k <= 0 || n <= 0 || thread_count == 0 ||
+            lda < (transpose_input ? m : k) || ldb < (transpose_weights ? k : n) ||
+            ldc < n) {
+        return -1;
+    }
+    zendnnEnv zenEnvObj = readEnv();
+    zenEnvObj.omp_num_threads = thread_count;
+
+    std::vector<bfloat16_t> input((size_t)(transpose_input ? k : m) * lda,
+                                  bfloat16_t(0.5f));
+    std::vector<bfloat16_t> weights((size_t)(transpose_weights ? n : k) * ldb,
+                                    bfloat16_t(0.25f));
+    std::vector<float> output((size_t)m * ldc);
+    float output_scale = 1.0f;
+
+    Key_matmul key_obj;
+    key_obj.transpose_input = transpose_input;
+    key_obj.transpose_weights = transpose_weights;
+    key_obj.m = m;
+    key_obj.k = k;
+    key_obj.n = n;
+    key_obj.lda = lda;
+    key_obj.ldb = ldb;
+    key_obj.ldc = ldc;
+    key_obj.weights = NULL;
+    key_obj.thread_count = thread_count;
+
+    unsigned int algo = zenTuningSweep(zenTuningKey(TUNING_OP_MATMUL_BF16, key_obj),
+                                       NUM_BF16_ALGO, iterations, [&](unsigned int eval_algo) {
+        zenEnvObj.zenBF16GEMMalgo = eval_algo;
+        cpu::matmul::matmul_bf16_wrapper(zenEnvObj, data_type::f32, data_type::undef,
+                                         true, transpose_input, transpose_weights, m, k, n, 1.0f,
+                                         input.data(), lda, weights.data(), ldb, NULL, false, 0, 0.0f,
+                                         output.data(), ldc, &output_scale, 1, true);
+    });
+    zendnnInvalidateWeights(weights.data());
+    return algo;
+}
+
+}
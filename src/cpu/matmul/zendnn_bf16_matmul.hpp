@@ -34,11 +34,41 @@
 #include "cpu/matmul/cpu_matmul_pd.hpp"
 #include "cpu/matmul/gemm_based_common.hpp"
 
+#include "zendnn_helper.hpp"
+
 namespace zendnn {
 namespace impl {
 namespace cpu {
 namespace matmul {
 
+//BF16 GEMM dispatched on zenEnvObj.zenBF16GEMMalgo: AOCL LPGEMM when built
+//with it, (blocked) BRGEMM otherwise. dst_type and bias_type are f32 or bf16.
+int matmul_bf16_wrapper(
+    zendnn::zendnnEnv zenEnvObj,
+    int dst_type,
+    int bias_type,
+    const bool Layout,
+    const bool transA,
+    const bool transB,
+    const int M,
+    const int K,
+    const int N,
+    const float alpha,
+    const zendnn::impl::bfloat16_t *src,
+    const int lda,
+    const zendnn::impl::bfloat16_t *weights,
+    const int ldb,
+    const char *bias,
+    const bool has_eltwise_relu,
+    const int geluType,
+    const float beta,
+    void *dst,
+    const int ldc,
+    const float *output_scales,
+    const int scale_size,
+    bool is_weights_const
+);
+
 template <impl::data_type_t dst_type>
 struct zendnn_bf16_matmul_t : public primitive_t {
     struct pd_t : public cpu_matmul_pd_t {
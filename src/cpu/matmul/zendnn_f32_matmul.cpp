@@ -26,6 +26,12 @@
 #include <math.h>
 #include <vector>
 
+#ifndef ZENDNN_USE_AOCL_BLIS_API
+    #include <cblas.h>
+#else // ZENDNN_USE_AOCL_BLIS_API
+    #include "cblas_with_blis_api.hpp"
+#endif // ZENDNN_USE_AOCL_BLIS_API
+
 #include "common/c_types_map.hpp"
 #include "common/zendnn_thread.hpp"
 #include "common/type_helpers.hpp"
@@ -36,6 +42,7 @@
 #include "cpu/gemm/gemm.hpp"
 
 #include "cpu/binary_injector_utils.hpp"
+#include "cpu/primitive_attr_postops.hpp"
 #include "cpu/matmul/gemm_f32_matmul.hpp"
 #include "cpu/matmul/matmul_utils.hpp"
 #include "cpu/matmul/zendnn_f32_matmul.hpp"
@@ -86,7 +93,24 @@ status_t zendnn_f32_matmul_t::pd_t::init(engine_t *engine) {
             = matmul_helper_t(src_md(), weights_md(), dst_md())
               .can_fuse_src_batch_dims();
 
-    return check_and_configure_attributes();
+    CHECK(check_and_configure_attributes());
+
+    nthr_ = zendnn_get_max_threads();
+    if (post_ops_chain_) {
+        // One accumulator tile per thread, or one matrix when a sum reads
+        // dst after a single GEMM; otherwise that GEMM writes to dst
+        size_t acc_size = (size_t)nthr_ * chain_tile_m_ * N();
+        if (chain_one_gemm_) {
+            acc_size = attr()->post_ops_.find(primitive_kind::sum) >= 0 ?
+                       (size_t)M() * N() : 0;
+        }
+        if (acc_size) {
+            auto scratchpad = scratchpad_registry().registrar();
+            scratchpad.book(memory_tracking::names::key_matmul_dst_in_acc_dt,
+                            acc_size, sizeof(acc_data_t));
+        }
+    }
+    return status::success;
 }
 
 // temporary solution to deal with format `any`
@@ -138,18 +162,59 @@ status_t zendnn_f32_matmul_t::pd_t::check_and_configure_attributes() {
         auto check_sum = [&](int idx) -> bool {
             return p.contain(sum, idx) && params_.gemm_applies_output_scales_;
         };
+        // ReLU and GeLU are the activations the ZenDNN GEMM calls fuse
+        auto check_eltwise = [&](int idx) -> bool {
+            return p.contain(eltwise, idx) && (p.entry_[idx].is_relu()
+                                               || (p.entry_[idx].is_eltwise(true)
+                                                   && utils::one_of(p.entry_[idx].eltwise.alg,
+                                                           alg_kind::eltwise_gelu, alg_kind::eltwise_gelu_erf)));
+        };
         switch (p.len()) {
         case 0:
             return true;
         case 1:
-            return check_sum(0) || p.contain(eltwise, 0);
+            return check_sum(0) || check_eltwise(0);
         case 2:
-            return check_sum(0) && p.contain(eltwise, 1);
+            return check_sum(0) && check_eltwise(1);
         default:
             return false;
         }
     };
 
+    // Any order of sum, eltwise and binary post-ops, with binary src1 in
+    // f32 and broadcast along any dimension of dst
+    auto check_post_ops_chain = [&]() -> bool {
+        const auto &p = attr()->post_ops_;
+        if (attr()->output_scales_.mask_ != 0 || has_runtime_dims_or_strides()) {
+            return false;
+        }
+        const memory_desc_wrapper dst_d(dst_md());
+        for (int idx = 0; idx < p.len(); idx++) {
+            const auto &e = p.entry_[idx];
+            if (e.is_sum(false, false)) {
+                if (!utils::one_of(e.sum.dt, data_type::undef, f32)) {
+                    return false;
+                }
+            }
+            else if (e.is_binary()) {
+                const memory_desc_wrapper src1_d(e.binary.src1_desc);
+                if (src1_d.data_type() != f32 || src1_d.ndims() != dst_d.ndims()
+                        || src1_d.format_any() || !src1_d.is_plain()) {
+                    return false;
+                }
+                for (int d = 0; d < dst_d.ndims(); d++) {
+                    if (src1_d.dims()[d] != 1 && src1_d.dims()[d] != dst_d.dims()[d]) {
+                        return false;
+                    }
+                }
+            }
+            else if (!e.is_eltwise()) {
+                return false;
+            }
+        }
+        return true;
+    };
+
     // check basic attributes
     if (!check_attr_oscale()) {
         return status::unimplemented;
@@ -179,6 +244,19 @@ status_t zendnn_f32_matmul_t::pd_t::check_and_configure_attributes() {
             po.entry_.erase(po.entry_.begin());
         }
     }
+    else if (check_post_ops_chain()) {
+        post_ops_chain_ = true;
+        // Rows of src, of the accumulator tile and of dst stay in L2, each
+        // tile packs B again so large B gets one GEMM for all rows
+        chain_tile_m_ = zenPostOpsTileRows((unsigned long)(K() + 2 * N()) * sizeof(
+                                               float), M(), (unsigned long)K() * N() * sizeof(float),
+                                           (unsigned long)N() * sizeof(float));
+        const dim_t batch = utils::array_product(dst_md()->dims, ndims() - 2);
+        chain_one_gemm_ = batch * utils::div_up(M(), chain_tile_m_)
+                          < zendnn_get_max_threads();
+        params_.has_pp_kernel_ = false;
+        return status::success;
+    }
     else {
         return status::unimplemented;
     }
@@ -362,6 +440,11 @@ status_t zendnn_f32_matmul_t::execute_ref(const exec_ctx_t &ctx) const {
     int *dst_offsets = dst_off.data();
     int *weight_offsets = wei_off.data();
 
+    if (pd()->post_ops_chain()) {
+        return execute_post_ops_chain(ctx, alpha, input_offsets, weight_offsets,
+                                      dst_offsets);
+    }
+
     if ((float *)bias == NULL) {
         //MatMul without Bias
         zenMatMul(Layout, strcmp(transA, "N"),strcmp(transB, "N"), batch, input_offsets,
@@ -414,6 +497,171 @@ status_t zendnn_f32_matmul_t::execute_ref(const exec_ctx_t &ctx) const {
     return status::success;
 }
 
+status_t zendnn_f32_matmul_t::execute_post_ops_chain(const exec_ctx_t &ctx,
+        float alpha, const int *input_offsets, const int *weight_offsets,
+        const int *dst_offsets) const {
+    using namespace primitive_kind;
+
+    auto src = CTX_IN_MEM(const src_data_t *, ZENDNN_ARG_SRC);
+    auto weights = CTX_IN_MEM(const weights_data_t *, ZENDNN_ARG_WEIGHTS);
+    auto bias = CTX_IN_MEM(const float *, ZENDNN_ARG_BIAS);
+    auto dst = CTX_OUT_MEM(dst_data_t *, ZENDNN_ARG_DST);
+
+    const auto src_d = ctx.memory_mdw(ZENDNN_ARG_SRC, pd()->src_md());
+    const auto weights_d = ctx.memory_mdw(ZENDNN_ARG_WEIGHTS, pd()->weights_md());
+    const auto dst_d = ctx.memory_mdw(ZENDNN_ARG_DST, pd()->dst_md());
+
+    matmul_helper_t helper(src_d, weights_d, dst_d);
+    const int ndims = pd()->ndims();
+    const dim_t M = helper.M();
+    const dim_t N = helper.N();
+    const dim_t K = helper.K();
+    const dim_t batch = helper.batch();
+    const bool transA = helper.transA() == 'T';
+    const bool transB = helper.transB() == 'T';
+    const dim_t lda = helper.lda();
+    const dim_t ldb = helper.ldb();
+    const dim_t ldc = helper.ldc();
+
+    // Binary src1 strides, 0 along broadcast dimensions
+    const auto &po = pd()->attr()->post_ops_;
+    std::vector<const float *> src1(po.len(), nullptr);
+    std::vector<dim_t> src1_strides(po.len() * ndims);
+    for (int idx = 0; idx < po.len(); idx++) {
+        if (!po.entry_[idx].is_binary()) {
+            continue;
+        }
+        const memory_desc_wrapper src1_d(po.entry_[idx].binary.src1_desc);
+        src1[idx] = CTX_IN_MEM(const float *,
+                               ZENDNN_ARG_ATTR_MULTIPLE_POST_OP(idx) | ZENDNN_ARG_SRC_1);
+        for (int d = 0; d < ndims; d++) {
+            src1_strides[idx * ndims + d] = src1_d.dims()[d] == 1 && dst_d.dims()[d] != 1
+                                   ? 0 : src1_d.blocking_desc().strides[d];
+        }
+    }
+
+    const dim_t tile_m = pd()->chain_tile_m();
+    const dim_t m_tiles = utils::div_up(M, tile_m);
+    acc_data_t *acc_base = ctx.get_scratchpad_grantor().template get<acc_data_t>
+                           (memory_tracking::names::key_matmul_dst_in_acc_dt);
+
+    zendnnVerbose(ZENDNN_CORELOG,
+                  "zendnn_f32_matmul_t::execute_post_ops_chain M: ", M, " N: ", N,
+                  " K: ", K, " batch: ", batch, " tile_m: ", tile_m, " one_gemm: ",
+                  pd()->chain_one_gemm(), " post_ops: ", po.len());
+
+    // rows x N block of the product, starting at row m0 of matrix b
+    auto gemm = [&](dim_t b, dim_t m0, dim_t rows, acc_data_t *acc,
+    dim_t ld_acc) {
+        cblas_sgemm(CblasRowMajor, transA ? CblasTrans : CblasNoTrans,
+                    transB ? CblasTrans : CblasNoTrans, rows, N, K, alpha,
+                    src + input_offsets[b] + (transA ? m0 : m0 * lda), lda,
+                    weights + weight_offsets[b], ldb, 0.0f, acc, ld_acc);
+    };
+    // Bias and the chain on row m of matrix b, res may alias out
+    auto apply_chain = [&](dim_t b, dim_t m, acc_data_t *res,
+    dst_data_t *out) {
+        // Position of this matrix in the batch dimensions of dst
+        dims_t pos = {0};
+        utils::l_dims_by_l_offset(pos, b, dst_d.dims(), ndims - 2);
+        if (bias) {
+            ZENDNN_PRAGMA_OMP_SIMD()
+            for (dim_t n = 0; n < N; n++) {
+                res[n] += alpha * bias[n];
+            }
+        }
+        for (int idx = 0; idx < po.len(); idx++) {
+            const auto &e = po.entry_[idx];
+            if (e.kind == sum) {
+                const float scale = e.sum.scale;
+                const float zero_point = (float)e.sum.zero_point;
+                ZENDNN_PRAGMA_OMP_SIMD()
+                for (dim_t n = 0; n < N; n++) {
+                    res[n] += scale * (out[n] - zero_point);
+                }
+            }
+            else if (e.kind == eltwise) {
+                if (e.is_relu(false, false)) {
+                    const float nslope = e.eltwise.alpha;
+                    const float scale = e.eltwise.scale;
+                    ZENDNN_PRAGMA_OMP_SIMD()
+                    for (dim_t n = 0; n < N; n++) {
+                        res[n] = scale * (res[n] > 0.f ? res[n] : nslope * res[n]);
+                    }
+                }
+                else {
+                    for (dim_t n = 0; n < N; n++) {
+                        res[n] = e.eltwise.scale * compute_eltwise_scalar_fwd(
+                                     e.eltwise.alg, res[n], e.eltwise.alpha,
+                                     e.eltwise.beta);
+                    }
+                }
+            }
+            else {
+                const dim_t *strides = &src1_strides[idx * ndims];
+                dim_t off = m * strides[ndims - 2];
+                for (int d = 0; d < ndims - 2; d++) {
+                    off += pos[d] * strides[d];
+                }
+                const float *rhs = src1[idx] + off;
+                const dim_t rhs_stride = strides[ndims - 1];
+                if (e.binary.alg == alg_kind::binary_add) {
+                    ZENDNN_PRAGMA_OMP_SIMD()
+                    for (dim_t n = 0; n < N; n++) {
+                        res[n] += rhs[n * rhs_stride];
+                    }
+                }
+                else if (e.binary.alg == alg_kind::binary_mul) {
+                    ZENDNN_PRAGMA_OMP_SIMD()
+                    for (dim_t n = 0; n < N; n++) {
+                        res[n] *= rhs[n * rhs_stride];
+                    }
+                }
+                else {
+                    for (dim_t n = 0; n < N; n++) {
+                        res[n] = compute_binary_scalar(e.binary.alg, res[n],
+                                                       rhs[n * rhs_stride]);
+                    }
+                }
+            }
+        }
+        if (res != out) {
+            ZENDNN_PRAGMA_OMP_SIMD()
+            for (dim_t n = 0; n < N; n++) {
+                out[n] = res[n];
+            }
+        }
+    };
+
+    if (pd()->chain_one_gemm()) {
+        // Threaded GEMM over the whole matrix, into dst unless a sum still
+        // has to read it
+        for (dim_t b = 0; b < batch; b++) {
+            acc_data_t *acc = acc_base ? acc_base : dst + dst_offsets[b];
+            const dim_t ld_acc = acc_base ? N : ldc;
+            gemm(b, 0, M, acc, ld_acc);
+            parallel_nd(M, [&](dim_t m) {
+                apply_chain(b, m, acc + m * ld_acc, dst + dst_offsets[b] + m * ldc);
+            });
+        }
+        return status::success;
+    }
+
+    parallel(pd()->nthr_, [&](int ithr, int nthr) {
+        acc_data_t *acc = acc_base + (size_t)ithr * tile_m * N;
+        for_nd(ithr, nthr, batch, m_tiles, [&](dim_t b, dim_t t) {
+            const dim_t m0 = t * tile_m;
+            const dim_t rows = nstl::min(tile_m, M - m0);
+            gemm(b, m0, rows, acc, N);
+            for (dim_t i = 0; i < rows; i++) {
+                apply_chain(b, m0 + i, acc + i * N, dst + dst_offsets[b] + (m0 + i) * ldc);
+            }
+        });
+    });
+
+    return status::success;
+}
+
 } // namespace matmul
 } // namespace cpu
 } // namespace impl
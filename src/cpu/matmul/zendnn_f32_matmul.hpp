@@ -48,9 +48,19 @@ struct zendnn_f32_matmul_t : public primitive_t {
         const gemm_based::params_t &params() const { return params_; }
         int nthr_; // To not exceed the limit in execute used for set up.
         bool set_default_formats();
+        bool post_ops_chain() const { return post_ops_chain_; }
+        dim_t chain_tile_m() const { return chain_tile_m_; }
+        bool chain_one_gemm() const { return chain_one_gemm_; }
     private:
         status_t check_and_configure_attributes();
         gemm_based::params_t params_;
+        // Post-op chains the ZenDNN GEMM calls do not fuse are applied on
+        // each tile of chain_tile_m_ rows right after its GEMM. With too few
+        // tiles for the threads every matrix is one threaded GEMM instead,
+        // followed by the chain on its rows.
+        bool post_ops_chain_ = false;
+        dim_t chain_tile_m_ = 0;
+        bool chain_one_gemm_ = false;
     };
 
     zendnn_f32_matmul_t(const pd_t *apd) : primitive_t(apd) {}
@@ -87,6 +97,9 @@ struct zendnn_f32_matmul_t : public primitive_t {
 private:
     const pd_t *pd() const { return (const pd_t *)primitive_t::pd().get(); }
     status_t execute_ref(const exec_ctx_t &ctx) const;
+    status_t execute_post_ops_chain(const exec_ctx_t &ctx, float alpha,
+                                    const int *input_offsets, const int *weight_offsets,
+                                    const int *dst_offsets) const;
 
     std::unique_ptr<inner_product_utils::pp_kernel_t> pp_kernel_;
 };
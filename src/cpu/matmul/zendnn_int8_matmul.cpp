@@ -0,0 +1,490 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#include <memory>
+#include <vector>
+
+#include "common/c_types_map.hpp"
+#include "common/zendnn_thread.hpp"
+#include "common/type_helpers.hpp"
+#include "common/utils.hpp"
+
+#include "cpu/cpu_primitive.hpp"
+#include "cpu/primitive_attr_postops.hpp"
+#include "cpu/ref_io_helper.hpp"
+#include "cpu/simple_q10n.hpp"
+
+#include "cpu/matmul/gemm_based_common.hpp"
+#include "cpu/matmul/matmul_utils.hpp"
+#include "cpu/matmul/zendnn_int8_matmul.hpp"
+
+#include "zendnn_logging.hpp"
+#include "common/zendnn_private.hpp"
+#include "common/zendnn_weight_cache.hpp"
+
+namespace zendnn {
+namespace impl {
+namespace cpu {
+namespace matmul {
+
+using namespace data_type;
+
+status_t zendnn_int8_matmul_t::pd_t::init(engine_t *engine) {
+    zendnnVerbose(ZENDNN_CORELOG, "zendnn_int8_matmul_t::pd_t::init()");
+#ifdef ZENDNN_ENABLE_LPGEMM
+    using smask_t = primitive_attr_t::skip_mask_t;
+    const auto dst_type = dst_md()->data_type;
+
+    bool ok = utils::one_of(src_md()->data_type, u8, s8)
+              && weights_md()->data_type == s8
+              && desc()->accum_data_type == s32
+              && utils::one_of(dst_type, s8, u8, s32, f32, bf16)
+              && IMPLICATION(with_bias(),
+                             utils::one_of(weights_md(1)->data_type, f32, s32, s8, u8)
+                             && is_bias_1xN())
+              && ndims() <= 3
+              && attr()->has_default_values(smask_t::oscale_runtime
+                                            | smask_t::zero_points_runtime
+                                            | smask_t::post_ops | smask_t::sum_dt,
+                                            dst_type)
+              && attr()->post_ops_.check_sum_consistent_dt(dst_type)
+              && (attr()->output_scales_.mask_ == 0
+                  || attr()->output_scales_.mask_ == (1 << (ndims() - 1)))
+              && attr_zero_points_ok() && attr_post_ops_ok()
+              && !has_runtime_dims_or_strides()
+              && set_default_formats()
+              && gemm_based::check_gemm_compatible_formats(*this);
+
+    zendnnOpInfo &obj = zendnnOpInfo::ZenDNNOpInfo();
+    if (obj.is_brgemm) {
+        return status::unimplemented;
+    }
+    if (!ok) {
+        return status::unimplemented;
+    }
+
+    // LPGEMM reads A row major; B is transposed only by the 4.2 API
+    matmul_helper_t helper(src_md(), weights_md(), dst_md());
+    if (helper.transA() == 'T') {
+        return status::unimplemented;
+    }
+#ifndef ZENDNN_ENABLE_LPGEMM_V4_2
+    if (helper.transB() == 'T') {
+        return status::unimplemented;
+    }
+#endif
+    // Weights are shared by the whole batch or given per batch entry
+    if (ndims() == 3 && !utils::one_of(weights_md()->dims[0], 1,
+                                       dst_md()->dims[0])) {
+        return status::unimplemented;
+    }
+
+    nthr_ = zendnn_get_max_threads();
+    // Rows of src, of the s32 tile and of dst stay in L2, each tile reads
+    // the reordered B again so large B gets one GEMM for all rows
+    tile_m_ = zenPostOpsTileRows((unsigned long)K() + N() * (sizeof(int32_t) +
+                                 types::data_type_size(dst_type)), M(), (unsigned long)K() * N(),
+                                 (unsigned long)N() * sizeof(int32_t));
+    const dim_t batch = utils::array_product(dst_md()->dims, ndims() - 2);
+    one_gemm_ = batch * utils::div_up(M(), tile_m_) < nthr_;
+
+    // One s32 tile and one f32 row per thread, or the whole s32 product
+    auto scratchpad = scratchpad_registry().registrar();
+    scratchpad.book(memory_tracking::names::key_matmul_dst_in_acc_dt,
+                    one_gemm_ ? (size_t)M() * N() : (size_t)nthr_ * tile_m_ * N(),
+                    sizeof(int32_t));
+    scratchpad.book(memory_tracking::names::key_gemm_tmp_buffer,
+                    (size_t)nthr_ * N(), sizeof(float));
+    return status::success;
+#else
+    return status::unimplemented;
+#endif
+}
+
+bool zendnn_int8_matmul_t::pd_t::attr_post_ops_ok() const {
+    const auto &p = attr()->post_ops_;
+    for (int idx = 0; idx < p.len(); idx++) {
+        if (!p.entry_[idx].is_sum(false, false) && !p.entry_[idx].is_eltwise()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool zendnn_int8_matmul_t::pd_t::attr_zero_points_ok() const {
+    // Common source and dst zero points, no weights zero point
+    int mask_src = 0, mask_dst = 0;
+    attr()->zero_points_.get(ZENDNN_ARG_SRC, nullptr, &mask_src, nullptr);
+    attr()->zero_points_.get(ZENDNN_ARG_DST, nullptr, &mask_dst, nullptr);
+    return mask_src == 0 && mask_dst == 0
+           && attr()->zero_points_.has_default_values(ZENDNN_ARG_WEIGHTS);
+}
+
+namespace {
+
+// Reordered B for the LPGEMM kernel of the source type, from the weight
+// cache when the weights are constant
+std::shared_ptr<int8_t> zenReorderWeightsS8(bool src_u8, bool transB,
+        const int8_t *weights, dim_t K, dim_t N, dim_t ldb,
+        bool is_weights_const) {
+    Key_matmul key_obj;
+    key_obj.transpose_input = false;
+    key_obj.transpose_weights = transB;
+    key_obj.m = 0;
+    key_obj.k = K;
+    key_obj.n = N;
+    key_obj.lda = 0;
+    key_obj.ldb = ldb;
+    key_obj.ldc = 0;
+    key_obj.weights = weights;
+    key_obj.thread_count = 0;
+
+    zendnnWeightCache &weight_cache = zendnnWeightCache::ZenDNNWeightCache();
+    Key_weight_cache cache_key = weight_cache.getKey(key_obj,
+                                 src_u8 ? WEIGHT_CACHE_AOCL_U8S8 : WEIGHT_CACHE_AOCL_S8S8,
+                                 zenWeightSpan(transB, K, N, ldb, sizeof(int8_t)));
+    std::shared_ptr<int8_t> reorder_buf;
+    if (is_weights_const) {
+        reorder_buf = weight_cache.find_as<int8_t>(cache_key);
+        if (reorder_buf) {
+            return reorder_buf;
+        }
+    }
+
+#ifdef ZENDNN_ENABLE_LPGEMM
+#ifdef ZENDNN_ENABLE_LPGEMM_V4_2
+    const char order = 'r';
+    const char trans = transB ? 't' : 'n';
+#endif
+    siz_t b_reorder_buf_siz_req = src_u8 ?
+                                  aocl_get_reorder_buf_size_u8s8s32os32(
+#ifdef ZENDNN_ENABLE_LPGEMM_V4_2
+                                      order, trans,
+#endif
+                                      'B', K, N) :
+                                  aocl_get_reorder_buf_size_s8s8s32os32(
+#ifdef ZENDNN_ENABLE_LPGEMM_V4_2
+                                      order, trans,
+#endif
+                                      'B', K, N);
+    int8_t *reorder_filter = (int8_t *)aligned_alloc(64, b_reorder_buf_siz_req);
+    if (src_u8) {
+        aocl_reorder_u8s8s32os32(
+#ifdef ZENDNN_ENABLE_LPGEMM_V4_2
+            order, trans,
+#endif
+            'B', weights, reorder_filter, K, N, ldb);
+    }
+    else {
+        aocl_reorder_s8s8s32os32(
+#ifdef ZENDNN_ENABLE_LPGEMM_V4_2
+            order, trans,
+#endif
+            'B', weights, reorder_filter, K, N, ldb);
+    }
+    reorder_buf = std::shared_ptr<int8_t>(reorder_filter, free);
+    if (is_weights_const) {
+        reorder_buf = weight_cache.insert_as<int8_t>(cache_key, reorder_buf,
+                      b_reorder_buf_siz_req);
+    }
+#endif
+    return reorder_buf;
+}
+
+// Sum over K of every column of B, the source zero point times this is
+// subtracted from the accumulator
+std::shared_ptr<int32_t> zenWeightsColSumS8(bool transB,
+        const int8_t *weights, dim_t K, dim_t N, dim_t ldb,
+        bool is_weights_const) {
+    Key_matmul key_obj;
+    key_obj.transpose_input = false;
+    key_obj.transpose_weights = transB;
+    key_obj.m = 0;
+    key_obj.k = K;
+    key_obj.n = N;
+    key_obj.lda = 0;
+    key_obj.ldb = ldb;
+    key_obj.ldc = 0;
+    key_obj.weights = weights;
+    key_obj.thread_count = 0;
+
+    zendnnWeightCache &weight_cache = zendnnWeightCache::ZenDNNWeightCache();
+    Key_weight_cache cache_key = weight_cache.getKey(key_obj,
+                                 WEIGHT_CACHE_S8_COLSUM,
+                                 zenWeightSpan(transB, K, N, ldb, sizeof(int8_t)));
+    std::shared_ptr<int32_t> col_sum;
+    if (is_weights_const) {
+        col_sum = weight_cache.find_as<int32_t>(cache_key);
+        if (col_sum) {
+            return col_sum;
+        }
+    }
+
+    col_sum = std::shared_ptr<int32_t>(new int32_t[N],
+                                       std::default_delete<int32_t[]>());
+    int32_t *sums = col_sum.get();
+    parallel_nd(N, [&](dim_t n) {
+        int32_t sum = 0;
+        for (dim_t k = 0; k < K; k++) {
+            sum += transB ? weights[n * ldb + k] : weights[k * ldb + n];
+        }
+        sums[n] = sum;
+    });
+    if (is_weights_const) {
+        col_sum = weight_cache.insert_as<int32_t>(cache_key, col_sum,
+                  N * sizeof(int32_t));
+    }
+    return col_sum;
+}
+
+template <typename dst_t>
+void zenRequantizeRow(const int32_t *acc, float *res, dim_t N,
+                      const int32_t *col_sum, int32_t src_zero_point, const float *bias,
+                      const float *scales, dim_t scale_stride, const post_ops_t &po,
+                      float dst_zero_point, dst_t *out) {
+    if (col_sum) {
+        ZENDNN_PRAGMA_OMP_SIMD()
+        for (dim_t n = 0; n < N; n++) {
+            res[n] = (float)(acc[n] - src_zero_point * col_sum[n]);
+        }
+    }
+    else {
+        ZENDNN_PRAGMA_OMP_SIMD()
+        for (dim_t n = 0; n < N; n++) {
+            res[n] = (float)acc[n];
+        }
+    }
+    if (bias) {
+        ZENDNN_PRAGMA_OMP_SIMD()
+        for (dim_t n = 0; n < N; n++) {
+            res[n] += bias[n];
+        }
+    }
+    ZENDNN_PRAGMA_OMP_SIMD()
+    for (dim_t n = 0; n < N; n++) {
+        res[n] *= scales[scale_stride * n];
+    }
+    for (int idx = 0; idx < po.len(); idx++) {
+        const auto &e = po.entry_[idx];
+        if (e.kind == primitive_kind::sum) {
+            // Sum reads dst before it is overwritten, in the sum data type
+            // that may differ from dst in signedness
+            const float scale = e.sum.scale;
+            const float zero_point = (float)e.sum.zero_point;
+            const data_type_t sum_dt = e.sum.dt == data_type::undef ?
+                                       data_traits<dst_t>::data_type : e.sum.dt;
+            if (sum_dt == data_traits<dst_t>::data_type) {
+                ZENDNN_PRAGMA_OMP_SIMD()
+                for (dim_t n = 0; n < N; n++) {
+                    res[n] += scale * ((float)out[n] - zero_point);
+                }
+            }
+            else {
+                for (dim_t n = 0; n < N; n++) {
+                    res[n] += scale * (io::load_float_value(sum_dt, out, n) - zero_point);
+                }
+            }
+        }
+        else if (e.is_relu(false, false)) {
+            const float nslope = e.eltwise.alpha;
+            const float scale = e.eltwise.scale;
+            ZENDNN_PRAGMA_OMP_SIMD()
+            for (dim_t n = 0; n < N; n++) {
+                res[n] = scale * (res[n] > 0.f ? res[n] : nslope * res[n]);
+            }
+        }
+        else {
+            for (dim_t n = 0; n < N; n++) {
+                res[n] = e.eltwise.scale * compute_eltwise_scalar_fwd(e.eltwise.alg,
+                         res[n], e.eltwise.alpha, e.eltwise.beta);
+            }
+        }
+    }
+    for (dim_t n = 0; n < N; n++) {
+        out[n] = saturate_and_round<dst_t>(res[n] + dst_zero_point);
+    }
+}
+
+} // namespace
+
+status_t zendnn_int8_matmul_t::execute_lpgemm(const exec_ctx_t &ctx) const {
+#ifdef ZENDNN_ENABLE_LPGEMM
+    auto src = CTX_IN_MEM(const void *, ZENDNN_ARG_SRC);
+    auto weights = CTX_IN_MEM(const int8_t *, ZENDNN_ARG_WEIGHTS);
+    auto bias = CTX_IN_MEM(const void *, ZENDNN_ARG_BIAS);
+    auto dst = CTX_OUT_MEM(void *, ZENDNN_ARG_DST);
+
+    DEFINE_SCALES_BUFFER(scales);
+    DEFINE_ZERO_POINT_VALUE(src_zero_point, ZENDNN_ARG_SRC);
+    DEFINE_ZERO_POINT_VALUE(dst_zero_point, ZENDNN_ARG_DST);
+
+    const auto src_d = ctx.memory_mdw(ZENDNN_ARG_SRC, pd()->src_md());
+    const auto weights_d = ctx.memory_mdw(ZENDNN_ARG_WEIGHTS, pd()->weights_md());
+    const auto dst_d = ctx.memory_mdw(ZENDNN_ARG_DST, pd()->dst_md());
+
+    matmul_helper_t helper(src_d, weights_d, dst_d);
+    const int ndims = pd()->ndims();
+    const dim_t M = helper.M();
+    const dim_t N = helper.N();
+    const dim_t K = helper.K();
+    const dim_t batch = helper.batch();
+    const bool transB = helper.transB() == 'T';
+    const dim_t lda = helper.lda();
+    const dim_t ldb = helper.ldb();
+    const dim_t ldc = helper.ldc();
+
+    const bool src_u8 = src_d.data_type() == u8;
+    const data_type_t dst_type = dst_d.data_type();
+    const size_t dst_size = types::data_type_size(dst_type);
+    const dim_t src_batch_stride = ndims == 3 ? src_d.blocking_desc().strides[0] :
+                                   0;
+    const dim_t dst_batch_stride = ndims == 3 ? dst_d.blocking_desc().strides[0] :
+                                   0;
+    const dim_t wei_batch = ndims == 3 ? weights_d.dims()[0] : 1;
+    const dim_t wei_batch_stride = wei_batch > 1 ?
+                                   weights_d.blocking_desc().strides[0] : 0;
+
+    zendnnEnv zenEnvObj = readEnv();
+    bool is_weights_const = zenEnvObj.zenWeightCache ||
+                            pd()->weights_md()->is_memory_const;
+
+    std::vector<std::shared_ptr<int8_t>> reorder_bufs(wei_batch);
+    std::vector<std::shared_ptr<int32_t>> col_sums(wei_batch);
+    for (dim_t b = 0; b < wei_batch; b++) {
+        reorder_bufs[b] = zenReorderWeightsS8(src_u8, transB,
+                                              weights + b * wei_batch_stride, K, N, ldb, is_weights_const);
+        if (src_zero_point != 0) {
+            col_sums[b] = zenWeightsColSumS8(transB, weights + b * wei_batch_stride, K,
+                                             N, ldb, is_weights_const);
+        }
+    }
+
+    // Bias in f32, the type the tile is requantized in
+    std::vector<float> bias_f32;
+    const float *bias_ptr = nullptr;
+    if (bias) {
+        const data_type_t bias_type = pd()->weights_md(1)->data_type;
+        if (bias_type == f32) {
+            bias_ptr = (const float *)bias;
+        }
+        else {
+            bias_f32.resize(N);
+            for (dim_t n = 0; n < N; n++) {
+                bias_f32[n] = io::load_float_value(bias_type, bias, n);
+            }
+            bias_ptr = bias_f32.data();
+        }
+    }
+    const dim_t scale_stride = pd()->attr()->output_scales_.mask_ == 0 ? 0 : 1;
+    const post_ops_t &po = pd()->attr()->post_ops_;
+
+    const dim_t tile_m = pd()->tile_m_;
+    const dim_t m_tiles = utils::div_up(M, tile_m);
+    const int nthr = pd()->nthr_;
+    int32_t *acc_base = ctx.get_scratchpad_grantor().template get<int32_t>
+                        (memory_tracking::names::key_matmul_dst_in_acc_dt);
+    float *row_base = ctx.get_scratchpad_grantor().template get<float>
+                      (memory_tracking::names::key_gemm_tmp_buffer);
+
+    zendnnVerbose(ZENDNN_CORELOG, "zendnn_int8_matmul_t::execute_lpgemm M: ", M,
+                  " N: ", N, " K: ", K, " batch: ", batch, " src: ",
+                  src_u8 ? "u8" : "s8", " dst: ", dst_type, " tile_m: ", tile_m,
+                  " one_gemm: ", pd()->one_gemm_, " src_zero_point: ", src_zero_point,
+                  " dst_zero_point: ", dst_zero_point,
+                  " post_ops: ", po.len());
+
+    // rows x N block of the s32 product, starting at row m0 of batch b
+    auto gemm = [&](dim_t b, dim_t m0, dim_t rows, int32_t *acc) {
+        const dim_t wb = wei_batch > 1 ? b : 0;
+        const size_t src_off = b * src_batch_stride + m0 * lda;
+        if (src_u8) {
+            aocl_gemm_u8s8s32os32('r', 'n', transB ? 't' : 'n', rows, N, K, 1,
+                                  (const uint8_t *)src + src_off, lda, 'n',
+                                  reorder_bufs[wb].get(), ldb, 'r', 0, acc, N, NULL);
+        }
+        else {
+            aocl_gemm_s8s8s32os32('r', 'n', transB ? 't' : 'n', rows, N, K, 1,
+                                  (const int8_t *)src + src_off, lda, 'n',
+                                  reorder_bufs[wb].get(), ldb, 'r', 0, acc, N, NULL);
+        }
+    };
+    auto requantize = [&](dim_t b, dim_t m, const int32_t *acc, float *res) {
+        const dim_t wb = wei_batch > 1 ? b : 0;
+        char *out = (char *)dst + (b * dst_batch_stride + m * ldc) * dst_size;
+        const int32_t *col_sum = col_sums[wb].get();
+        switch (dst_type) {
+        case s8:
+            zenRequantizeRow(acc, res, N, col_sum, src_zero_point, bias_ptr, scales,
+                             scale_stride, po, (float)dst_zero_point, (int8_t *)out);
+            break;
+        case u8:
+            zenRequantizeRow(acc, res, N, col_sum, src_zero_point, bias_ptr, scales,
+                             scale_stride, po, (float)dst_zero_point, (uint8_t *)out);
+            break;
+        case s32:
+            zenRequantizeRow(acc, res, N, col_sum, src_zero_point, bias_ptr, scales,
+                             scale_stride, po, (float)dst_zero_point, (int32_t *)out);
+            break;
+        case f32:
+            zenRequantizeRow(acc, res, N, col_sum, src_zero_point, bias_ptr, scales,
+                             scale_stride, po, (float)dst_zero_point, (float *)out);
+            break;
+        default:
+            zenRequantizeRow(acc, res, N, col_sum, src_zero_point, bias_ptr, scales,
+                             scale_stride, po, (float)dst_zero_point, (bfloat16_t *)out);
+            break;
+        }
+    };
+
+    if (!pd()->one_gemm_) {
+        parallel(nthr, [&](int ithr, int nthr) {
+            int32_t *acc = acc_base + (size_t)ithr * tile_m * N;
+            float *res = row_base + (size_t)ithr * N;
+            for_nd(ithr, nthr, batch, m_tiles, [&](dim_t b, dim_t t) {
+                const dim_t m0 = t * tile_m;
+                const dim_t rows = nstl::min(tile_m, M - m0);
+                gemm(b, m0, rows, acc);
+                for (dim_t i = 0; i < rows; i++) {
+                    requantize(b, m0 + i, acc + i * N, res);
+                }
+            });
+        });
+    }
+    else {
+        // Too few tiles for the threads or B too large to read per tile:
+        // LPGEMM threads the whole matrix and the rows are requantized in
+        // parallel
+        for (dim_t b = 0; b < batch; b++) {
+            gemm(b, 0, M, acc_base);
+            parallel(nthr, [&](int ithr, int nthr) {
+                float *res = row_base + (size_t)ithr * N;
+                for_nd(ithr, nthr, M, [&](dim_t m) {
+                    requantize(b, m, acc_base + m * N, res);
+                });
+            });
+        }
+    }
+    return status::success;
+#else
+    return status::unimplemented;
+#endif
+}
+
+} // namespace matmul
+} // namespace cpu
+} // namespace impl
+} // namespace zendnn
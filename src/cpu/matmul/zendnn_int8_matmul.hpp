@@ -0,0 +1,75 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef ZENDNN_INT8_MATMUL_HPP
+#define ZENDNN_INT8_MATMUL_HPP
+
+#include <assert.h>
+
+#include "common/c_types_map.hpp"
+#include "common/primitive.hpp"
+#include "common/type_helpers.hpp"
+
+#include "cpu/matmul/cpu_matmul_pd.hpp"
+
+namespace zendnn {
+namespace impl {
+namespace cpu {
+namespace matmul {
+
+//u8/s8 x s8 MatMul on the AOCL LPGEMM s32 kernels, with the B matrix
+//reordered once and kept in the weight cache. Every thread multiplies
+//tiles of tile_m_ rows into an s32 accumulator and requantizes the tile
+//while it is in cache: source zero point compensation, bias, per tensor or
+//per channel output scales, sum and eltwise post-ops and the dst zero
+//point, stored as s8, u8, s32, f32 or bf16.
+struct zendnn_int8_matmul_t : public primitive_t {
+    struct pd_t : public cpu_matmul_pd_t {
+        using cpu_matmul_pd_t::cpu_matmul_pd_t;
+
+        DECLARE_COMMON_PD_T("zendnn_int8", zendnn_int8_matmul_t);
+
+        status_t init(engine_t *engine);
+
+        int nthr_; // To not exceed the limit in execute used for set up.
+        dim_t tile_m_;
+        bool one_gemm_; // One GEMM per batch entry instead of row tiles
+
+      private:
+        bool attr_post_ops_ok() const;
+        bool attr_zero_points_ok() const;
+    };
+
+    zendnn_int8_matmul_t(const pd_t *apd) : primitive_t(apd) {}
+
+    status_t execute(const exec_ctx_t &ctx) const override {
+        return execute_lpgemm(ctx);
+    }
+
+  private:
+    const pd_t *pd() const {
+        return (const pd_t *)primitive_t::pd().get();
+    }
+    status_t execute_lpgemm(const exec_ctx_t &ctx) const;
+};
+
+} // namespace matmul
+} // namespace cpu
+} // namespace impl
+} // namespace zendnn
+
+#endif
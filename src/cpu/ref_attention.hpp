@@ -327,7 +327,18 @@ struct ref_attention_t : public primitive_t {
         DECLARE_COMMON_PD_T("ref:any", ref_attention_t);
 
         status_t init(engine_t *engine) {
-            if (!platform::has_data_type_support(data_type)) {
+            if (!platform::has_data_type_support(data_type)
+                    || this->src_md(ZENDNN_ARG_SRC_0)->data_type != data_type
+                    || this->src_md(ZENDNN_ARG_WEIGHTS_0)->data_type != data_type
+                    || this->dst_md(ZENDNN_ARG_DST)->data_type != data_type) {
+                return status::unimplemented;
+            }
+            //Shared K/V heads are handled by grouped_attention_t and KV
+            //cache decode by decode_attention_t only
+            if (utils::one_of(this->desc()->alg_kind,
+                              alg_kind::multiquery_attention,
+                              alg_kind::groupedquery_attention)
+                    || this->is_decode()) {
                 return status::unimplemented;
             }
 
@@ -40,7 +40,9 @@ namespace impl {
 namespace cpu {
 
 /* add new primitive */
-template <impl::data_type_t data_type>
+// idx_type is the data type of the indices and the offsets, s32 or s64
+template <impl::data_type_t data_type,
+          impl::data_type_t idx_type = impl::data_type::s32>
 struct ref_embedding_bag_t : public primitive_t {
     struct pd_t : public cpu_embedding_bag_pd_t {
         using cpu_embedding_bag_pd_t::cpu_embedding_bag_pd_t;
@@ -64,8 +66,8 @@ struct ref_embedding_bag_t : public primitive_t {
     }
 
     using input_type   = typename prec_traits<data_type>::type;
-    using indices_type = int32_t;
-    using offsets_type = int32_t;
+    using indices_type = typename prec_traits<idx_type>::type;
+    using offsets_type = typename prec_traits<idx_type>::type;
     using dst_type     = input_type;
 
     // exec() override from primitive_t
@@ -80,9 +82,9 @@ struct ref_embedding_bag_t : public primitive_t {
     status_t execute_ref(const exec_ctx_t &ctx) const;
 };
 
-template<data_type_t data_type>
+template<data_type_t data_type, data_type_t idx_type>
 status_t
-ref_embedding_bag_t<data_type>::execute_ref(const exec_ctx_t &ctx) const {
+ref_embedding_bag_t<data_type, idx_type>::execute_ref(const exec_ctx_t &ctx) const {
     status_t status = status::success;
 
     // get algorithm params
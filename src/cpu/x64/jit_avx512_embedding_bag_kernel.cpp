@@ -0,0 +1,187 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#include <limits>
+
+#include "cpu/x64/jit_avx512_embedding_bag_kernel.hpp"
+
+namespace zendnn {
+namespace impl {
+namespace cpu {
+namespace x64 {
+
+using namespace Xbyak;
+
+void jit_avx512_embedding_bag_kernel_t::load_index(
+        const Reg64 &reg, const Reg64 &reg_pos) {
+    if (conf_.idx_dt == data_type::s64)
+        mov(reg, qword[reg_indices + reg_pos * sizeof(int64_t)]);
+    else
+        movsxd(reg, dword[reg_indices + reg_pos * sizeof(int32_t)]);
+}
+
+// Prefetches every cache line of the row looked up prefetch_dist ahead
+void jit_avx512_embedding_bag_kernel_t::prefetch_row() {
+    const int row_bytes = conf_.width * src_dt_size();
+    Label no_prefetch;
+    lea(reg_tmp, ptr[reg_i + conf_.prefetch_dist]);
+    cmp(reg_tmp, reg_pf_count);
+    jge(no_prefetch, T_NEAR);
+    load_index(reg_pf_row, reg_tmp);
+    imul(reg_pf_row, reg_pf_row, row_bytes);
+    add(reg_pf_row, reg_input);
+    for (int line = 0; line < row_bytes; line += 64)
+        prefetcht0(ptr[reg_pf_row + line]);
+    L(no_prefetch);
+}
+
+// Reduces columns [vec_first * simd_w, (vec_first + nvecs) * simd_w) of the
+// bag in zmm0..zmm(nvecs - 1) and stores them, the last vector masked when
+// tail is set
+void jit_avx512_embedding_bag_kernel_t::reduce_block(
+        int vec_first, int nvecs, bool tail) {
+    const bool is_max = conf_.alg == alg_kind::embedding_bag_max;
+    const bool is_mean = conf_.alg == alg_kind::embedding_bag_mean;
+    const int row_bytes = conf_.width * src_dt_size();
+
+    if (is_max) {
+        mov(reg_tmp.cvt32(),
+                float2int(-std::numeric_limits<float>::infinity()));
+        vmovd(xmm_tmp, reg_tmp.cvt32());
+        vbroadcastss(zmm_src, xmm_tmp);
+        for (int v = 0; v < nvecs; v++)
+            vmovups(Zmm(v), zmm_src);
+    } else {
+        for (int v = 0; v < nvecs; v++)
+            vpxord(Zmm(v), Zmm(v), Zmm(v));
+    }
+    xor_(reg_valid, reg_valid);
+    xor_(reg_i, reg_i);
+
+    Label loop, skip, end;
+    L(loop);
+    {
+        cmp(reg_i, reg_count);
+        jge(end, T_NEAR);
+        if (conf_.prefetch_dist > 0 && vec_first == 0) prefetch_row();
+
+        load_index(reg_row, reg_i);
+        if (conf_.padidx >= 0) {
+            mov(reg_tmp, conf_.padidx);
+            cmp(reg_row, reg_tmp);
+            je(skip, T_NEAR);
+        }
+        imul(reg_row, reg_row, row_bytes);
+        add(reg_row, reg_input);
+        if (conf_.is_weights)
+            vbroadcastss(zmm_weight, ptr[reg_weights + reg_i * sizeof(float)]);
+
+        for (int v = 0; v < nvecs; v++) {
+            const Zmm acc = Zmm(v);
+            const bool masked = tail && v == nvecs - 1;
+            const auto src_addr = ptr[reg_row
+                    + (vec_first + v) * simd_w * src_dt_size()];
+            // f32 rows are used from memory, bf16 rows are widened first
+            if (conf_.src_dt == data_type::f32) {
+                if (masked) vmovups(zmm_src | k_tail | T_z, src_addr);
+            } else {
+                if (masked)
+                    vpmovzxwd(zmm_src | k_tail | T_z, src_addr);
+                else
+                    vpmovzxwd(zmm_src, src_addr);
+                vpslld(zmm_src, zmm_src, 16);
+            }
+            const bool from_reg = masked || conf_.src_dt != data_type::f32;
+            const Operand &src = from_reg ? static_cast<const Operand &>(zmm_src)
+                                          : static_cast<const Operand &>(src_addr);
+            if (is_max)
+                vmaxps(acc, acc, src);
+            else if (conf_.is_weights)
+                vfmadd231ps(acc, zmm_weight, src);
+            else
+                vaddps(acc, acc, src);
+        }
+        inc(reg_valid);
+
+        L(skip);
+        inc(reg_i);
+        jmp(loop, T_NEAR);
+    }
+    L(end);
+
+    // Bags without rows are stored as zeros
+    if (is_mean) {
+        Label no_rows;
+        test(reg_valid, reg_valid);
+        jz(no_rows, T_NEAR);
+        mov(reg_tmp.cvt32(), float2int(1.0f));
+        vmovd(xmm_scale, reg_tmp.cvt32());
+        vcvtsi2ss(xmm_tmp, xmm_tmp, reg_valid);
+        vdivss(xmm_scale, xmm_scale, xmm_tmp);
+        vbroadcastss(zmm_scale, xmm_scale);
+        for (int v = 0; v < nvecs; v++)
+            vmulps(Zmm(v), Zmm(v), zmm_scale);
+        L(no_rows);
+    }
+    if (is_max) {
+        Label has_rows;
+        test(reg_valid, reg_valid);
+        jnz(has_rows, T_NEAR);
+        for (int v = 0; v < nvecs; v++)
+            vpxord(Zmm(v), Zmm(v), Zmm(v));
+        L(has_rows);
+    }
+
+    for (int v = 0; v < nvecs; v++) {
+        const auto dst_addr
+                = ptr[reg_dst + (vec_first + v) * simd_w * sizeof(float)];
+        if (tail && v == nvecs - 1)
+            vmovups(dst_addr | k_tail, Zmm(v));
+        else
+            vmovups(dst_addr, Zmm(v));
+    }
+}
+
+void jit_avx512_embedding_bag_kernel_t::generate() {
+    preamble();
+#define PARAM_OFF(x) offsetof(jit_emb_bag_call_s, x)
+    mov(reg_input, ptr[reg_param + PARAM_OFF(input)]);
+    mov(reg_indices, ptr[reg_param + PARAM_OFF(indices)]);
+    mov(reg_weights, ptr[reg_param + PARAM_OFF(weights)]);
+    mov(reg_dst, ptr[reg_param + PARAM_OFF(dst)]);
+    mov(reg_count, ptr[reg_param + PARAM_OFF(count)]);
+    mov(reg_pf_count, ptr[reg_param + PARAM_OFF(prefetch_count)]);
+#undef PARAM_OFF
+
+    const int nvecs = utils::div_up(conf_.width, simd_w);
+    const int tail = conf_.width % simd_w;
+    if (tail) {
+        mov(reg_tmp.cvt32(), (1 << tail) - 1);
+        kmovw(k_tail, reg_tmp.cvt32());
+    }
+    for (int v = 0; v < nvecs; v += max_acc_vecs) {
+        const int block = nstl::min(max_acc_vecs, nvecs - v);
+        reduce_block(v, block, tail && v + block == nvecs);
+    }
+
+    postamble();
+}
+
+} // namespace x64
+} // namespace cpu
+} // namespace impl
+} // namespace zendnn
@@ -0,0 +1,106 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#ifndef CPU_X64_JIT_AVX512_EMBEDDING_BAG_KERNEL_HPP
+#define CPU_X64_JIT_AVX512_EMBEDDING_BAG_KERNEL_HPP
+
+#include "common/c_types_map.hpp"
+#include "common/utils.hpp"
+
+#include "cpu/x64/jit_generator.hpp"
+
+namespace zendnn {
+namespace impl {
+namespace cpu {
+namespace x64 {
+
+// Embedding bag kernel generated for one table width, table data type (f32
+// or bf16 stored as s16), index data type and reduction. A call reduces one
+// bag into f32; the row is kept in zmm accumulators, at most
+// max_acc_vecs of them, wider rows walk the bag once per block of columns.
+struct jit_emb_bag_conf_t {
+    int64_t width;
+    data_type_t src_dt;
+    data_type_t idx_dt;
+    alg_kind_t alg;
+    bool is_weights;
+    int64_t padidx;         // < 0 when there is no padding index
+    int prefetch_dist;      // lookups prefetched ahead, 0 disables
+};
+
+struct jit_emb_bag_call_s {
+    const void *input;
+    const void *indices;    // first index of the bag
+    const float *weights;   // first weight of the bag
+    float *dst;
+    int64_t count;          // indices in the bag
+    int64_t prefetch_count; // indices from the bag start that can be prefetched
+};
+
+struct jit_avx512_embedding_bag_kernel_t : public jit_generator {
+    DECLARE_CPU_JIT_AUX_FUNCTIONS(jit_avx512_embedding_bag_kernel_t)
+
+    jit_avx512_embedding_bag_kernel_t(const jit_emb_bag_conf_t &conf)
+        : jit_generator(nullptr, MAX_CODE_SIZE, true, avx512_core)
+        , conf_(conf) {}
+
+    static bool is_applicable(data_type_t src_dt) {
+        return mayiuse(avx512_core)
+                && utils::one_of(src_dt, data_type::f32, data_type::s16);
+    }
+
+    static constexpr int simd_w = 16;
+    static constexpr int max_acc_vecs = 24;
+
+private:
+    const jit_emb_bag_conf_t conf_;
+
+    const Xbyak::Reg64 reg_param = abi_param1;
+    const Xbyak::Reg64 reg_input = r8;
+    const Xbyak::Reg64 reg_indices = r9;
+    const Xbyak::Reg64 reg_weights = r10;
+    const Xbyak::Reg64 reg_dst = r11;
+    const Xbyak::Reg64 reg_count = r12;
+    const Xbyak::Reg64 reg_i = r13;
+    const Xbyak::Reg64 reg_row = r14;
+    const Xbyak::Reg64 reg_valid = r15;
+    const Xbyak::Reg64 reg_tmp = rax;
+    const Xbyak::Reg64 reg_pf_count = rbx;
+    const Xbyak::Reg64 reg_pf_row = rdx;
+
+    const Xbyak::Zmm zmm_weight = Xbyak::Zmm(24);
+    const Xbyak::Zmm zmm_src = Xbyak::Zmm(25);
+    const Xbyak::Zmm zmm_scale = Xbyak::Zmm(26);
+    const Xbyak::Xmm xmm_scale = Xbyak::Xmm(26);
+    const Xbyak::Xmm xmm_tmp = Xbyak::Xmm(27);
+    const Xbyak::Opmask k_tail = k1;
+
+    size_t src_dt_size() const {
+        return conf_.src_dt == data_type::f32 ? sizeof(float) : sizeof(int16_t);
+    }
+    void load_index(const Xbyak::Reg64 &reg, const Xbyak::Reg64 &reg_pos);
+    void prefetch_row();
+    void reduce_block(int vec_first, int nvecs, bool tail);
+    void generate() override;
+};
+
+} // namespace x64
+} // namespace cpu
+} // namespace impl
+} // namespace zendnn
+
+#endif
@@ -15,17 +15,21 @@
 *
 *******************************************************************************/
 
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 #include <iostream>
 #include <vector>
 #include <utility>
 #include <tuple>
 #include <time.h>
+#include <omp.h>
 #include "common/zendnn_private.hpp"
 #include "zendnn_logging.hpp"
 #include "common/utils.hpp"
 #include "common/zendnn_private.hpp"
 #include "common/type_helpers.hpp"
+#include "common/zendnn_tuning_db.hpp"
 
 #ifdef ZENDNN_ENABLE_LPGEMM_CONV
     #include "cpu/x64/zendnn_lpgemm_utils.hpp"
@@ -48,7 +52,9 @@ extern int graph_exe_count;
 #define LPGEMM_EVALUATE_ITER_V3 10
 
 //structure to make key
+//supported_path (os8/os32) is part of the key as the algos differ per path
 struct Key_lpgemm {
+    int supported_path;
     int no_of_images;
     const int8_t *filter;
     int channels;
@@ -67,6 +73,7 @@ struct Key_lpgemm {
 
     bool operator==(const Key_lpgemm &other) const {
         return (thread_count == other.thread_count
+                && supported_path == other.supported_path
                 && no_of_images == other.no_of_images
                 && filter == other.filter
                 && channels == other.channels
@@ -91,6 +98,7 @@ template <>
 struct hash<Key_lpgemm> {
     std::size_t operator()(const Key_lpgemm &k) const {
         std::size_t seed = 0;
+        seed = zendnn::impl::hash_combine(seed, (k.supported_path));
         seed = zendnn::impl::hash_combine(seed, (k.no_of_images));
         seed = zendnn::impl::hash_combine(seed, (k.filter));
         seed = zendnn::impl::hash_combine(seed, (k.channels));
@@ -139,6 +147,60 @@ std::unordered_map<Key_lpgemm,std::tuple<unsigned int, float, unsigned int>>
 std::unordered_map<Key_lpgemm,std::tuple<std::vector<std::pair<unsigned int,float>>, float, unsigned int>>
         conv_kernel_map2_helper;
 
+//Set when a new layer is tuned, the tuning database is written once the
+//layer finishes evaluation (ZENDNN_LPGEMM_PERSISTENT_MAP=1)
+static std::atomic<bool> conv_persistent_map_dirty(false);
+
+static Key_tuning conv_tuning_key(const Key_lpgemm &key_obj) {
+    Key_tuning key;
+    key.op = key_obj.supported_path == 0 ? TUNING_OP_CONV_LPGEMM_OS8 :
+             TUNING_OP_CONV_LPGEMM_OS32;
+    key.thread_count = key_obj.thread_count;
+    key.dims = {key_obj.no_of_images, key_obj.channels, key_obj.height,
+                key_obj.width, key_obj.no_of_filter, key_obj.kernel_h,
+                key_obj.kernel_w, key_obj.pad_t, key_obj.pad_l, key_obj.pad_b,
+                key_obj.pad_r, key_obj.stride_h, key_obj.stride_w
+               };
+    return key;
+}
+
+//Records the tuned algos with their best time in the tuning database
+//and merges them into the file.
+static int conv_map_write_to_file() {
+    const char *fname = zendnnTuningDB::getFile();
+    if (fname == NULL) {
+        fname = "key_matmul_map.csv";
+    }
+
+    zendnnTuningDB &tuning_db = zendnnTuningDB::ZenDNNTuningDB();
+    for (const auto &entry : conv_kernel_map) {
+        //Best time is kept by the helper map of the auto tuner version
+        float time_ms = 0;
+        auto found_obj1 = conv_kernel_map1_helper.find(entry.first);
+        auto found_obj2 = conv_kernel_map2_helper.find(entry.first);
+        if (found_obj1 != conv_kernel_map1_helper.end()) {
+            time_ms = std::get<1>(found_obj1->second);
+        }
+        else if (found_obj2 != conv_kernel_map2_helper.end()) {
+            time_ms = std::get<1>(found_obj2->second);
+        }
+        tuning_db.record(conv_tuning_key(entry.first), entry.second, time_ms);
+    }
+    return tuning_db.save(fname);
+}
+
+//Writes the tuning database once the new layers are tuned
+static void conv_map_persist() {
+    if (zendnnTuningDB::getMode("ZENDNN_LPGEMM_PERSISTENT_MAP") ==
+            zenTuningDBMode::TUNING_DB_WRITE &&
+            conv_persistent_map_dirty.exchange(false)) {
+        if (conv_map_write_to_file()) {
+            zendnnError(ZENDNN_ALGOLOG,
+                        "Error occured while writing Persistent Map File. Check the file");
+        }
+    }
+}
+
 /*Verion 1
 
   Works with framework (graph_exe_count)
@@ -244,6 +306,7 @@ int auto_compute_conv_v1(
                                        (convolution_os8::convolution_gemm_u8s8s32os8) : static_cast<int>
                                        (convolution_os32::convolution_gemm_u8s8s32os32);
             conv_kernel_map1_helper[key_obj] = {0, cur_algo_time, supportedPath == 0 ? static_cast<int>(convolution_os8::convolution_gemm_u8s8s32os8) : static_cast<int>(convolution_os32::convolution_gemm_u8s8s32os32)}; // {eval_count, time, algo}
+            conv_persistent_map_dirty = true;
         }
         else {
             zendnnConvolutionLPGEMM(supportedPath, selected_algo,in_layer,
@@ -267,6 +330,9 @@ int auto_compute_conv_v1(
                                 out_width, concat, filter_offset, total_filters, reluFused, elementwiseType,
                                 output_scales,
                                 zero_point_dst, scale_count);
+
+        //Writing Map in file.
+        conv_map_persist();
     }
     //Runs for evaluate iterations
     //Updates the map values accordingly
@@ -420,6 +486,7 @@ int auto_compute_conv_v2(
                                        (convolution_os8::convolution_gemm_u8s8s32os8) :static_cast<int>
                                        (convolution_os32::convolution_gemm_u8s8s32os32);
             //value of map {vector<{iteration,avg time}>, time, algo}
+            conv_persistent_map_dirty = true;
         }
         else {
             zendnnConvolutionLPGEMM(supportedPath, selected_algo,in_layer,
@@ -441,6 +508,9 @@ int auto_compute_conv_v2(
                                 out_width, concat, filter_offset, total_filters, reluFused, elementwiseType,
                                 output_scales,
                                 zero_point_dst, scale_count);
+
+        //Writing Map in file.
+        conv_map_persist();
     }
     //Runs for evaluate iterations
     //Updates the map values accordingly
@@ -603,6 +673,7 @@ int auto_compute_conv_v3(
             conv_kernel_map[key_obj] = supportedPath == 0 ? static_cast<int>
                                        (convolution_os8::convolution_gemm_u8s8s32os8) : static_cast<int>
                                        (convolution_os32::convolution_gemm_u8s8s32os32);
+            conv_persistent_map_dirty = true;
         }
         //If key found then increment the iter_count and run algo 3.
         else {
@@ -626,6 +697,9 @@ int auto_compute_conv_v3(
                                 out_width, concat, filter_offset, total_filters, reluFused, elementwiseType,
                                 output_scales,
                                 zero_point_dst, scale_count);
+
+        //Writing Map in file.
+        conv_map_persist();
     }
     //Updates the map values by running different algorithms
     else {
@@ -717,6 +791,12 @@ int auto_compute_conv(
     //0: disable, 1: enable.
     int map_type = zendnn::zendnn_getenv_int("ZENDNN_LPGEMM_MAP_TYPE",1);
 
+    //Persistent Map, shares the file of the MatMul auto tuner
+    //{ 0: disable, 1: write, 2:read }
+    unsigned int persistent_map =
+        zendnnTuningDB::getMode("ZENDNN_LPGEMM_PERSISTENT_MAP");
+
+    key_obj.supported_path = supportedPath;
     key_obj.no_of_images = no_of_images;
     key_obj.channels = channels;
     key_obj.height = height;
@@ -732,10 +812,38 @@ int auto_compute_conv(
     key_obj.stride_w = stride_w;
 
     //This condition makes sure that address
-    //doesn't gets saved if map_type is NOT 1.
-    key_obj.filter = map_type == 1 ? filter : NULL;
+    //doesn't gets saved if map_type is NOT 1 or persistent map is used.
+    key_obj.filter = map_type == 1 &&
+                     persistent_map == zenTuningDBMode::TUNING_DB_DISABLE ? filter : NULL;
     key_obj.thread_count = zendnn::zendnn_getenv_int("OMP_NUM_THREADS",1);
 
+    //Read operation from File (Persistent Map)
+    if (persistent_map == zenTuningDBMode::TUNING_DB_READ) {
+        zendnnTuningDB &tuning_db = zendnnTuningDB::ZenDNNTuningDB();
+        static std::once_flag map_read;
+        std::call_once(map_read, [&] {
+            if (tuning_db.load(zendnnTuningDB::getFile())) {
+                zendnnError(ZENDNN_ALGOLOG,
+                            "Persistent Map File Not Found or invalid value in file. Persistent feature won't work. Set ZENDNN_MATMUL_MAP_FILE environment variable. Executing with default algo.");
+            }
+        });
+        //Layers missing from the file run the default algo. The database
+        //is searched under its own lock, conv_kernel_map is left to the
+        //tuning modes so that concurrent convolutions never insert into it.
+        zenTuningRecord record;
+        algo_type = tuning_db.find(conv_tuning_key(key_obj), record) ?
+                    record.algo : supportedPath == 0 ? static_cast<int>
+                    (convolution_os8::convolution_gemm_u8s8s32os8) : static_cast<int>
+                    (convolution_os32::convolution_gemm_u8s8s32os32);
+        zendnnConvolutionLPGEMM(supportedPath, algo_type, in_layer,
+                                no_of_images, channels, height, width, filter, no_of_filter, kernel_h, kernel_w,
+                                pad_t, pad_l, pad_b, pad_r, stride_h, stride_w, bias, out_layer, out_height,
+                                out_width, concat, filter_offset, total_filters, reluFused, elementwiseType,
+                                output_scales,
+                                zero_point_dst, scale_count);
+        return algo_type;
+    }
+
     //If graph_exe_count is incremented by framework
     if (graph_exe_count != -1) {
         //uses framework.
@@ -779,3 +887,81 @@ int auto_compute_conv(
 
     return algo_type;
 }
+
+namespace zendnn {
+
+int zendnnTuneConvLPGEMM(bool output_s32, int no_of_images, int channels,
+                         int height, int width, int no_of_filter, int kernel_h, int kernel_w,
+                         int pad_t, int pad_l, int pad_b, int pad_r, int stride_h, int stride_w,
+                         unsigned int thread_count, unsigned int iterations) {
+    int out_height = stride_h > 0 ? (height + pad_t + pad_b - kernel_h) / stride_h
+                     + 1 : 0;
+    int out_width = stride_w > 0 ? (width + pad_l + pad_r - kernel_w) / stride_w
+                    + 1 : 0;
+    if (no_of_images <= 0 || channels <= 0 || no_of_filter <= 0 ||
+            kernel_h <= 0 || kernel_w <= 0 || out_height <= 0 || out_width <= 0 ||
+            thread_count == 0) {
+        return -1;
+    }
+    int supportedPath = output_s32 ? 1 : 0;
+    //Reference direct path (os8 algo 3) needs LPGEMM
+#ifdef ZENDNN_ENABLE_LPGEMM
+    unsigned int num_of_lpgemm_algo = supportedPath == 0 ? static_cast<int>
+                                      (num_of_lpgemm_os8)-1 : static_cast<int>(num_of_lpgemm_os32)-1;
+#else
+    unsigned int num_of_lpgemm_algo = supportedPath == 0 ? static_cast<int>
+                                      (convolution_os8::convolution_gemm_u8s8s16os8) : static_cast<int>
+                                      (num_of_lpgemm_os32)-1;
+#endif
+
+    std::vector<uint8_t> input((size_t)no_of_images * height * width * channels,
+                               1);
+    std::vector<int8_t> filter((size_t)kernel_h * kernel_w * channels *
+                               no_of_filter, 1);
+    //Zero bias, valid as s32 and s16 bias
+    std::vector<int32_t> bias(no_of_filter, 0);
+    std::vector<int32_t> output((size_t)no_of_images * out_height * out_width *
+                                no_of_filter);
+    std::vector<float> output_scales(no_of_filter, 1.0f);
+    int zero_point_dst = 0;
+
+    Key_lpgemm key_obj;
+    key_obj.supported_path = supportedPath;
+    key_obj.no_of_images = no_of_images;
+    key_obj.filter = NULL;
+    key_obj.channels = channels;
+    key_obj.height = height;
+    key_obj.width = width;
+    key_obj.no_of_filter = no_of_filter;
+    key_obj.kernel_h = kernel_h;
+    key_obj.kernel_w = kernel_w;
+    key_obj.pad_t = pad_t;
+    key_obj.pad_l = pad_l;
+    key_obj.pad_b = pad_b;
+    key_obj.pad_r = pad_r;
+    key_obj.stride_h = stride_h;
+    key_obj.stride_w = stride_w;
+    key_obj.thread_count = thread_count;
+
+    //The record is keyed on thread_count, time the runs with that many
+    //threads: the convolution reads readEnv(), the LPGEMM kernels the OpenMP
+    //setting
+    unsigned int prev_budget = zendnnGetThreadBudget();
+    int prev_max_threads = omp_get_max_threads();
+    zendnnSetThreadBudget(thread_count);
+    omp_set_num_threads(thread_count);
+    unsigned int algo = zenTuningSweep(conv_tuning_key(key_obj),
+                                       num_of_lpgemm_algo, iterations, [&](unsigned int eval_algo) {
+        zendnnConvolutionLPGEMM(supportedPath, eval_algo, input.data(),
+                                no_of_images, channels, height, width, filter.data(), no_of_filter,
+                                kernel_h, kernel_w, pad_t, pad_l, pad_b, pad_r, stride_h, stride_w,
+                                bias.data(), output.data(), out_height, out_width, false, 0,
+                                no_of_filter, false, 0, output_scales.data(), &zero_point_dst,
+                                no_of_filter);
+    });
+    omp_set_num_threads(prev_max_threads);
+    zendnnSetThreadBudget(prev_budget);
+    return algo;
+}
+
+}
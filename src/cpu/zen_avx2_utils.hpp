@@ -20,6 +20,8 @@
 #define ZEN_AVX2_UTILS_HPP
 
 #include <immintrin.h>
+#include <cstdint>
+#include <cstring>
 
 #define ZEN_MM_PS_STRIDE        (8)
 #define ZEN_MM_PS_STRIDE1       (16)
@@ -214,4 +216,93 @@ struct zenmm_ext_ps {
 using zenmm_ext_ps64=zenmm_ext_ps<8>;
 using zenmm_ext_ps128=zenmm_ext_ps<16>;
 
+//
+// row-wise quantized rows of DIM*8 codes of BITS (8 or 4, low nibble first),
+// dequantized in registers as code * scale + bias
+//
+template<uint32_t BITS, uint32_t DIM>
+struct zenmm_ext_pq {
+
+    static_assert(BITS == 8 || BITS == 4, "zenmm_ext_pq: BITS needs to be 8 or 4");
+
+    zenmm_ext_pq() {
+        setzero_ps();
+    }
+
+    inline void setzero_ps() {
+        for (uint32_t i = 0; i < DIM; ++i) {
+            v[i] = _mm256_setzero_ps();
+        }
+    };
+
+    inline void load_ps(uint8_t const *row, const float scale, const float bias) {
+        __m256 ms = _mm256_set1_ps(scale), mb = _mm256_set1_ps(bias);
+        for (uint32_t i = 0; i < DIM; ++i) {
+            v[i] = dequant_ps(row, i, ms, mb);
+        }
+    };
+
+    inline void fetch_add_ps(uint8_t const *row, const float scale,
+                             const float bias) {
+        __m256 ms = _mm256_set1_ps(scale), mb = _mm256_set1_ps(bias);
+        for (uint32_t i = 0; i < DIM; ++i) {
+            v[i] = _mm256_add_ps(dequant_ps(row, i, ms, mb), v[i]);
+        }
+    };
+
+    inline void fetch_fmadd_ps(uint8_t const *row, const float scale,
+                               const float bias, const float mfactor) {
+        __m256 ms = _mm256_set1_ps(scale * mfactor);
+        __m256 mb = _mm256_set1_ps(bias * mfactor);
+        for (uint32_t i = 0; i < DIM; ++i) {
+            v[i] = _mm256_add_ps(dequant_ps(row, i, ms, mb), v[i]);
+        }
+    };
+
+    inline void fetch_max_ps(uint8_t const *row, const float scale,
+                             const float bias) {
+        __m256 ms = _mm256_set1_ps(scale), mb = _mm256_set1_ps(bias);
+        for (uint32_t i = 0; i < DIM; ++i) {
+            v[i] = _mm256_max_ps(dequant_ps(row, i, ms, mb), v[i]);
+        }
+    };
+
+    inline void store_ps(float *mem) {
+        for (uint32_t i = 0; i < DIM; ++i) {
+            _mm256_storeu_ps(mem, v[i]);
+            mem += ZEN_MM_PS_STRIDE;
+        }
+    };
+
+    inline void scale_store_ps(float *mem, const float mfactor) {
+        __m256 mm = _mm256_set1_ps(mfactor);
+        for (uint32_t i = 0; i < DIM; ++i) {
+            _mm256_storeu_ps(mem, _mm256_mul_ps(v[i], mm));
+            mem += ZEN_MM_PS_STRIDE;
+        }
+    };
+
+  private:
+    // codes i*8 .. i*8+7 of the row
+    inline __m256 dequant_ps(uint8_t const *row, uint32_t i, __m256 ms,
+                             __m256 mb) {
+        __m128i q;
+        if (BITS == 8) {
+            q = _mm_loadl_epi64((__m128i const *)(row + i * ZEN_MM_PS_STRIDE));
+        }
+        else {
+            int32_t packed;
+            std::memcpy(&packed, row + i * (ZEN_MM_PS_STRIDE / 2), sizeof(packed));
+            __m128i p  = _mm_cvtsi32_si128(packed);
+            __m128i lo = _mm_and_si128(p, _mm_set1_epi8(0x0f));
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(p, 4), _mm_set1_epi8(0x0f));
+            q = _mm_unpacklo_epi8(lo, hi);
+        }
+        __m256 codes = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(q));
+        return _mm256_fmadd_ps(codes, ms, mb);
+    }
+
+    __m256           v[DIM];
+};
+
 #endif
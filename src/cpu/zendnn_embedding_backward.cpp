@@ -0,0 +1,385 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+#include "zendnn.hpp"
+#include "zendnn_helper.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include "zendnn_logging.hpp"
+#include "verbose.hpp"
+#define EB_GRAD_ROWS_PER_CHUNK 64
+//Least looked up indices per sorted chunk
+#define EB_GRAD_SORT_CHUNK 4096
+
+namespace zendnn {
+
+//Row sparse gradient of one embedding bag call. The index positions are
+//grouped by table row, so every distinct row is accumulated by one thread
+//and nothing is written to rows that are not looked up.
+struct zenEbagGrad {
+    int64_t width;
+    bool scale_grad_by_freq;
+    //Distinct rows, ascending, and their positions: pos[seg[k]..seg[k+1])
+    std::vector<int64_t> rows;
+    std::vector<int64_t> seg;
+    std::vector<int64_t> pos;
+    //Bag and gradient factor of every index position
+    std::vector<int64_t> bag;
+    std::vector<float> weight;
+    //Max mode: position selected in every bag and column, -1 for none
+    std::vector<int64_t> max_pos;
+};
+
+//Reads s32 or s64 indices and offsets in place
+struct zenEbagIndexView {
+    const void *data;
+    bool s64;
+    int64_t size;
+    zenEbagIndexView(const memory &z_mem)
+        : data(z_mem.get_data_handle()),
+          s64(z_mem.get_desc().data_type() == memory::data_type::s64),
+          size(z_mem.get_desc().dims()[0]) {}
+    int64_t operator[](int64_t i) const {
+        return s64 ? static_cast<const int64_t *>(data)[i] :
+               static_cast<const int32_t *>(data)[i];
+    }
+};
+
+static void zenEbagGradPrepare(const memory &z_input,
+                               const memory &z_grad_output, const memory &z_indices,
+                               const memory &z_offsets, const bool &z_scale_grad_by_freq,
+                               const algorithm &z_mode, const memory &z_per_sample_weights_opt,
+                               const bool &z_per_sample_weights_defined,
+                               const bool &z_include_last_offset, const int32_t &z_padding_idx,
+                               unsigned int num_threads, zenEbagGrad &grad) {
+
+    auto input_desc = z_input.get_desc();
+    auto grad_desc = z_grad_output.get_desc();
+    if (input_desc.data_type() != memory::data_type::f32 ||
+            grad_desc.data_type() != memory::data_type::f32 ||
+            input_desc.dims().size() != 2 || grad_desc.dims().size() != 2 ||
+            grad_desc.dims()[1] != input_desc.dims()[1]) {
+        throw error(zendnn_invalid_arguments,
+                    "embedding bag backward: table and output gradient must be 2D f32 "
+                    "of the same width");
+    }
+    if (z_per_sample_weights_defined && z_mode != algorithm::embedding_bag_sum) {
+        throw error(zendnn_invalid_arguments,
+                    "embedding bag backward: per sample weights need the sum mode");
+    }
+
+    const int64_t num_rows = input_desc.dims()[0];
+    const int64_t width = input_desc.dims()[1];
+    const zenEbagIndexView indices(z_indices);
+    const zenEbagIndexView offsets(z_offsets);
+    const int64_t num_indices = indices.size;
+    const int64_t num_bags = offsets.size - (z_include_last_offset ? 1 : 0);
+    if (num_bags < 0 || grad_desc.dims()[0] < num_bags) {
+        throw error(zendnn_invalid_arguments,
+                    "embedding bag backward: output gradient has fewer rows than bags");
+    }
+    auto bag_end = [&](int64_t b) {
+        return b + 1 < offsets.size ? offsets[b + 1] : num_indices;
+    };
+    //Bags are ascending ranges of the indices, so that they never overlap
+    for (int64_t b = 0; b < num_bags; b++) {
+        if (offsets[b] < 0 || offsets[b] > bag_end(b) || bag_end(b) > num_indices) {
+            throw error(zendnn_invalid_arguments,
+                        "embedding bag backward: offsets must be ascending and within "
+                        "the indices");
+        }
+    }
+    const float *psw = z_per_sample_weights_defined ? static_cast<const float *>
+                       (z_per_sample_weights_opt.get_data_handle()) : nullptr;
+
+    grad.width = width;
+    grad.scale_grad_by_freq = z_scale_grad_by_freq &&
+                              z_mode != algorithm::embedding_bag_max;
+    grad.bag.assign(num_indices, 0);
+    grad.weight.assign(num_indices, 1.0f);
+    #pragma omp parallel for num_threads(num_threads)
+    for (int64_t b = 0; b < num_bags; b++) {
+        int64_t first = offsets[b];
+        int64_t last = bag_end(b);
+        int64_t count = 0;
+        for (int64_t i = first; i < last; i++) {
+            grad.bag[i] = b;
+            count += indices[i] != z_padding_idx;
+        }
+        for (int64_t i = first; i < last; i++) {
+            if (psw) {
+                grad.weight[i] = psw[i];
+            }
+            else if (z_mode == algorithm::embedding_bag_mean) {
+                grad.weight[i] = 1.0f / count;
+            }
+        }
+    }
+
+    //(row, position) of every looked up index, sorted so that the rows come
+    //out ascending and their positions in order. Positions of the bags are
+    //cut in chunks, each sorted by one thread, then merged pairwise.
+    typedef std::pair<int64_t, int64_t> lookup_t;
+    const int64_t lo = num_bags ? offsets[0] : 0;
+    const int64_t hi = num_bags ? bag_end(num_bags - 1) : 0;
+    const int64_t chunks = std::max((int64_t)1, std::min((int64_t)num_threads,
+                                    (hi - lo) / EB_GRAD_SORT_CHUNK));
+    std::vector<int64_t> bounds(chunks + 1, 0);
+    bool bad_index = false;
+    #pragma omp parallel for num_threads(num_threads) reduction(||:bad_index)
+    for (int64_t c = 0; c < chunks; c++) {
+        int64_t count = 0;
+        for (int64_t i = lo + (hi - lo) * c / chunks;
+                i < lo + (hi - lo) * (c + 1) / chunks; i++) {
+            if (indices[i] == z_padding_idx) {
+                continue;
+            }
+            bad_index = bad_index || indices[i] < 0 || indices[i] >= num_rows;
+            count++;
+        }
+        bounds[c + 1] = count;
+    }
+    if (bad_index) {
+        throw error(zendnn_invalid_arguments,
+                    "embedding bag backward: index out of the table");
+    }
+    for (int64_t c = 0; c < chunks; c++) {
+        bounds[c + 1] += bounds[c];
+    }
+    std::vector<lookup_t> lookups(bounds[chunks]);
+    #pragma omp parallel for num_threads(num_threads)
+    for (int64_t c = 0; c < chunks; c++) {
+        int64_t l = bounds[c];
+        for (int64_t i = lo + (hi - lo) * c / chunks;
+                i < lo + (hi - lo) * (c + 1) / chunks; i++) {
+            if (indices[i] != z_padding_idx) {
+                lookups[l++] = lookup_t(indices[i], i);
+            }
+        }
+        std::sort(lookups.begin() + bounds[c], lookups.begin() + bounds[c + 1]);
+    }
+    if (chunks > 1) {
+        std::vector<lookup_t> merged(lookups.size());
+        for (int64_t step = 1; step < chunks; step *= 2) {
+            #pragma omp parallel for num_threads(num_threads)
+            for (int64_t c = 0; c < chunks; c += 2 * step) {
+                int64_t mid = std::min(c + step, chunks);
+                int64_t end = std::min(c + 2 * step, chunks);
+                std::merge(lookups.begin() + bounds[c], lookups.begin() + bounds[mid],
+                           lookups.begin() + bounds[mid], lookups.begin() + bounds[end],
+                           merged.begin() + bounds[c]);
+            }
+            lookups.swap(merged);
+        }
+    }
+    grad.rows.clear();
+    grad.seg.clear();
+    grad.pos.resize(lookups.size());
+    for (size_t l = 0; l < lookups.size(); l++) {
+        if (!l || lookups[l].first != lookups[l - 1].first) {
+            grad.rows.push_back(lookups[l].first);
+            grad.seg.push_back(l);
+        }
+        grad.pos[l] = lookups[l].second;
+    }
+    grad.seg.push_back(lookups.size());
+
+    grad.max_pos.clear();
+    if (z_mode == algorithm::embedding_bag_max) {
+        //The first position holding the maximum, as the forward kernels
+        const float *input = static_cast<const float *>(z_input.get_data_handle());
+        grad.max_pos.assign(num_bags * width, -1);
+        #pragma omp parallel for num_threads(num_threads)
+        for (int64_t b = 0; b < num_bags; b++) {
+            int64_t first = offsets[b];
+            int64_t last = bag_end(b);
+            int64_t *max_pos = grad.max_pos.data() + b * width;
+            std::vector<float> best(width);
+            for (int64_t i = first; i < last; i++) {
+                if (indices[i] == z_padding_idx) {
+                    continue;
+                }
+                const float *row = input + indices[i] * width;
+                for (int64_t j = 0; j < width; j++) {
+                    if (max_pos[j] < 0 || row[j] > best[j]) {
+                        best[j] = row[j];
+                        max_pos[j] = i;
+                    }
+                }
+            }
+        }
+    }
+}
+
+//Gradient of the distinct row k of grad into g
+static void zenEbagGradRow(const zenEbagGrad &grad, int64_t k,
+                           const float *grad_output, float *g) {
+    const int64_t width = grad.width;
+    std::fill(g, g + width, 0.0f);
+    for (int64_t p = grad.seg[k]; p < grad.seg[k + 1]; p++) {
+        int64_t i = grad.pos[p];
+        const float *go = grad_output + grad.bag[i] * width;
+        if (grad.max_pos.empty()) {
+            float w = grad.weight[i];
+            for (int64_t j = 0; j < width; j++) {
+                g[j] += w * go[j];
+            }
+        }
+        else {
+            const int64_t *max_pos = grad.max_pos.data() + grad.bag[i] * width;
+            for (int64_t j = 0; j < width; j++) {
+                if (max_pos[j] == i) {
+                    g[j] += go[j];
+                }
+            }
+        }
+    }
+    if (grad.scale_grad_by_freq) {
+        float scale = 1.0f / (grad.seg[k + 1] - grad.seg[k]);
+        for (int64_t j = 0; j < width; j++) {
+            g[j] *= scale;
+        }
+    }
+}
+
+int64_t zendnn_custom_op::zendnn_embedding_bag_backward(const memory &z_input,
+        const memory &z_grad_output, const memory &z_indices,
+        const memory &z_offsets, const bool &z_scale_grad_by_freq,
+        const algorithm &z_mode, const memory &z_per_sample_weights_opt,
+        const bool &z_per_sample_weights_defined,
+        const bool &z_include_last_offset, const int32_t &z_padding_idx,
+        memory &z_grad_indices, memory &z_grad_values) {
+
+    zendnnEnv zenEnvObj = readEnv();
+    unsigned int num_threads = zenEnvObj.omp_num_threads;
+    double start_ms = impl::get_msec();
+
+    zenEbagGrad grad;
+    zenEbagGradPrepare(z_input, z_grad_output, z_indices, z_offsets,
+                       z_scale_grad_by_freq, z_mode, z_per_sample_weights_opt,
+                       z_per_sample_weights_defined, z_include_last_offset, z_padding_idx,
+                       num_threads, grad);
+
+    const int64_t num_unique = grad.rows.size();
+    const int64_t width = grad.width;
+    if (z_grad_indices.get_desc().dims()[0] < num_unique ||
+            z_grad_values.get_desc().data_type() != memory::data_type::f32 ||
+            z_grad_values.get_desc().dims()[0] < num_unique ||
+            z_grad_values.get_desc().dims()[1] != width) {
+        throw error(zendnn_invalid_arguments,
+                    "embedding bag backward: gradient indices and values can not hold "
+                    "every distinct row");
+    }
+
+    const float *grad_output = static_cast<const float *>
+                               (z_grad_output.get_data_handle());
+    float *values = static_cast<float *>(z_grad_values.get_data_handle());
+    bool indices_s64 = z_grad_indices.get_desc().data_type() ==
+                       memory::data_type::s64;
+    void *grad_indices = z_grad_indices.get_data_handle();
+    #pragma omp parallel for num_threads(num_threads) schedule(dynamic, EB_GRAD_ROWS_PER_CHUNK)
+    for (int64_t k = 0; k < num_unique; k++) {
+        zenEbagGradRow(grad, k, grad_output, values + k * width);
+        if (indices_s64) {
+            static_cast<int64_t *>(grad_indices)[k] = grad.rows[k];
+        }
+        else {
+            static_cast<int32_t *>(grad_indices)[k] = grad.rows[k];
+        }
+    }
+
+    double duration_ms = impl::get_msec() - start_ms;
+    zendnnVerbose(ZENDNN_PROFLOG,
+                  "zendnn_custom_op_execute,cpu,embedding_bag_backward,",
+                  "indices:", grad.pos.size(), ",", "rows:", num_unique, ",",
+                  "width:", width, ",", duration_ms, ",ms");
+    return num_unique;
+}
+
+void zendnn_custom_op::zendnn_embedding_bag_update(memory &z_input,
+        memory &z_state, const memory &z_grad_output, const memory &z_indices,
+        const memory &z_offsets, const bool &z_scale_grad_by_freq,
+        const algorithm &z_mode, const memory &z_per_sample_weights_opt,
+        const bool &z_per_sample_weights_defined,
+        const bool &z_include_last_offset, const int32_t &z_padding_idx,
+        const embedding_optimizer &z_optimizer, const float &z_learning_rate,
+        const float &z_eps) {
+
+    zendnnEnv zenEnvObj = readEnv();
+    unsigned int num_threads = zenEnvObj.omp_num_threads;
+    double start_ms = impl::get_msec();
+
+    //The max mode reads the table, so every row is prepared before the
+    //first one is updated
+    zenEbagGrad grad;
+    zenEbagGradPrepare(z_input, z_grad_output, z_indices, z_offsets,
+                       z_scale_grad_by_freq, z_mode, z_per_sample_weights_opt,
+                       z_per_sample_weights_defined, z_include_last_offset, z_padding_idx,
+                       num_threads, grad);
+
+    const int64_t num_unique = grad.rows.size();
+    const int64_t width = grad.width;
+    bool adagrad = z_optimizer == embedding_optimizer::rowwise_adagrad;
+    float *state = nullptr;
+    if (adagrad) {
+        if (z_state.get_desc().data_type() != memory::data_type::f32 ||
+                z_state.get_desc().dims()[0] != z_input.get_desc().dims()[0]) {
+            throw error(zendnn_invalid_arguments,
+                        "embedding bag update: row-wise Adagrad needs one f32 state per row");
+        }
+        state = static_cast<float *>(z_state.get_data_handle());
+    }
+
+    const float *grad_output = static_cast<const float *>
+                               (z_grad_output.get_data_handle());
+    float *input = static_cast<float *>(z_input.get_data_handle());
+    const float lr = z_learning_rate;
+    #pragma omp parallel num_threads(num_threads)
+    {
+        std::vector<float> g(width);
+        #pragma omp for schedule(dynamic, EB_GRAD_ROWS_PER_CHUNK)
+        for (int64_t k = 0; k < num_unique; k++) {
+            zenEbagGradRow(grad, k, grad_output, g.data());
+            float *row = input + grad.rows[k] * width;
+            float step = lr;
+            if (adagrad) {
+                float sum_sq = 0.0f;
+                for (int64_t j = 0; j < width; j++) {
+                    sum_sq += g[j] * g[j];
+                }
+                float &s = state[grad.rows[k]];
+                s += sum_sq / width;
+                step = lr / (std::sqrt(s) + z_eps);
+            }
+            for (int64_t j = 0; j < width; j++) {
+                row[j] -= step * g[j];
+            }
+        }
+    }
+
+    double duration_ms = impl::get_msec() - start_ms;
+    zendnnVerbose(ZENDNN_PROFLOG,
+                  "zendnn_custom_op_execute,cpu,embedding_bag_update,",
+                  "optimizer:", adagrad ? "rowwise_adagrad" : "sgd", ",",
+                  "indices:", grad.pos.size(), ",", "rows:", num_unique, ",",
+                  "width:", width, ",", duration_ms, ",ms");
+}
+
+}//ZenDNN
@@ -17,13 +17,21 @@
 
 #include "zendnn.hpp"
 #include "zendnn_helper.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <vector>
 #include <omp.h>
 #include <string.h>
+#ifdef __linux__
+    #include <sched.h>
+#endif
 #include "zendnn_logging.hpp"
+#include "zendnn_cpu_topology.hpp"
+#include "zendnn_embedding_placement.hpp"
 #include "verbose.hpp"
 #define ZENDNN_EMBED_BAG_THRDS 16
-#define CCD_NUM_THREADS 8
+#define EB_WORK_ITEMS_PER_THREAD 4
 #if FBGEMM_ENABLE
     #include "fbgemm/FbgemmEmbedding.h"
     using namespace fbgemm;
@@ -89,6 +97,70 @@ void zendnn_embedding_bag_kernel(
     }
 }
 
+#if FBGEMM_ENABLE
+template<typename index_t>
+void zendnn_embedding_bag_fbgemm(
+    const memory &z_input, const memory &z_indices, const memory &z_offsets,
+    const int32_t &include_last_offset, memory &z_dst) {
+
+    auto emd_table_dims = z_input.get_desc().dims();
+    auto dim_embedding  = emd_table_dims[1];
+    auto num_rows       = emd_table_dims[0];
+    int64_t indices_size = z_indices.get_desc().dims()[0];
+    int batch_size      = z_dst.get_desc().dims()[0];
+
+    double start_ms = impl::get_msec();
+
+    float *table_ptr = static_cast<float *>(z_input.get_data_handle());
+    index_t *indices = static_cast<index_t *>(z_indices.get_data_handle());
+    index_t *offsets = static_cast<index_t *>(z_offsets.get_data_handle());
+    float *output    = static_cast<float *>(z_dst.get_data_handle());
+
+    bool use_weight=false;
+    bool normalize_by_lengths=false;
+    bool prefetch=true;
+    bool is_wt_positional=false;
+    bool use_offsets=true;
+    bool ret;
+    auto kernel = GenerateEmbeddingSpMDM<float, index_t>(
+                      dim_embedding,
+                      use_weight,
+                      normalize_by_lengths,
+                      prefetch?16:0,
+                      is_wt_positional,
+                      use_offsets);
+
+    //FBGEMM reads the indices of the first bag from indices[0], offsets of a
+    //bag range view start past 0: rebase them on the first index of the range
+    index_t first = batch_size > 0 || include_last_offset ? offsets[0] : 0;
+    index_t last  = include_last_offset ? offsets[batch_size] : indices_size;
+    index_t *fbgemm_offsets = new index_t[batch_size+1];
+    for (int b = 0; b < batch_size; b++) {
+        fbgemm_offsets[b] = offsets[b] - first;
+    }
+    fbgemm_offsets[batch_size] = last - first;
+
+    ret = kernel(
+              batch_size,
+              last - first,
+              num_rows,
+              table_ptr,
+              indices + first,
+              (const index_t *)fbgemm_offsets,
+              nullptr,
+              output);
+
+    delete[] fbgemm_offsets;
+
+    double duration_ms = impl::get_msec() - start_ms;
+
+    zendnnVerbose(ZENDNN_PROFLOG, "zendnn_primitive_execute,cpu,embedding_bag,",
+                  "fbgemm",",","BS:",batch_size,",ED:",dim_embedding,",alg:sum",
+                  ",",duration_ms,
+                  ",ms");
+}
+#endif
+
 void zendnn_embedding_bag_exec(
     const memory &z_input, const memory &z_indices, const memory &z_offsets,
     const int32_t &scale_grad_by_freq,
@@ -99,72 +171,20 @@ void zendnn_embedding_bag_exec(
     unsigned int op_num_threads=1) {
 
     zendnnEnv EnvObj = readEnv();
-    auto emd_table_dims = z_input.get_desc().dims();
-    auto dim_embedding  = emd_table_dims[1];
-    auto num_rows       = emd_table_dims[0];
-    int indices_size    = z_indices.get_desc().dims()[0];
-    int batch_size      = z_dst.get_desc().dims()[0];
 
 #if FBGEMM_ENABLE
-    // FBGEMM kernel path is taken for algo sum
+    // FBGEMM kernel path is taken for algo sum on f32 tables
     if (EnvObj.zenEBAlgo==zenEBAlgoType::EB_OP_FBGEMM &&
-            z_algorithm==algorithm::embedding_bag_sum) {
-        double start_ms = impl::get_msec();
-
-        float *table_ptr = static_cast<float *>(z_input.get_data_handle());
-        int32_t *indices = static_cast<int32_t *>(z_indices.get_data_handle());
-        int32_t *offsets = static_cast<int32_t *>(z_offsets.get_data_handle());
-        float *output    = static_cast<float *>(z_dst.get_data_handle());
-
-        bool use_weight=false;
-        bool normalize_by_lengths=false;
-        bool prefetch=true;
-        bool is_wt_positional=false;
-        bool use_offsets=true;
-        bool ret;
-        auto kernel = GenerateEmbeddingSpMDM<float, int32_t>(
-                          dim_embedding,
-                          use_weight,
-                          normalize_by_lengths,
-                          prefetch?16:0,
-                          is_wt_positional,
-                          use_offsets);
-
-        if (include_last_offset==0) {
-            int32_t *fbgemm_offsets = new int32_t[batch_size+1];
-            memcpy(fbgemm_offsets, offsets, batch_size * sizeof(int32_t));
-            fbgemm_offsets[batch_size]=indices_size;
-
-            ret = kernel(
-                      batch_size,
-                      indices_size,
-                      num_rows,
-                      table_ptr,
-                      indices,
-                      (const int *)fbgemm_offsets,
-                      nullptr,
-                      output);
-
-            delete[] fbgemm_offsets;
+            z_algorithm==algorithm::embedding_bag_sum &&
+            z_input.get_desc().data_type()==memory::data_type::f32) {
+        if (z_indices.get_desc().data_type()==memory::data_type::s64) {
+            zendnn_embedding_bag_fbgemm<int64_t>(z_input, z_indices, z_offsets,
+                                                 include_last_offset, z_dst);
         }
         else {
-            ret = kernel(
-                      batch_size,
-                      indices_size,
-                      num_rows,
-                      table_ptr,
-                      indices,
-                      (const int *)offsets,
-                      nullptr,
-                      output);
+            zendnn_embedding_bag_fbgemm<int32_t>(z_input, z_indices, z_offsets,
+                                                 include_last_offset, z_dst);
         }
-
-        double duration_ms = impl::get_msec() - start_ms;
-
-        zendnnVerbose(ZENDNN_PROFLOG, "zendnn_primitive_execute,cpu,embedding_bag,",
-                      "fbgemm",",","BS:",batch_size,",ED:",dim_embedding,",alg:sum",
-                      ",",duration_ms,
-                      ",ms");
     }
     else {
         zendnn_embedding_bag_kernel(
@@ -187,6 +207,142 @@ void zendnn_embedding_bag_exec(
 
 }
 
+//Unit of work of the WORK_THREADED scheduler: bags [bag_begin, bag_end) of
+//one table, with its estimated cost in bytes read.
+struct zenEBWorkItem {
+    int table;
+    int bag_begin;
+    int bag_end;
+    double cost;
+};
+
+//End (exclusive) in the indices array of bag b of a table.
+template<typename offset_t>
+static inline int64_t zenEBBagEnd(const offset_t *offsets, int num_bags,
+                                  int64_t indices_size, int32_t include_last_offset, int b) {
+    if (b < num_bags || include_last_offset) {
+        return offsets[b];
+    }
+    return indices_size;
+}
+
+//Cuts bags [0, num_bags) of table t into chunks ranges of the same number of
+//bags, offsets are s32 or s64. The ranges only depend on the shapes so the
+//embedding_bag primitive of each range is found in the primitive cache on the
+//next call, the cost of a range follows the indices it holds.
+template<typename offset_t>
+static void zenEBSplitTable(std::vector<zenEBWorkItem> &items, int t,
+                            const offset_t *offsets, int num_bags, int64_t indices_size,
+                            int32_t include_last_offset, int chunks, double bytes_per_row) {
+    for (int c = 0; c < chunks; c++) {
+        int bag_begin = (int)((int64_t)num_bags * c / chunks);
+        int bag_end   = (int)((int64_t)num_bags * (c + 1) / chunks);
+        int64_t idx_begin = offsets[bag_begin];
+        int64_t idx_end   = zenEBBagEnd(offsets, num_bags, indices_size,
+                                        include_last_offset, bag_end);
+        items.push_back({t, bag_begin, bag_end,
+                         ((idx_end - idx_begin) + (bag_end - bag_begin)) * bytes_per_row});
+    }
+}
+
+//Splits the tables into work items: a table costs (indices + bags) * width *
+//dtype bytes, tables above total / (threads * EB_WORK_ITEMS_PER_THREAD) are
+//cut into ranges of the same number of bags.
+static std::vector<zenEBWorkItem> zenEBBuildWorkItems(
+    std::vector <memory> &z_input, std::vector <memory> &z_indices,
+    std::vector <memory> &z_offsets, std::vector <int32_t> &z_include_last_offset,
+    std::vector <memory> &z_destination, unsigned int nthr) {
+
+    int num_tables = z_input.size();
+    std::vector<double> bytes_per_row(num_tables);
+    double total = 0;
+    for (int t = 0; t < num_tables; t++) {
+        auto input_desc = z_input[t].get_desc();
+        auto dims = input_desc.dims();
+        bytes_per_row[t] = (double)input_desc.get_size() / dims[0];
+        total += (z_indices[t].get_desc().dims()[0] +
+                  z_destination[t].get_desc().dims()[0]) * bytes_per_row[t];
+    }
+    double target = total / (nthr * EB_WORK_ITEMS_PER_THREAD);
+
+    std::vector<zenEBWorkItem> items;
+    for (int t = 0; t < num_tables; t++) {
+        int num_bags         = z_destination[t].get_desc().dims()[0];
+        int64_t indices_size = z_indices[t].get_desc().dims()[0];
+        double cost          = (indices_size + num_bags) * bytes_per_row[t];
+        int chunks = target > 0 ? (int)std::min<double>(cost / target, num_bags) : 1;
+        if (chunks <= 1) {
+            items.push_back({t, 0, num_bags, cost});
+            continue;
+        }
+
+        void *offsets = z_offsets[t].get_data_handle();
+        if (z_offsets[t].get_desc().data_type() == memory::data_type::s64) {
+            zenEBSplitTable(items, t, static_cast<const int64_t *>(offsets),
+                            num_bags, indices_size, z_include_last_offset[t], chunks,
+                            bytes_per_row[t]);
+        }
+        else {
+            zenEBSplitTable(items, t, static_cast<const int32_t *>(offsets),
+                            num_bags, indices_size, z_include_last_offset[t], chunks,
+                            bytes_per_row[t]);
+        }
+    }
+    return items;
+}
+
+//Runs one work item on the calling thread. A bag range uses views of the
+//offsets and of the destination rows, offsets stay absolute into indices.
+static void zenEBRunWorkItem(const zenEBWorkItem &item,
+                             std::vector <memory> &z_input, std::vector <memory> &z_indices,
+                             std::vector <memory> &z_offsets,
+                             std::vector <int32_t> &z_scale_grad_by_freq,
+                             std::vector <algorithm> &z_modes, std::vector <int32_t> &z_sparse,
+                             std::vector <memory> &z_per_sample_weights_opt,
+                             std::vector <int32_t> &z_per_sample_weights_defined,
+                             std::vector <int32_t> &z_include_last_offset,
+                             std::vector <int32_t> &z_padding_idx,
+                             std::vector <memory> &z_destination) {
+    int t = item.table;
+    auto dst_desc = z_destination[t].get_desc();
+    int num_bags  = dst_desc.dims()[0];
+    if (item.bag_begin == 0 && item.bag_end == num_bags) {
+        zendnn_embedding_bag_exec(
+            z_input[t], z_indices[t], z_offsets[t],
+            z_scale_grad_by_freq[t], z_modes[t],
+            z_sparse[t], z_per_sample_weights_opt[t],
+            z_per_sample_weights_defined[t],
+            z_include_last_offset[t],
+            z_padding_idx[t], z_destination[t], 1);
+        return;
+    }
+
+    engine eng = z_input[t].get_engine();
+    int32_t sub_bags = item.bag_end - item.bag_begin;
+    //Every range but the last one reads its end from the next offset
+    int32_t sub_last_offset = (item.bag_end < num_bags ||
+                               z_include_last_offset[t]) ? 1 : 0;
+    auto offsets_desc = z_offsets[t].get_desc();
+    size_t offset_bytes = offsets_desc.get_size() / offsets_desc.dims()[0];
+    char *offsets = static_cast<char *>(z_offsets[t].get_data_handle());
+    memory sub_offsets({{sub_bags + sub_last_offset}, offsets_desc.data_type(),
+                        memory::format_tag::a}, eng, offsets + item.bag_begin * offset_bytes);
+
+    auto width = dst_desc.dims()[1];
+    size_t row_bytes = dst_desc.get_size() / num_bags;
+    char *dst = static_cast<char *>(z_destination[t].get_data_handle());
+    memory sub_dst({{sub_bags, width}, dst_desc.data_type(),
+                    memory::format_tag::ab}, eng, dst + item.bag_begin * row_bytes);
+
+    zendnn_embedding_bag_exec(
+        z_input[t], z_indices[t], sub_offsets,
+        z_scale_grad_by_freq[t], z_modes[t],
+        z_sparse[t], z_per_sample_weights_opt[t],
+        z_per_sample_weights_defined[t],
+        sub_last_offset,
+        z_padding_idx[t], sub_dst, 1);
+}
+
 //API call to perform embedding lookups on bags of indices and then optionally apply
 // a reduction opration(such as sum, mean or max) on the embedding within each bag.
 
@@ -232,21 +388,17 @@ void zendnn_custom_op::zendnn_grp_embedding_bag(std::vector <memory> &z_input,
     if (zenEnvObj.zenEBThreadAlgo==zenEBThreadType::CCD_THREADED) {
         thread_type="CCD_THREADED";
         omp_set_max_active_levels(2);
-        int ccd_num_threads=CCD_NUM_THREADS;
-        unsigned int outer_threads = (eb_thread_qty%ccd_num_threads)==0 ?
-                                     eb_thread_qty/ccd_num_threads: ((eb_thread_qty/ccd_num_threads)+1);
-        unsigned int rem = (eb_thread_qty%ccd_num_threads)==0 ? ccd_num_threads :
-                           eb_thread_qty%ccd_num_threads;
+        //One team of inner threads per L3 domain (CCX)
+        std::vector<unsigned int> ccd_teams =
+            zendnnCpuTopology::Instance().l3_teams(eb_thread_qty);
+        unsigned int outer_threads = ccd_teams.size();
         unsigned int loopCount = (num_tables%outer_threads)==0 ?
                                  num_tables/outer_threads : ((num_tables/outer_threads)+1);
 
         #pragma omp parallel num_threads(outer_threads)
         {
-            unsigned int inner_threads = ccd_num_threads;
             unsigned int thid = omp_get_thread_num();
-            if (thid == outer_threads-1) {
-                inner_threads = rem;
-            }
+            unsigned int inner_threads = ccd_teams[thid];
 
             for (int i=0; i<loopCount; i++) {
                 int threadOffset = thid+ (i*outer_threads);
@@ -300,6 +452,107 @@ void zendnn_custom_op::zendnn_grp_embedding_bag(std::vector <memory> &z_input,
 
     }
 
+    else if (zenEnvObj.zenEBThreadAlgo==zenEBThreadType::WORK_THREADED ||
+             zenEnvObj.zenEBThreadAlgo==zenEBThreadType::AUTO_ALGO) {
+        thread_type="WORK_THREADED";
+        std::vector<zenEBWorkItem> items = zenEBBuildWorkItems(z_input,
+                                           z_indices, z_offsets, z_include_last_offset, z_destination,
+                                           eb_thread_qty);
+        unsigned int nthr = std::max<size_t>(1, std::min<size_t>(eb_thread_qty,
+                                             items.size()));
+
+        //Longest item first to the least loaded thread
+        std::sort(items.begin(), items.end(),
+        [](const zenEBWorkItem &a, const zenEBWorkItem &b) {
+            return a.cost > b.cost;
+        });
+
+        //Items of tables bound to a node go to the queue of that node, the
+        //others are spread over one queue per thread, least loaded first
+        std::vector<int> table_node(num_tables, -1);
+        std::vector<int> cpu_node;
+        const zendnnCpuTopology &topology = zendnnCpuTopology::Instance();
+        if (zenEnvObj.zenEBNuma && topology.numa_nodes.size() > 1) {
+            bool placed = false;
+            for (int t = 0; t < num_tables; t++) {
+                table_node[t] = zendnnEmbeddingPlacement::Instance().owner(
+                                    z_input[t].get_data_handle());
+                placed = placed || table_node[t] >= 0;
+            }
+            if (placed) {
+                thread_type="WORK_THREADED_NUMA";
+                cpu_node.assign(topology.cpus.back().cpu + 1, -1);
+                for (const auto &info : topology.cpus) {
+                    cpu_node[info.cpu] = info.numa;
+                }
+            }
+        }
+
+        //Queue nthr + node holds the items of the tables bound to node
+        int max_node = -1;
+        for (int node : table_node) {
+            max_node = std::max(max_node, node);
+        }
+        const unsigned int num_queues = nthr + max_node + 1;
+        std::vector<std::vector<int>> queues(num_queues);
+        std::vector<double> load(nthr, 0);
+        for (int i = 0; i < (int)items.size(); i++) {
+            int node = table_node[items[i].table];
+            if (node >= 0) {
+                queues[nthr + node].push_back(i);
+                continue;
+            }
+            int thr = std::min_element(load.begin(), load.end()) - load.begin();
+            queues[thr].push_back(i);
+            load[thr] += items[i].cost;
+        }
+
+        //Every thread drains its own queue, then the queue of the node it
+        //runs on, found with sched_getcpu as threads need not be bound to
+        //CPUs in order, then steals from the others
+        std::vector<std::atomic<int>> heads(num_queues);
+        for (auto &head : heads) {
+            head.store(0);
+        }
+        #pragma omp parallel num_threads(nthr)
+        {
+            unsigned int thid = omp_get_thread_num();
+            int node = -1;
+#ifdef __linux__
+            if (!cpu_node.empty()) {
+                int cpu = sched_getcpu();
+                if (cpu >= 0 && cpu < (int)cpu_node.size()) {
+                    node = cpu_node[cpu];
+                }
+            }
+#endif
+            const unsigned int own = node >= 0 && node <= max_node ? nthr + node :
+                                     num_queues;
+            std::vector<unsigned int> victims;
+            victims.push_back(thid);
+            if (own < num_queues) {
+                victims.push_back(own);
+            }
+            for (unsigned int q = 1; q < num_queues; q++) {
+                unsigned int victim = (thid + q) % num_queues;
+                if (victim != own) {
+                    victims.push_back(victim);
+                }
+            }
+            for (unsigned int victim : victims) {
+                int pos;
+                while ((pos = heads[victim].fetch_add(1)) <
+                        (int)queues[victim].size()) {
+                    zenEBRunWorkItem(items[queues[victim][pos]], z_input,
+                                     z_indices, z_offsets, z_scale_grad_by_freq, z_modes,
+                                     z_sparse, z_per_sample_weights_opt,
+                                     z_per_sample_weights_defined, z_include_last_offset,
+                                     z_padding_idx, z_destination);
+                }
+            }
+        }
+    }
+
     else {
         thread_type="TABLE_THREADED";
         unsigned int loopCount = (num_tables%eb_thread_qty)==0 ?
@@ -330,6 +583,33 @@ void zendnn_custom_op::zendnn_grp_embedding_bag(std::vector <memory> &z_input,
                   ",ms");
 }
 
+//Offsets of one index per bag, s32 or s64 as the indices.
+template<typename offset_t>
+static void zenEmbeddingFillOffsets(offset_t *hndl, int64_t indices_size,
+                                    unsigned int num_thread) {
+    #pragma omp parallel for num_threads(num_thread)
+    for (int64_t k = 0; k < indices_size; k++) {
+        hndl[k] = k;
+    }
+}
+
+static memory zenEmbeddingOffsets(const memory &z_indices, const engine &eng,
+                                  unsigned int num_thread) {
+    auto indices_desc = z_indices.get_desc();
+    memory::dim indices_size = indices_desc.dims()[0];
+    memory z_offsets({{indices_size}, indices_desc.data_type(),
+        memory::format_tag::a}, eng);
+    if (indices_desc.data_type() == memory::data_type::s64) {
+        zenEmbeddingFillOffsets(static_cast<int64_t *>(z_offsets.get_data_handle()),
+                                indices_size, num_thread);
+    }
+    else {
+        zenEmbeddingFillOffsets(static_cast<int32_t *>(z_offsets.get_data_handle()),
+                                indices_size, num_thread);
+    }
+    return z_offsets;
+}
+
 //API call to perform just embedding lookup where each input index corresponds to single embedding.
 
 void zendnn_custom_op::zendnn_embedding(const memory &z_input,
@@ -344,18 +624,11 @@ void zendnn_custom_op::zendnn_embedding(const memory &z_input,
 
     engine eng;
     eng=engine(engine::kind::cpu, 0);
-    auto z_offsets=memory({{indices_size},
-        memory::data_type::s32,
-        memory::format_tag::a}, eng);
-    int32_t *hndl = static_cast<int32_t *>(z_offsets.get_data_handle());
 
     zendnnEnv zenEnvObj = readEnv();
     unsigned int num_thread = zenEnvObj.omp_num_threads;
 
-    #pragma omp parallel for num_threads(num_thread)
-    for (int k = 0; k < indices_size; k++) {
-        hndl[k] = k;
-    }
+    auto z_offsets=zenEmbeddingOffsets(z_indices, eng, num_thread);
 
     algorithm z_mode=algorithm::embedding_bag_sum;
     auto z_per_sample_weights_opt=memory({{indices_size},
@@ -394,14 +667,7 @@ void zendnn_custom_op::zendnn_grp_embedding(std::vector <memory> &z_input,
     for (int i = 0; i <  num_eb_ops; i++) {
 
         int indices_size = z_indices[i].get_desc().dims()[0];
-        z_offsets[i] = memory({{indices_size},
-            memory::data_type::s32,
-            memory::format_tag::a}, eng);
-        int32_t *hndl = static_cast<int32_t *>(z_offsets[i].get_data_handle());
-
-        for (int k = 0; k < indices_size; k++) {
-            hndl[k] = k;
-        }
+        z_offsets[i] = zenEmbeddingOffsets(z_indices[i], eng, 1);
 
         z_per_sample_weights_opt[i] = memory({{indices_size},
             memory::data_type::s32,
@@ -417,5 +683,191 @@ void zendnn_custom_op::zendnn_grp_embedding(std::vector <memory> &z_input,
 
 
 }
-}//ZenDNN
 
+template<typename idx_t>
+static void zenEmbeddingCountRows(const idx_t *indices, int64_t num_indices,
+                                  int64_t *frequencies, int64_t num_rows) {
+    for (int64_t i = 0; i < num_indices; i++) {
+        if (indices[i] >= 0 && indices[i] < num_rows) {
+            frequencies[indices[i]]++;
+        }
+    }
+}
+
+void zendnn_custom_op::zendnn_embedding_row_frequencies(
+    const memory &z_indices, memory &z_frequencies) {
+
+    if (z_frequencies.get_desc().data_type() != memory::data_type::s64) {
+        throw error(zendnn_invalid_arguments,
+                    "embedding row frequencies: counts must be s64");
+    }
+    int64_t num_indices = z_indices.get_desc().dims()[0];
+    int64_t num_rows = z_frequencies.get_desc().dims()[0];
+    int64_t *frequencies = static_cast<int64_t *>(z_frequencies.get_data_handle());
+    if (z_indices.get_desc().data_type() == memory::data_type::s64) {
+        zenEmbeddingCountRows(static_cast<int64_t *>(z_indices.get_data_handle()),
+                              num_indices, frequencies, num_rows);
+    }
+    else {
+        zenEmbeddingCountRows(static_cast<int32_t *>(z_indices.get_data_handle()),
+                              num_indices, frequencies, num_rows);
+    }
+}
+
+template<typename idx_t>
+static void zenEmbeddingFillRemap(const std::vector<int64_t> &from,
+                                  const std::vector<int64_t> &to, idx_t *remap, int64_t num_rows,
+                                  unsigned int num_threads) {
+    #pragma omp parallel for num_threads(num_threads)
+    for (int64_t r = 0; r < num_rows; r++) {
+        remap[r] = r;
+    }
+    for (size_t i = 0; i < from.size(); i++) {
+        remap[from[i]] = to[i];
+    }
+}
+
+int64_t zendnn_custom_op::zendnn_embedding_reorder_rows(memory &z_table,
+        const memory &z_frequencies, memory &z_remap, int64_t z_hot_rows) {
+
+    int64_t num_rows = z_table.get_desc().dims()[0];
+    if (z_frequencies.get_desc().dims()[0] != num_rows ||
+            z_frequencies.get_desc().data_type() != memory::data_type::s64 ||
+            z_remap.get_desc().dims()[0] != num_rows) {
+        throw error(zendnn_invalid_arguments,
+                    "embedding reorder rows: s64 frequencies and remap must match "
+                    "the table rows");
+    }
+    size_t row_bytes = num_rows ? z_table.get_desc().get_size() / num_rows : 0;
+    if (row_bytes == 0) {
+        return 0;
+    }
+    const int64_t *frequencies = static_cast<const int64_t *>
+                                 (z_frequencies.get_data_handle());
+
+    //Hot block: the most frequent rows that fit in half of an L3 domain
+    if (z_hot_rows <= 0) {
+        z_hot_rows = std::max<int64_t>(1,
+                                       zendnnCpuTopology::Instance().l3_bytes / 2 / row_bytes);
+    }
+    std::vector<int64_t> hot;
+    for (int64_t r = 0; r < num_rows; r++) {
+        if (frequencies[r] > 0) {
+            hot.push_back(r);
+        }
+    }
+    z_hot_rows = std::min<int64_t>(z_hot_rows, hot.size());
+    std::partial_sort(hot.begin(), hot.begin() + z_hot_rows, hot.end(),
+    [&](int64_t a, int64_t b) {
+        return frequencies[a] > frequencies[b] ||
+               (frequencies[a] == frequencies[b] && a < b);
+    });
+    hot.resize(z_hot_rows);
+
+    //Only the hot rows and the cold rows of the top block move: hot row h
+    //goes to row h, the displaced cold rows take the places the hot rows
+    //below the block leave, in ascending order. The table is permuted in
+    //place through a copy of the hot block.
+    std::vector<bool> is_hot(num_rows, false);
+    for (auto r : hot) {
+        is_hot[r] = true;
+    }
+    std::vector<int64_t> displaced, vacated;
+    for (int64_t r = 0; r < z_hot_rows; r++) {
+        if (!is_hot[r]) {
+            displaced.push_back(r);
+        }
+    }
+    for (int64_t r = z_hot_rows; r < num_rows && vacated.size() < displaced.size();
+            r++) {
+        if (is_hot[r]) {
+            vacated.push_back(r);
+        }
+    }
+
+    char *table = static_cast<char *>(z_table.get_data_handle());
+    std::vector<char> hot_block(z_hot_rows * row_bytes);
+    zendnnEnv zenEnvObj = readEnv();
+    #pragma omp parallel for num_threads(zenEnvObj.omp_num_threads)
+    for (int64_t h = 0; h < z_hot_rows; h++) {
+        std::memcpy(hot_block.data() + h * row_bytes, table + hot[h] * row_bytes,
+                    row_bytes);
+    }
+    #pragma omp parallel for num_threads(zenEnvObj.omp_num_threads)
+    for (int64_t i = 0; i < (int64_t)displaced.size(); i++) {
+        std::memcpy(table + vacated[i] * row_bytes, table + displaced[i] * row_bytes,
+                    row_bytes);
+    }
+    std::memcpy(table, hot_block.data(), hot_block.size());
+
+    std::vector<int64_t> from(hot), to(z_hot_rows);
+    for (int64_t h = 0; h < z_hot_rows; h++) {
+        to[h] = h;
+    }
+    from.insert(from.end(), displaced.begin(), displaced.end());
+    to.insert(to.end(), vacated.begin(), vacated.end());
+    if (z_remap.get_desc().data_type() == memory::data_type::s64) {
+        zenEmbeddingFillRemap(from, to, static_cast<int64_t *>
+                              (z_remap.get_data_handle()), num_rows, zenEnvObj.omp_num_threads);
+    }
+    else {
+        zenEmbeddingFillRemap(from, to, static_cast<int32_t *>
+                              (z_remap.get_data_handle()), num_rows, zenEnvObj.omp_num_threads);
+    }
+
+    zendnnVerbose(ZENDNN_PROFLOG, "zendnn_custom_op_execute,cpu,embedding_reorder_rows,",
+                  "rows:", num_rows, ",", "row_bytes:", row_bytes, ",",
+                  "hot_rows:", z_hot_rows, ",", "moved_rows:", from.size());
+    return z_hot_rows;
+}
+
+//Indices outside the remap are left as they are and counted
+template<typename idx_t, typename remap_t>
+static int64_t zenEmbeddingRemapIndices(const remap_t *remap, int64_t num_rows,
+                                        idx_t *indices, int64_t num_indices, unsigned int num_threads) {
+    int64_t invalid = 0;
+    #pragma omp parallel for num_threads(num_threads) reduction(+:invalid)
+    for (int64_t i = 0; i < num_indices; i++) {
+        if (indices[i] < 0 || indices[i] >= num_rows) {
+            invalid++;
+            continue;
+        }
+        indices[i] = remap[indices[i]];
+    }
+    return invalid;
+}
+
+void zendnn_custom_op::zendnn_embedding_remap_indices(const memory &z_remap,
+        memory &z_indices) {
+
+    int64_t num_indices = z_indices.get_desc().dims()[0];
+    int64_t num_rows = z_remap.get_desc().dims()[0];
+    unsigned int num_threads = readEnv().omp_num_threads;
+    bool remap_s64 = z_remap.get_desc().data_type() == memory::data_type::s64;
+    bool indices_s64 = z_indices.get_desc().data_type() == memory::data_type::s64;
+    void *remap = z_remap.get_data_handle();
+    void *indices = z_indices.get_data_handle();
+    int64_t invalid;
+    if (remap_s64 && indices_s64) {
+        invalid = zenEmbeddingRemapIndices(static_cast<int64_t *>(remap), num_rows,
+                                           static_cast<int64_t *>(indices), num_indices, num_threads);
+    }
+    else if (remap_s64) {
+        invalid = zenEmbeddingRemapIndices(static_cast<int64_t *>(remap), num_rows,
+                                           static_cast<int32_t *>(indices), num_indices, num_threads);
+    }
+    else if (indices_s64) {
+        invalid = zenEmbeddingRemapIndices(static_cast<int32_t *>(remap), num_rows,
+                                           static_cast<int64_t *>(indices), num_indices, num_threads);
+    }
+    else {
+        invalid = zenEmbeddingRemapIndices(static_cast<int32_t *>(remap), num_rows,
+                                           static_cast<int32_t *>(indices), num_indices, num_threads);
+    }
+    if (invalid) {
+        throw error(zendnn_invalid_arguments,
+                    "embedding remap indices: indices outside the table rows");
+    }
+}
+
+}//ZenDNN
@@ -0,0 +1,138 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//1x1 convolutions (NHWC) whose post-ops are applied per L2 sized GEMM tile,
+//against the same convolution without post-ops followed by the post-ops.
+//Bias+ReLU, batchnorm and batchnorm+elementwise add+ReLU are run on a layer
+//of many small rows, split in several tiles, and on a layer of large
+//filters, multiplied in one GEMM.
+//
+//Usage: zendnn_conv_postops_tiled [batch]
+//  batch : images per call (default 1, the 1x1 direct GEMM path)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "zendnn_helper.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+
+struct layer {
+    int channels, height, width, filters;
+};
+
+//0 bias+relu, 1 batchnorm, 2 batchnorm+elementwise add+relu
+const char *post_op_names[] = {"bias_relu", "batchnorm", "batchnorm_add_relu"};
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_conv_postops_tiled test starts");
+    int batch = argc > 1 ? std::stoi(std::string(argv[1])) : 1;
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+
+    const layer layers[] = {
+        {32, 224, 224, 32},
+        {64, 112, 112, 128},
+        {1024, 14, 14, 1024}
+    };
+
+    std::cout<<"post_ops,batch,channels,height,width,filters,rel_diff,ms"<<std::endl;
+    int status = 0;
+    for (const auto &l : layers) {
+        const size_t src_size = (size_t)batch * l.height * l.width * l.channels;
+        const size_t dst_size = (size_t)batch * l.height * l.width * l.filters;
+        std::vector<float> src(src_size), wei((size_t)l.channels * l.filters);
+        std::vector<float> bias(l.filters), scale(l.filters), mean(l.filters),
+            offset(l.filters), elementwise(dst_size);
+        for (auto *v : {
+                    &src, &bias, &mean, &offset, &elementwise
+                }) {
+            for (auto &x : *v) {
+                x = dis(gen);
+            }
+        }
+        for (auto &x : wei) {
+            x = dis(gen) / l.channels;
+        }
+        for (auto &x : scale) {
+            x = 1.0f + 0.5f * dis(gen);
+        }
+
+        //Untiled: no post-ops, one GEMM per thread
+        std::vector<float> plain(dst_size);
+        zenConvolution2D(src.data(), batch, l.channels, l.height, l.width, wei.data(),
+                         l.filters, 1, 1, 0, 0, 0, 0, 1, 1, plain.data(), l.height, l.width);
+
+        for (int p = 0; p < 3; p++) {
+            std::vector<float> out(dst_size);
+            auto begin = std::chrono::steady_clock::now();
+            if (p == 0) {
+                zenConvolution2DwithBiasRelu(src.data(), batch, l.channels, l.height,
+                                             l.width, wei.data(), l.filters, 1, 1, 0, 0, 0, 0, 1, 1, bias.data(),
+                                             out.data(), l.height, l.width);
+            }
+            else if (p == 1) {
+                zenConvolution2DwithBatchNorm(src.data(), batch, l.channels, l.height,
+                                              l.width, wei.data(), l.filters, 1, 1, 0, 0, 0, 0, 1, 1, scale.data(),
+                                              mean.data(), offset.data(), out.data(), l.height, l.width);
+            }
+            else {
+                zenConvolution2DwithBatchNormsum(src.data(), batch, l.channels, l.height,
+                                                 l.width, wei.data(), l.filters, 1, 1, 0, 0, 0, 0, 1, 1, scale.data(),
+                                                 mean.data(), offset.data(), elementwise.data(), out.data(), l.height,
+                                                 l.width);
+            }
+            auto end = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+            float diff = 0.0f, range = 0.0f;
+            for (size_t i = 0; i < dst_size; i++) {
+                const int c = i % l.filters;
+                float ref = plain[i];
+                if (p == 0) {
+                    ref = std::max(ref + bias[c], 0.0f);
+                }
+                else {
+                    ref = ref * scale[c] + (offset[c] - scale[c] * mean[c]);
+                    if (p == 2) {
+                        ref = std::max(ref + elementwise[i], 0.0f);
+                    }
+                }
+                diff = std::max(diff, std::fabs(ref - out[i]));
+                range = std::max(range, std::fabs(ref));
+            }
+            float rel_diff = diff / range;
+            std::cout<<post_op_names[p]<<","<<batch<<","<<l.channels<<","<<l.height
+                     <<","<<l.width<<","<<l.filters<<","<<rel_diff<<","<<ms<<std::endl;
+            if (rel_diff > 1e-5f) {
+                status = 1;
+            }
+        }
+    }
+
+    std::cout<<(status ? "Tiled convolution post-ops mismatch" :
+                "Tiled convolution post-ops passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_conv_postops_tiled test ends");
+    return status;
+}
@@ -0,0 +1,159 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Convolutions (NHWC) on the GEMM path with the im2row patch matrix built in
+//row blocks of at most ZENDNN_CONV_PATCH_KB, against a direct reference. A
+//small budget splits the wide layers down to a single output row per block.
+//
+//Usage: conv_tiled_im2row [patch_kb] [batch]
+//  patch_kb : patch block budget in KB, 0 is half of L2 (default 16)
+//  batch    : images per call, more than one (default 2)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+#ifdef _WIN32
+    #define setenv(name, value, overwrite) _putenv_s(name, value)
+#endif
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+struct layer {
+    int channels, height, width, filters, kernel_h, kernel_w, stride, pad;
+};
+
+//Direct convolution, src NHWC, weights HWCN, dst NHWC
+std::vector<float> reference_conv(const std::vector<float> &src,
+                                  const std::vector<float> &wei, const std::vector<float> &bias,
+                                  int batch, const layer &l, int out_h, int out_w) {
+    std::vector<float> dst((size_t)batch * out_h * out_w * l.filters);
+    for (int n = 0; n < batch; n++)
+        for (int oh = 0; oh < out_h; oh++)
+            for (int ow = 0; ow < out_w; ow++)
+                for (int k = 0; k < l.filters; k++) {
+                    double acc = bias[k];
+                    for (int i = 0; i < l.kernel_h; i++)
+                        for (int j = 0; j < l.kernel_w; j++) {
+                            int h = oh * l.stride + i - l.pad, w = ow * l.stride + j - l.pad;
+                            if (h < 0 || h >= l.height || w < 0 || w >= l.width) {
+                                continue;
+                            }
+                            for (int c = 0; c < l.channels; c++) {
+                                acc += (double)src[(((size_t)n * l.height + h) * l.width + w) *
+                                                   l.channels + c] *
+                                       wei[((size_t)(i * l.kernel_w + j) * l.channels + c) * l.filters + k];
+                            }
+                        }
+                    dst[(((size_t)n * out_h + oh) * out_w + ow) * l.filters + k] = acc;
+                }
+    return dst;
+}
+
+int main(int argc, char **argv) {
+    std::string patch_kb = argc > 1 ? argv[1] : "16";
+    int batch = argc > 2 ? std::stoi(std::string(argv[2])) : 2;
+    //The environment is read once, before the first primitive
+    setenv("ZENDNN_CONV_ALGO", "1", 1);
+    setenv("ZENDNN_CONV_PATCH_KB", patch_kb.c_str(), 1);
+
+    zendnnInfo(ZENDNN_TESTLOG, "conv_tiled_im2row test starts");
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+
+    const layer layers[] = {
+        {16, 96, 160, 32, 3, 3, 1, 1},
+        {32, 64, 320, 32, 3, 3, 1, 1},
+        {24, 48, 96, 48, 1, 7, 1, 0},
+        {8, 80, 120, 16, 5, 5, 2, 2}
+    };
+
+    std::cout<<"patch_kb,batch,channels,height,width,filters,kernel,stride,rel_diff,ms"
+             <<std::endl;
+    int status = 0;
+    for (const auto &l : layers) {
+        const int out_h = (l.height + 2 * l.pad - l.kernel_h) / l.stride + 1;
+        const int out_w = (l.width + 2 * l.pad - l.kernel_w) / l.stride + 1;
+        std::vector<float> src((size_t)batch * l.height * l.width * l.channels);
+        std::vector<float> wei((size_t)l.kernel_h * l.kernel_w * l.channels *
+                               l.filters), bias(l.filters);
+        for (auto &v : src) {
+            v = dis(gen);
+        }
+        for (auto &v : wei) {
+            v = dis(gen) / l.channels;
+        }
+        for (auto &v : bias) {
+            v = dis(gen);
+        }
+
+        auto src_mem = memory({{batch, l.channels, l.height, l.width}, dt::f32, tag::nhwc},
+                              eng, src.data());
+        auto wei_mem = memory({{l.filters, l.channels, l.kernel_h, l.kernel_w}, dt::f32, tag::hwio},
+                              eng, wei.data());
+        auto bias_mem = memory({{l.filters}, dt::f32, tag::x}, eng, bias.data());
+        auto dst_mem = memory({{batch, l.filters, out_h, out_w}, dt::f32, tag::nhwc},
+                              eng);
+        auto conv_desc = convolution_forward::desc(prop_kind::forward_inference,
+                         algorithm::convolution_gemm, src_mem.get_desc(), wei_mem.get_desc(),
+                         bias_mem.get_desc(), dst_mem.get_desc(), {l.stride, l.stride},
+        {l.pad, l.pad}, {l.pad, l.pad});
+        auto conv = convolution_forward(convolution_forward::primitive_desc(conv_desc,
+                                        eng));
+
+        auto begin = std::chrono::steady_clock::now();
+        conv.execute(s, {{ZENDNN_ARG_SRC, src_mem}, {ZENDNN_ARG_WEIGHTS, wei_mem},
+            {ZENDNN_ARG_BIAS, bias_mem}, {ZENDNN_ARG_DST, dst_mem}
+        });
+        s.wait();
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+        std::vector<float> ref = reference_conv(src, wei, bias, batch, l, out_h,
+                                                out_w);
+        std::vector<float> out(ref.size());
+        read_from_zendnn_memory(out.data(), dst_mem);
+        float diff = 0.0f, scale = 0.0f;
+        for (size_t i = 0; i < ref.size(); i++) {
+            diff = std::max(diff, std::fabs(ref[i] - out[i]));
+            scale = std::max(scale, std::fabs(ref[i]));
+        }
+        float rel_diff = diff / scale;
+        std::cout<<patch_kb<<","<<batch<<","<<l.channels<<","<<l.height<<","
+                 <<l.width<<","<<l.filters<<","<<l.kernel_h<<"x"<<l.kernel_w<<","
+                 <<l.stride<<","<<rel_diff<<","<<ms<<std::endl;
+        if (rel_diff > 1e-5f) {
+            status = 1;
+        }
+    }
+
+    std::cout<<(status ? "Tiled im2row convolution mismatch" :
+                "Tiled im2row convolution passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "conv_tiled_im2row test ends");
+    return status;
+}
@@ -0,0 +1,165 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//3x3 convolutions (NHWC, stride 1) on the Winograd path for one output tile,
+//against a direct reference. Every layer is run twice with weight caching
+//on, so the second run uses the cached filter transform, and the time of
+//the cached run is reported. Output sizes that are not a multiple of the
+//tile check the cropped edge tiles.
+//
+//Usage: conv_winograd [tile] [batch]
+//  tile  : 2, 4 or 6, 0 picks it from the output size (default 0)
+//  batch : images per call, more than one (default 2)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+#ifdef _WIN32
+    #define setenv(name, value, overwrite) _putenv_s(name, value)
+#endif
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Direct convolution, src NHWC, weights HWCN, dst NHWC
+std::vector<float> reference_conv(const std::vector<float> &src,
+                                  const std::vector<float> &wei, const std::vector<float> &bias,
+                                  int batch, int height, int width, int channels, int filters, int pad,
+                                  int out_h, int out_w) {
+    std::vector<float> dst((size_t)batch * out_h * out_w * filters);
+    for (int n = 0; n < batch; n++)
+        for (int oh = 0; oh < out_h; oh++)
+            for (int ow = 0; ow < out_w; ow++)
+                for (int k = 0; k < filters; k++) {
+                    double acc = bias[k];
+                    for (int i = 0; i < 3; i++)
+                        for (int j = 0; j < 3; j++) {
+                            int h = oh + i - pad, w = ow + j - pad;
+                            if (h < 0 || h >= height || w < 0 || w >= width) {
+                                continue;
+                            }
+                            for (int c = 0; c < channels; c++) {
+                                acc += (double)src[(((size_t)n * height + h) * width + w) * channels + c] *
+                                       wei[((size_t)(i * 3 + j) * channels + c) * filters + k];
+                            }
+                        }
+                    dst[(((size_t)n * out_h + oh) * out_w + ow) * filters + k] = acc;
+                }
+    return dst;
+}
+
+int main(int argc, char **argv) {
+    std::string tile = argc > 1 ? argv[1] : "0";
+    int batch = argc > 2 ? std::stoi(std::string(argv[2])) : 2;
+    //The environment is read once, before the first primitive
+    setenv("ZENDNN_CONV_ALGO", "2", 1);
+    setenv("ZENDNN_WINOGRAD_TILE", tile.c_str(), 1);
+    setenv("ZENDNN_WEIGHT_CACHING", "1", 0);
+
+    zendnnInfo(ZENDNN_TESTLOG, "conv_winograd test starts");
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+
+    struct layer {
+        int channels, height, width, filters, pad;
+    };
+    const layer layers[] = {
+        {64, 56, 56, 64, 1},
+        {128, 28, 28, 128, 1},
+        {32, 14, 14, 48, 1},
+        {16, 12, 18, 24, 0},
+        {256, 8, 8, 256, 1}
+    };
+
+    std::cout<<"tile,batch,channels,height,width,filters,pad,rel_diff,ms"<<std::endl;
+    int status = 0;
+    for (const auto &l : layers) {
+        const int out_h = l.height + 2 * l.pad - 2;
+        const int out_w = l.width + 2 * l.pad - 2;
+        std::vector<float> src((size_t)batch * l.height * l.width * l.channels);
+        std::vector<float> wei((size_t)9 * l.channels * l.filters), bias(l.filters);
+        for (auto &v : src) {
+            v = dis(gen);
+        }
+        for (auto &v : wei) {
+            v = dis(gen) / l.channels;
+        }
+        for (auto &v : bias) {
+            v = dis(gen);
+        }
+
+        auto src_mem = memory({{batch, l.channels, l.height, l.width}, dt::f32, tag::nhwc},
+                              eng, src.data());
+        auto wei_mem = memory({{l.filters, l.channels, 3, 3}, dt::f32, tag::hwio},
+                              eng, wei.data());
+        auto bias_mem = memory({{l.filters}, dt::f32, tag::x}, eng, bias.data());
+        auto dst_mem = memory({{batch, l.filters, out_h, out_w}, dt::f32, tag::nhwc},
+                              eng);
+        auto conv_desc = convolution_forward::desc(prop_kind::forward_inference,
+                         algorithm::convolution_gemm, src_mem.get_desc(), wei_mem.get_desc(),
+                         bias_mem.get_desc(), dst_mem.get_desc(), {1, 1}, {l.pad, l.pad},
+        {l.pad, l.pad});
+        auto conv = convolution_forward(convolution_forward::primitive_desc(conv_desc,
+                                        eng));
+        std::unordered_map<int, memory> args = {{ZENDNN_ARG_SRC, src_mem},
+            {ZENDNN_ARG_WEIGHTS, wei_mem}, {ZENDNN_ARG_BIAS, bias_mem},
+            {ZENDNN_ARG_DST, dst_mem}
+        };
+
+        std::vector<float> ref = reference_conv(src, wei, bias, batch, l.height,
+                                                l.width, l.channels, l.filters, l.pad, out_h, out_w);
+        double ms = 0.0;
+        float rel_diff = 0.0f;
+        for (int run = 0; run < 2; run++) {
+            auto begin = std::chrono::steady_clock::now();
+            conv.execute(s, args);
+            s.wait();
+            auto end = std::chrono::steady_clock::now();
+            ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+            std::vector<float> out(ref.size());
+            read_from_zendnn_memory(out.data(), dst_mem);
+            float diff = 0.0f, scale = 0.0f;
+            for (size_t i = 0; i < ref.size(); i++) {
+                diff = std::max(diff, std::fabs(ref[i] - out[i]));
+                scale = std::max(scale, std::fabs(ref[i]));
+            }
+            rel_diff = std::max(rel_diff, diff / scale);
+        }
+        std::cout<<tile<<","<<batch<<","<<l.channels<<","<<l.height<<","<<l.width<<","
+                 <<l.filters<<","<<l.pad<<","<<rel_diff<<","<<ms<<std::endl;
+        if (rel_diff > 1e-4f) {
+            status = 1;
+        }
+    }
+
+    std::cout<<(status ? "Winograd convolution mismatch" :
+                "Winograd convolution passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "conv_winograd test ends");
+    return status;
+}
@@ -0,0 +1,185 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Attention incremental decode against a paged KV cache. Generates S tokens
+//one at a time, every step appends the token's K/V to the cache and attends
+//over the history. The last step must match multihead_attention over the
+//whole sequence (last query row). Reports the average time per token.
+//
+//Usage: zendnn_attention_decode_f32 [S] [N] [H] [B] [page_size]
+//  S         : tokens to generate (default 300)
+//  N, H      : number of heads and head size (default 8 x 64)
+//  B         : sequences decoded together (default 2)
+//  page_size : tokens per KV cache page (default 16)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_attention_decode_f32 test starts");
+
+    memory::dim S = 300, N = 8, H = 64, B = 2, page_size = 16;
+    if (argc > 1) {
+        S = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        N = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        H = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        B = std::stoi(std::string(argv[4]));
+    }
+    if (argc > 5) {
+        page_size = std::stoi(std::string(argv[5]));
+    }
+
+    engine eng(engine::kind::cpu, 0);
+    stream engine_stream(eng);
+
+    const memory::dim E = N * H;
+    const memory::dim max_pages = (S + page_size - 1) / page_size;
+    const memory::dim num_pages = B * max_pages;
+    const float scale = 1 / std::sqrt((float)H);
+
+    //Whole sequence, token t of sequence b is row b * S + t
+    std::vector<float> src_data(B * S * E), weights_data(E * E), bias_data(E),
+        mask_data(B * S, 1.0f);
+    for (size_t i = 0; i < src_data.size(); i++) {
+        src_data[i] = std::cos(i / 10.f);
+    }
+    for (size_t i = 0; i < weights_data.size(); i++) {
+        weights_data[i] = std::sin(i * 2.f) / std::sqrt((float)E);
+    }
+    for (size_t i = 0; i < bias_data.size(); i++) {
+        bias_data[i] = std::tanh(i);
+    }
+
+    auto weights_md = memory::desc({E, E}, dt::f32, tag::ab);
+    auto bias_md = memory::desc({E}, dt::f32, tag::a);
+    auto weights_mem = memory(weights_md, eng, weights_data.data());
+    auto bias_mem = memory(bias_md, eng, bias_data.data());
+
+    //Reference: full sequence attention
+    auto seq_md = memory::desc({B, S, E}, dt::f32, tag::abc);
+    auto seq_mask_md = memory::desc({B, S}, dt::f32, tag::ab);
+    std::vector<float> ref_dst(B * S * E);
+    auto seq_mem = memory(seq_md, eng, src_data.data());
+    auto seq_mask_mem = memory(seq_mask_md, eng, mask_data.data());
+    auto ref_dst_mem = memory(seq_md, eng, ref_dst.data());
+    primitive_attr attn_attr;
+    auto ref_desc = attention::desc(prop_kind::forward_inference,
+                                    algorithm::multihead_attention, seq_md, seq_md, seq_md,
+                                    weights_md, weights_md, weights_md, bias_md, bias_md, bias_md,
+                                    seq_mask_md, seq_md, scale, N, 1);
+    auto ref_pd = attention::primitive_desc(ref_desc, attn_attr, eng);
+    attention(ref_pd).execute(engine_stream, {{ZENDNN_ARG_SRC_0, seq_mem},
+        {ZENDNN_ARG_SRC_1, seq_mem}, {ZENDNN_ARG_SRC_2, seq_mem},
+        {ZENDNN_ARG_WEIGHTS_0, weights_mem}, {ZENDNN_ARG_WEIGHTS_1, weights_mem},
+        {ZENDNN_ARG_WEIGHTS_2, weights_mem}, {ZENDNN_ARG_BIAS_0, bias_mem},
+        {ZENDNN_ARG_BIAS_1, bias_mem}, {ZENDNN_ARG_BIAS_2, bias_mem},
+        {ZENDNN_ARG_MASK, seq_mask_mem}, {ZENDNN_ARG_DST, ref_dst_mem}
+    });
+    engine_stream.wait();
+
+    //Decode: one token per step, pages of a sequence are interleaved with
+    //the pages of the other sequences in the cache
+    std::vector<float> token_data(B * E), dst_data(B * E),
+        kv_cache_data(num_pages * 2 * page_size * E),
+        decode_mask_data(B * max_pages * page_size, 1.0f);
+    std::vector<int32_t> index_data(B * (1 + max_pages));
+    for (memory::dim b = 0; b < B; b++) {
+        index_data[b * (1 + max_pages)] = 0;
+        for (memory::dim p = 0; p < max_pages; p++) {
+            index_data[b * (1 + max_pages) + 1 + p] = p * B + b;
+        }
+    }
+    auto token_md = memory::desc({B, 1, E}, dt::f32, tag::abc);
+    auto decode_mask_md = memory::desc({B, max_pages * page_size}, dt::f32,
+                                       tag::ab);
+    auto kv_cache_md = memory::desc({num_pages, 2, page_size, E}, dt::f32,
+                                    tag::abcd);
+    auto index_md = memory::desc({B, 1 + max_pages}, dt::s32, tag::ab);
+    auto token_mem = memory(token_md, eng, token_data.data());
+    auto dst_mem = memory(token_md, eng, dst_data.data());
+    auto decode_mask_mem = memory(decode_mask_md, eng, decode_mask_data.data());
+    auto kv_cache_mem = memory(kv_cache_md, eng, kv_cache_data.data());
+    auto index_mem = memory(index_md, eng, index_data.data());
+
+    auto decode_desc = attention::desc(prop_kind::forward_inference,
+                                       algorithm::multihead_attention, token_md, token_md, token_md,
+                                       weights_md, weights_md, weights_md, bias_md, bias_md, bias_md,
+                                       decode_mask_md, kv_cache_md, index_md, token_md, scale, N, 1);
+    auto decode_pd = attention::primitive_desc(decode_desc, attn_attr, eng);
+    auto decode_prim = attention(decode_pd);
+    std::cout<<"# "<<decode_pd.impl_info_str()<<std::endl;
+    std::unordered_map<int, memory> decode_args = {{ZENDNN_ARG_SRC_0, token_mem},
+        {ZENDNN_ARG_SRC_1, token_mem}, {ZENDNN_ARG_SRC_2, token_mem},
+        {ZENDNN_ARG_WEIGHTS_0, weights_mem}, {ZENDNN_ARG_WEIGHTS_1, weights_mem},
+        {ZENDNN_ARG_WEIGHTS_2, weights_mem}, {ZENDNN_ARG_BIAS_0, bias_mem},
+        {ZENDNN_ARG_BIAS_1, bias_mem}, {ZENDNN_ARG_BIAS_2, bias_mem},
+        {ZENDNN_ARG_MASK, decode_mask_mem}, {ZENDNN_ARG_KV_CACHE, kv_cache_mem},
+        {ZENDNN_ARG_KV_CACHE_INDEX, index_mem}, {ZENDNN_ARG_DST, dst_mem}
+    };
+
+    double total_ms = 0;
+    for (memory::dim t = 0; t < S; t++) {
+        for (memory::dim b = 0; b < B; b++) {
+            std::copy(src_data.begin() + (b * S + t) * E,
+                      src_data.begin() + (b * S + t + 1) * E, token_data.begin() + b * E);
+        }
+        auto begin = std::chrono::steady_clock::now();
+        decode_prim.execute(engine_stream, decode_args);
+        engine_stream.wait();
+        auto end = std::chrono::steady_clock::now();
+        total_ms += std::chrono::duration<double, std::milli>(end - begin).count();
+        for (memory::dim b = 0; b < B; b++) {
+            index_data[b * (1 + max_pages)]++;
+        }
+    }
+
+    float max_diff = 0.0f;
+    for (memory::dim b = 0; b < B; b++) {
+        for (memory::dim e = 0; e < E; e++) {
+            max_diff = std::max(max_diff, std::fabs(dst_data[b * E + e] -
+                                ref_dst[(b * S + S - 1) * E + e]));
+        }
+    }
+
+    std::cout<<"B="<<B<<" S="<<S<<" N="<<N<<" H="<<H<<" page_size="<<page_size
+             <<std::endl;
+    std::cout<<"ms_per_token,max_abs_diff"<<std::endl;
+    std::cout<<total_ms / S<<","<<max_diff<<std::endl;
+
+    int status = max_diff > 1e-3f ? 1 : 0;
+    std::cout<<(status ? "Decode attention mismatch" : "Decode attention passed")
+             <<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_attention_decode_f32 test ends");
+    return status;
+}
@@ -0,0 +1,298 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Embedding bag backward and fused optimizer update. For sum (with and
+//without per sample weights), mean and max, with scale_grad_by_freq and a
+//padding_idx, the row sparse gradient of zendnn_embedding_bag_backward is
+//checked against a dense reference gradient, and the tables updated by
+//zendnn_embedding_bag_update with SGD and row-wise Adagrad against the
+//reference step. The time per call of the fused update is reported.
+//
+//Usage: embedding_bag_backward [width] [batch_size] [pool_size]
+//  width      : embedding dimension (default 64)
+//  batch_size : number of bags (default 512)
+//  pool_size  : indices per bag (default 20)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+using optimizer = zendnn_custom_op::embedding_optimizer;
+
+//Dense gradient of the table, computed directly from the definition
+std::vector<float> reference_gradient(const std::vector<float> &table,
+                                      const std::vector<float> &grad_output, const std::vector<int32_t> &indices,
+                                      const std::vector<int32_t> &offsets, const std::vector<float> &psw,
+                                      algorithm mode, bool scale_grad_by_freq, int32_t padding_idx, int rows,
+                                      int width) {
+    std::vector<float> grad((size_t)rows * width, 0.0f);
+    std::vector<int> freq(rows, 0);
+    const int num_indices = indices.size(), num_bags = offsets.size();
+    for (int b = 0; b < num_bags; b++) {
+        int first = offsets[b];
+        int last = b + 1 < num_bags ? offsets[b + 1] : num_indices;
+        int count = 0;
+        for (int i = first; i < last; i++) {
+            if (indices[i] != padding_idx) {
+                count++;
+                freq[indices[i]]++;
+            }
+        }
+        for (int j = 0; j < width; j++) {
+            float go = grad_output[b * width + j];
+            int max_i = -1;
+            for (int i = first; i < last; i++) {
+                if (indices[i] == padding_idx) {
+                    continue;
+                }
+                if (mode == algorithm::embedding_bag_max) {
+                    if (max_i < 0 ||
+                            table[indices[i] * width + j] > table[indices[max_i] * width + j]) {
+                        max_i = i;
+                    }
+                }
+                else {
+                    float w = mode == algorithm::embedding_bag_mean ? 1.0f / count :
+                              psw.empty() ? 1.0f : psw[i];
+                    grad[indices[i] * width + j] += w * go;
+                }
+            }
+            if (max_i >= 0) {
+                grad[indices[max_i] * width + j] += go;
+            }
+        }
+    }
+    if (scale_grad_by_freq && mode != algorithm::embedding_bag_max) {
+        for (int r = 0; r < rows; r++) {
+            for (int j = 0; j < width && freq[r]; j++) {
+                grad[r * width + j] /= freq[r];
+            }
+        }
+    }
+    return grad;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_backward test starts");
+
+    int width = 64, batch_size = 512, pool_size = 20;
+    if (argc > 1) {
+        width = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        batch_size = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        pool_size = std::stoi(std::string(argv[3]));
+    }
+    //Few rows, so that rows repeat within and across bags
+    const int rows = 1000, padding_idx = 7, iters = 20;
+    const int indices_size = batch_size * pool_size;
+    const float lr = 0.05f, eps = 1e-10f;
+
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<> dis_row(0, rows - 1);
+    std::uniform_real_distribution<float> dis_val(-1.0f, 1.0f);
+
+    std::vector<int32_t> indices(indices_size), offsets(batch_size);
+    for (auto &i : indices) {
+        i = dis_row(gen);
+    }
+    for (int b = 0; b < batch_size; b++) {
+        offsets[b] = b * pool_size;
+    }
+    std::vector<float> table_data(rows * width), grad_data(batch_size * width),
+        psw_data(indices_size);
+    for (auto &v : table_data) {
+        v = dis_val(gen);
+    }
+    for (auto &v : grad_data) {
+        v = dis_val(gen);
+    }
+    for (auto &v : psw_data) {
+        v = dis_val(gen);
+    }
+    auto indices_mem = memory({{indices_size}, dt::s32, tag::a}, eng,
+                              indices.data());
+    auto offsets_mem = memory({{batch_size}, dt::s32, tag::a}, eng,
+                              offsets.data());
+    auto grad_mem = memory({{batch_size, width}, dt::f32, tag::ab}, eng,
+                           grad_data.data());
+    auto psw_mem = memory({{indices_size}, dt::f32, tag::a}, eng,
+                          psw_data.data());
+
+    std::cout<<"case,rows,gradient_max_abs_diff,sgd_max_abs_diff,"
+             <<"adagrad_max_abs_diff"<<std::endl;
+    int status = 0;
+    struct test_case {
+        const char *name;
+        algorithm mode;
+        bool weighted;
+        bool scale_grad_by_freq;
+    };
+    const test_case cases[] = {
+        {"sum", algorithm::embedding_bag_sum, false, false},
+        {"sum_weighted", algorithm::embedding_bag_sum, true, false},
+        {"sum_freq", algorithm::embedding_bag_sum, false, true},
+        {"mean", algorithm::embedding_bag_mean, false, false},
+        {"mean_freq", algorithm::embedding_bag_mean, false, true},
+        {"max", algorithm::embedding_bag_max, false, false}
+    };
+    for (const auto &tc : cases) {
+        std::vector<float> table(table_data);
+        auto table_mem = memory({{rows, width}, dt::f32, tag::ab}, eng, table.data());
+        std::vector<float> ref = reference_gradient(table_data, grad_data, indices,
+                                 offsets, tc.weighted ? psw_data : std::vector<float>(), tc.mode,
+                                 tc.scale_grad_by_freq, padding_idx, rows, width);
+
+        //Row sparse gradient
+        std::vector<int64_t> grad_indices(indices_size);
+        std::vector<float> grad_values((size_t)indices_size * width);
+        auto grad_indices_mem = memory({{indices_size}, dt::s64, tag::a}, eng,
+                                       grad_indices.data());
+        auto grad_values_mem = memory({{indices_size, width}, dt::f32, tag::ab}, eng,
+                                      grad_values.data());
+        int64_t num_unique = zendnn_custom_op::zendnn_embedding_bag_backward(
+                                 table_mem, grad_mem, indices_mem, offsets_mem, tc.scale_grad_by_freq,
+                                 tc.mode, psw_mem, tc.weighted, false, padding_idx, grad_indices_mem,
+                                 grad_values_mem);
+        std::vector<bool> used(rows, false);
+        for (auto i : indices) {
+            used[i] = i != padding_idx;
+        }
+        float grad_diff = num_unique == std::count(used.begin(), used.end(),
+                          true) ? 0.0f : INFINITY;
+        for (int64_t k = 0; k < num_unique && grad_diff == 0.0f; k++) {
+            for (int j = 0; j < width; j++) {
+                grad_diff = std::max(grad_diff,
+                                     std::fabs(grad_values[k * width + j] - ref[grad_indices[k] * width + j]));
+            }
+        }
+        for (int64_t k = 1; k < num_unique; k++) {
+            if (grad_indices[k] <= grad_indices[k - 1]) {
+                grad_diff = INFINITY;
+            }
+        }
+
+        //Fused SGD and row-wise Adagrad steps
+        float sgd_diff = 0.0f, adagrad_diff = 0.0f;
+        memory no_state;
+        zendnn_custom_op::zendnn_embedding_bag_update(table_mem, no_state, grad_mem,
+                indices_mem, offsets_mem, tc.scale_grad_by_freq, tc.mode, psw_mem,
+                tc.weighted, false, padding_idx, optimizer::sgd, lr);
+        for (size_t e = 0; e < table.size(); e++) {
+            sgd_diff = std::max(sgd_diff, std::fabs(table[e] - (table_data[e] - lr *
+                                ref[e])));
+        }
+
+        table = table_data;
+        std::vector<float> state(rows, 0.1f);
+        auto state_mem = memory({{rows}, dt::f32, tag::a}, eng, state.data());
+        zendnn_custom_op::zendnn_embedding_bag_update(table_mem, state_mem, grad_mem,
+                indices_mem, offsets_mem, tc.scale_grad_by_freq, tc.mode, psw_mem,
+                tc.weighted, false, padding_idx, optimizer::rowwise_adagrad, lr, eps);
+        for (int r = 0; r < rows; r++) {
+            float ref_state = 0.1f;
+            if (used[r]) {
+                float sum_sq = 0.0f;
+                for (int j = 0; j < width; j++) {
+                    sum_sq += ref[r * width + j] * ref[r * width + j];
+                }
+                ref_state += sum_sq / width;
+            }
+            adagrad_diff = std::max(adagrad_diff, std::fabs(state[r] - ref_state));
+            for (int j = 0; j < width; j++) {
+                float ref_w = table_data[r * width + j] - (used[r] ? lr * ref[r * width + j] /
+                              (std::sqrt(ref_state) + eps) : 0.0f);
+                adagrad_diff = std::max(adagrad_diff, std::fabs(table[r * width + j] - ref_w));
+            }
+        }
+
+        std::cout<<tc.name<<","<<num_unique<<","<<grad_diff<<","<<sgd_diff<<","
+                 <<adagrad_diff<<std::endl;
+        if (grad_diff > 1e-5f || sgd_diff > 1e-5f || adagrad_diff > 1e-5f) {
+            status = 1;
+        }
+    }
+
+    //Descending offsets and offsets past the indices must be refused
+    for (int bad = 0; bad < 2 && batch_size > 2 && pool_size > 0; bad++) {
+        std::vector<int32_t> bad_offsets(offsets);
+        if (bad == 0) {
+            std::swap(bad_offsets[1], bad_offsets[2]);
+        }
+        else {
+            bad_offsets[batch_size - 1] = indices_size + 1;
+        }
+        auto bad_offsets_mem = memory({{batch_size}, dt::s32, tag::a}, eng,
+                                      bad_offsets.data());
+        std::vector<int64_t> grad_indices(indices_size);
+        std::vector<float> grad_values((size_t)indices_size * width);
+        auto grad_indices_mem = memory({{indices_size}, dt::s64, tag::a}, eng,
+                                       grad_indices.data());
+        auto grad_values_mem = memory({{indices_size, width}, dt::f32, tag::ab}, eng,
+                                      grad_values.data());
+        std::vector<float> table(table_data);
+        auto table_mem = memory({{rows, width}, dt::f32, tag::ab}, eng, table.data());
+        bool refused = false;
+        try {
+            zendnn_custom_op::zendnn_embedding_bag_backward(table_mem, grad_mem,
+                    indices_mem, bad_offsets_mem, false, algorithm::embedding_bag_sum,
+                    psw_mem, false, false, padding_idx, grad_indices_mem, grad_values_mem);
+        }
+        catch (const error &) {
+            refused = true;
+        }
+        if (!refused) {
+            std::cout<<(bad ? "offsets past the indices" : "descending offsets")
+                     <<" not refused"<<std::endl;
+            status = 1;
+        }
+    }
+
+    //Time per call of the fused update
+    std::vector<float> table(table_data), state(rows, 0.0f);
+    auto table_mem = memory({{rows, width}, dt::f32, tag::ab}, eng, table.data());
+    auto state_mem = memory({{rows}, dt::f32, tag::a}, eng, state.data());
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        zendnn_custom_op::zendnn_embedding_bag_update(table_mem, state_mem, grad_mem,
+                indices_mem, offsets_mem, false, algorithm::embedding_bag_sum, psw_mem,
+                false, false, -1, optimizer::rowwise_adagrad, lr);
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout<<"fused rowwise_adagrad update: "
+             <<std::chrono::duration<double, std::milli>(end - begin).count() / iters
+             <<" ms"<<std::endl;
+
+    std::cout<<(status ? "Embedding bag backward mismatch" :
+                "Embedding bag backward passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_backward test ends");
+    return status;
+}
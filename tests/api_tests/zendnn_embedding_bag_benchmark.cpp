@@ -1,5 +1,5 @@
 /*******************************************************************************
-* Copyright (c) 2021-2022 Advanced Micro Devices, Inc. All rights reserved.
+* Copyright (c) 2021-2024 Advanced Micro Devices, Inc. All rights reserved.
 *
 * Licensed under the Apache License, Version 2.0 (the "License");
 * you may not use this file except in compliance with the License.
@@ -16,431 +16,435 @@
 *
 *******************************************************************************/
 
-/* Steps:
- *  1. create engin and stream
- *  2. create user memory (input, indices, offsets, weights)
- *  3. create memory descriptor
- *  4. create embedding_bag descriptor
- *  5. create embedding_bag primitive descriptor
- *  6. create embedding_bag primitive
- *  7. execute the embedding_bag primitive
- */
-
-//IMP => export ZENDNN_VERBOSE=1
-//ZENDNN_VERBOSE=1 bin/simple_conv_test cpu
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
+//Embedding bag benchmark with production like traffic: several tables of
+//mixed sizes, power law (Zipf) or uniform indices and a pooling factor that
+//varies from bag to bag.
+// 1. The memory bandwidth peak is measured with the STREAM triad.
+// 2. Every table runs alone through zendnn_embedding_bag. Its time,
+//    lookups/s and GB/s are reported, along with the imbalance across tables
+//    (slowest table time / mean table time).
+// 3. zendnn_grp_embedding_bag runs over all tables once for every
+//    ZENDNN_EB_THREAD_TYPE and ZENDNN_EB_ALGO. The environment is read once
+//    per process, so every combination runs in a child process of this
+//    benchmark. Each reports time, lookups/s, GB/s and the percentage of the
+//    STREAM peak.
+//
+//GB/s counts the bytes an ideal implementation moves: one table row per
+//lookup, the indices, the offsets and the output.
+//
+//Usage: embedding_bag_benchmark [cpu] [--option=value ...]
+//  --tables=SPEC      comma separated [count x]rows:width tables
+//                     (default 2x1000000:64,6x100000:64,10x10000:64,8x100:64)
+//  --batch=N          bags per table (default 2048)
+//  --pooling=P|LO:HI  indices per bag, fixed or uniform in [LO, HI]
+//                     (default 10:80)
+//  --dist=zipf:S|uniform  index distribution, Zipf exponent S (default zipf:1.05)
+//  --thread_types=L   comma separated ZENDNN_EB_THREAD_TYPE values
+//                     (default 0,1,2,3,4,5)
+//  --algos=L          comma separated ZENDNN_EB_ALGO values (default 0,1)
+//  --iters=N          timed iterations (default 20)
+//  --seed=N           seed of the index generators (default 1)
+//  --peak=GBS         skip the STREAM run and use GBS as peak
+//  --stream_mb=N      size of each STREAM array in MiB (default 512)
+
+#include <algorithm>
 #include <chrono>
-#include <iostream>
-#include <vector>
-#include <assert.h>
 #include <cmath>
-#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
 #include <numeric>
+#include <random>
+#include <sstream>
 #include <string>
-#include <math.h>
-#include <cstdlib>
-#include <string.h>
-#ifndef _WIN32
-    #include <unistd.h>
-    #include <sys/time.h>
-#endif
+#include <vector>
+#include <omp.h>
+#include "zendnn.hpp"
 #include "test_utils.hpp"
 #include "zendnn_logging.hpp"
 
 #define   API_SUCCESS          (0)
 #define   API_FAILURE          (1)
 
-#define  POOLING_SIZE       25
+//The tests are built without optimization, the STREAM kernel is not
+#if defined(__GNUC__) && !defined(__clang__)
+    #define BENCH_OPTIMIZE __attribute__((optimize("O3")))
+#else
+    #define BENCH_OPTIMIZE
+#endif
 
-using namespace std;
 using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+struct bench_options {
+    std::string tables = "2x1000000:64,6x100000:64,10x10000:64,8x100:64";
+    int batch = 2048;
+    std::string pooling = "10:80";
+    std::string dist = "zipf:1.05";
+    std::string thread_types = "0,1,2,3,4,5";
+    std::string algos = "0,1";
+    int iters = 20;
+    int seed = 1;
+    double peak = 0.0;
+    int stream_mb = 512;
+    bool child = false;
+};
 
-/* ground truth */
-std::vector<float> exp_sum_nwt_npd_128{546.56,1058.56,1570.56,2082.56,2594.56};
-std::vector<float> exp_sum_wt_npd_128{883.84,1651.84,2419.84,3187.84,3955.84};
-std::vector<float> exp_sum_nwt_npd_64{232.32,488.32,744.32,1000.32,1256.32};
-std::vector<float> exp_sum_wt_npd_64{380.48,764.48,1148.48,1532.48,1916.48};
-std::vector<float> exp_sum_nwt_npd_10{30.9,70.9,110.9,150.9,190.9};
-std::vector<float> exp_sum_wt_npd_10{51.35,111.35,171.35,231.35,291.35};
-std::vector<float> exp_sum_nwt_pd_128{209.28,1058.56,1570.56,2082.56,2594.56};
-std::vector<float> exp_sum_wt_pd_128{209.28,1651.84,2419.84,3187.84,3955.84};
-std::vector<float> exp_sum_nwt_pd_64{84.16,488.32,744.32,1000.32,1256.32};
-std::vector<float> exp_sum_wt_pd_64{84.16,764.48,1148.48,1532.48,1916.48};
-std::vector<float> exp_sum_nwt_pd_10{10.45,70.9,110.9,150.9,190.9};
-std::vector<float> exp_sum_wt_pd_10{10.45,111.35,171.35,231.35,291.35};
-std::vector<float> exp_mean_npd_128{273.28,529.28,785.28,1041.28,1297.28};
-std::vector<float> exp_max_npd_128{337.28,593.28,849.28,1105.28,1361.28};
-
-
-/* functor for float comparison */
-class compare_float_t {
-  public:
-    compare_float_t(float tol = 1e-05):tolerance{tol} {}
+struct table_spec {
+    int64_t rows;
+    int64_t width;
+};
 
-    bool operator()(const float a, const float b) {
-        if (isnan(a) || isnan(b)) {
-            return false;
-        }
-        if ((a -b) > tolerance) {
-            return false;
+static std::vector<std::string> split(const std::string &str, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(str);
+    std::string part;
+    while (std::getline(ss, part, sep)) {
+        if (!part.empty()) {
+            parts.push_back(part);
         }
-        if ((b -a) > tolerance) {
-            return false;
-        }
-
-        return true;
     }
+    return parts;
+}
 
-  private:
-    float tolerance;
-};
-
-/* compare two vectors */
-bool compare_vectors(const std::vector<float> &a, const std::vector<float> &b) {
-
-    compare_float_t cmp_op{1e-02};
+//"2x1000000:64,8x100:64"
+static std::vector<table_spec> parse_tables(const std::string &spec) {
+    std::vector<table_spec> tables;
+    for (const auto &entry : split(spec, ',')) {
+        size_t x = entry.find('x');
+        int count = x == std::string::npos ? 1 : std::stoi(entry.substr(0, x));
+        std::string shape = x == std::string::npos ? entry : entry.substr(x + 1);
+        size_t colon = shape.find(':');
+        table_spec t;
+        t.rows = std::stoll(shape.substr(0, colon));
+        t.width = colon == std::string::npos ? 64 : std::stoll(shape.substr(
+                      colon + 1));
+        tables.insert(tables.end(), count, t);
+    }
+    return tables;
+}
 
-    if (a.size() != b.size()) {
-        return false;
+//Zipf distributed ranks in [0, n), rank r with probability ~ 1/(r+1)^s.
+//Rejection-inversion sampling (Hormann, Derflinger), O(1) per sample for any
+//n.
+class zipf_generator {
+  public:
+    zipf_generator(int64_t n, double s) : n_(n), s_(s) {
+        h_x1_ = h_integral(1.5) - 1.0;
+        h_n_ = h_integral(n + 0.5);
+        s_c_ = 2.0 - h_integral_inverse(h_integral(2.5) - h(2.0));
     }
 
-    for (auto i = 0; i < a.size(); ++i) {
-        if (!cmp_op(a[i],b[i])) {
-            return false;
+    int64_t operator()(std::mt19937_64 &gen) {
+        std::uniform_real_distribution<double> dis(0.0, 1.0);
+        while (true) {
+            double u = h_n_ + dis(gen) * (h_x1_ - h_n_);
+            double x = h_integral_inverse(u);
+            int64_t k = std::min(std::max((int64_t)(x + 0.5), (int64_t)1), n_);
+            if (k - x <= s_c_ || u >= h_integral(k + 0.5) - h(k)) {
+                return k - 1;
+            }
         }
     }
 
-    return true;
-};
-
-/* display a vector */
-std::string vec_str(std::string vd, const std::vector<float> &a) {
-
-    auto sz = a.size();
-
-    std::string out = vd + "{";
-    for (auto i = 0; i < sz -1; ++i) {
-        out = out + std::to_string(a[i]) + ";";
+  private:
+    double h(double x) const {
+        return std::exp(-s_ * std::log(x));
     }
-
-    out = out + std::to_string(a[sz -1]) + "}";
-
-    return out;
-};
-
-/* create embedding table */
-memory create_embedding_table(engine eng, uint32_t rows, uint32_t width) {
-
-    const float incr = 0.01;
-
-    auto table = memory({{rows, width},
-        memory::data_type::f32,
-        memory::format_tag::ab}, eng);
-
-    float *hndl = (float *)table.get_data_handle();
-
-    for (auto i = 0; i < rows ; ++i) {
-        for (auto j = 0; j < width; ++j) {
-            hndl[j + i*width] = i + 1.0 + j*incr;
-        }
+    double h_integral(double x) const {
+        double log_x = std::log(x);
+        return helper2((1.0 - s_) * log_x) * log_x;
     }
-
-    return table;
-}
-
-/* create indices */
-memory create_indices(engine eng, uint32_t len) {
-
-    auto indices = memory({{len},
-        memory::data_type::s32,
-        memory::format_tag::a}, eng);
-
-    int32_t *hndl = (int32_t *)indices.get_data_handle();
-
-    /* indices should be in the range of 0 to rows */
-    for (auto i = 0; i < len; ++i) {
-        hndl[i] = i;
+    double h_integral_inverse(double x) const {
+        double t = std::max(x * (1.0 - s_), -1.0);
+        return std::exp(helper1(t) * x);
     }
-
-    return indices;
-}
-
-/* create offsets */
-memory create_offsets(engine eng, uint32_t len) {
-
-    const uint32_t incr = POOLING_SIZE;
-    uint32_t       bags = len/incr;
-
-    auto offsets = memory({{bags},
-        memory::data_type::s32,
-        memory::format_tag::a}, eng);
-
-    int32_t *hndl = (int32_t *)offsets.get_data_handle();
-
-    /* first offset should always be zero */
-    uint32_t offset = 0;
-    for (auto i = 0; i < bags; ++i) {
-        hndl[i] = offset;
-        offset += incr;
+    //log1p(x) / x and expm1(x) / x, accurate near 0
+    static double helper1(double x) {
+        return std::fabs(x) > 1e-8 ? std::log1p(x) / x :
+               1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
     }
-
-    return offsets;
-}
-
-/* create weights */
-memory create_weights(engine eng, uint32_t len) {
-
-    const uint32_t modulo = 2;
-
-    auto weights = memory({{len},
-        memory::data_type::f32,
-        memory::format_tag::a}, eng);
-
-    float *hndl = (float *)weights.get_data_handle();
-
-    for (auto i = 0; i < len; ++i) {
-        hndl[i]  = 1.0 + float(i % modulo);
+    static double helper2(double x) {
+        return std::fabs(x) > 1e-8 ? std::expm1(x) / x :
+               1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
     }
 
-    return weights;
-
-}
-
-/* create output */
-memory create_output(engine eng, uint32_t rows, uint32_t width) {
-
-    /* create destination buffer */
-    auto dst = memory({{rows, width},
-        memory::data_type::f32,
-        memory::format_tag::ab}, eng);
+    int64_t n_;
+    double s_, h_x1_, h_n_, s_c_;
+};
 
-    return dst;
+static int64_t gcd(int64_t a, int64_t b) {
+    while (b) {
+        int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
 }
 
-/* sum the bags for verification */
-std::vector<float> sum_bags(memory &dst) {
-    std::vector<float> sum;
-
-    auto dst_dims       = dst.get_desc().dims();
-    auto num_bags       = dst_dims[0];
-    auto dim_embedding  = dst_dims[1];
+//Tables, indices and offsets of one benchmark configuration
+struct bench_data {
+    std::vector<table_spec> specs;
+    std::vector<memory> tables, indices, offsets, dst;
+    std::vector<int64_t> lookups;
+    std::vector<double> bytes;
+};
 
-    float *hndl         = (float *)dst.get_data_handle();
+static void build_data(const bench_options &opt, engine &eng,
+                       bench_data &data) {
+    data.specs = parse_tables(opt.tables);
+    std::vector<std::string> pool = split(opt.pooling, ':');
+    int pool_lo = std::stoi(pool[0]);
+    int pool_hi = pool.size() > 1 ? std::stoi(pool[1]) : pool_lo;
+    std::vector<std::string> dist = split(opt.dist, ':');
+    bool zipf = dist[0] == "zipf";
+    double zipf_s = dist.size() > 1 ? std::stod(dist[1]) : 1.05;
+
+    for (size_t t = 0; t < data.specs.size(); t++) {
+        const int64_t rows = data.specs[t].rows, width = data.specs[t].width;
+        std::mt19937_64 gen(opt.seed * 1000003ULL + t);
+        std::uniform_int_distribution<int> dis_pool(pool_lo, pool_hi);
+        std::uniform_int_distribution<int64_t> dis_row(0, rows - 1);
+        zipf_generator zipf_gen(rows, zipf_s);
+        //The hot ranks are scattered over the table, rank * stride mod rows
+        //is a permutation for a stride coprime to rows
+        int64_t stride = 2654435761LL % rows;
+        while (stride == 0 || gcd(stride, rows) != 1) {
+            stride++;
+        }
 
-    int32_t idx_base    = 0;
-    for (auto bag = 0; bag < num_bags; ++bag) {
-        float bag_sum = 0.0;
-        for (auto j = 0; j < dim_embedding; ++j) {
-            bag_sum += hndl[idx_base +j];
+        std::vector<int32_t> offsets(opt.batch), indices;
+        for (int b = 0; b < opt.batch; b++) {
+            offsets[b] = indices.size();
+            int pooling = dis_pool(gen);
+            for (int p = 0; p < pooling; p++) {
+                int64_t row = zipf ? zipf_gen(gen) * stride % rows : dis_row(gen);
+                indices.push_back(row);
+            }
         }
 
-        sum.push_back(bag_sum);
-        idx_base += dim_embedding;
+        memory table({{rows, width}, dt::f32, tag::ab}, eng);
+        float *hndl = static_cast<float *>(table.get_data_handle());
+        #pragma omp parallel for
+        for (int64_t r = 0; r < rows; r++) {
+            for (int64_t j = 0; j < width; j++) {
+                hndl[r * width + j] = (r % 1000) * 0.001f + j * 0.01f;
+            }
+        }
+        memory indices_mem({{(memory::dim)indices.size()}, dt::s32, tag::a}, eng);
+        memory offsets_mem({{opt.batch}, dt::s32, tag::a}, eng);
+        write_to_zendnn_memory(indices.data(), indices_mem);
+        write_to_zendnn_memory(offsets.data(), offsets_mem);
+
+        data.tables.push_back(table);
+        data.indices.push_back(indices_mem);
+        data.offsets.push_back(offsets_mem);
+        data.dst.push_back(memory({{opt.batch, width}, dt::f32, tag::ab}, eng));
+        data.lookups.push_back(indices.size());
+        data.bytes.push_back((double)indices.size() * (width + 1) * sizeof(
+                                 float) + opt.batch * (width + 1) * sizeof(float));
     }
-
-    return sum;
 }
 
-/* execute embedding_bag */
-void exec_embedding_bag(engine eng, stream s, memory table,
-                        memory indices, memory offsets, memory weights,
-                        memory bags, algorithm alg, uint32_t num_threads,
-                        bool is_weights, int32_t padding_idx) {
-
-    auto table_md   = memory::desc(table.get_desc());
-    auto indices_md = memory::desc(indices.get_desc());
-    auto offsets_md = memory::desc(offsets.get_desc());
-    auto weights_md = memory::desc(weights.get_desc());
-    auto bags_md    = memory::desc(bags.get_desc());
-
-    auto emdb_d = embedding_bag::desc();
-
-    if (!is_weights) {
-        if (padding_idx < 0)
-            emdb_d = embedding_bag::desc(prop_kind::forward_inference,
-                                         alg,
-                                         num_threads,
-                                         table_md,
-                                         indices_md,
-                                         offsets_md,
-                                         bags_md);
-        else
-            emdb_d = embedding_bag::desc(prop_kind::forward_inference,
-                                         alg,
-                                         num_threads,
-                                         table_md,
-                                         indices_md,
-                                         offsets_md,
-                                         bags_md,
-                                         padding_idx);
+//Best STREAM triad bandwidth over 5 runs, in GB/s
+BENCH_OPTIMIZE static double stream_triad_gbs(int array_mb) {
+    const int64_t n = (int64_t)array_mb * (1 << 20) / sizeof(double);
+    std::unique_ptr<double[]> a(new double[n]), b(new double[n]), c(new double[n]);
+    //First touch by the threads that use the pages
+    #pragma omp parallel for
+    for (int64_t i = 0; i < n; i++) {
+        a[i] = 0.0;
+        b[i] = 1.0;
+        c[i] = 2.0;
     }
-    else {
-        if (padding_idx < 0)
-            emdb_d = embedding_bag::desc(prop_kind::forward_inference,
-                                         alg,
-                                         num_threads,
-                                         table_md,
-                                         indices_md,
-                                         offsets_md,
-                                         weights_md,
-                                         bags_md);
-        else
-            emdb_d = embedding_bag::desc(prop_kind::forward_inference,
-                                         alg,
-                                         num_threads,
-                                         table_md,
-                                         indices_md,
-                                         offsets_md,
-                                         weights_md,
-                                         bags_md,
-                                         padding_idx);
+    double *pa = a.get(), *pb = b.get(), *pc = c.get();
+    double best = 0.0;
+    for (int rep = 0; rep < 5; rep++) {
+        auto begin = std::chrono::steady_clock::now();
+        #pragma omp parallel for
+        for (int64_t i = 0; i < n; i++) {
+            pa[i] = pb[i] + 3.0 * pc[i];
+        }
+        auto end = std::chrono::steady_clock::now();
+        double sec = std::chrono::duration<double>(end - begin).count();
+        best = std::max(best, 3.0 * n * sizeof(double) / sec / 1e9);
     }
+    return best;
+}
 
-    auto emdb_pd = embedding_bag::primitive_desc(emdb_d, eng);
-    auto emdb    = embedding_bag(emdb_pd);
-
-    if (!is_weights) {
-        emdb.execute(s, {{ZENDNN_ARG_SRC_0, table},
-            {ZENDNN_ARG_SRC_1, indices},
-            {ZENDNN_ARG_SRC_2, offsets},
-            {ZENDNN_ARG_DST, bags}
-        });
-    }
-    else {
-        emdb.execute(s, {{ZENDNN_ARG_SRC_0, table},
-            {ZENDNN_ARG_SRC_1, indices},
-            {ZENDNN_ARG_SRC_2, offsets},
-            {ZENDNN_ARG_SRC_3, weights},
-            {ZENDNN_ARG_DST, bags}
-        });
+template<typename F>
+static double time_ms(int iters, F run) {
+    run();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        run();
     }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
 }
 
-bool run_test(std::string test_id, engine eng, stream s, uint32_t width,
-              algorithm alg, bool is_wt, int32_t padidx,
-              std::vector<float> &expected, uint32_t emb_rows_in, uint32_t emb_nthr_in,
-              uint32_t num_iteration_in) {
-
-    //parameters
-    uint32_t emb_rows  = emb_rows_in;
-    uint32_t emb_nthr  = emb_nthr_in;
-    uint32_t num_iteration = num_iteration_in;
-    /* create embedding table */
-    memory table = create_embedding_table(eng, emb_rows, width);
-
-    /* create indices */
-    memory indices = create_indices(eng, emb_rows);
-
-    /* create offsets */
-    memory offsets = create_offsets(eng, emb_rows);
-
-    /* create weights */
-    memory weights = create_weights(eng, emb_rows);
-
-    /* create output */
-    auto   bag_count      = offsets.get_desc().dims()[0];
-    memory bags           = create_output(eng, bag_count, width);
-
-    /* execute emb */
-    for (int i = 0; i < num_iteration; ++i) {
-        exec_embedding_bag(eng, s, table, indices, offsets, weights, bags,
-                           alg, emb_nthr, is_wt, padidx);
+//Every table alone, with all threads
+static void run_per_table(const bench_options &opt, engine &eng,
+                          double peak) {
+    bench_data data;
+    build_data(opt, eng, data);
+    memory no_weights;
+    std::vector<double> table_ms;
+    std::cout<<"table,rows,width,lookups,ms,Mlookups_per_s,GB_s,peak_pct"
+             <<std::endl;
+    for (size_t t = 0; t < data.specs.size(); t++) {
+        double ms = time_ms(opt.iters, [&] {
+            zendnn_custom_op::zendnn_embedding_bag(data.tables[t], data.indices[t],
+                                                   data.offsets[t], false, algorithm::embedding_bag_sum, false, no_weights,
+                                                   false, false, -1, data.dst[t]);
+        });
+        double gbs = data.bytes[t] / ms / 1e6;
+        table_ms.push_back(ms);
+        std::cout<<t<<","<<data.specs[t].rows<<","<<data.specs[t].width<<","
+                 <<data.lookups[t]<<","<<ms<<","<<data.lookups[t] / ms / 1e3<<","<<gbs<<","
+                 <<100.0 * gbs / peak<<std::endl;
     }
-    /* compare against ground truth */
-    /*
-    auto actual = sum_bags(bags);
-        if (!compare_vectors(expected, actual)) {
-            zendnnError(ZENDNN_TESTLOG, test_id, ":", vec_str("exp", expected),":",
-                        vec_str("act", actual));
+    double mean = std::accumulate(table_ms.begin(), table_ms.end(),
+                                  0.0) / table_ms.size();
+    std::cout<<"table_imbalance,"<<*std::max_element(table_ms.begin(),
+             table_ms.end()) / mean<<std::endl;
+}
 
-            return false;
-        }
-    */
-    return true;
+//zendnn_grp_embedding_bag with the thread type and algo of the environment
+static void run_group(const bench_options &opt, engine &eng, double peak) {
+    bench_data data;
+    build_data(opt, eng, data);
+    const int num_tables = data.specs.size();
+    std::vector<int32_t> zeros(num_tables, 0), padding_idx(num_tables, -1);
+    std::vector<algorithm> modes(num_tables, algorithm::embedding_bag_sum);
+    std::vector<memory> psw(num_tables);
+    double ms = time_ms(opt.iters, [&] {
+        zendnn_custom_op::zendnn_grp_embedding_bag(data.tables, data.indices,
+                data.offsets, zeros, modes, zeros, psw, zeros, zeros, padding_idx,
+                data.dst);
+    });
+    int64_t lookups = std::accumulate(data.lookups.begin(), data.lookups.end(),
+                                      (int64_t)0);
+    double bytes = std::accumulate(data.bytes.begin(), data.bytes.end(), 0.0);
+    double gbs = bytes / ms / 1e6;
+    const char *thread_type = std::getenv("ZENDNN_EB_THREAD_TYPE");
+    const char *algo = std::getenv("ZENDNN_EB_ALGO");
+    std::cout<<(thread_type ? thread_type : "default")<<","
+             <<(algo ? algo : "default")<<","<<num_tables<<","<<opt.batch<<","
+             <<lookups<<","<<ms<<","<<lookups / ms / 1e3<<","<<gbs<<","
+             <<100.0 * gbs / peak<<std::endl;
 }
 
 int main(int argc, char **argv) {
 
     int status = API_SUCCESS;
-
-    zendnnInfo(ZENDNN_TESTLOG, "ZenDNN API test for embedding_bag starts");
-
-    uint32_t emb_rows  = atoi(argv[2]);
-    uint32_t emb_nthr  = atoi(argv[3]);
-    uint32_t num_iteration = atoi(argv[4]) ;
-
-
-    /* create engine kind */
-    engine::kind engine_kind = parse_engine_kind(argc, argv);
-    engine eng(engine_kind, 0);
-    zendnnVerbose(ZENDNN_TESTLOG, "cpu engine created");
-
-    /* create stream */
-    stream s(eng);
-    zendnnVerbose(ZENDNN_TESTLOG, "stream created");
-
-    /* run tests */
-    if (!run_test("sm_nw_np_512", eng, s, 512, algorithm::embedding_bag_sum,
-                  false, -1, exp_sum_nwt_npd_128, emb_rows, emb_nthr, num_iteration)) {
-        status = API_FAILURE;
-    }
-
-    if (!run_test("sm_w_np_512", eng, s, 512, algorithm::embedding_bag_sum,
-                  true, -1, exp_sum_wt_npd_128, emb_rows, emb_nthr, num_iteration)) {
-        status = API_FAILURE;
-    }
-
-    if (!run_test("sm_nw_np_128", eng, s, 128, algorithm::embedding_bag_sum,
-                  false, -1, exp_sum_nwt_npd_64, emb_rows, emb_nthr, num_iteration)) {
-        status = API_FAILURE;
+    bench_options opt;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "cpu") {
+            continue;
+        }
+        else if (key == "--tables") {
+            opt.tables = value;
+        }
+        else if (key == "--batch") {
+            opt.batch = std::stoi(value);
+        }
+        else if (key == "--pooling") {
+            opt.pooling = value;
+        }
+        else if (key == "--dist") {
+            opt.dist = value;
+        }
+        else if (key == "--thread_types") {
+            opt.thread_types = value;
+        }
+        else if (key == "--algos") {
+            opt.algos = value;
+        }
+        else if (key == "--iters") {
+            opt.iters = std::stoi(value);
+        }
+        else if (key == "--seed") {
+            opt.seed = std::stoi(value);
+        }
+        else if (key == "--peak") {
+            opt.peak = std::stod(value);
+        }
+        else if (key == "--stream_mb") {
+            opt.stream_mb = std::stoi(value);
+        }
+        else if (key == "--child") {
+            opt.child = true;
+        }
+        else {
+            std::cerr<<"unknown option "<<arg<<std::endl;
+            return API_FAILURE;
+        }
     }
 
-    if (!run_test("sm_w_np_128", eng, s, 128, algorithm::embedding_bag_sum,
-                  true, -1, exp_sum_wt_npd_64, emb_rows, emb_nthr, num_iteration)) {
-        status = API_FAILURE;
+    engine eng(engine::kind::cpu, 0);
+    if (opt.child) {
+        run_group(opt, eng, opt.peak);
+        return status;
     }
 
-    if (!run_test("sm_nw_np_64", eng, s, 64, algorithm::embedding_bag_sum,
-                  false, -1, exp_sum_nwt_npd_64, emb_rows, emb_nthr, num_iteration)) {
-        status = API_FAILURE;
+    zendnnInfo(ZENDNN_TESTLOG, "ZenDNN embedding_bag benchmark starts");
+    if (opt.peak <= 0.0) {
+        opt.peak = stream_triad_gbs(opt.stream_mb);
     }
-
-    if (!run_test("sm_w_np_64", eng, s, 64, algorithm::embedding_bag_sum,
-                  true, -1, exp_sum_wt_npd_64, emb_rows, emb_nthr, num_iteration)) {
-        status = API_FAILURE;
+    std::cout<<"threads,"<<omp_get_max_threads()<<std::endl;
+    std::cout<<"stream_triad_GB_s,"<<opt.peak<<std::endl;
+    std::cout<<"tables,"<<opt.tables<<std::endl;
+    std::cout<<"pooling,"<<opt.pooling<<std::endl;
+    std::cout<<"dist,"<<opt.dist<<std::endl;
+    run_per_table(opt, eng, opt.peak);
+
+    std::cout<<"thread_type,algo,tables,batch,lookups,ms,Mlookups_per_s,GB_s,"
+             <<"peak_pct"<<std::endl;
+#ifdef _WIN32
+    //No child processes, only the thread type and algo of the environment
+    run_group(opt, eng, opt.peak);
+#else
+    std::string child_args;
+    for (int a = 1; a < argc; a++) {
+        child_args += std::string(" '") + argv[a] + "'";
     }
-
-    /*
-        if (!run_test("sm_nw_np_10", eng, s, 10, algorithm::embedding_bag_sum,
-                      false, -1, exp_sum_nwt_npd_10, emb_rows, emb_nthr, num_iteration)) {
-            status = API_FAILURE;
-        }
-
-        if (!run_test("sm_w_np_10", eng, s, 10, algorithm::embedding_bag_sum,
-                      true, -1, exp_sum_wt_npd_10, emb_rows, emb_nthr, num_iteration)) {
-            status = API_FAILURE;
+    std::ostringstream peak;
+    peak<<opt.peak;
+    child_args += " --child --peak=" + peak.str();
+    for (const auto &thread_type : split(opt.thread_types, ',')) {
+        for (const auto &algo : split(opt.algos, ',')) {
+            setenv("ZENDNN_EB_THREAD_TYPE", thread_type.c_str(), 1);
+            setenv("ZENDNN_EB_ALGO", algo.c_str(), 1);
+            FILE *child = popen((std::string("'") + argv[0] + "'" + child_args).c_str(),
+                                "r");
+            if (!child) {
+                status = API_FAILURE;
+                continue;
+            }
+            char line[1024];
+            while (fgets(line, sizeof(line), child)) {
+                std::cout<<line;
+            }
+            std::cout.flush();
+            if (pclose(child) != 0) {
+                status = API_FAILURE;
+            }
         }
-
-        if (!run_test("mn_np_128", eng, s, 128, algorithm::embedding_bag_mean,
-                      false, -1, exp_mean_npd_128, emb_rows, emb_nthr, num_iteration)) {
-            status = API_FAILURE;
-        }
-
-        if (!run_test("mx_w_np_128", eng, s, 128, algorithm::embedding_bag_max,
-                      false, -1, exp_max_npd_128, emb_rows, emb_nthr, num_iteration)) {
-            status = API_FAILURE;
-        }
-    */
+    }
+#endif
 
     if (status == API_SUCCESS)
         zendnnInfo(ZENDNN_TESTLOG,
-                   "ZenDNN API test for embedding_bag successful.");
+                   "ZenDNN embedding_bag benchmark successful.");
     else
         zendnnInfo(ZENDNN_TESTLOG,
-                   "ZenDNN API test for embedding_bag fails.");
-
+                   "ZenDNN embedding_bag benchmark fails.");
     return status;
 }
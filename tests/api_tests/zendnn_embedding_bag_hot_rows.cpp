@@ -0,0 +1,199 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Embedding bag on a table reordered by row frequency. Lookups follow a
+//power law. The row frequencies are profiled on a first batch, a copy of the
+//table is reordered in place so the hot rows form a block at its top, and
+//the indices of a second batch are remapped. The result must match
+//embedding_bag on the original table and indices exactly; the time per call
+//of both is reported. Remapping an index past the table must fail.
+//
+//Usage: embedding_bag_hot_rows [rows] [width] [batch_size] [pool_size] [iters]
+//  rows       : table rows (default 2000000)
+//  width      : embedding dimension (default 64)
+//  batch_size : number of bags (default 2048)
+//  pool_size  : indices per bag (default 50)
+//  iters      : timed calls (default 20)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Power law row ids: row r is drawn with probability ~ 1/(r+1), the rows are
+//scattered over the table by a fixed permutation
+std::vector<int32_t> skewed_indices(int64_t count, int32_t rows,
+                                    const std::vector<int32_t> &scatter, std::mt19937 &gen) {
+    std::uniform_real_distribution<double> dis(0.0, 1.0);
+    std::vector<int32_t> indices(count);
+    for (auto &i : indices) {
+        int32_t r = (int32_t)std::exp(dis(gen) * std::log((double)rows)) - 1;
+        i = scatter[std::min(std::max(r, 0), rows - 1)];
+    }
+    return indices;
+}
+
+//Runs embedding_bag sum, returns the average time per call in ms
+double run_embedding_bag(engine &eng, stream &s, memory &table,
+                         memory &indices, memory &offsets, memory &dst, int iters) {
+    auto pdesc = embedding_bag::desc(prop_kind::forward_inference,
+                                     algorithm::embedding_bag_sum, 0, table.get_desc(), indices.get_desc(),
+                                     offsets.get_desc(), dst.get_desc(), -1);
+    auto pd = embedding_bag::primitive_desc(pdesc, eng);
+    auto prim = embedding_bag(pd);
+    std::unordered_map<int, memory> args = {{ZENDNN_ARG_SRC_0, table},
+        {ZENDNN_ARG_SRC_1, indices}, {ZENDNN_ARG_SRC_2, offsets},
+        {ZENDNN_ARG_DST, dst}
+    };
+    prim.execute(s, args);
+    s.wait();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        prim.execute(s, args);
+    }
+    s.wait();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_hot_rows test starts");
+
+    int rows = 2000000, width = 64, batch_size = 2048, pool_size = 50,
+        iters = 20;
+    if (argc > 1) {
+        rows = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        width = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        batch_size = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        pool_size = std::stoi(std::string(argv[4]));
+    }
+    if (argc > 5) {
+        iters = std::stoi(std::string(argv[5]));
+    }
+    const int indices_size = batch_size * pool_size;
+
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<float> dis_val(-1.0f, 1.0f);
+
+    std::vector<int32_t> scatter(rows);
+    for (int r = 0; r < rows; r++) {
+        scatter[r] = r;
+    }
+    std::shuffle(scatter.begin(), scatter.end(), gen);
+
+    std::vector<float> table_data((size_t)rows * width);
+    for (auto &v : table_data) {
+        v = dis_val(gen);
+    }
+    auto table = memory({{rows, width}, dt::f32, tag::ab}, eng, table_data.data());
+
+    //Profile on one batch
+    std::vector<int32_t> profile = skewed_indices(indices_size, rows, scatter,
+                                   gen);
+    auto profile_mem = memory({{indices_size}, dt::s32, tag::a}, eng,
+                              profile.data());
+    std::vector<int64_t> frequencies(rows, 0);
+    auto freq_mem = memory({{rows}, dt::s64, tag::a}, eng, frequencies.data());
+    zendnn_custom_op::zendnn_embedding_row_frequencies(profile_mem, freq_mem);
+
+    //The copy is reordered in place
+    std::vector<float> reordered_data(table_data);
+    auto reordered = memory({{rows, width}, dt::f32, tag::ab}, eng,
+                            reordered_data.data());
+    auto remap = memory({{rows}, dt::s32, tag::a}, eng);
+    int64_t hot_rows = zendnn_custom_op::zendnn_embedding_reorder_rows(reordered,
+                       freq_mem, remap);
+
+    //Run on another batch
+    std::vector<int32_t> indices = skewed_indices(indices_size, rows, scatter,
+                                   gen);
+    std::vector<int32_t> offsets(batch_size);
+    for (int b = 0; b < batch_size; b++) {
+        offsets[b] = b * pool_size;
+    }
+    auto indices_mem = memory({{indices_size}, dt::s32, tag::a}, eng,
+                              indices.data());
+    std::vector<int32_t> remapped(indices);
+    auto remapped_mem = memory({{indices_size}, dt::s32, tag::a}, eng,
+                               remapped.data());
+    zendnn_custom_op::zendnn_embedding_remap_indices(remap, remapped_mem);
+    auto offsets_mem = memory({{batch_size}, dt::s32, tag::a}, eng,
+                              offsets.data());
+
+    std::vector<float> ref(batch_size * width), out(batch_size * width);
+    auto ref_mem = memory({{batch_size, width}, dt::f32, tag::ab}, eng,
+                          ref.data());
+    auto out_mem = memory({{batch_size, width}, dt::f32, tag::ab}, eng,
+                          out.data());
+    double ref_ms = run_embedding_bag(eng, s, table, indices_mem, offsets_mem,
+                                      ref_mem, iters);
+    double ms = run_embedding_bag(eng, s, reordered, remapped_mem, offsets_mem,
+                                  out_mem, iters);
+
+    int64_t hot_hits = 0;
+    for (auto i : remapped) {
+        hot_hits += i < hot_rows;
+    }
+    float max_diff = 0.0f;
+    for (size_t i = 0; i < ref.size(); i++) {
+        max_diff = std::max(max_diff, std::fabs(ref[i] - out[i]));
+    }
+
+    std::cout<<"rows,width,hot_rows,hot_hit_rate,original_ms,reordered_ms,"
+             <<"max_abs_diff"<<std::endl;
+    std::cout<<rows<<","<<width<<","<<hot_rows<<","
+             <<(double)hot_hits / indices_size<<","<<ref_ms<<","<<ms<<","<<max_diff
+             <<std::endl;
+
+    //An index past the table is refused
+    std::vector<int32_t> bad_indices = {0, rows};
+    auto bad_mem = memory({{2}, dt::s32, tag::a}, eng, bad_indices.data());
+    bool bad_refused = false;
+    try {
+        zendnn_custom_op::zendnn_embedding_remap_indices(remap, bad_mem);
+    }
+    catch (const error &e) {
+        bad_refused = true;
+    }
+    if (!bad_refused) {
+        std::cout<<"index past the table was remapped"<<std::endl;
+    }
+
+    int status = max_diff != 0.0f || !bad_refused ? 1 : 0;
+    std::cout<<(status ? "Hot row embedding bag mismatch" :
+                "Hot row embedding bag passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_hot_rows test ends");
+    return status;
+}
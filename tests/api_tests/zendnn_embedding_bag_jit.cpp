@@ -0,0 +1,198 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Embedding bag on widths without a hand unrolled path, served by kernels
+//generated for the exact width. Sum, weighted sum, mean and max, with and
+//without a padding index, are checked against a scalar reference for every
+//width, and the time per call is reported.
+//
+//Usage: embedding_bag_jit [batch_size] [pool_size] [widths...]
+//  batch_size : number of bags (default 1024)
+//  pool_size  : indices per bag (default 20)
+//  widths     : embedding dimensions (default 48 80 96 200 1000)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Scalar embedding bag, bags without rows are zeros
+std::vector<float> reference_embedding_bag(const std::vector<float> &table,
+        const std::vector<int32_t> &indices, const std::vector<int32_t> &offsets,
+        const std::vector<float> &weights, algorithm alg, int32_t padding_idx,
+        int width) {
+    const int num_bags = offsets.size(), num_indices = indices.size();
+    std::vector<float> dst((size_t)num_bags * width, 0.0f);
+    for (int b = 0; b < num_bags; b++) {
+        int first = offsets[b];
+        int last = b + 1 < num_bags ? offsets[b + 1] : num_indices;
+        for (int j = 0; j < width; j++) {
+            float acc = alg == algorithm::embedding_bag_max ? -INFINITY : 0.0f;
+            int count = 0;
+            for (int i = first; i < last; i++) {
+                if (indices[i] == padding_idx) {
+                    continue;
+                }
+                float v = table[(size_t)indices[i] * width + j];
+                count++;
+                if (alg == algorithm::embedding_bag_max) {
+                    acc = std::max(acc, v);
+                }
+                else {
+                    acc += weights.empty() ? v : weights[i] * v;
+                }
+            }
+            if (alg == algorithm::embedding_bag_mean && count) {
+                acc /= count;
+            }
+            dst[(size_t)b * width + j] = count ? acc : 0.0f;
+        }
+    }
+    return dst;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_jit test starts");
+
+    int batch_size = 1024, pool_size = 20;
+    std::vector<int> widths = {48, 80, 96, 200, 1000};
+    if (argc > 1) {
+        batch_size = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        pool_size = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        widths.clear();
+        for (int a = 3; a < argc; a++) {
+            widths.push_back(std::stoi(std::string(argv[a])));
+        }
+    }
+    const int rows = 20000, padding_idx = 5, iters = 20;
+    const int indices_size = batch_size * pool_size;
+
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(13);
+    std::uniform_int_distribution<> dis_row(0, rows - 1);
+    std::uniform_real_distribution<float> dis_val(-1.0f, 1.0f);
+
+    std::vector<int32_t> indices(indices_size), offsets(batch_size);
+    for (int i = 0; i < indices_size; i++) {
+        indices[i] = i % 7 ? dis_row(gen) : padding_idx;
+    }
+    for (int b = 0; b < batch_size; b++) {
+        offsets[b] = b * pool_size;
+    }
+    std::vector<float> weights(indices_size);
+    for (auto &w : weights) {
+        w = dis_val(gen);
+    }
+    auto indices_mem = memory({{indices_size}, dt::s32, tag::a}, eng,
+                              indices.data());
+    auto offsets_mem = memory({{batch_size}, dt::s32, tag::a}, eng,
+                              offsets.data());
+    auto weights_mem = memory({{indices_size}, dt::f32, tag::a}, eng,
+                              weights.data());
+
+    struct test_case {
+        const char *name;
+        algorithm alg;
+        bool weighted;
+    };
+    const test_case cases[] = {
+        {"sum", algorithm::embedding_bag_sum, false},
+        {"sum_wt", algorithm::embedding_bag_sum, true},
+        {"mean", algorithm::embedding_bag_mean, false},
+        {"max", algorithm::embedding_bag_max, false}
+    };
+
+    std::cout<<"width,alg,padding_idx,max_abs_diff,ms"<<std::endl;
+    int status = 0;
+    for (int width : widths) {
+        std::vector<float> table((size_t)rows * width);
+        for (auto &v : table) {
+            v = dis_val(gen);
+        }
+        auto table_mem = memory({{rows, width}, dt::f32, tag::ab}, eng, table.data());
+        for (const auto &tc : cases) {
+            for (int32_t pad : {
+                        -1, padding_idx
+                    }) {
+                std::vector<float> out((size_t)batch_size * width);
+                auto dst_mem = memory({{batch_size, width}, dt::f32, tag::ab}, eng,
+                                      out.data());
+                embedding_bag::desc pdesc;
+                if (tc.weighted) {
+                    pdesc = embedding_bag::desc(prop_kind::forward_inference, tc.alg, 0,
+                                                table_mem.get_desc(), indices_mem.get_desc(), offsets_mem.get_desc(),
+                                                weights_mem.get_desc(), dst_mem.get_desc(), pad);
+                }
+                else {
+                    pdesc = embedding_bag::desc(prop_kind::forward_inference, tc.alg, 0,
+                                                table_mem.get_desc(), indices_mem.get_desc(), offsets_mem.get_desc(),
+                                                dst_mem.get_desc(), pad);
+                }
+                auto pd = embedding_bag::primitive_desc(pdesc, eng);
+                auto prim = embedding_bag(pd);
+                std::unordered_map<int, memory> args = {{ZENDNN_ARG_SRC_0, table_mem},
+                    {ZENDNN_ARG_SRC_1, indices_mem}, {ZENDNN_ARG_SRC_2, offsets_mem},
+                    {ZENDNN_ARG_DST, dst_mem}
+                };
+                if (tc.weighted) {
+                    args.insert({ZENDNN_ARG_SRC_3, weights_mem});
+                }
+                prim.execute(s, args);
+                s.wait();
+                auto begin = std::chrono::steady_clock::now();
+                for (int i = 0; i < iters; i++) {
+                    prim.execute(s, args);
+                }
+                s.wait();
+                auto end = std::chrono::steady_clock::now();
+                double ms = std::chrono::duration<double, std::milli>(end - begin).count() /
+                            iters;
+
+                std::vector<float> ref = reference_embedding_bag(table, indices, offsets,
+                                         tc.weighted ? weights : std::vector<float>(), tc.alg, pad, width);
+                float diff = 0.0f;
+                for (size_t e = 0; e < ref.size(); e++) {
+                    diff = std::max(diff, std::fabs(ref[e] - out[e]));
+                }
+                std::cout<<width<<","<<tc.name<<","<<pad<<","<<diff<<","<<ms<<std::endl;
+                if (diff > 1e-4f) {
+                    status = 1;
+                }
+            }
+        }
+    }
+
+    std::cout<<(status ? "JIT embedding bag mismatch" :
+                "JIT embedding bag passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_jit test ends");
+    return status;
+}
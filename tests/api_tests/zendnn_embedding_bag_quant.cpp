@@ -0,0 +1,210 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Embedding bag on row-wise quantized (u8) tables. Every row of the table is
+//quantized to 8 or 4 bit codes followed by its fp32 scale and bias. The
+//result is checked against embedding_bag on the f32 table holding the
+//dequantized values, for sum, weighted sum, mean and max, and the time per
+//call of the f32 and the quantized tables is reported.
+//
+//Usage: embedding_bag_quant [width] [batch_size] [pool_size] [iters]
+//  width      : embedding dimension (default 128)
+//  batch_size : number of bags (default 1024)
+//  pool_size  : indices per bag (default 40)
+//  iters      : timed calls per case (default 10)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Quantizes table (rows x width) row-wise to bits, returns the u8 rows and
+//writes the dequantized values back to table
+std::vector<uint8_t> quantize_rows(std::vector<float> &table, int rows,
+                                   int width, int bits) {
+    int code_bytes = bits == 8 ? width : (width + 1) / 2;
+    int row_bytes = code_bytes + 2 * sizeof(float);
+    int levels = (1 << bits) - 1;
+    std::vector<uint8_t> qtable(rows * row_bytes, 0);
+    for (int r = 0; r < rows; r++) {
+        float *row = table.data() + r * width;
+        uint8_t *qrow = qtable.data() + r * row_bytes;
+        float lo = *std::min_element(row, row + width);
+        float hi = *std::max_element(row, row + width);
+        float scale = hi > lo ? (hi - lo) / levels : 1.0f;
+        for (int j = 0; j < width; j++) {
+            int code = std::min(levels, std::max(0,
+                                (int)std::lround((row[j] - lo) / scale)));
+            if (bits == 8) {
+                qrow[j] = code;
+            }
+            else {
+                qrow[j / 2] |= code << ((j & 1) * 4);
+            }
+            row[j] = code * scale + lo;
+        }
+        std::memcpy(qrow + code_bytes, &scale, sizeof(float));
+        std::memcpy(qrow + code_bytes + sizeof(float), &lo, sizeof(float));
+    }
+    return qtable;
+}
+
+//Runs embedding_bag, returns the average time per call in ms
+double run_embedding_bag(engine &eng, stream &s, algorithm alg,
+                         memory &table, memory &indices, memory &offsets,
+                         memory *weights, memory &dst, int iters) {
+    embedding_bag::desc pdesc;
+    if (weights) {
+        pdesc = embedding_bag::desc(prop_kind::forward_inference, alg, 0,
+                                    table.get_desc(), indices.get_desc(), offsets.get_desc(),
+                                    weights->get_desc(), dst.get_desc(), -1);
+    }
+    else {
+        pdesc = embedding_bag::desc(prop_kind::forward_inference, alg, 0,
+                                    table.get_desc(), indices.get_desc(), offsets.get_desc(),
+                                    dst.get_desc(), -1);
+    }
+    auto pd = embedding_bag::primitive_desc(pdesc, eng);
+    auto prim = embedding_bag(pd);
+    std::unordered_map<int, memory> args = {{ZENDNN_ARG_SRC_0, table},
+        {ZENDNN_ARG_SRC_1, indices}, {ZENDNN_ARG_SRC_2, offsets},
+        {ZENDNN_ARG_DST, dst}
+    };
+    if (weights) {
+        args.insert({ZENDNN_ARG_SRC_3, *weights});
+    }
+    prim.execute(s, args);
+    s.wait();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        prim.execute(s, args);
+    }
+    s.wait();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_quant test starts");
+
+    int width = 128, batch_size = 1024, pool_size = 40, iters = 10;
+    if (argc > 1) {
+        width = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        batch_size = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        pool_size = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        iters = std::stoi(std::string(argv[4]));
+    }
+    const int rows = 200000;
+    const int indices_size = batch_size * pool_size;
+
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<> dis_row(0, rows - 1);
+    std::uniform_real_distribution<float> dis_val(-1.0f, 1.0f);
+
+    std::vector<int32_t> indices_data(indices_size), offsets_data(batch_size);
+    std::vector<float> weights_data(indices_size);
+    for (auto &i : indices_data) {
+        i = dis_row(gen);
+    }
+    for (auto &w : weights_data) {
+        w = dis_val(gen);
+    }
+    for (int b = 0; b < batch_size; b++) {
+        offsets_data[b] = b * pool_size;
+    }
+    auto indices_mem = memory({{indices_size}, dt::s32, tag::a}, eng,
+                              indices_data.data());
+    auto offsets_mem = memory({{batch_size}, dt::s32, tag::a}, eng,
+                              offsets_data.data());
+    auto weights_mem = memory({{indices_size}, dt::f32, tag::a}, eng,
+                              weights_data.data());
+
+    struct eb_case_t {
+        const char *name;
+        algorithm alg;
+        bool weighted;
+    };
+    const eb_case_t cases[] = {{"sum", algorithm::embedding_bag_sum, false},
+        {"sum_wt", algorithm::embedding_bag_sum, true},
+        {"mean", algorithm::embedding_bag_mean, false},
+        {"max", algorithm::embedding_bag_max, false}
+    };
+
+    std::cout<<"width="<<width<<" batch_size="<<batch_size<<" pool_size="
+             <<pool_size<<std::endl;
+    std::cout<<"bits,alg,table_MB,f32_ms,quant_ms,max_abs_diff"<<std::endl;
+    int status = 0;
+    for (int bits : {8, 4}) {
+        std::vector<float> table_data(rows * width);
+        for (auto &v : table_data) {
+            v = dis_val(gen);
+        }
+        std::vector<uint8_t> qtable_data = quantize_rows(table_data, rows, width,
+                                           bits);
+        memory::dim row_bytes = qtable_data.size() / rows;
+        auto table_mem = memory({{rows, width}, dt::f32, tag::ab}, eng,
+                                table_data.data());
+        auto qtable_mem = memory({{rows, row_bytes}, dt::u8, tag::ab}, eng,
+                                 qtable_data.data());
+
+        for (const auto &c : cases) {
+            std::vector<float> ref(batch_size * width), out(batch_size * width);
+            auto ref_mem = memory({{batch_size, width}, dt::f32, tag::ab}, eng,
+                                  ref.data());
+            auto out_mem = memory({{batch_size, width}, dt::f32, tag::ab}, eng,
+                                  out.data());
+            memory *weights = c.weighted ? &weights_mem : nullptr;
+            double ref_ms = run_embedding_bag(eng, s, c.alg, table_mem, indices_mem,
+                                              offsets_mem, weights, ref_mem, iters);
+            double ms = run_embedding_bag(eng, s, c.alg, qtable_mem, indices_mem,
+                                          offsets_mem, weights, out_mem, iters);
+            float max_diff = 0.0f;
+            for (size_t i = 0; i < ref.size(); i++) {
+                max_diff = std::max(max_diff, std::fabs(ref[i] - out[i]));
+            }
+            if (max_diff > 1e-3f) {
+                status = 1;
+            }
+            std::cout<<bits<<","<<c.name<<","<<qtable_data.size() / (1024.0 * 1024.0)
+                     <<","<<ref_ms<<","<<ms<<","<<max_diff<<std::endl;
+        }
+    }
+
+    std::cout<<(status ? "Quantized embedding bag mismatch" :
+                "Quantized embedding bag passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_quant test ends");
+    return status;
+}
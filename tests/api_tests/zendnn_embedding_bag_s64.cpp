@@ -0,0 +1,196 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Embedding bag and embedding with s64 indices and offsets. Every case runs
+//once with s32 and once with s64 indices/offsets holding the same values, and
+//the outputs must match exactly: embedding_bag sum/mean/max on f32 and 8 bit
+//quantized tables, the group embedding bag and the embedding op.
+//
+//Usage: embedding_bag_s64 [width] [batch_size] [pool_size]
+//  width      : embedding dimension (default 64)
+//  batch_size : number of bags (default 512)
+//  pool_size  : indices per bag (default 20)
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Index memory of data type idx_dt holding values
+memory index_memory(const std::vector<int64_t> &values, dt idx_dt,
+                    engine &eng) {
+    memory mem({{(memory::dim)values.size()}, idx_dt, tag::a}, eng);
+    if (idx_dt == dt::s64) {
+        std::copy(values.begin(), values.end(),
+                  static_cast<int64_t *>(mem.get_data_handle()));
+    }
+    else {
+        std::copy(values.begin(), values.end(),
+                  static_cast<int32_t *>(mem.get_data_handle()));
+    }
+    return mem;
+}
+
+void run_embedding_bag(engine &eng, stream &s, algorithm alg, memory &table,
+                       memory &indices, memory &offsets, memory &dst) {
+    auto pdesc = embedding_bag::desc(prop_kind::forward_inference, alg, 0,
+                                     table.get_desc(), indices.get_desc(), offsets.get_desc(),
+                                     dst.get_desc(), -1);
+    auto pd = embedding_bag::primitive_desc(pdesc, eng);
+    embedding_bag(pd).execute(s, {{ZENDNN_ARG_SRC_0, table},
+        {ZENDNN_ARG_SRC_1, indices}, {ZENDNN_ARG_SRC_2, offsets},
+        {ZENDNN_ARG_DST, dst}
+    });
+    s.wait();
+}
+
+float max_abs_diff(memory &a, memory &b) {
+    size_t n = a.get_desc().get_size() / sizeof(float);
+    std::vector<float> va(n), vb(n);
+    read_from_zendnn_memory(va.data(), a);
+    read_from_zendnn_memory(vb.data(), b);
+    float diff = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        diff = std::max(diff, std::fabs(va[i] - vb[i]));
+    }
+    return diff;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_s64 test starts");
+
+    int width = 64, batch_size = 512, pool_size = 20;
+    if (argc > 1) {
+        width = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        batch_size = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        pool_size = std::stoi(std::string(argv[3]));
+    }
+    const int rows = 10000, num_tables = 4;
+    const int indices_size = batch_size * pool_size;
+
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<> dis_row(0, rows - 1);
+    std::uniform_real_distribution<float> dis_val(-1.0f, 1.0f);
+
+    std::vector<int64_t> indices(indices_size), offsets(batch_size);
+    for (auto &i : indices) {
+        i = dis_row(gen);
+    }
+    for (int b = 0; b < batch_size; b++) {
+        offsets[b] = b * pool_size;
+    }
+    std::vector<float> table_data(rows * width);
+    for (auto &v : table_data) {
+        v = dis_val(gen);
+    }
+    //8 bit rows: codes, then scale and bias
+    const int qrow_bytes = width + 2 * sizeof(float);
+    std::vector<uint8_t> qtable_data(rows * qrow_bytes);
+    for (int r = 0; r < rows; r++) {
+        for (int j = 0; j < width; j++) {
+            qtable_data[r * qrow_bytes + j] = gen() & 0xff;
+        }
+        float scale = 0.01f, bias = -1.0f;
+        std::memcpy(&qtable_data[r * qrow_bytes + width], &scale, sizeof(float));
+        std::memcpy(&qtable_data[r * qrow_bytes + width + sizeof(float)], &bias,
+                    sizeof(float));
+    }
+    auto table = memory({{rows, width}, dt::f32, tag::ab}, eng,
+                        table_data.data());
+    auto qtable = memory({{rows, qrow_bytes}, dt::u8, tag::ab}, eng,
+                         qtable_data.data());
+
+    auto idx32 = index_memory(indices, dt::s32, eng);
+    auto off32 = index_memory(offsets, dt::s32, eng);
+    auto idx64 = index_memory(indices, dt::s64, eng);
+    auto off64 = index_memory(offsets, dt::s64, eng);
+    auto dst_md = memory::desc({batch_size, width}, dt::f32, tag::ab);
+
+    std::cout<<"case,max_abs_diff"<<std::endl;
+    int status = 0;
+    auto report = [&](const std::string &name, float diff) {
+        std::cout<<name<<","<<diff<<std::endl;
+        if (diff != 0.0f) {
+            status = 1;
+        }
+    };
+
+    const std::pair<const char *, algorithm> algs[] = {
+        {"sum", algorithm::embedding_bag_sum},
+        {"mean", algorithm::embedding_bag_mean},
+        {"max", algorithm::embedding_bag_max}
+    };
+    for (auto &tbl : {
+                std::make_pair("f32", &table), std::make_pair("u8", &qtable)
+            }) {
+        for (const auto &alg : algs) {
+            memory dst32(dst_md, eng), dst64(dst_md, eng);
+            run_embedding_bag(eng, s, alg.second, *tbl.second, idx32, off32, dst32);
+            run_embedding_bag(eng, s, alg.second, *tbl.second, idx64, off64, dst64);
+            report(std::string("embedding_bag_") + tbl.first + "_" + alg.first,
+                   max_abs_diff(dst32, dst64));
+        }
+    }
+
+    //Group embedding bag, the tables share the indices
+    std::vector<memory> tables(num_tables, table), grp_idx32(num_tables, idx32),
+        grp_off32(num_tables, off32), grp_idx64(num_tables, idx64),
+        grp_off64(num_tables, off64), grp_dst32, grp_dst64, psw(num_tables);
+    for (int t = 0; t < num_tables; t++) {
+        grp_dst32.push_back(memory(dst_md, eng));
+        grp_dst64.push_back(memory(dst_md, eng));
+    }
+    std::vector<int32_t> zeros(num_tables, 0), padding_idx(num_tables, -1);
+    std::vector<algorithm> modes(num_tables, algorithm::embedding_bag_sum);
+    zendnn_custom_op::zendnn_grp_embedding_bag(tables, grp_idx32, grp_off32,
+            zeros, modes, zeros, psw, zeros, zeros, padding_idx, grp_dst32);
+    zendnn_custom_op::zendnn_grp_embedding_bag(tables, grp_idx64, grp_off64,
+            zeros, modes, zeros, psw, zeros, zeros, padding_idx, grp_dst64);
+    float grp_diff = 0.0f;
+    for (int t = 0; t < num_tables; t++) {
+        grp_diff = std::max(grp_diff, max_abs_diff(grp_dst32[t], grp_dst64[t]));
+    }
+    report("grp_embedding_bag", grp_diff);
+
+    //Embedding, one index per row of the output
+    auto emb_md = memory::desc({indices_size, width}, dt::f32, tag::ab);
+    memory emb32(emb_md, eng), emb64(emb_md, eng);
+    zendnn_custom_op::zendnn_embedding(table, idx32, -1, false, false, emb32);
+    zendnn_custom_op::zendnn_embedding(table, idx64, -1, false, false, emb64);
+    report("embedding", max_abs_diff(emb32, emb64));
+
+    std::cout<<(status ? "s64 embedding bag mismatch" :
+                "s64 embedding bag passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_bag_s64 test ends");
+    return status;
+}
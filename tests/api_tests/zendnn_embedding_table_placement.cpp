@@ -0,0 +1,209 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Group embedding bag on placed tables. The tables are written to one file,
+//after a header so that they do not start on a page, and half of them are
+//memory mapped from it; the other half are copied and sharded over the NUMA
+//nodes, the last one interleaved. The group op on the placed tables is
+//checked against the same op on the tables in ordinary memory, and the time
+//per call of both is reported. Mapping a table past the end of the file must
+//fail.
+//
+//Usage: embedding_table_placement [num_tables] [batch_size] [iters] [file]
+//  num_tables : number of tables (default 8)
+//  batch_size : bags per table (default 1024)
+//  iters      : timed calls (default 20)
+//  file       : table file, removed at the end (default embedding_tables.bin)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Time per call of the group op
+double time_grp_embedding_bag(std::vector<memory> &tables,
+                              std::vector<memory> &indices, std::vector<memory> &offsets,
+                              std::vector<memory> &dst, std::vector<algorithm> &alg, int iters) {
+    int num_tables = tables.size();
+    std::vector<memory> psw(num_tables);
+    std::vector<int32_t> scale_grad_by_freq(num_tables, 0), sparse(num_tables, 0),
+        psw_defined(num_tables, 0), include_last_offset(num_tables, 0),
+        padding_idx(num_tables, -1);
+    zendnn_custom_op::zendnn_grp_embedding_bag(tables, indices, offsets,
+            scale_grad_by_freq, alg, sparse, psw, psw_defined, include_last_offset,
+            padding_idx, dst);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        zendnn_custom_op::zendnn_grp_embedding_bag(tables, indices, offsets,
+                scale_grad_by_freq, alg, sparse, psw, psw_defined, include_last_offset,
+                padding_idx, dst);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_table_placement test starts");
+
+    int num_tables = 8, batch_size = 1024, iters = 20;
+    std::string path = "embedding_tables.bin";
+    if (argc > 1) {
+        num_tables = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        batch_size = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        iters = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        path = argv[4];
+    }
+    const int pool_size = 20, header_bytes = 40;
+
+    engine eng(engine::kind::cpu, 0);
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> dis_table(-1.0f, 1.0f);
+
+    std::vector<memory> table_mem(num_tables), placed_mem(num_tables),
+        indices_mem(num_tables), offsets_mem(num_tables), dst_mem(num_tables),
+        placed_dst_mem(num_tables);
+    std::vector<algorithm> alg(num_tables, algorithm::embedding_bag_sum);
+    std::vector<int> widths(num_tables);
+    std::vector<int64_t> file_offsets(num_tables);
+
+    std::ofstream file(path, std::ios::binary);
+    std::vector<char> header(header_bytes, 0);
+    file.write(header.data(), header_bytes);
+    int64_t file_pos = header_bytes;
+    for (int t = 0; t < num_tables; t++) {
+        int rows = 20000 + 10000 * t;
+        int width = t % 2 ? 64 : 128;
+        widths[t] = width;
+        if (t % 3 == 2) {
+            alg[t] = algorithm::embedding_bag_mean;
+        }
+
+        std::vector<float> table((size_t)rows * width);
+        for (auto &w : table) {
+            w = dis_table(gen);
+        }
+        std::uniform_int_distribution<> dis_row(0, rows - 1);
+        std::vector<int32_t> indices(batch_size * pool_size), offsets(batch_size);
+        for (auto &idx : indices) {
+            idx = dis_row(gen);
+        }
+        for (int b = 0; b < batch_size; b++) {
+            offsets[b] = b * pool_size;
+        }
+
+        table_mem[t] = memory({{rows, width}, dt::f32, tag::ab}, eng);
+        indices_mem[t] = memory({{(memory::dim)indices.size()}, dt::s32, tag::a},
+                                eng);
+        offsets_mem[t] = memory({{batch_size}, dt::s32, tag::a}, eng);
+        dst_mem[t] = memory({{batch_size, width}, dt::f32, tag::ab}, eng);
+        placed_dst_mem[t] = memory({{batch_size, width}, dt::f32, tag::ab}, eng);
+        write_to_zendnn_memory(table.data(), table_mem[t]);
+        write_to_zendnn_memory(indices.data(), indices_mem[t]);
+        write_to_zendnn_memory(offsets.data(), offsets_mem[t]);
+
+        file.write((const char *)table.data(), table.size() * sizeof(float));
+        file_offsets[t] = file_pos;
+        file_pos += table.size() * sizeof(float);
+    }
+    file.close();
+
+    //Even tables mapped from the file, odd ones copied and placed
+    std::vector<memory> sharded;
+    for (int t = 0; t < num_tables; t++) {
+        if (t % 2 == 0) {
+            placed_mem[t] = memory(table_mem[t].get_desc(), eng, ZENDNN_MEMORY_NONE);
+            zendnn_custom_op::zendnn_embedding_table_map(path, placed_mem[t],
+                    file_offsets[t]);
+        }
+        else {
+            placed_mem[t] = memory(table_mem[t].get_desc(), eng);
+            std::vector<float> table(table_mem[t].get_desc().get_size() / sizeof(float));
+            read_from_zendnn_memory(table.data(), table_mem[t]);
+            write_to_zendnn_memory(table.data(), placed_mem[t]);
+            sharded.push_back(placed_mem[t]);
+        }
+    }
+    if (!sharded.empty()) {
+        zendnn_custom_op::zendnn_embedding_table_place(sharded.back(), -1);
+        sharded.pop_back();
+    }
+    zendnn_custom_op::zendnn_embedding_tables_shard(sharded);
+
+    double ms = time_grp_embedding_bag(table_mem, indices_mem, offsets_mem,
+                                       dst_mem, alg, iters);
+    double placed_ms = time_grp_embedding_bag(placed_mem, indices_mem,
+                       offsets_mem, placed_dst_mem, alg, iters);
+
+    float max_diff = 0.0f;
+    for (int t = 0; t < num_tables; t++) {
+        std::vector<float> ref(batch_size * widths[t]), out(batch_size * widths[t]);
+        read_from_zendnn_memory(ref.data(), dst_mem[t]);
+        read_from_zendnn_memory(out.data(), placed_dst_mem[t]);
+        for (size_t i = 0; i < ref.size(); i++) {
+            max_diff = std::max(max_diff, std::fabs(ref[i] - out[i]));
+        }
+    }
+    for (int t = 0; t < num_tables; t++) {
+        zendnn_custom_op::zendnn_embedding_table_release(placed_mem[t]);
+    }
+
+    //The last table one element further on runs past the end of the file
+    bool short_file_refused = false;
+    try {
+        memory past_end(table_mem[num_tables - 1].get_desc(), eng,
+                        ZENDNN_MEMORY_NONE);
+        zendnn_custom_op::zendnn_embedding_table_map(path, past_end,
+                file_offsets[num_tables - 1] + sizeof(float));
+        zendnn_custom_op::zendnn_embedding_table_release(past_end);
+    }
+    catch (const error &e) {
+        short_file_refused = true;
+    }
+    std::remove(path.c_str());
+
+    std::cout<<"num_tables,batch_size,ms_per_call,placed_ms_per_call,max_abs_diff"
+             <<std::endl;
+    std::cout<<num_tables<<","<<batch_size<<","<<ms<<","<<placed_ms<<","
+             <<max_diff<<std::endl;
+
+    if (!short_file_refused) {
+        std::cout<<"table past the end of the file was mapped"<<std::endl;
+    }
+    int status = max_diff > 1e-4f || !short_file_refused ? 1 : 0;
+    std::cout<<(status ? "Embedding table placement mismatch" :
+                "Embedding table placement passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "embedding_table_placement test ends");
+    return status;
+}
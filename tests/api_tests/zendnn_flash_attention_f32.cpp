@@ -0,0 +1,168 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Flash attention (multihead_attention_flash_v1/v2) against the reference
+//multihead_attention: checks the outputs match and reports the time per call
+//of every algorithm.
+//
+//Usage: zendnn_attention_flash_f32 [S] [N] [H] [B] [iters]
+//  S     : sequence length (default 200, not a multiple of the flash tiles)
+//  N, H  : number of heads and head size (default 8 x 64)
+//  B     : batch size (default 2)
+//  iters : timed calls per algorithm (default 5)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Runs algo, returns the average time per call in ms
+double run_attention(engine &eng, stream &engine_stream, algorithm algo,
+                     memory::dim B, memory::dim S, memory::dim N, memory::dim H,
+                     int iters, std::vector<float> &dst_data) {
+    const memory::dim E = N * H;
+    std::vector<float> src_data(B * S * E), weights_data(E * E), bias_data(E),
+        mask_data(B * S);
+    for (size_t i = 0; i < src_data.size(); i++) {
+        src_data[i] = std::cos(i / 10.f);
+    }
+    for (size_t i = 0; i < weights_data.size(); i++) {
+        weights_data[i] = std::sin(i * 2.f) / std::sqrt((float)E);
+    }
+    for (size_t i = 0; i < bias_data.size(); i++) {
+        bias_data[i] = std::tanh(i);
+    }
+    //Padded tail on every sequence but the first
+    for (memory::dim b = 0; b < B; b++) {
+        for (memory::dim s = 0; s < S; s++) {
+            mask_data[b * S + s] = (s < S - b * (S / 4)) ? 1.0f : 0.0f;
+        }
+    }
+    dst_data.assign(B * S * E, 0.0f);
+
+    auto src_md = memory::desc({B, S, E}, dt::f32, tag::abc);
+    auto weights_md = memory::desc({E, E}, dt::f32, tag::ab);
+    auto bias_md = memory::desc({E}, dt::f32, tag::a);
+    auto mask_md = memory::desc({B, S}, dt::f32, tag::ab);
+    auto dst_md = memory::desc({B, S, E}, dt::f32, tag::abc);
+    auto src_mem = memory(src_md, eng, src_data.data());
+    auto weights_mem = memory(weights_md, eng, weights_data.data());
+    auto bias_mem = memory(bias_md, eng, bias_data.data());
+    auto mask_mem = memory(mask_md, eng, mask_data.data());
+    auto dst_mem = memory(dst_md, eng, dst_data.data());
+
+    auto attn_desc = attention::desc(prop_kind::forward_inference, algo,
+                                     src_md, src_md, src_md,
+                                     weights_md, weights_md, weights_md,
+                                     bias_md, bias_md, bias_md,
+                                     mask_md, dst_md, 1 / std::sqrt((float)H),
+                                     N, 1);
+    primitive_attr attn_attr;
+    auto attn_pd = attention::primitive_desc(attn_desc, attn_attr, eng);
+    auto attn_prim = attention(attn_pd);
+    std::cout<<"# "<<attn_pd.impl_info_str()<<std::endl;
+
+    std::unordered_map<int, memory> attn_args;
+    attn_args.insert({ZENDNN_ARG_SRC_0, src_mem});
+    attn_args.insert({ZENDNN_ARG_SRC_1, src_mem});
+    attn_args.insert({ZENDNN_ARG_SRC_2, src_mem});
+    attn_args.insert({ZENDNN_ARG_WEIGHTS_0, weights_mem});
+    attn_args.insert({ZENDNN_ARG_WEIGHTS_1, weights_mem});
+    attn_args.insert({ZENDNN_ARG_WEIGHTS_2, weights_mem});
+    attn_args.insert({ZENDNN_ARG_BIAS_0, bias_mem});
+    attn_args.insert({ZENDNN_ARG_BIAS_1, bias_mem});
+    attn_args.insert({ZENDNN_ARG_BIAS_2, bias_mem});
+    attn_args.insert({ZENDNN_ARG_MASK, mask_mem});
+    attn_args.insert({ZENDNN_ARG_DST, dst_mem});
+
+    attn_prim.execute(engine_stream, attn_args);
+    engine_stream.wait();
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        attn_prim.execute(engine_stream, attn_args);
+    }
+    engine_stream.wait();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_attention_flash_f32 test starts");
+
+    memory::dim S = 200, N = 8, H = 64, B = 2;
+    int iters = 5;
+    if (argc > 1) {
+        S = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        N = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        H = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        B = std::stoi(std::string(argv[4]));
+    }
+    if (argc > 5) {
+        iters = std::stoi(std::string(argv[5]));
+    }
+
+    engine eng(engine::kind::cpu, 0);
+    stream engine_stream(eng);
+
+    std::cout<<"B="<<B<<" S="<<S<<" N="<<N<<" H="<<H<<std::endl;
+    std::vector<float> ref_dst, flash_dst;
+    double ref_ms = run_attention(eng, engine_stream,
+                                  algorithm::multihead_attention, B, S, N, H, iters, ref_dst);
+    std::cout<<"algo,ms_per_call,max_abs_diff"<<std::endl;
+    std::cout<<"multihead_attention,"<<ref_ms<<",0"<<std::endl;
+
+    int status = 0;
+    const algorithm flash_algos[] = {algorithm::multihead_attention_flash_v1,
+                                     algorithm::multihead_attention_flash_v2
+                                    };
+    const char *flash_names[] = {"multihead_attention_flash_v1",
+                                 "multihead_attention_flash_v2"
+                                };
+    for (int a = 0; a < 2; a++) {
+        double ms = run_attention(eng, engine_stream, flash_algos[a], B, S, N, H,
+                                  iters, flash_dst);
+        float max_diff = 0.0f;
+        for (size_t i = 0; i < ref_dst.size(); i++) {
+            max_diff = std::max(max_diff, std::fabs(ref_dst[i] - flash_dst[i]));
+        }
+        std::cout<<flash_names[a]<<","<<ms<<","<<max_diff<<std::endl;
+        if (max_diff > 1e-3f) {
+            status = 1;
+        }
+    }
+
+    std::cout<<(status ? "Flash attention mismatch" : "Flash attention passed")
+             <<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_attention_flash_f32 test ends");
+    return status;
+}
@@ -0,0 +1,201 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Grouped-query and multi-query attention. K and V weights hold Nkv heads
+//only, (E, Nkv*H), and query head n attends with K/V head n / (N / Nkv).
+//The result is checked against multihead_attention run with the K/V heads
+//replicated for every query head, and the time per call of both is reported.
+//
+//Usage: zendnn_attention_grouped_f32 [S] [N] [Nkv] [H] [B] [iters]
+//  S     : sequence length (default 200)
+//  N     : number of query heads (default 16)
+//  Nkv   : number of K/V heads, 1 runs multiquery_attention (default 4)
+//  H     : head size (default 64)
+//  B     : batch size (default 2)
+//  iters : timed calls per algorithm (default 5)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Runs algo with kv_heads K/V heads, returns the average time per call in ms
+double run_attention(engine &eng, stream &engine_stream, algorithm algo,
+                     memory::dim B, memory::dim S, memory::dim N, memory::dim H,
+                     memory::dim kv_heads, const std::vector<float> &kv_weights_data,
+                     const std::vector<float> &kv_bias_data, int iters,
+                     std::vector<float> &dst_data) {
+    const memory::dim E = N * H, E_kv = kv_heads * H;
+    std::vector<float> src_data(B * S * E), weights_data(E * E), bias_data(E),
+        mask_data(B * S);
+    for (size_t i = 0; i < src_data.size(); i++) {
+        src_data[i] = std::cos(i / 10.f);
+    }
+    for (size_t i = 0; i < weights_data.size(); i++) {
+        weights_data[i] = std::sin(i * 2.f) / std::sqrt((float)E);
+    }
+    for (size_t i = 0; i < bias_data.size(); i++) {
+        bias_data[i] = std::tanh(i);
+    }
+    for (memory::dim b = 0; b < B; b++) {
+        for (memory::dim s = 0; s < S; s++) {
+            mask_data[b * S + s] = (s < S - b * (S / 4)) ? 1.0f : 0.0f;
+        }
+    }
+    dst_data.assign(B * S * E, 0.0f);
+
+    auto src_md = memory::desc({B, S, E}, dt::f32, tag::abc);
+    auto weights_md = memory::desc({E, E}, dt::f32, tag::ab);
+    auto kv_weights_md = memory::desc({E, E_kv}, dt::f32, tag::ab);
+    auto bias_md = memory::desc({E}, dt::f32, tag::a);
+    auto kv_bias_md = memory::desc({E_kv}, dt::f32, tag::a);
+    auto mask_md = memory::desc({B, S}, dt::f32, tag::ab);
+    auto dst_md = memory::desc({B, S, E}, dt::f32, tag::abc);
+    auto src_mem = memory(src_md, eng, src_data.data());
+    auto weights_mem = memory(weights_md, eng, weights_data.data());
+    auto kv_weights_mem = memory(kv_weights_md, eng,
+                                 (void *)kv_weights_data.data());
+    auto bias_mem = memory(bias_md, eng, bias_data.data());
+    auto kv_bias_mem = memory(kv_bias_md, eng, (void *)kv_bias_data.data());
+    auto mask_mem = memory(mask_md, eng, mask_data.data());
+    auto dst_mem = memory(dst_md, eng, dst_data.data());
+
+    auto attn_desc = attention::desc(prop_kind::forward_inference, algo,
+                                     src_md, src_md, src_md,
+                                     weights_md, kv_weights_md, kv_weights_md,
+                                     bias_md, kv_bias_md, kv_bias_md,
+                                     mask_md, dst_md, 1 / std::sqrt((float)H),
+                                     N, 1);
+    primitive_attr attn_attr;
+    auto attn_pd = attention::primitive_desc(attn_desc, attn_attr, eng);
+    auto attn_prim = attention(attn_pd);
+    std::cout<<"# "<<attn_pd.impl_info_str()<<std::endl;
+
+    std::unordered_map<int, memory> attn_args;
+    attn_args.insert({ZENDNN_ARG_SRC_0, src_mem});
+    attn_args.insert({ZENDNN_ARG_SRC_1, src_mem});
+    attn_args.insert({ZENDNN_ARG_SRC_2, src_mem});
+    attn_args.insert({ZENDNN_ARG_WEIGHTS_0, weights_mem});
+    attn_args.insert({ZENDNN_ARG_WEIGHTS_1, kv_weights_mem});
+    attn_args.insert({ZENDNN_ARG_WEIGHTS_2, kv_weights_mem});
+    attn_args.insert({ZENDNN_ARG_BIAS_0, bias_mem});
+    attn_args.insert({ZENDNN_ARG_BIAS_1, kv_bias_mem});
+    attn_args.insert({ZENDNN_ARG_BIAS_2, kv_bias_mem});
+    attn_args.insert({ZENDNN_ARG_MASK, mask_mem});
+    attn_args.insert({ZENDNN_ARG_DST, dst_mem});
+
+    attn_prim.execute(engine_stream, attn_args);
+    engine_stream.wait();
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        attn_prim.execute(engine_stream, attn_args);
+    }
+    engine_stream.wait();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_attention_grouped_f32 test starts");
+
+    memory::dim S = 200, N = 16, Nkv = 4, H = 64, B = 2;
+    int iters = 5;
+    if (argc > 1) {
+        S = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        N = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        Nkv = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        H = std::stoi(std::string(argv[4]));
+    }
+    if (argc > 5) {
+        B = std::stoi(std::string(argv[5]));
+    }
+    if (argc > 6) {
+        iters = std::stoi(std::string(argv[6]));
+    }
+    if (Nkv <= 0 || N % Nkv != 0) {
+        std::cout<<"N must be a multiple of Nkv"<<std::endl;
+        return 1;
+    }
+
+    engine eng(engine::kind::cpu, 0);
+    stream engine_stream(eng);
+
+    //K/V weights of the Nkv heads and the same heads replicated per query head
+    const memory::dim E = N * H, group = N / Nkv;
+    std::vector<float> kv_weights(E * Nkv * H), kv_bias(Nkv * H),
+        mha_weights(E * E), mha_bias(E);
+    for (size_t i = 0; i < kv_weights.size(); i++) {
+        kv_weights[i] = std::cos(i * 3.f) / std::sqrt((float)E);
+    }
+    for (size_t i = 0; i < kv_bias.size(); i++) {
+        kv_bias[i] = std::sin(i);
+    }
+    for (memory::dim e = 0; e < E; e++) {
+        for (memory::dim n = 0; n < N; n++) {
+            for (memory::dim h = 0; h < H; h++) {
+                mha_weights[e * E + n * H + h] = kv_weights[e * Nkv * H +
+                                                 (n / group) * H + h];
+            }
+        }
+    }
+    for (memory::dim n = 0; n < N; n++) {
+        for (memory::dim h = 0; h < H; h++) {
+            mha_bias[n * H + h] = kv_bias[(n / group) * H + h];
+        }
+    }
+
+    std::cout<<"B="<<B<<" S="<<S<<" N="<<N<<" Nkv="<<Nkv<<" H="<<H<<std::endl;
+    std::vector<float> ref_dst, grouped_dst;
+    double ref_ms = run_attention(eng, engine_stream,
+                                  algorithm::multihead_attention, B, S, N, H, N, mha_weights, mha_bias,
+                                  iters, ref_dst);
+    algorithm algo = Nkv == 1 ? algorithm::multiquery_attention :
+                     algorithm::groupedquery_attention;
+    double ms = run_attention(eng, engine_stream, algo, B, S, N, H, Nkv,
+                              kv_weights, kv_bias, iters, grouped_dst);
+    float max_diff = 0.0f;
+    for (size_t i = 0; i < ref_dst.size(); i++) {
+        max_diff = std::max(max_diff, std::fabs(ref_dst[i] - grouped_dst[i]));
+    }
+
+    std::cout<<"algo,ms_per_call,max_abs_diff"<<std::endl;
+    std::cout<<"multihead_attention,"<<ref_ms<<",0"<<std::endl;
+    std::cout<<(Nkv == 1 ? "multiquery_attention," : "groupedquery_attention,")
+             <<ms<<","<<max_diff<<std::endl;
+
+    int status = max_diff > 1e-3f ? 1 : 0;
+    std::cout<<(status ? "Grouped attention mismatch" :
+                "Grouped attention passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_attention_grouped_f32 test ends");
+    return status;
+}
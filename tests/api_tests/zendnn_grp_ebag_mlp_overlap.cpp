@@ -0,0 +1,208 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Overlapped group embedding bag and MLP. zendnn_grp_ebag_mlp runs with
+//ZENDNN_EB_MLP_OVERLAP=1 (set by the test unless already in the environment)
+//and its outputs are checked against zendnn_grp_embedding_bag followed by
+//zendnn_grp_mlp. The time per call of both is reported. ZENDNN_EB_MLP_THREADS
+//sets the embedding share of the threads, the split is estimated otherwise.
+//An MLP input overlapping the embedding destinations at another address is
+//checked to run after the embedding bags.
+//
+//Usage: grp_ebag_mlp_overlap [num_tables] [batch_size] [num_layers] [iters]
+//  num_tables : number of embedding tables (default 26)
+//  batch_size : bags per table and rows of the MLP input (default 2048)
+//  num_layers : linear MLP layers of width 512 (default 3)
+//  iters      : timed calls (default 20)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+float max_abs_diff(std::vector<memory> &a, std::vector<memory> &b) {
+    float diff = 0.0f;
+    for (size_t t = 0; t < a.size(); t++) {
+        size_t n = a[t].get_desc().get_size() / sizeof(float);
+        std::vector<float> va(n), vb(n);
+        read_from_zendnn_memory(va.data(), a[t]);
+        read_from_zendnn_memory(vb.data(), b[t]);
+        for (size_t i = 0; i < n; i++) {
+            diff = std::max(diff, std::fabs(va[i] - vb[i]));
+        }
+    }
+    return diff;
+}
+
+int main(int argc, char **argv) {
+    //Before the first op, the environment is read once
+    setenv("ZENDNN_EB_MLP_OVERLAP", "1", 0);
+    zendnnInfo(ZENDNN_TESTLOG, "grp_ebag_mlp_overlap test starts");
+
+    int num_tables = 26, batch_size = 2048, num_layers = 3, iters = 20;
+    if (argc > 1) {
+        num_tables = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        batch_size = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        num_layers = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        iters = std::stoi(std::string(argv[4]));
+    }
+    const int rows = 100000, width = 64, pool_size = 20, mlp_width = 512;
+
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<> dis_row(0, rows - 1);
+    std::uniform_real_distribution<float> dis_val(-1.0f, 1.0f);
+
+    //Embedding bag inputs
+    std::vector<memory> tables, indices, offsets, eb_dst, ref_eb_dst,
+        psw(num_tables);
+    std::vector<int32_t> zeros(num_tables, 0), padding_idx(num_tables, -1);
+    std::vector<algorithm> modes(num_tables, algorithm::embedding_bag_sum);
+    std::vector<int32_t> offsets_data(batch_size),
+        indices_data(batch_size * pool_size);
+    std::vector<float> table_data(rows * width);
+    for (int b = 0; b < batch_size; b++) {
+        offsets_data[b] = b * pool_size;
+    }
+    for (int t = 0; t < num_tables; t++) {
+        for (auto &v : table_data) {
+            v = dis_val(gen);
+        }
+        for (auto &i : indices_data) {
+            i = dis_row(gen);
+        }
+        tables.push_back(memory({{rows, width}, dt::f32, tag::ab}, eng));
+        indices.push_back(memory({{(memory::dim)indices_data.size()}, dt::s32, tag::a},
+                                 eng));
+        offsets.push_back(memory({{batch_size}, dt::s32, tag::a}, eng));
+        eb_dst.push_back(memory({{batch_size, width}, dt::f32, tag::ab}, eng));
+        ref_eb_dst.push_back(memory({{batch_size, width}, dt::f32, tag::ab}, eng));
+        write_to_zendnn_memory(table_data.data(), tables[t]);
+        write_to_zendnn_memory(indices_data.data(), indices[t]);
+        write_to_zendnn_memory(offsets_data.data(), offsets[t]);
+    }
+
+    //Linear MLP on a dense input of its own
+    std::vector<memory> mlp_input(1), mlp_weight, mlp_bias(num_layers), mlp_dst,
+        ref_mlp_dst;
+    std::vector<float> alpha(num_layers, 1.0f), beta(num_layers, 0.0f);
+    std::vector<bool> bias_defined(num_layers, false);
+    std::vector<int64_t> fuse(num_layers, 1);
+    std::vector<float> mlp_data(batch_size * mlp_width);
+    for (auto &v : mlp_data) {
+        v = dis_val(gen);
+    }
+    mlp_input[0] = memory({{batch_size, mlp_width}, dt::f32, tag::ab}, eng);
+    write_to_zendnn_memory(mlp_data.data(), mlp_input[0]);
+    std::vector<float> weight_data(mlp_width * mlp_width);
+    for (int l = 0; l < num_layers; l++) {
+        for (auto &w : weight_data) {
+            w = dis_val(gen) / mlp_width;
+        }
+        mlp_weight.push_back(memory({{mlp_width, mlp_width}, dt::f32, tag::ab}, eng));
+        write_to_zendnn_memory(weight_data.data(), mlp_weight[l]);
+        mlp_dst.push_back(memory({{batch_size, mlp_width}, dt::f32, tag::ab}, eng));
+        ref_mlp_dst.push_back(memory({{batch_size, mlp_width}, dt::f32, tag::ab},
+                                     eng));
+    }
+
+    auto run_sequential = [&] {
+        zendnn_custom_op::zendnn_grp_embedding_bag(tables, indices, offsets, zeros,
+                modes, zeros, psw, zeros, zeros, padding_idx, ref_eb_dst);
+        zendnn_custom_op::zendnn_grp_mlp(mlp_input, mlp_weight, mlp_bias, alpha,
+                                         beta, bias_defined, fuse, ref_mlp_dst);
+    };
+    auto run_overlapped = [&] {
+        zendnn_custom_op::zendnn_grp_ebag_mlp(tables, indices, offsets, zeros,
+                                              modes, zeros, psw, zeros, zeros, padding_idx, eb_dst, mlp_input,
+                                              mlp_weight, mlp_bias, alpha, beta, bias_defined, fuse, mlp_dst);
+    };
+    auto time_ms = [&](const std::function<void()> &run) {
+        run();
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; i++) {
+            run();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - begin).count() /
+               iters;
+    };
+
+    double seq_ms = time_ms(run_sequential);
+    double overlap_ms = time_ms(run_overlapped);
+    float eb_diff = max_abs_diff(eb_dst, ref_eb_dst);
+    float mlp_diff = max_abs_diff(mlp_dst, ref_mlp_dst);
+
+    std::cout<<"num_tables,batch_size,num_layers,sequential_ms,overlapped_ms,"
+             <<"eb_max_abs_diff,mlp_max_abs_diff"<<std::endl;
+    std::cout<<num_tables<<","<<batch_size<<","<<num_layers<<","<<seq_ms<<","
+             <<overlap_ms<<","<<eb_diff<<","<<mlp_diff<<std::endl;
+
+    //Embedding destinations back to back in one buffer and an MLP input
+    //starting inside the first of them: the ops share bytes without sharing
+    //a handle and must run one after the other
+    const size_t eb_floats = (size_t)batch_size * width;
+    const size_t cat_floats = std::max(num_tables * eb_floats,
+                                       eb_floats / 2 + (size_t)batch_size * mlp_width);
+    std::vector<float> cat(cat_floats, 0.0f), ref_cat(cat_floats, 0.0f);
+    std::vector<memory> cat_eb_dst, ref_cat_eb_dst;
+    for (int t = 0; t < num_tables; t++) {
+        cat_eb_dst.push_back(memory({{batch_size, width}, dt::f32, tag::ab}, eng,
+                                    cat.data() + t * eb_floats));
+        ref_cat_eb_dst.push_back(memory({{batch_size, width}, dt::f32, tag::ab},
+                                        eng, ref_cat.data() + t * eb_floats));
+    }
+    std::vector<memory> cat_input(1), ref_cat_input(1);
+    cat_input[0] = memory({{batch_size, mlp_width}, dt::f32, tag::ab}, eng,
+                          cat.data() + eb_floats / 2);
+    ref_cat_input[0] = memory({{batch_size, mlp_width}, dt::f32, tag::ab}, eng,
+                              ref_cat.data() + eb_floats / 2);
+    zendnn_custom_op::zendnn_grp_embedding_bag(tables, indices, offsets, zeros,
+            modes, zeros, psw, zeros, zeros, padding_idx, ref_cat_eb_dst);
+    zendnn_custom_op::zendnn_grp_mlp(ref_cat_input, mlp_weight, mlp_bias, alpha,
+                                     beta, bias_defined, fuse, ref_mlp_dst);
+    zendnn_custom_op::zendnn_grp_ebag_mlp(tables, indices, offsets, zeros,
+                                          modes, zeros, psw, zeros, zeros, padding_idx, cat_eb_dst, cat_input,
+                                          mlp_weight, mlp_bias, alpha, beta, bias_defined, fuse, mlp_dst);
+    float dep_diff = max_abs_diff(mlp_dst, ref_mlp_dst);
+    std::cout<<"overlapping_views_mlp_max_abs_diff"<<std::endl<<dep_diff<<std::endl;
+
+    int status = (eb_diff > 1e-4f || mlp_diff > 1e-3f || dep_diff > 1e-3f) ? 1 : 0;
+    std::cout<<(status ? "Overlapped grp ebag mlp mismatch" :
+                "Overlapped grp ebag mlp passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "grp_ebag_mlp_overlap test ends");
+    return status;
+}
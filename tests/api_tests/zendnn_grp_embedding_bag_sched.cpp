@@ -0,0 +1,170 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Group embedding bag on skewed tables: a few hot tables with long bags and
+//wide rows next to many small ones. The group op is checked against
+//embedding_bag run table by table, and the time per call is reported for the
+//scheduler picked by ZENDNN_EB_THREAD_TYPE (WORK_THREADED by default).
+//
+//Usage: grp_embedding_bag_sched [num_tables] [num_hot] [batch_size] [iters]
+//  num_tables : number of tables (default 26)
+//  num_hot    : number of hot tables (default 3)
+//  batch_size : bags per table (default 2048)
+//  iters      : timed calls (default 20)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "grp_embedding_bag_sched test starts");
+
+    int num_tables = 26, num_hot = 3, batch_size = 2048, iters = 20;
+    if (argc > 1) {
+        num_tables = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        num_hot = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        batch_size = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        iters = std::stoi(std::string(argv[4]));
+    }
+
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(7);
+
+    std::vector<memory> table_mem(num_tables), indices_mem(num_tables),
+        offsets_mem(num_tables), dst_mem(num_tables), grp_dst_mem(num_tables),
+        psw_mem(num_tables);
+    std::vector<int32_t> scale_grad_by_freq(num_tables, 0), sparse(num_tables, 0),
+        psw_defined(num_tables, 0), include_last_offset(num_tables, 0),
+        padding_idx(num_tables, -1);
+    std::vector<algorithm> alg(num_tables, algorithm::embedding_bag_sum);
+    std::vector<int> widths(num_tables);
+    size_t total_indices = 0;
+
+    for (int t = 0; t < num_tables; t++) {
+        //Hot tables: wide rows and long, uneven bags
+        bool hot = t < num_hot;
+        int rows = hot ? 100000 : 1000;
+        int width = hot ? 128 : (t % 2 ? 64 : 16);
+        int max_pool = hot ? 120 : 2;
+        widths[t] = width;
+        include_last_offset[t] = t % 3 == 1;
+        if (t % 4 == 2) {
+            alg[t] = algorithm::embedding_bag_mean;
+        }
+
+        std::uniform_int_distribution<> dis_pool(1, max_pool);
+        std::uniform_int_distribution<> dis_row(0, rows - 1);
+        std::uniform_real_distribution<float> dis_table(-1.0f, 1.0f);
+
+        std::vector<int32_t> offsets(batch_size + include_last_offset[t]);
+        std::vector<int32_t> indices;
+        for (int b = 0; b < batch_size; b++) {
+            offsets[b] = indices.size();
+            int pool = dis_pool(gen);
+            for (int p = 0; p < pool; p++) {
+                indices.push_back(dis_row(gen));
+            }
+        }
+        if (include_last_offset[t]) {
+            offsets[batch_size] = indices.size();
+        }
+        total_indices += indices.size();
+        std::vector<float> table(rows * width);
+        for (auto &w : table) {
+            w = dis_table(gen);
+        }
+
+        table_mem[t] = memory({{rows, width}, dt::f32, tag::ab}, eng);
+        indices_mem[t] = memory({{(memory::dim)indices.size()}, dt::s32, tag::a},
+                                eng);
+        offsets_mem[t] = memory({{(memory::dim)offsets.size()}, dt::s32, tag::a},
+                                eng);
+        dst_mem[t] = memory({{batch_size, width}, dt::f32, tag::ab}, eng);
+        grp_dst_mem[t] = memory({{batch_size, width}, dt::f32, tag::ab}, eng);
+        write_to_zendnn_memory(table.data(), table_mem[t]);
+        write_to_zendnn_memory(indices.data(), indices_mem[t]);
+        write_to_zendnn_memory(offsets.data(), offsets_mem[t]);
+    }
+
+    //Reference: one embedding_bag per table
+    for (int t = 0; t < num_tables; t++) {
+        auto pdesc = embedding_bag::desc(prop_kind::forward_inference, alg[t], 1,
+                                         table_mem[t].get_desc(), indices_mem[t].get_desc(),
+                                         offsets_mem[t].get_desc(), dst_mem[t].get_desc(),
+                                         padding_idx[t]);
+        auto pd = embedding_bag::primitive_desc(pdesc, eng);
+        embedding_bag(pd).execute(s, {{ZENDNN_ARG_SRC_0, table_mem[t]},
+            {ZENDNN_ARG_SRC_1, indices_mem[t]},
+            {ZENDNN_ARG_SRC_2, offsets_mem[t]},
+            {ZENDNN_ARG_DST, dst_mem[t]}
+        });
+    }
+    s.wait();
+
+    zendnn_custom_op::zendnn_grp_embedding_bag(table_mem, indices_mem,
+            offsets_mem, scale_grad_by_freq, alg, sparse, psw_mem, psw_defined,
+            include_last_offset, padding_idx, grp_dst_mem);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        zendnn_custom_op::zendnn_grp_embedding_bag(table_mem, indices_mem,
+                offsets_mem, scale_grad_by_freq, alg, sparse, psw_mem, psw_defined,
+                include_last_offset, padding_idx, grp_dst_mem);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - begin).count() /
+                iters;
+
+    float max_diff = 0.0f;
+    for (int t = 0; t < num_tables; t++) {
+        std::vector<float> ref(batch_size * widths[t]), out(batch_size * widths[t]);
+        read_from_zendnn_memory(ref.data(), dst_mem[t]);
+        read_from_zendnn_memory(out.data(), grp_dst_mem[t]);
+        for (size_t i = 0; i < ref.size(); i++) {
+            max_diff = std::max(max_diff, std::fabs(ref[i] - out[i]));
+        }
+    }
+
+    std::cout<<"num_tables,num_hot,batch_size,indices,ms_per_call,max_abs_diff"
+             <<std::endl;
+    std::cout<<num_tables<<","<<num_hot<<","<<batch_size<<","<<total_indices<<","
+             <<ms<<","<<max_diff<<std::endl;
+
+    int status = max_diff > 1e-4f ? 1 : 0;
+    std::cout<<(status ? "Grp embedding bag sched mismatch" :
+                "Grp embedding bag sched passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "grp_embedding_bag_sched test ends");
+    return status;
+}
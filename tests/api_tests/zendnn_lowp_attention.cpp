@@ -0,0 +1,272 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//bf16 and u8s8 attention. Inputs and weights are rounded (bf16) or
+//quantized (u8 inputs, s8 weights with per output channel scales) and the
+//result is checked against f32 attention run on the same rounded or
+//dequantized values. The bf16 runs write a bf16 dst. Reports the time per
+//call of the low precision and the f32 runs.
+//
+//Usage: zendnn_attention_lowp [S] [N] [Nkv] [H] [B] [iters]
+//  S     : sequence length (default 200)
+//  N     : number of query heads (default 8)
+//  Nkv   : K/V heads of the groupedquery_attention runs (default 2)
+//  H     : head size (default 64)
+//  B     : batch size (default 2)
+//  iters : timed calls per run (default 5)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Inputs of one attention run
+struct attention_args_t {
+    memory src, weights, kv_weights, bias, kv_bias, mask, dst;
+};
+
+//Runs algo, returns the average time per call in ms
+double run_attention(engine &eng, stream &engine_stream, algorithm algo,
+                     const primitive_attr &attn_attr, attention_args_t &a, memory::dim N,
+                     float scale, int iters) {
+    auto attn_desc = attention::desc(prop_kind::forward_inference, algo,
+                                     a.src.get_desc(), a.src.get_desc(), a.src.get_desc(),
+                                     a.weights.get_desc(), a.kv_weights.get_desc(),
+                                     a.kv_weights.get_desc(), a.bias.get_desc(), a.kv_bias.get_desc(),
+                                     a.kv_bias.get_desc(), a.mask.get_desc(), a.dst.get_desc(), scale,
+                                     N, 1);
+    auto attn_pd = attention::primitive_desc(attn_desc, attn_attr, eng);
+    auto attn_prim = attention(attn_pd);
+    std::cout<<"# "<<attn_pd.impl_info_str()<<std::endl;
+
+    std::unordered_map<int, memory> attn_args = {{ZENDNN_ARG_SRC_0, a.src},
+        {ZENDNN_ARG_SRC_1, a.src}, {ZENDNN_ARG_SRC_2, a.src},
+        {ZENDNN_ARG_WEIGHTS_0, a.weights}, {ZENDNN_ARG_WEIGHTS_1, a.kv_weights},
+        {ZENDNN_ARG_WEIGHTS_2, a.kv_weights}, {ZENDNN_ARG_BIAS_0, a.bias},
+        {ZENDNN_ARG_BIAS_1, a.kv_bias}, {ZENDNN_ARG_BIAS_2, a.kv_bias},
+        {ZENDNN_ARG_MASK, a.mask}, {ZENDNN_ARG_DST, a.dst}
+    };
+    attn_prim.execute(engine_stream, attn_args);
+    engine_stream.wait();
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        attn_prim.execute(engine_stream, attn_args);
+    }
+    engine_stream.wait();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
+}
+
+//Converts src to a new memory of data type to_dt
+memory convert(engine &eng, stream &engine_stream, memory &src, dt to_dt) {
+    auto md = src.get_desc();
+    memory::desc to_md(md.dims(), to_dt, md.dims().size() == 1 ? tag::a :
+                       md.dims().size() == 2 ? tag::ab : tag::abc);
+    memory to(to_md, eng);
+    reorder(src, to).execute(engine_stream, src, to);
+    engine_stream.wait();
+    return to;
+}
+
+//Quantizes (K, W) weights to s8 with one scale per output channel, stores
+//the dequantized values back to w
+std::vector<int8_t> quantize_weights(std::vector<float> &w, memory::dim K,
+                                     memory::dim W, std::vector<float> &scales) {
+    std::vector<int8_t> q(w.size());
+    scales.assign(W, 0.0f);
+    for (memory::dim k = 0; k < K; k++) {
+        for (memory::dim n = 0; n < W; n++) {
+            scales[n] = std::max(scales[n], std::fabs(w[k * W + n]) / 127.0f);
+        }
+    }
+    for (memory::dim k = 0; k < K; k++) {
+        for (memory::dim n = 0; n < W; n++) {
+            q[k * W + n] = (int8_t)std::lround(w[k * W + n] / scales[n]);
+            w[k * W + n] = q[k * W + n] * scales[n];
+        }
+    }
+    return q;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_attention_lowp test starts");
+
+    memory::dim S = 200, N = 8, Nkv = 2, H = 64, B = 2;
+    int iters = 5;
+    if (argc > 1) {
+        S = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        N = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        Nkv = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        H = std::stoi(std::string(argv[4]));
+    }
+    if (argc > 5) {
+        B = std::stoi(std::string(argv[5]));
+    }
+    if (argc > 6) {
+        iters = std::stoi(std::string(argv[6]));
+    }
+    if (Nkv <= 0 || N % Nkv != 0) {
+        std::cout<<"N must be a multiple of Nkv"<<std::endl;
+        return 1;
+    }
+
+    engine eng(engine::kind::cpu, 0);
+    stream engine_stream(eng);
+
+    const memory::dim E = N * H;
+    const float scale = 1 / std::sqrt((float)H);
+    std::cout<<"B="<<B<<" S="<<S<<" N="<<N<<" Nkv="<<Nkv<<" H="<<H<<std::endl;
+    std::cout<<"dt,algo,ms_per_call,f32_ms_per_call,max_abs_diff"<<std::endl;
+
+    int status = 0;
+    const algorithm algos[] = {algorithm::multihead_attention,
+                               algorithm::groupedquery_attention
+                              };
+    const char *algo_names[] = {"multihead_attention", "groupedquery_attention"};
+    for (int a = 0; a < 2; a++) {
+        const memory::dim kv_heads = a == 0 ? N : Nkv;
+        const memory::dim E_kv = kv_heads * H;
+        //u8 inputs, so the source data is kept in [0, 1]
+        std::vector<float> src_data(B * S * E), weights_data(E * E),
+            kv_weights_data(E * E_kv), bias_data(E), kv_bias_data(E_kv),
+            mask_data(B * S), dst_data(B * S * E), ref_data(B * S * E);
+        for (size_t i = 0; i < src_data.size(); i++) {
+            src_data[i] = (std::cos(i / 10.f) + 1.0f) / 2.0f;
+        }
+        for (size_t i = 0; i < weights_data.size(); i++) {
+            weights_data[i] = std::sin(i * 2.f) / std::sqrt((float)E);
+        }
+        for (size_t i = 0; i < kv_weights_data.size(); i++) {
+            kv_weights_data[i] = std::cos(i * 3.f) / std::sqrt((float)E);
+        }
+        for (size_t i = 0; i < bias_data.size(); i++) {
+            bias_data[i] = std::tanh(i);
+        }
+        for (size_t i = 0; i < kv_bias_data.size(); i++) {
+            kv_bias_data[i] = std::sin(i);
+        }
+        for (memory::dim b = 0; b < B; b++) {
+            for (memory::dim s = 0; s < S; s++) {
+                mask_data[b * S + s] = (s < S - b * (S / 4)) ? 1.0f : 0.0f;
+            }
+        }
+
+        auto src_md = memory::desc({B, S, E}, dt::f32, tag::abc);
+        auto weights_md = memory::desc({E, E}, dt::f32, tag::ab);
+        auto kv_weights_md = memory::desc({E, E_kv}, dt::f32, tag::ab);
+        auto bias_md = memory::desc({E}, dt::f32, tag::a);
+        auto kv_bias_md = memory::desc({E_kv}, dt::f32, tag::a);
+        auto mask_md = memory::desc({B, S}, dt::f32, tag::ab);
+        attention_args_t f32_args = {memory(src_md, eng, src_data.data()),
+                                     memory(weights_md, eng, weights_data.data()),
+                                     memory(kv_weights_md, eng, kv_weights_data.data()),
+                                     memory(bias_md, eng, bias_data.data()),
+                                     memory(kv_bias_md, eng, kv_bias_data.data()),
+                                     memory(mask_md, eng, mask_data.data()),
+                                     memory(src_md, eng, ref_data.data())
+                                    };
+        primitive_attr f32_attr;
+
+        //bf16: f32 reference on the bf16 rounded inputs and weights
+        attention_args_t bf16_args = {convert(eng, engine_stream, f32_args.src, dt::bf16),
+                                      convert(eng, engine_stream, f32_args.weights, dt::bf16),
+                                      convert(eng, engine_stream, f32_args.kv_weights, dt::bf16),
+                                      f32_args.bias, f32_args.kv_bias, f32_args.mask,
+                                      memory({{B, S, E}, dt::bf16, tag::abc}, eng)
+                                     };
+        attention_args_t rounded_args = f32_args;
+        rounded_args.src = convert(eng, engine_stream, bf16_args.src, dt::f32);
+        rounded_args.weights = convert(eng, engine_stream, bf16_args.weights, dt::f32);
+        rounded_args.kv_weights = convert(eng, engine_stream, bf16_args.kv_weights,
+                                          dt::f32);
+        double ref_ms = run_attention(eng, engine_stream, algos[a], f32_attr,
+                                      rounded_args, N, scale, iters);
+        double ms = run_attention(eng, engine_stream, algos[a], f32_attr, bf16_args,
+                                  N, scale, iters);
+        memory bf16_dst = convert(eng, engine_stream, bf16_args.dst, dt::f32);
+        const float *bf16_dst_data = (const float *)bf16_dst.get_data_handle();
+        float max_diff = 0.0f;
+        for (size_t i = 0; i < ref_data.size(); i++) {
+            max_diff = std::max(max_diff, std::fabs(ref_data[i] - bf16_dst_data[i]));
+        }
+        std::cout<<"bf16,"<<algo_names[a]<<","<<ms<<","<<ref_ms<<","<<max_diff
+                 <<std::endl;
+        if (max_diff > 5e-2f) {
+            status = 1;
+        }
+
+        //u8s8: f32 reference on the dequantized inputs and weights
+        const float src_scale = 1.0f / 255.0f;
+        std::vector<uint8_t> src_u8(src_data.size());
+        for (size_t i = 0; i < src_data.size(); i++) {
+            src_u8[i] = (uint8_t)std::lround(src_data[i] / src_scale);
+            src_data[i] = src_u8[i] * src_scale;
+        }
+        std::vector<float> weights_scales, kv_weights_scales;
+        std::vector<int8_t> weights_s8 = quantize_weights(weights_data, E, E,
+                                         weights_scales);
+        std::vector<int8_t> kv_weights_s8 = quantize_weights(kv_weights_data, E,
+                                            E_kv, kv_weights_scales);
+        attention_args_t u8_args = {memory({{B, S, E}, dt::u8, tag::abc}, eng, src_u8.data()),
+                                    memory({{E, E}, dt::s8, tag::ab}, eng, weights_s8.data()),
+                                    memory({{E, E_kv}, dt::s8, tag::ab}, eng, kv_weights_s8.data()),
+                                    f32_args.bias, f32_args.kv_bias, f32_args.mask,
+                                    memory(src_md, eng, dst_data.data())
+                                   };
+        primitive_attr u8_attr;
+        u8_attr.set_scales(ZENDNN_ARG_SRC_0, 0, {src_scale});
+        u8_attr.set_scales(ZENDNN_ARG_SRC_1, 0, {src_scale});
+        u8_attr.set_scales(ZENDNN_ARG_SRC_2, 0, {src_scale});
+        u8_attr.set_scales(ZENDNN_ARG_WEIGHTS_0, 1 << 1, weights_scales);
+        u8_attr.set_scales(ZENDNN_ARG_WEIGHTS_1, 1 << 1, kv_weights_scales);
+        u8_attr.set_scales(ZENDNN_ARG_WEIGHTS_2, 1 << 1, kv_weights_scales);
+        ref_ms = run_attention(eng, engine_stream, algos[a], f32_attr, f32_args, N,
+                               scale, iters);
+        ms = run_attention(eng, engine_stream, algos[a], u8_attr, u8_args, N, scale,
+                           iters);
+        max_diff = 0.0f;
+        for (size_t i = 0; i < ref_data.size(); i++) {
+            max_diff = std::max(max_diff, std::fabs(ref_data[i] - dst_data[i]));
+        }
+        std::cout<<"u8s8,"<<algo_names[a]<<","<<ms<<","<<ref_ms<<","<<max_diff
+                 <<std::endl;
+        if (max_diff > 1e-3f) {
+            status = 1;
+        }
+    }
+
+    std::cout<<(status ? "Low precision attention mismatch" :
+                "Low precision attention passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_attention_lowp test ends");
+    return status;
+}
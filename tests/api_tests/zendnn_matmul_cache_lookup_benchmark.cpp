@@ -0,0 +1,186 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Multi threaded stress benchmark for the MatMul lookup path.
+//Every caller thread owns a primitive and stream and runs a tiny MatMul
+//with constant weights, so after warm up each call is dominated by the
+//auto tuner map lookup (FP32:0) or the reordered weight cache lookup
+//(FP32:3). Per call latency is reported for 1 to max_threads concurrent
+//callers; with a lock-free read path it should stay flat as callers grow.
+//Odd callers use a second weight tensor that differs in one element, every
+//caller checks its result so that tensors sharing a cache entry fail the run.
+//
+//Usage: zendnn_matmul_cache_lookup_benchmark [algo] [max_threads] [iters]
+//  algo        : ZENDNN_MATMUL_ALGO FP32 value, 0 (auto tuner) or 3 (blocked)
+//  max_threads : number of concurrent callers to scale up to (default 64)
+//  iters       : MatMul calls per thread (default 2000)
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "zendnn.hpp"
+#include "zendnn_helper.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//Small problem so that the GEMM itself does not hide the lookup cost
+const memory::dim M = 1, K = 64, N = 64;
+const int warmup_runs = 50;
+
+//Weights are shared by the callers like the weights of a served model, the
+//second tensor differs from the first in one element
+std::vector<float> weights_data[2] = {std::vector<float>(K *N),
+                                      std::vector<float>(K *N)
+                                     };
+
+//Runs iters MatMul calls with weight tensor t and returns the average time
+//per call in us, 0 when the result does not match that tensor
+double run_caller(engine &eng, int iters, std::atomic<int> &ready,
+                  int num_callers, int t) {
+    stream engine_stream(eng);
+    std::vector<float> src_data(M * K);
+    std::vector<float> dst_data(M * N);
+    for (size_t i = 0; i < src_data.size(); i++) {
+        src_data[i] = std::cos(i / 10.f);
+    }
+
+    auto src_md = memory::desc({M, K}, dt::f32, tag::ab);
+    auto weights_md = memory::desc({K, N}, dt::f32, tag::ab, true);
+    auto dst_md = memory::desc({M, N}, dt::f32, tag::ab);
+    auto src_mem = memory(src_md, eng, src_data.data());
+    auto weights_mem = memory(weights_md, eng, weights_data[t].data());
+    auto dst_mem = memory(dst_md, eng, dst_data.data());
+
+    auto matmul_d = matmul::desc(src_md, weights_md, dst_md);
+    auto matmul_pd = matmul::primitive_desc(matmul_d, eng);
+    auto matmul_prim = matmul(matmul_pd);
+    std::unordered_map<int, memory> matmul_args;
+    matmul_args.insert({ZENDNN_ARG_SRC, src_mem});
+    matmul_args.insert({ZENDNN_ARG_WEIGHTS, weights_mem});
+    matmul_args.insert({ZENDNN_ARG_DST, dst_mem});
+
+    //Start all callers together
+    ready.fetch_add(1);
+    while (ready.load() < num_callers) {
+        std::this_thread::yield();
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        matmul_prim.execute(engine_stream, matmul_args);
+    }
+    engine_stream.wait();
+    auto end = std::chrono::steady_clock::now();
+
+    for (memory::dim n = 0; n < N; n++) {
+        float ref = 0.f;
+        for (memory::dim k = 0; k < K; k++) {
+            ref += src_data[k] * weights_data[t][k * N + n];
+        }
+        if (std::fabs(ref - dst_data[n]) > 1e-4f * (1.f + std::fabs(ref))) {
+            return 0.0;
+        }
+    }
+    return std::chrono::duration<double, std::micro>(end - begin).count() / iters;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG,
+               "zendnn_matmul_cache_lookup_benchmark test starts");
+
+    std::string algo = "FP32:0";
+    int max_threads = 64;
+    int iters = 2000;
+    if (argc > 1) {
+        algo = "FP32:" + std::string(argv[1]);
+    }
+    if (argc > 2) {
+        max_threads = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        iters = std::stoi(std::string(argv[3]));
+    }
+
+    //Environment is read once by the library, set it before the first call
+#ifdef _WIN32
+    _putenv_s("ZENDNN_MATMUL_ALGO", algo.c_str());
+    _putenv_s("ZENDNN_GEMM_AUTO_TYPE", "3");
+    _putenv_s("OMP_NUM_THREADS", "1");
+#else
+    setenv("ZENDNN_MATMUL_ALGO", algo.c_str(), 1);
+    setenv("ZENDNN_GEMM_AUTO_TYPE", "3", 1);
+    setenv("OMP_NUM_THREADS", "1", 1);
+#endif
+
+    for (size_t i = 0; i < weights_data[0].size(); i++) {
+        weights_data[0][i] = std::sin(i * 2.f);
+    }
+    weights_data[1] = weights_data[0];
+    weights_data[1][K / 2 * N + 1] += 1.f;
+
+    engine eng(engine::kind::cpu, 0);
+
+    //Warm up: fills the auto tuner map and the weight cache
+    {
+        std::atomic<int> ready(0);
+        run_caller(eng, warmup_runs, ready, 1, 0);
+    }
+
+    std::cout<<"ZENDNN_MATMUL_ALGO="<<algo<<" M="<<M<<" K="<<K<<" N="<<N
+             <<" iterations per caller="<<iters<<std::endl;
+    std::cout<<"callers,avg_us_per_call,max_us_per_call"<<std::endl;
+    int status = 0;
+    for (int num_callers = 1; num_callers <= max_threads; num_callers *= 2) {
+        std::vector<std::thread> callers;
+        std::vector<double> time_per_call(num_callers);
+        std::atomic<int> ready(0);
+        for (int t = 0; t < num_callers; t++) {
+            callers.emplace_back([&, t]() {
+                time_per_call[t] = run_caller(eng, iters, ready, num_callers, t % 2);
+            });
+        }
+        for (auto &caller : callers) {
+            caller.join();
+        }
+        double avg_time = 0, max_time = 0;
+        for (double t : time_per_call) {
+            if (t == 0.0) {
+                status = 1;
+            }
+            avg_time += t;
+            max_time = t > max_time ? t : max_time;
+        }
+        avg_time /= num_callers;
+        std::cout<<num_callers<<","<<avg_time<<","<<max_time<<std::endl;
+    }
+
+    zendnnWeightCacheStats stats = zendnnGetWeightCacheStats();
+    std::cout<<"Weight cache hits: "<<stats.hits<<" misses: "<<stats.misses
+             <<" entries: "<<stats.entries<<std::endl;
+    std::cout<<(status ? "Cache lookup benchmark result mismatch" :
+                "Cache lookup benchmark passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_cache_lookup_benchmark test ends");
+    return status;
+}
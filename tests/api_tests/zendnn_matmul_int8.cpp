@@ -0,0 +1,229 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//INT8 MatMul with u8/s8 source and s8 weights, f32 bias, per tensor and
+//per channel output scales, source and dst zero points and ReLU, requantized
+//to s8, u8, s32, f32 and bf16, against a reference. The weights are marked
+//constant and every primitive is run twice, the second run must find the
+//reordered weights in the cache. Built with LPGEMM the zendnn_int8
+//implementation must be the one selected.
+//
+//Usage: zendnn_matmul_int8 [M] [K] [N] [batch]
+//  M, K, N : matrix sizes (default 128, 512, 256)
+//  batch   : batch of the 3D cases (default 2)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "zendnn_helper.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+float bf16_to_float(uint16_t x) {
+    uint32_t bits = (uint32_t)x << 16;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+//Rounds and saturates as the library does for integer dst types
+float saturate(float x, dt type) {
+    float lo = type == dt::s8 ? -128.f : type == dt::u8 ? 0.f : -2147483520.f;
+    float hi = type == dt::s8 ? 127.f : type == dt::u8 ? 255.f : 2147483520.f;
+    return std::nearbyint(std::min(hi, std::max(lo, x)));
+}
+
+float load(const std::vector<char> &buf, dt type, size_t i) {
+    switch (type) {
+    case dt::s8:
+        return ((const int8_t *)buf.data())[i];
+    case dt::u8:
+        return ((const uint8_t *)buf.data())[i];
+    case dt::s32:
+        return (float)((const int32_t *)buf.data())[i];
+    case dt::bf16:
+        return bf16_to_float(((const uint16_t *)buf.data())[i]);
+    default:
+        return ((const float *)buf.data())[i];
+    }
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_int8 test starts");
+    memory::dim M = argc > 1 ? std::stoi(std::string(argv[1])) : 128;
+    memory::dim K = argc > 2 ? std::stoi(std::string(argv[2])) : 512;
+    memory::dim N = argc > 3 ? std::stoi(std::string(argv[3])) : 256;
+    memory::dim batch = argc > 4 ? std::stoi(std::string(argv[4])) : 2;
+
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> dis_s8(-64, 63);
+    std::uniform_int_distribution<int> dis_u8(0, 127);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+
+    const dt dst_types[] = {dt::s8, dt::u8, dt::s32, dt::f32, dt::bf16};
+    std::cout<<"impl,src,dst,batch,M,K,N,per_channel,src_zp,relu,run,max_diff,ms"
+             <<std::endl;
+    int status = 0;
+    for (int batched = 0; batched < 2; batched++)
+        for (dt src_type : {
+                    dt::u8, dt::s8
+                })
+            for (dt dst_type : dst_types) {
+                const memory::dim B = batched ? batch : 1;
+                const bool per_channel = dst_type != dt::s32;
+                const bool relu = dst_type != dt::f32;
+                const int32_t src_zp = src_type == dt::u8 ? 3 : 0;
+                //Zero points apply to the integer dst types only
+                const int32_t dst_zp = dst_type == dt::u8 ? 10 : dst_type == dt::s8 ? -5 : 0;
+                auto dims_of = [&](memory::dim rows, memory::dim cols) {
+                    return batched ? memory::dims {B, rows, cols} : memory::dims {rows, cols};
+                };
+                const tag plain = batched ? tag::abc : tag::ab;
+
+                std::vector<int32_t> src(B * M * K), wei(K * N);
+                std::vector<float> bias(N), scales(per_channel ? N : 1);
+                for (auto &x : src) {
+                    x = src_type == dt::u8 ? dis_u8(gen) : dis_s8(gen);
+                }
+                for (auto &x : wei) {
+                    x = dis_s8(gen);
+                }
+                for (auto &x : bias) {
+                    x = 100.f * dis(gen);
+                }
+                for (auto &x : scales) {
+                    x = (dst_type == dt::f32 || dst_type == dt::bf16 ? 0.5f : 0.002f) *
+                        (1.5f + dis(gen));
+                }
+                std::vector<int8_t> src_s8(src.begin(), src.end()), wei_s8(wei.begin(),
+                        wei.end());
+                std::vector<uint8_t> src_u8(src.begin(), src.end());
+
+                primitive_attr attr;
+                attr.set_output_scales(per_channel ? 1 << (batched ? 2 : 1) : 0, scales);
+                if (src_zp) {
+                    attr.set_zero_points(ZENDNN_ARG_SRC, 0, {src_zp});
+                }
+                if (dst_zp) {
+                    attr.set_zero_points(ZENDNN_ARG_DST, 0, {dst_zp});
+                }
+                if (relu) {
+                    post_ops po;
+                    po.append_eltwise(1.f, algorithm::eltwise_relu, 0.f, 0.f);
+                    attr.set_post_ops(po);
+                }
+
+                //Weights are shared over the batch and constant
+                memory::dims wei_dims = batched ? memory::dims {1, K, N} : memory::dims {K, N};
+                memory::dims bias_dims = batched ? memory::dims {1, 1, N} : memory::dims {1, N};
+                auto src_mem = memory({dims_of(M, K), src_type, plain}, eng,
+                                      src_type == dt::u8 ? (void *)src_u8.data() : (void *)src_s8.data());
+                auto wei_mem = memory({wei_dims, dt::s8, plain, true}, eng, wei_s8.data());
+                auto bias_mem = memory({bias_dims, dt::f32, plain}, eng, bias.data());
+                auto dst_mem = memory({dims_of(M, N), dst_type, plain}, eng);
+
+                auto matmul_d = matmul::desc(src_mem.get_desc(), wei_mem.get_desc(),
+                                             bias_mem.get_desc(), dst_mem.get_desc());
+                auto matmul_pd = matmul::primitive_desc(matmul_d, attr, eng);
+                auto mm = matmul(matmul_pd);
+#ifdef ZENDNN_ENABLE_LPGEMM
+                if (std::string(matmul_pd.impl_info_str()) != "zendnn_int8") {
+                    std::cout<<"zendnn_int8 not selected: "<<matmul_pd.impl_info_str()
+                             <<std::endl;
+                    status = 1;
+                }
+#endif
+
+                //Reference in double, before the dst rounding
+                std::vector<float> ref(B * M * N);
+                for (memory::dim b = 0; b < B; b++)
+                    for (memory::dim m = 0; m < M; m++)
+                        for (memory::dim n = 0; n < N; n++) {
+                            int64_t acc = 0;
+                            for (memory::dim k = 0; k < K; k++) {
+                                acc += (int64_t)(src[(b * M + m) * K + k] - src_zp) * wei[k * N + n];
+                            }
+                            float res = ((float)acc + bias[n]) * scales[per_channel ? n : 0];
+                            if (relu) {
+                                res = std::max(res, 0.f);
+                            }
+                            res += dst_zp;
+                            ref[(b * M + m) * N + n] = dst_type == dt::f32 ||
+                                                       dst_type == dt::bf16 ? res : saturate(res, dst_type);
+                        }
+
+                std::vector<char> out(dst_mem.get_desc().get_size());
+                for (int run = 0; run < 2; run++) {
+#ifdef ZENDNN_ENABLE_LPGEMM
+                    zendnnWeightCacheStats before = zendnnGetWeightCacheStats();
+#endif
+                    auto begin = std::chrono::steady_clock::now();
+                    mm.execute(s, {{ZENDNN_ARG_SRC, src_mem}, {ZENDNN_ARG_WEIGHTS, wei_mem},
+                        {ZENDNN_ARG_BIAS, bias_mem}, {ZENDNN_ARG_DST, dst_mem}
+                    });
+                    s.wait();
+                    auto end = std::chrono::steady_clock::now();
+                    double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+                    read_from_zendnn_memory(out.data(), dst_mem);
+                    float diff = 0.0f;
+                    bool ok = true;
+                    for (size_t i = 0; i < ref.size(); i++) {
+                        float got = load(out, dst_type, i);
+                        float d = std::fabs(got - ref[i]);
+                        diff = std::max(diff, d);
+                        //One step of rounding for integers, bf16 keeps 8 bits
+                        float tol = dst_type == dt::bf16 ? 1e-2f * std::fabs(ref[i]) + 1e-2f :
+                                    dst_type == dt::f32 ? 1e-5f * std::fabs(ref[i]) + 1e-3f : 1.f;
+                        ok = ok && d <= tol;
+                    }
+                    std::cout<<matmul_pd.impl_info_str()<<","<<(src_type == dt::u8 ? "u8" : "s8")
+                             <<","<<(int)dst_type<<","<<B<<","<<M<<","<<K<<","<<N<<","
+                             <<per_channel<<","<<src_zp<<","<<relu<<","<<run<<","<<diff<<","<<ms
+                             <<std::endl;
+                    if (!ok) {
+                        status = 1;
+                    }
+#ifdef ZENDNN_ENABLE_LPGEMM
+                    //The second run reorders nothing
+                    zendnnWeightCacheStats after = zendnnGetWeightCacheStats();
+                    if (run == 1 && after.evictions == before.evictions &&
+                            (after.hits == before.hits || after.misses != before.misses)) {
+                        std::cout<<"reordered weights not reused"<<std::endl;
+                        status = 1;
+                    }
+#endif
+                }
+            }
+
+    std::cout<<(status ? "INT8 MatMul mismatch" : "INT8 MatMul passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_int8 test ends");
+    return status;
+}
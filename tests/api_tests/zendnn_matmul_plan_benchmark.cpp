@@ -0,0 +1,135 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Per call overhead of small-M MatMul, as seen in transformer decode steps.
+//For M = 1..32 it reports the steady state time per MatMul call (bias and
+//GeLU post-ops, constant weights). Run once with the default plan cache and
+//once with ZENDNN_MATMUL_PLAN_CACHE_CAPACITY=0 to see the setup cost saved
+//per call by the cached execution plans.
+//
+//Usage: zendnn_matmul_plan_benchmark [algo] [K] [N] [iters]
+//  algo  : ZENDNN_MATMUL_ALGO FP32 value, 3 (blocked JIT) or 5 (AOCL blocked)
+//  K, N  : weight dims (default 64 x 64, small so that setup cost dominates)
+//  iters : MatMul calls per M (default 2000)
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+const int warmup_runs = 20;
+
+//Returns the average time per call in us
+double run_matmul(engine &eng, stream &engine_stream, memory::dim M,
+                  memory::dim K, memory::dim N, int iters) {
+    std::vector<float> src_data(M * K), weights_data(K * N), bias_data(N),
+        dst_data(M * N);
+    for (size_t i = 0; i < src_data.size(); i++) {
+        src_data[i] = std::cos(i / 10.f);
+    }
+    for (size_t i = 0; i < weights_data.size(); i++) {
+        weights_data[i] = std::sin(i * 2.f);
+    }
+    for (size_t i = 0; i < bias_data.size(); i++) {
+        bias_data[i] = std::tanh(i);
+    }
+
+    auto src_md = memory::desc({M, K}, dt::f32, tag::ab);
+    auto weights_md = memory::desc({K, N}, dt::f32, tag::ab, true);
+    auto bias_md = memory::desc({1, N}, dt::f32, tag::ab);
+    auto dst_md = memory::desc({M, N}, dt::f32, tag::ab);
+    auto src_mem = memory(src_md, eng, src_data.data());
+    auto weights_mem = memory(weights_md, eng, weights_data.data());
+    auto bias_mem = memory(bias_md, eng, bias_data.data());
+    auto dst_mem = memory(dst_md, eng, dst_data.data());
+
+    post_ops matmul_ops;
+    matmul_ops.append_eltwise(1.f, algorithm::eltwise_gelu, 0.f, 0.f);
+    primitive_attr matmul_attr;
+    matmul_attr.set_post_ops(matmul_ops);
+    auto matmul_d = matmul::desc(src_md, weights_md, bias_md, dst_md);
+    auto matmul_pd = matmul::primitive_desc(matmul_d, matmul_attr, eng);
+    auto matmul_prim = matmul(matmul_pd);
+    std::unordered_map<int, memory> matmul_args;
+    matmul_args.insert({ZENDNN_ARG_SRC, src_mem});
+    matmul_args.insert({ZENDNN_ARG_WEIGHTS, weights_mem});
+    matmul_args.insert({ZENDNN_ARG_BIAS, bias_mem});
+    matmul_args.insert({ZENDNN_ARG_DST, dst_mem});
+
+    for (int i = 0; i < warmup_runs; i++) {
+        matmul_prim.execute(engine_stream, matmul_args);
+    }
+    engine_stream.wait();
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        matmul_prim.execute(engine_stream, matmul_args);
+    }
+    engine_stream.wait();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - begin).count() / iters;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_plan_benchmark test starts");
+
+    std::string algo = "FP32:3";
+    memory::dim K = 64, N = 64;
+    int iters = 2000;
+    if (argc > 1) {
+        algo = "FP32:" + std::string(argv[1]);
+    }
+    if (argc > 2) {
+        K = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        N = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        iters = std::stoi(std::string(argv[4]));
+    }
+
+#ifdef _WIN32
+    _putenv_s("ZENDNN_MATMUL_ALGO", algo.c_str());
+#else
+    setenv("ZENDNN_MATMUL_ALGO", algo.c_str(), 1);
+#endif
+    const char *plan_capacity = getenv("ZENDNN_MATMUL_PLAN_CACHE_CAPACITY");
+
+    engine eng(engine::kind::cpu, 0);
+    stream engine_stream(eng);
+
+    std::cout<<"ZENDNN_MATMUL_ALGO="<<algo<<" K="<<K<<" N="<<N
+             <<" ZENDNN_MATMUL_PLAN_CACHE_CAPACITY="
+             <<(plan_capacity ? plan_capacity : "default")<<std::endl;
+    std::cout<<"M,us_per_call"<<std::endl;
+    for (memory::dim M = 1; M <= 32; M *= 2) {
+        std::cout<<M<<","<<run_matmul(eng, engine_stream, M, K, N, iters)
+                 <<std::endl;
+    }
+
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_plan_benchmark test ends");
+    return 0;
+}
@@ -0,0 +1,222 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//f32 MatMul with post-op chains of a transformer block (bias, GeLU, scale,
+//residual add, per-channel binary mul, sum in the middle of the chain),
+//against a reference. 2D and batched shapes are run, with binary src1
+//broadcast per tensor, per channel and not at all. A second shape of many
+//rows and small weights is run as well, it is multiplied in row tiles
+//where the first one is a single GEMM per matrix.
+//
+//Usage: zendnn_matmul_post_ops_chain [M] [K] [N] [batch]
+//  M, K, N : matrix sizes of the first shape (default 384, 768, 1024)
+//  batch   : batch of the 3D cases (default 2)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+//One post-op of a chain, kind 0 sum, 1 eltwise, 2 binary
+struct post_op {
+    int kind;
+    algorithm alg;
+    float alpha, beta;
+    //Binary src1 broadcast: 0 per tensor, 1 per channel, 2 none
+    int bcast;
+};
+
+float eltwise_ref(algorithm alg, float x, float alpha, float beta) {
+    switch (alg) {
+    case algorithm::eltwise_relu:
+        return x > 0.f ? x : alpha * x;
+    case algorithm::eltwise_gelu_tanh:
+        return 0.5f * x * (1.f + std::tanh(0.79788456f * (x + 0.044715f * x * x * x)));
+    case algorithm::eltwise_gelu_erf:
+        return 0.5f * x * (1.f + std::erf(x * 0.70710678f));
+    case algorithm::eltwise_linear:
+        return alpha * x + beta;
+    default:
+        return x;
+    }
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_post_ops_chain test starts");
+    memory::dim arg_M = argc > 1 ? std::stoi(std::string(argv[1])) : 384;
+    memory::dim arg_K = argc > 2 ? std::stoi(std::string(argv[2])) : 768;
+    memory::dim arg_N = argc > 3 ? std::stoi(std::string(argv[3])) : 1024;
+    memory::dim batch = argc > 4 ? std::stoi(std::string(argv[4])) : 2;
+
+    engine eng(engine::kind::cpu, 0);
+    stream s(eng);
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+
+    const std::vector<std::vector<post_op>> chains = {
+        //FFN: bias, GeLU, residual add
+        {{1, algorithm::eltwise_gelu_erf, 0.f, 0.f, 0}, {2, algorithm::binary_add, 0.f, 0.f, 2}},
+        //Attention output: bias, scale, residual add
+        {{1, algorithm::eltwise_linear, 0.125f, 0.f, 0}, {2, algorithm::binary_add, 0.f, 0.f, 2}},
+        //Sum in the middle of the chain
+        {   {2, algorithm::binary_mul, 0.f, 0.f, 1}, {1, algorithm::eltwise_relu, 0.1f, 0.f, 0},
+            {0, algorithm::undef, 0.5f, 0.f, 0}, {1, algorithm::eltwise_gelu_tanh, 0.f, 0.f, 0}
+        },
+        //Several binary and eltwise ops
+        {   {2, algorithm::binary_add, 0.f, 0.f, 0}, {1, algorithm::eltwise_relu, 0.f, 0.f, 0},
+            {2, algorithm::binary_mul, 0.f, 0.f, 2}, {2, algorithm::binary_add, 0.f, 0.f, 1},
+            {1, algorithm::eltwise_linear, 2.f, -1.f, 0}
+        }
+    };
+
+    std::cout<<"chain,batch,M,K,N,post_ops,rel_diff,ms"<<std::endl;
+    int status = 0;
+    const memory::dims shapes[] = {{arg_M, arg_K, arg_N}, {4096, 64, 64}};
+    for (int shape = 0; shape < 2; shape++) {
+        for (int batched = 0; batched < 2; batched++) {
+            const memory::dim M = shapes[shape][0], K = shapes[shape][1],
+                              N = shapes[shape][2];
+            for (size_t c = 0; c < chains.size(); c++) {
+                const auto &chain = chains[c];
+                const memory::dim B = batched ? batch : 1;
+                auto dims_of = [&](memory::dim rows, memory::dim cols) {
+                    return batched ? memory::dims {B, rows, cols} : memory::dims {rows, cols};
+                };
+                //Dims of a row broadcast over the batch and the rows of dst
+                auto broadcast_dims = [&](memory::dim cols) {
+                    return batched ? memory::dims {1, 1, cols} : memory::dims {1, cols};
+                };
+                const tag plain = batched ? tag::abc : tag::ab;
+
+                std::vector<float> src(B * M * K), wei(B * K * N), bias(N), dst(B * M * N);
+                for (auto *v : {
+                            &src, &wei, &bias, &dst
+                        }) {
+                    for (auto &x : *v) {
+                        x = dis(gen);
+                    }
+                }
+                for (auto &x : wei) {
+                    x /= std::sqrt((float)K);
+                }
+
+                post_ops po;
+                std::vector<std::vector<float>> src1(chain.size());
+                std::vector<memory> src1_mem(chain.size());
+                for (size_t i = 0; i < chain.size(); i++) {
+                    const auto &p = chain[i];
+                    if (p.kind == 0) {
+                        po.append_sum(p.alpha);
+                    }
+                    else if (p.kind == 1) {
+                        po.append_eltwise(1.f, p.alg, p.alpha, p.beta);
+                    }
+                    else {
+                        memory::dims src1_dims = p.bcast == 2 ? dims_of(M, N) :
+                                                 broadcast_dims(p.bcast == 1 ? N : 1);
+                        memory::desc src1_md(src1_dims, dt::f32, plain);
+                        src1[i].resize(src1_md.get_size() / sizeof(float));
+                        for (auto &x : src1[i]) {
+                            x = dis(gen);
+                        }
+                        po.append_binary(p.alg, src1_md);
+                        src1_mem[i] = memory(src1_md, eng, src1[i].data());
+                    }
+                }
+                primitive_attr attr;
+                attr.set_post_ops(po);
+
+                auto src_mem = memory({dims_of(M, K), dt::f32, plain}, eng, src.data());
+                auto wei_mem = memory({dims_of(K, N), dt::f32, plain}, eng, wei.data());
+                auto bias_mem = memory({broadcast_dims(N), dt::f32, plain}, eng, bias.data());
+                auto dst_mem = memory({dims_of(M, N), dt::f32, plain}, eng);
+                write_to_zendnn_memory(dst.data(), dst_mem);
+
+                auto matmul_d = matmul::desc(src_mem.get_desc(), wei_mem.get_desc(),
+                                             bias_mem.get_desc(), dst_mem.get_desc());
+                auto matmul_pd = matmul::primitive_desc(matmul_d, attr, eng);
+                auto mm = matmul(matmul_pd);
+                std::unordered_map<int, memory> args = {{ZENDNN_ARG_SRC, src_mem},
+                    {ZENDNN_ARG_WEIGHTS, wei_mem}, {ZENDNN_ARG_BIAS, bias_mem},
+                    {ZENDNN_ARG_DST, dst_mem}
+                };
+                for (size_t i = 0; i < chain.size(); i++) {
+                    if (chain[i].kind == 2) {
+                        args.insert({ZENDNN_ARG_ATTR_MULTIPLE_POST_OP((int)i) | ZENDNN_ARG_SRC_1,
+                                     src1_mem[i]});
+                    }
+                }
+
+                auto begin = std::chrono::steady_clock::now();
+                mm.execute(s, args);
+                s.wait();
+                auto end = std::chrono::steady_clock::now();
+                double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+                std::vector<float> out(dst.size());
+                read_from_zendnn_memory(out.data(), dst_mem);
+                float diff = 0.0f, scale = 0.0f;
+                for (memory::dim b = 0; b < B; b++)
+                    for (memory::dim m = 0; m < M; m++)
+                        for (memory::dim n = 0; n < N; n++) {
+                            double acc = bias[n];
+                            for (memory::dim k = 0; k < K; k++) {
+                                acc += (double)src[(b * M + m) * K + k] * wei[(b * K + k) * N + n];
+                            }
+                            const size_t off = (b * M + m) * N + n;
+                            float res = (float)acc;
+                            for (size_t i = 0; i < chain.size(); i++) {
+                                const auto &p = chain[i];
+                                if (p.kind == 0) {
+                                    res += p.alpha * dst[off];
+                                }
+                                else if (p.kind == 1) {
+                                    res = eltwise_ref(p.alg, res, p.alpha, p.beta);
+                                }
+                                else {
+                                    float rhs = src1[i][p.bcast == 2 ? off : p.bcast == 1 ? n : 0];
+                                    res = p.alg == algorithm::binary_add ? res + rhs : res * rhs;
+                                }
+                            }
+                            diff = std::max(diff, std::fabs(res - out[off]));
+                            scale = std::max(scale, std::fabs(res));
+                        }
+                float rel_diff = diff / scale;
+                std::cout<<c<<","<<B<<","<<M<<","<<K<<","<<N<<","<<chain.size()<<","
+                         <<rel_diff<<","<<ms<<std::endl;
+                if (rel_diff > 1e-4f) {
+                    status = 1;
+                }
+            }
+        }
+    }
+
+    std::cout<<(status ? "MatMul post-op chain mismatch" :
+                "MatMul post-op chain passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_post_ops_chain test ends");
+    return status;
+}
@@ -30,6 +30,7 @@
 #include <string>
 #include <chrono>
 #include "zendnn.hpp"
+#include "zendnn_helper.hpp"
 #include "test_utils.hpp"
 #include "zendnn_logging.hpp"
 
@@ -155,9 +156,6 @@ int main(int argc, char **argv) {
     //return handle_example_errors(matmul_example, parse_engine_kind(argc, argv));
     zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_test test starts");
 
-    zendnn::engine eng(engine::kind::cpu, 0);
-    zendnn::stream engine_stream(eng);
-
     bool is_const_check = 0;
     std::string algo = "FP32:3"; //(blocked brgemm)
 
@@ -181,6 +179,10 @@ int main(int argc, char **argv) {
     setenv("ZENDNN_MATMUL_ALGO",algo.c_str(),1);
 #endif
 
+    //Created after the environment is set, the library reads it once
+    zendnn::engine eng(engine::kind::cpu, 0);
+    zendnn::stream engine_stream(eng);
+
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
     for (int i=0; i<number_of_runs; i++) {
@@ -194,6 +196,11 @@ int main(int argc, char **argv) {
     std::string str = is_const_check?" weight caching enabled | " + algo:
                       " weight caching disabled | " + algo;
     std::cout<<str<<" "<<number_of_runs<<" MatMul execution time taken: "<<time_taken<<std::endl;
+
+    zendnnWeightCacheStats stats = zendnnGetWeightCacheStats();
+    std::cout<<"Weight cache hits: "<<stats.hits<<" misses: "<<stats.misses
+             <<" evictions: "<<stats.evictions<<" entries: "<<stats.entries
+             <<" bytes: "<<stats.bytes<<std::endl;
     zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_test test ends");
     return 0;
 }
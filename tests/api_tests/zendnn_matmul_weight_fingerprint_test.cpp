@@ -0,0 +1,167 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Reordered weight cache keyed on weight contents (ZENDNN_WEIGHT_CACHE_KEY=1).
+//Two constant weight tensors that differ in one element must never share a
+//reorder, neither from their own buffers nor from one rewritten buffer.
+//
+//Usage: zendnn_matmul_weight_fingerprint_test [algo]
+//  algo : FP32 MatMul algo, 3 or 5 (default 3)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "zendnn_helper.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+using tag = memory::format_tag;
+using dt = memory::data_type;
+
+namespace {
+void init_vector(std::vector<float> &v) {
+    std::mt19937 gen;
+    std::uniform_real_distribution<float> u(-1, 1);
+    for (auto &e : v) {
+        e = u(gen);
+    }
+}
+int compare_vectors(const std::vector<float> &v1, const std::vector<float> &v2,
+                    int64_t K, const char *message) {
+    double v1_l2 = 0, diff_l2 = 0;
+    for (size_t n = 0; n < v1.size(); ++n) {
+        float diff = v1[n] - v2[n];
+        v1_l2 += v1[n] * v1[n];
+        diff_l2 += diff * diff;
+    }
+    v1_l2 = std::sqrt(v1_l2);
+    diff_l2 = std::sqrt(diff_l2);
+    //Machine epsilon multiplied by log(K), as in the other MatMul tests
+    const double threshold = std::numeric_limits<float>::epsilon()
+                             * std::log(std::max(2., (double)K));
+    bool ok = diff_l2 <= threshold * v1_l2;
+    printf("%s\n\tL2 Norms"
+           "\n\t\tReference matrix:%g\n\t\tError:%g\n\t\tRelative_error:%g\n"
+           "\tAccuracy check: %s\n",
+           message, v1_l2, diff_l2, diff_l2 / v1_l2, ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+} // namespace
+
+//Runs two constant weight tensors of the same shape that differ in one
+//element only, first from their own buffers and then one after the other
+//from a shared buffer, as a framework reusing freed memory would. The shared
+//buffer is invalidated after each rewrite. Checks every result against a
+//reference, that each tensor got its own cache entry and that a rewrite
+//replaced the entry of the shared buffer.
+int distinct_weights_check(zendnn::engine eng, zendnn::stream engine_stream) {
+    zendnnInfo(ZENDNN_TESTLOG,
+               "zendnn_matmul_weight_fingerprint_test: distinct_weights_check starts");
+    const memory::dim M = 16, K = 256, N = 128;
+    std::vector<float> src_data(M * K), dst_data(M * N);
+    std::vector<std::vector<float>> weights_data(2, std::vector<float>(K * N));
+    init_vector(src_data);
+    init_vector(weights_data[0]);
+    weights_data[1] = weights_data[0];
+    weights_data[1][(K / 2) * N + N / 2 + 1] += 1.0f;
+    std::vector<float> shared_data(K * N);
+
+    auto src_md = memory::desc({M, K}, dt::f32, tag::ab);
+    auto weights_md = memory::desc({K, N}, dt::f32, tag::ab, true);
+    auto dst_md = memory::desc({M, N}, dt::f32, tag::ab);
+    auto matmul_pd = matmul::primitive_desc(matmul::desc(src_md, weights_md,
+                                            dst_md), eng);
+    auto matmul_prim = matmul(matmul_pd);
+    auto src_mem = memory(src_md, eng, src_data.data());
+    auto dst_mem = memory(dst_md, eng, dst_data.data());
+
+    zendnnWeightCacheStats before = zendnnGetWeightCacheStats();
+    int status = 0;
+    //Each tensor twice per buffer, the second run reads the cached reorder
+    for (int run = 0; run < 8; run++) {
+        const std::vector<float> &weights = weights_data[run % 2];
+        float *buffer = (float *)weights.data();
+        if (run >= 4) {
+            std::copy(weights.begin(), weights.end(), shared_data.begin());
+            buffer = shared_data.data();
+            zendnnInvalidateWeights(buffer);
+        }
+        auto weights_mem = memory(weights_md, eng, buffer);
+        matmul_prim.execute(engine_stream, {{ZENDNN_ARG_SRC, src_mem},
+            {ZENDNN_ARG_WEIGHTS, weights_mem}, {ZENDNN_ARG_DST, dst_mem}
+        });
+        engine_stream.wait();
+
+        std::vector<float> ref(M * N, 0.0f);
+        for (memory::dim m = 0; m < M; m++)
+            for (memory::dim k = 0; k < K; k++)
+                for (memory::dim n = 0; n < N; n++) {
+                    ref[m * N + n] += src_data[m * K + k] * weights[k * N + n];
+                }
+        status |= compare_vectors(ref, dst_data, K, run % 2 ?
+                                  "distinct weights: second tensor" :
+                                  "distinct weights: first tensor");
+    }
+
+    //When the path caches reorders both own buffers and the last contents
+    //of the shared one must be held
+    zendnnWeightCacheStats after = zendnnGetWeightCacheStats();
+    if (after.misses > before.misses && after.evictions == before.evictions &&
+            after.entries != before.entries + 3) {
+        std::cout<<"distinct weights share a cache entry: entries "
+                 <<before.entries<<" -> "<<after.entries<<std::endl;
+        status = 1;
+    }
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_weight_fingerprint_test: distinct_weights_check ends");
+    return status;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_weight_fingerprint_test test starts");
+    std::string algo = "FP32:3"; //(blocked brgemm)
+    if (argc > 1) {
+        int val = std::stoi(std::string(argv[1]));
+        if (val == 3 || val == 5) {
+            algo = "FP32:" + std::to_string(val);
+        }
+    }
+
+#ifdef _WIN32
+    _putenv_s("ZENDNN_MATMUL_ALGO",algo.c_str());
+    _putenv_s("ZENDNN_WEIGHT_CACHE_KEY","1");
+#else
+    setenv("ZENDNN_MATMUL_ALGO",algo.c_str(),1);
+    setenv("ZENDNN_WEIGHT_CACHE_KEY","1",1);
+#endif
+
+    //Created after the environment is set, the library reads it once
+    zendnn::engine eng(engine::kind::cpu, 0);
+    zendnn::stream engine_stream(eng);
+
+    int status = distinct_weights_check(eng, engine_stream);
+    std::cout<<(status ? "Weight fingerprint test failed" :
+                "Weight fingerprint test passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_matmul_weight_fingerprint_test test ends");
+    return status;
+}
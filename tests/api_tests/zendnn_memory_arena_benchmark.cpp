@@ -0,0 +1,173 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Multi threaded benchmark of the library scratch memory pool. Every thread
+//acquires buffers of convolution patch matrix sizes, writes one byte per
+//page as a kernel would, and releases them. The time per acquire/write/
+//release is reported for 1 to max_threads threads, for the pool and for
+//plain aligned allocation, with the pool occupancy after the run.
+//
+//Usage: zendnn_memory_arena_benchmark [max_threads] [iters] [streams]
+//  max_threads : number of concurrent threads to scale up to (default 64)
+//  iters       : buffers per thread (default 2000)
+//  streams     : 0 all threads share one pool, 1 one pool per thread as
+//                with one stream per thread (default 0)
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "zendnn_utils.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+
+//Patch matrix sizes of a few convolution layers, in bytes
+const unsigned long buffer_sizes[] = {
+    9 * 64 * 56 * 4, 9 * 64 * 56 * 56 * 4, 9 * 128 * 28 * 28 * 4,
+    9 * 256 * 14 * 14 * 4, 49 * 3 * 112 * 112 * 4, 9 * 512 * 7 * 4
+};
+const int page_bytes = 4096;
+
+//Runs iters acquire/write/release cycles, returns the time per cycle in ns,
+//0 when a buffer is missing or misaligned
+double run_thread(ZenLibMemoryPool *pool, int iters, int seed,
+                  std::atomic<int> &ready, int num_threads) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dis(0, sizeof(buffer_sizes) / sizeof(
+            buffer_sizes[0]) - 1);
+    std::vector<int> sequence(iters);
+    for (auto &s : sequence) {
+        s = dis(gen);
+    }
+
+    ready.fetch_add(1);
+    while (ready.load() < num_threads) {
+        std::this_thread::yield();
+    }
+
+    bool valid = true;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        unsigned long size = buffer_sizes[sequence[i]];
+        float *buffer = NULL;
+        bool pooled = pool && !pool->acquireZenLibPoolBuf(&buffer, size, 1);
+        if (!pooled) {
+            buffer = (float *)zendnn_aligned_alloc(ALIGNED_OFFSET,
+                                                   (size + ALIGNED_OFFSET - 1) / ALIGNED_OFFSET * ALIGNED_OFFSET);
+        }
+        if (!buffer || (uintptr_t)buffer % ALIGNED_OFFSET) {
+            valid = false;
+            break;
+        }
+        for (unsigned long off = 0; off < size; off += page_bytes) {
+            ((volatile char *)buffer)[off] = (char)i;
+        }
+        if (pooled) {
+            pool->zenLibMemPoolFree(buffer);
+        }
+        else {
+            free(buffer);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return valid ? std::chrono::duration<double, std::nano>(end - begin).count() /
+           iters : 0.0;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_memory_arena_benchmark test starts");
+
+    int max_threads = 64, iters = 2000, streams = 0;
+    if (argc > 1) {
+        max_threads = std::stoi(std::string(argv[1]));
+    }
+    if (argc > 2) {
+        iters = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        streams = std::stoi(std::string(argv[3]));
+    }
+    if (max_threads > ZEN_LIB_MEM_POOL_LIMIT) {
+        max_threads = ZEN_LIB_MEM_POOL_LIMIT;
+    }
+
+    std::cout<<"iterations per thread="<<iters<<" streams="<<streams<<std::endl;
+    std::cout<<"threads,alloc,avg_ns_per_buffer,max_ns_per_buffer,peak_MB,"
+             "reserved_MB,reused_pct"<<std::endl;
+    int status = 0;
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        for (int use_pool = 1; use_pool >= 0; use_pool--) {
+            std::vector<std::thread> threads;
+            std::vector<double> time_per_buffer(num_threads);
+            std::atomic<int> ready(0);
+            for (int t = 0; t < num_threads; t++) {
+                ZenLibMemoryPool *pool = use_pool ? ZenLibMemoryPool::getZenLibMemPool(
+                                             streams ? t : 0) : NULL;
+                threads.emplace_back([&, pool, t]() {
+                    time_per_buffer[t] = run_thread(pool, iters, t, ready, num_threads);
+                });
+            }
+            for (auto &t : threads) {
+                t.join();
+            }
+
+            double avg = 0.0, max = 0.0;
+            for (double ns : time_per_buffer) {
+                if (ns == 0.0) {
+                    status = 1;
+                }
+                avg += ns / num_threads;
+                max = ns > max ? ns : max;
+            }
+            std::cout<<num_threads<<","<<(use_pool ? "pool" : "aligned_alloc")<<","
+                     <<avg<<","<<max;
+            if (use_pool) {
+                //Sum over the pools used in this run
+                zendnnArena::stats_t total = {0, 0, 0, 0, 0};
+                for (int p = 0; p < (streams ? num_threads : 1); p++) {
+                    zendnnArena::stats_t s =
+                        ZenLibMemoryPool::getZenLibMemPool(p)->zenLibMemPoolStats();
+                    if (s.in_use) {
+                        status = 1;
+                    }
+                    total.peak += s.peak;
+                    total.reserved += s.reserved;
+                    total.requests += s.requests;
+                    total.reused += s.reused;
+                }
+                std::cout<<","<<total.peak / 1048576.0<<","<<total.reserved / 1048576.0
+                         <<","<<(total.requests ? 100.0 * total.reused / total.requests : 0.0);
+            }
+            else {
+                std::cout<<",,,";
+            }
+            std::cout<<std::endl;
+        }
+    }
+
+    std::cout<<(status ? "Memory arena benchmark failed" :
+                "Memory arena benchmark passed")<<std::endl;
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_memory_arena_benchmark test ends");
+    return status;
+}
@@ -0,0 +1,177 @@
+/*******************************************************************************
+* Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*******************************************************************************/
+
+//Offline auto tuner. Sweeps every MatMul (FP32 and BF16) and LPGEMM
+//convolution algo for a list of shapes and writes the best algo per shape to
+//the persistent tuning database. Deployments then run with
+//  ZENDNN_MATMUL_PERSISTENT_MAP=2 (MatMul) / ZENDNN_LPGEMM_PERSISTENT_MAP=2
+//  (convolution) and ZENDNN_MATMUL_MAP_FILE=<map file>
+//and never tune online.
+//
+//Usage: zendnn_offline_tuner <shape file> [threads] [iters] [map file]
+//  threads  : thread count to tune for (default OMP_NUM_THREADS or 1)
+//  iters    : timed runs per algo, best one is kept (default 10)
+//  map file : output, merged if it exists (default ZENDNN_MATMUL_MAP_FILE or
+//             key_matmul_map.csv)
+//
+//Shape file, one shape per line, '#' starts a comment:
+//  matmul,M,K,N[,trans_a,trans_b,lda,ldb,ldc]       FP32 and BF16
+//  matmul_f32,M,K,N[,trans_a,trans_b,lda,ldb,ldc]
+//  matmul_bf16,M,K,N[,trans_a,trans_b,lda,ldb,ldc]
+//  conv_os8,N,C,H,W,K,KH,KW,pad_t,pad_l,pad_b,pad_r,stride_h,stride_w
+//  conv_os32,N,C,H,W,K,KH,KW,pad_t,pad_l,pad_b,pad_r,stride_h,stride_w
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "zendnn.hpp"
+#include "zendnn_helper.hpp"
+#include "test_utils.hpp"
+#include "zendnn_logging.hpp"
+
+using namespace zendnn;
+
+//Tunes one shape line, returns false if the line is invalid
+bool tune_shape(const std::string &op, const std::vector<int> &dims,
+                unsigned int threads, unsigned int iters) {
+    if (op == "matmul" || op == "matmul_f32" || op == "matmul_bf16") {
+        if (dims.size() != 3 && dims.size() != 5 && dims.size() != 8) {
+            return false;
+        }
+        int m = dims[0], k = dims[1], n = dims[2];
+        bool trans_a = dims.size() > 3 ? dims[3] : false;
+        bool trans_b = dims.size() > 3 ? dims[4] : false;
+        int lda = dims.size() > 5 ? dims[5] : (trans_a ? m : k);
+        int ldb = dims.size() > 5 ? dims[6] : (trans_b ? k : n);
+        int ldc = dims.size() > 5 ? dims[7] : n;
+        if (op != "matmul_bf16") {
+            int algo = zendnnTuneMatMul(trans_a, trans_b, m, k, n, lda, ldb, ldc,
+                                        threads, iters);
+            std::cout<<"matmul_f32,"<<m<<"x"<<k<<"x"<<n<<","<<algo<<std::endl;
+            if (algo < 0) {
+                return false;
+            }
+        }
+        if (op != "matmul_f32") {
+            int algo = zendnnTuneMatMulBF16(trans_a, trans_b, m, k, n, lda, ldb, ldc,
+                                            threads, iters);
+            std::cout<<"matmul_bf16,"<<m<<"x"<<k<<"x"<<n<<","<<algo<<std::endl;
+            if (algo < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (op == "conv_os8" || op == "conv_os32") {
+        if (dims.size() != 13) {
+            return false;
+        }
+        int algo = zendnnTuneConvLPGEMM(op == "conv_os32", dims[0], dims[1],
+                                        dims[2], dims[3], dims[4], dims[5], dims[6], dims[7], dims[8],
+                                        dims[9], dims[10], dims[11], dims[12], threads, iters);
+        std::cout<<op<<","<<dims[0]<<"x"<<dims[1]<<"x"<<dims[2]<<"x"<<dims[3]
+                 <<"->"<<dims[4]<<"("<<dims[5]<<"x"<<dims[6]<<")"<<","<<algo
+                 <<std::endl;
+        return algo >= 0;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_offline_tuner test starts");
+
+    if (argc < 2) {
+        std::cout<<"Usage: "<<argv[0]
+                 <<" <shape file> [threads] [iters] [map file]"<<std::endl;
+        return 1;
+    }
+    unsigned int threads = zendnn_getenv_int("OMP_NUM_THREADS", 1);
+    unsigned int iters = 10;
+    const char *map_file = NULL;
+    if (argc > 2) {
+        threads = std::stoi(std::string(argv[2]));
+    }
+    if (argc > 3) {
+        iters = std::stoi(std::string(argv[3]));
+    }
+    if (argc > 4) {
+        map_file = argv[4];
+    }
+
+    //Environment is read once by the library, set it before the first call.
+    //Tuning always measures, it never reads a map.
+    std::string threads_str = std::to_string(threads);
+#ifdef _WIN32
+    _putenv_s("OMP_NUM_THREADS", threads_str.c_str());
+    _putenv_s("ZENDNN_MATMUL_PERSISTENT_MAP", "0");
+    _putenv_s("ZENDNN_LPGEMM_PERSISTENT_MAP", "0");
+#else
+    setenv("OMP_NUM_THREADS", threads_str.c_str(), 1);
+    setenv("ZENDNN_MATMUL_PERSISTENT_MAP", "0", 1);
+    setenv("ZENDNN_LPGEMM_PERSISTENT_MAP", "0", 1);
+#endif
+
+    std::ifstream shape_file(argv[1]);
+    if (!shape_file.is_open()) {
+        std::cout<<"Could not open shape file "<<argv[1]<<std::endl;
+        return 1;
+    }
+
+    std::cout<<"threads="<<threads<<" iterations="<<iters<<std::endl;
+    std::cout<<"op,shape,best_algo"<<std::endl;
+    std::string line;
+    unsigned int line_num = 0, invalid = 0;
+    while (getline(shape_file, line)) {
+        line_num++;
+        line = line.substr(0, line.find('#'));
+        std::stringstream fields(line);
+        std::string op, field;
+        if (!getline(fields, op, ',') || op.find_first_not_of(" \t\r") ==
+                std::string::npos) {
+            continue;
+        }
+        op.erase(0, op.find_first_not_of(" \t"));
+        op.erase(op.find_last_not_of(" \t\r") + 1);
+        std::vector<int> dims;
+        bool valid = true;
+        while (getline(fields, field, ',')) {
+            try {
+                dims.push_back(std::stoi(field));
+            }
+            catch (std::exception const &e) {
+                valid = false;
+            }
+        }
+        if (!valid || !tune_shape(op, dims, threads, iters)) {
+            std::cout<<"Invalid shape at line "<<line_num<<": "<<line<<std::endl;
+            invalid++;
+        }
+    }
+
+    if (zendnnSaveTuningDB(map_file)) {
+        std::cout<<"Could not write the tuning database"<<std::endl;
+        return 1;
+    }
+    std::cout<<"Tuning database written to "<<(map_file ? map_file :
+             getenv("ZENDNN_MATMUL_MAP_FILE") ? getenv("ZENDNN_MATMUL_MAP_FILE") :
+             "key_matmul_map.csv")<<std::endl;
+
+    zendnnInfo(ZENDNN_TESTLOG, "zendnn_offline_tuner test ends");
+    return invalid ? 1 : 0;
+}